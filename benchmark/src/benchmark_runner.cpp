@@ -0,0 +1,75 @@
+#include "benchmark_runner.h"
+
+#include <utils/json.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace Benchmark
+{
+    void BenchmarkRunner::Run(
+        const std::string & name,
+        const std::function<void()> & function,
+        const int item_count
+        )
+    {
+        std::vector<double>
+            time_table;
+        Result
+            result;
+        double
+            total_time = 0.0;
+
+        function();
+
+        for( int iteration = 0; iteration < m_IterationCount; ++iteration )
+        {
+            std::chrono::steady_clock::time_point
+                start = std::chrono::steady_clock::now();
+
+            function();
+
+            std::chrono::duration<double, std::milli>
+                duration = std::chrono::steady_clock::now() - start;
+
+            time_table.push_back( duration.count() );
+            total_time += duration.count();
+        }
+
+        std::sort( time_table.begin(), time_table.end() );
+
+        result.m_Name = name;
+        result.m_IterationCount = m_IterationCount;
+        result.m_ItemCount = item_count;
+        result.m_MinimumMilliseconds = time_table.empty() ? 0.0 : time_table.front();
+        result.m_MeanMilliseconds = time_table.empty() ? 0.0 : total_time / time_table.size();
+        result.m_MedianMilliseconds = time_table.empty() ? 0.0 : time_table[ time_table.size() / 2 ];
+
+        std::cerr << name << ": " << result.m_MedianMilliseconds << " ms" << std::endl;
+
+        m_ResultTable.push_back( result );
+    }
+
+    void BenchmarkRunner::PrintJson( std::ostream & stream ) const
+    {
+        std::vector<Result>::const_iterator it, end;
+        const char
+            * separator = "";
+
+        stream << "{\n  \"benchmarks\": [";
+
+        for( it = m_ResultTable.begin(), end = m_ResultTable.end(); it != end; ++it )
+        {
+            stream << separator << "\n    { \"name\": ";
+            write_json_string( stream, (*it).m_Name );
+            stream << ", \"iterations\": " << (*it).m_IterationCount
+                << ", \"items\": " << (*it).m_ItemCount
+                << ", \"min_ms\": " << (*it).m_MinimumMilliseconds
+                << ", \"mean_ms\": " << (*it).m_MeanMilliseconds
+                << ", \"median_ms\": " << (*it).m_MedianMilliseconds << " }";
+            separator = ",";
+        }
+
+        stream << "\n  ]\n}\n";
+    }
+}
\ No newline at end of file
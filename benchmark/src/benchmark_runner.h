@@ -0,0 +1,49 @@
+#ifndef BENCHMARK_RUNNER_H
+    #define BENCHMARK_RUNNER_H
+
+    #include <functional>
+    #include <ostream>
+    #include <string>
+    #include <vector>
+
+    namespace Benchmark
+    {
+        // Runs each benchmark once to warm up, then times every iteration separately
+
+        class BenchmarkRunner
+        {
+        public:
+
+            explicit BenchmarkRunner( const int iteration_count ) : m_IterationCount( iteration_count ) {}
+
+            void Run(
+                const std::string & name,
+                const std::function<void()> & function,
+                const int item_count = 1
+                );
+
+            void PrintJson( std::ostream & stream ) const;
+
+        private:
+
+            struct Result
+            {
+                std::string
+                    m_Name;
+                int
+                    m_IterationCount,
+                    m_ItemCount;
+                double
+                    m_MinimumMilliseconds,
+                    m_MeanMilliseconds,
+                    m_MedianMilliseconds;
+            };
+
+            int
+                m_IterationCount;
+            std::vector<Result>
+                m_ResultTable;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "corpus_generator.h"
+
+#include <random>
+#include <sstream>
+
+namespace Benchmark
+{
+    namespace
+    {
+        const char
+            * const VariableNameTable[] = { "value", "color", "factor", "offset" };
+        const int
+            VariableCount = sizeof( VariableNameTable ) / sizeof( VariableNameTable[ 0 ] );
+
+        class CorpusWriter
+        {
+        public:
+
+            CorpusWriter( const CorpusSettings & settings ) :
+                m_Settings( settings ),
+                m_Random( settings.m_Seed )
+            {
+            }
+
+            void WriteFunction( std::ostream & stream, const int index )
+            {
+                stream << "float4 Function" << index << "( float4 value : Value" << index
+                    << ", float4 color : Color )\n{\n"
+                    << "    float4 factor = value * 0.5;\n"
+                    << "    float4 offset = color - value;\n";
+
+                for( int statement = 0; statement < m_Settings.m_StatementCount; ++statement )
+                {
+                    WriteStatement( stream, "    " );
+                }
+
+                stream << "    return " ;
+                WriteExpression( stream, m_Settings.m_ExpressionDepth );
+                stream << ";\n}\n\n";
+            }
+
+        private:
+
+            int GetRandom( const int count )
+            {
+                return std::uniform_int_distribution<int>( 0, count - 1 )( m_Random );
+            }
+
+            void WriteStatement( std::ostream & stream, const std::string & indentation )
+            {
+                const int
+                    total_weight = m_Settings.m_AssignmentWeight + m_Settings.m_BranchWeight + m_Settings.m_LoopWeight;
+                int
+                    choice = total_weight > 0 ? GetRandom( total_weight ) : 0;
+
+                if( total_weight == 0 || choice < m_Settings.m_AssignmentWeight )
+                {
+                    stream << indentation << VariableNameTable[ GetRandom( VariableCount ) ] << " = ";
+                    WriteExpression( stream, m_Settings.m_ExpressionDepth );
+                    stream << ";\n";
+                }
+                else if( choice < m_Settings.m_AssignmentWeight + m_Settings.m_BranchWeight )
+                {
+                    stream << indentation << "if( " << VariableNameTable[ GetRandom( VariableCount ) ] << ".x > 0.5 )\n"
+                        << indentation << "{\n"
+                        << indentation << "    " << VariableNameTable[ GetRandom( VariableCount ) ] << " += ";
+                    WriteExpression( stream, m_Settings.m_ExpressionDepth - 1 );
+                    stream << ";\n" << indentation << "}\n"
+                        << indentation << "else\n"
+                        << indentation << "{\n"
+                        << indentation << "    " << VariableNameTable[ GetRandom( VariableCount ) ] << " -= ";
+                    WriteExpression( stream, m_Settings.m_ExpressionDepth - 1 );
+                    stream << ";\n" << indentation << "}\n";
+                }
+                else
+                {
+                    stream << indentation << "for( int i = 0; i < 4; ++i )\n"
+                        << indentation << "{\n"
+                        << indentation << "    " << VariableNameTable[ GetRandom( VariableCount ) ] << " *= ";
+                    WriteExpression( stream, m_Settings.m_ExpressionDepth - 1 );
+                    stream << ";\n" << indentation << "}\n";
+                }
+            }
+
+            void WriteExpression( std::ostream & stream, const int depth )
+            {
+                if( depth <= 0 )
+                {
+                    if( GetRandom( 3 ) == 0 )
+                    {
+                        stream << GetRandom( 100 ) << ".0";
+                    }
+                    else
+                    {
+                        stream << VariableNameTable[ GetRandom( VariableCount ) ];
+                    }
+
+                    return;
+                }
+
+                switch( GetRandom( 4 ) )
+                {
+                    case 0:
+                        stream << "saturate( ";
+                        WriteExpression( stream, depth - 1 );
+                        stream << " )";
+                        break;
+
+                    case 1:
+                        stream << "lerp( ";
+                        WriteExpression( stream, depth - 1 );
+                        stream << ", ";
+                        WriteExpression( stream, depth - 1 );
+                        stream << ", 0.5 )";
+                        break;
+
+                    default:
+                        {
+                            const char
+                                * const operator_table[] = { " + ", " - ", " * " };
+
+                            stream << "( ";
+                            WriteExpression( stream, depth - 1 );
+                            stream << operator_table[ GetRandom( 3 ) ];
+                            WriteExpression( stream, depth - 1 );
+                            stream << " )";
+                        }
+                        break;
+                }
+            }
+
+            const CorpusSettings
+                & m_Settings;
+            std::minstd_rand
+                m_Random;
+        };
+
+        std::string GetSemantic( const int layer, const int index )
+        {
+            std::ostringstream
+                semantic;
+
+            semantic << "Layer" << layer << "Semantic" << index;
+
+            return semantic.str();
+        }
+    }
+
+    std::string GenerateCorpus( const CorpusSettings & settings )
+    {
+        std::ostringstream
+            stream;
+        CorpusWriter
+            writer( settings );
+
+        for( int index = 0; index < settings.m_FunctionCount; ++index )
+        {
+            writer.WriteFunction( stream, index );
+        }
+
+        return stream.str();
+    }
+
+    void GenerateLibrary(
+        FragmentLibrary & library,
+        const LibrarySettings & settings
+        )
+    {
+        const int
+            width = settings.m_SemanticCount > 0 ? settings.m_SemanticCount : 1,
+            layer_count = settings.m_FragmentCount / width > 0 ? settings.m_FragmentCount / width : 1;
+
+        library = FragmentLibrary();
+        library.m_InputSemanticTable.push_back( "Input" );
+
+        for( int layer = 0; layer < layer_count; ++layer )
+        {
+            for( int index = 0; index < width; ++index )
+            {
+                std::ostringstream
+                    path,
+                    source;
+
+                path << "fragment_" << layer << "_" << index << ".fx";
+                source << "float4 Compute" << layer << "_" << index << "(";
+
+                if( layer == 0 )
+                {
+                    source << " float4 input : Input";
+                }
+                else
+                {
+                    source << " float4 first : " << GetSemantic( layer - 1, index );
+
+                    if( settings.m_Topology == LibraryTopology_Diamond && width > 1 )
+                    {
+                        source << ", float4 second : " << GetSemantic( layer - 1, ( index + 1 ) % width );
+                    }
+                }
+
+                source << " ) : " << GetSemantic( layer, index ) << "\n{\n";
+
+                if( layer == 0 )
+                {
+                    source << "    return input * " << index + 1 << ".0;\n";
+                }
+                else if( settings.m_Topology == LibraryTopology_Diamond && width > 1 )
+                {
+                    source << "    return lerp( first, second, 0.5 );\n";
+                }
+                else
+                {
+                    source << "    return saturate( first * 2.0 );\n";
+                }
+
+                source << "}\n";
+
+                library.m_FileTable[ path.str() ] = source.str();
+                library.m_PathTable.push_back( path.str() );
+            }
+        }
+
+        for( int index = 0; index < width; ++index )
+        {
+            library.m_OutputSemanticTable.push_back( GetSemantic( layer_count - 1, index ) );
+        }
+    }
+}
\ No newline at end of file
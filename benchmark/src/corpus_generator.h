@@ -0,0 +1,80 @@
+#ifndef CORPUS_GENERATOR_H
+    #define CORPUS_GENERATOR_H
+
+    #include <map>
+    #include <string>
+    #include <vector>
+
+    namespace Benchmark
+    {
+        // Statement weights are relative, a weight of 0 disables the statement kind
+
+        struct CorpusSettings
+        {
+            CorpusSettings() :
+                m_FunctionCount( 100 ),
+                m_StatementCount( 20 ),
+                m_ExpressionDepth( 4 ),
+                m_AssignmentWeight( 6 ),
+                m_BranchWeight( 2 ),
+                m_LoopWeight( 1 ),
+                m_Seed( 1 )
+            {
+            }
+
+            int
+                m_FunctionCount,
+                m_StatementCount,
+                m_ExpressionDepth,
+                m_AssignmentWeight,
+                m_BranchWeight,
+                m_LoopWeight;
+            unsigned int
+                m_Seed;
+        };
+
+        enum LibraryTopology
+        {
+            LibraryTopology_Chain,
+            LibraryTopology_Diamond
+        };
+
+        // Fragments are laid out in layers of m_SemanticCount functions, each function
+        // producing one semantic from the previous layer. Chains only read the semantic with
+        // the same index, diamonds also read the next one, so that semantics are shared.
+
+        struct LibrarySettings
+        {
+            LibrarySettings() :
+                m_FragmentCount( 64 ),
+                m_SemanticCount( 8 ),
+                m_Topology( LibraryTopology_Diamond )
+            {
+            }
+
+            int
+                m_FragmentCount,
+                m_SemanticCount;
+            LibraryTopology
+                m_Topology;
+        };
+
+        struct FragmentLibrary
+        {
+            std::map<std::string, std::string>
+                m_FileTable;
+            std::vector<std::string>
+                m_PathTable,
+                m_InputSemanticTable,
+                m_OutputSemanticTable;
+        };
+
+        std::string GenerateCorpus( const CorpusSettings & settings );
+
+        void GenerateLibrary(
+            FragmentLibrary & library,
+            const LibrarySettings & settings
+            );
+    }
+
+#endif
\ No newline at end of file
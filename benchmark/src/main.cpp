@@ -0,0 +1,360 @@
+#include "benchmark_runner.h"
+#include "corpus_generator.h"
+#include <hlsl_parser/hlsl.h>
+#include <hlsl_parser/preprocessor.h>
+#include <ast/node.h>
+#include <ast/flat/flat_converter.h>
+#include <ast/flat/flat_hlsl_printer.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/code_generator.h>
+#include <generation/flat_semantic_remover.h>
+#include <generation/fragment_definition.h>
+#include <generation/semantic_remover.h>
+#include <base/text_error_handler.h>
+#include <tclap/CmdLine.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+TCLAP::CmdLine cmd( "ShaderShaker benchmarks" );
+
+TCLAP::ValueArg<int> iteration_argument( "n", "iterations", "timed iterations of each benchmark", false, 10, "count", cmd );
+TCLAP::ValueArg<int> function_argument( "f", "functions", "function count of the synthetic corpus", false, 100, "count", cmd );
+TCLAP::ValueArg<int> statement_argument( "", "statements", "statement count of each corpus function", false, 20, "count", cmd );
+TCLAP::ValueArg<int> depth_argument( "d", "depth", "expression depth of the synthetic corpus", false, 4, "depth", cmd );
+TCLAP::ValueArg<std::string> statement_mix_argument( "", "statement_mix", "relative weights of assignments, branches and loops", false, "6,2,1", "a,b,l", cmd );
+TCLAP::ValueArg<int> fragment_argument( "", "fragments", "fragment count of the synthetic library", false, 64, "count", cmd );
+TCLAP::ValueArg<int> semantic_argument( "", "semantics", "semantics produced by each layer of the library", false, 8, "count", cmd );
+TCLAP::ValueArg<std::string> topology_argument( "t", "topology", "library topology, chain or diamond", false, "diamond", "topology", cmd );
+TCLAP::ValueArg<std::string> output_argument( "o", "output", "JSON result file, standard output when not set", false, "", "filepath", cmd );
+
+namespace
+{
+    class MemoryIncludeCache : public HLSL::IncludeCache
+    {
+    public:
+
+        virtual bool ReadFile(
+            std::string & content,
+            const std::string & path
+            ) const override
+        {
+            std::map<std::string, std::string>::const_iterator file = m_FileTable.find( path );
+
+            if( file == m_FileTable.end() )
+            {
+                return false;
+            }
+
+            content = (*file).second;
+            return true;
+        }
+
+        std::map<std::string, std::string>
+            m_FileTable;
+    };
+
+    bool ParseStatementMix( Benchmark::CorpusSettings & settings, const std::string & mix )
+    {
+        std::istringstream
+            stream( mix );
+        char
+            first_separator = 0,
+            second_separator = 0;
+
+        stream >> settings.m_AssignmentWeight >> first_separator
+            >> settings.m_BranchWeight >> second_separator
+            >> settings.m_LoopWeight;
+
+        return stream && first_separator == ',' && second_separator == ',';
+    }
+
+    bool ParseLibrary(
+        std::vector<Base::ObjectRef<AST::TranslationUnit> > & translation_unit_table,
+        HLSL::Preprocessor & preprocessor,
+        const Benchmark::FragmentLibrary & library
+        )
+    {
+        std::vector<std::string>::const_iterator it, end;
+
+        translation_unit_table.clear();
+
+        for( it = library.m_PathTable.begin(), end = library.m_PathTable.end(); it != end; ++it )
+        {
+            Base::ObjectRef<AST::TranslationUnit>
+                translation_unit = HLSL::ParseHLSL( *it, preprocessor );
+
+            if( !translation_unit )
+            {
+                return false;
+            }
+
+            translation_unit_table.push_back( translation_unit );
+        }
+
+        return true;
+    }
+}
+
+int main( int argument_count, const char* argument_table[] )
+{
+    try
+    {
+        cmd.parse( argument_count, argument_table );
+    }
+    catch( TCLAP::ArgException &e )
+    {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        return 1;
+    }
+
+    Benchmark::CorpusSettings
+        corpus_settings;
+    Benchmark::LibrarySettings
+        library_settings;
+    Benchmark::FragmentLibrary
+        library;
+
+    corpus_settings.m_FunctionCount = function_argument.getValue();
+    corpus_settings.m_StatementCount = statement_argument.getValue();
+    corpus_settings.m_ExpressionDepth = depth_argument.getValue();
+    library_settings.m_FragmentCount = fragment_argument.getValue();
+    library_settings.m_SemanticCount = semantic_argument.getValue();
+
+    if( !ParseStatementMix( corpus_settings, statement_mix_argument.getValue() ) )
+    {
+        std::cerr << "error: invalid statement mix " << statement_mix_argument.getValue() << std::endl;
+        return 1;
+    }
+
+    if( topology_argument.getValue() == "chain" )
+    {
+        library_settings.m_Topology = Benchmark::LibraryTopology_Chain;
+    }
+    else if( topology_argument.getValue() != "diamond" )
+    {
+        std::cerr << "error: unknown topology " << topology_argument.getValue() << std::endl;
+        return 1;
+    }
+
+    Benchmark::GenerateLibrary( library, library_settings );
+
+    Base::ObjectRef<MemoryIncludeCache>
+        cache = new MemoryIncludeCache;
+    Base::ObjectRef<Base::TextErrorHandler>
+        error_handler = new Base::TextErrorHandler;
+    HLSL::Preprocessor
+        preprocessor( *cache, *error_handler );
+    Benchmark::BenchmarkRunner
+        runner( iteration_argument.getValue() );
+    Base::ObjectRef<AST::TranslationUnit>
+        corpus,
+        generated_shader;
+    std::vector<Base::ObjectRef<AST::TranslationUnit> >
+        translation_unit_table;
+    std::vector<Generation::FragmentDefinition::Ref>
+        definition_table;
+    std::vector<std::string>
+        used_semantic_table;
+    AST::FlatTranslationUnit
+        flat_corpus;
+
+    cache->m_FileTable = library.m_FileTable;
+    cache->m_FileTable[ "corpus.fx" ] = Benchmark::GenerateCorpus( corpus_settings );
+
+    corpus = HLSL::ParseHLSL( "corpus.fx", preprocessor );
+
+    if( !corpus || !ParseLibrary( translation_unit_table, preprocessor, library ) )
+    {
+        std::cerr << "error: unable to parse the synthetic sources" << std::endl
+            << error_handler->GetErrorMessage() << std::endl;
+        return 1;
+    }
+
+    runner.Run(
+        "parse_corpus",
+        [&]()
+        {
+            corpus = HLSL::ParseHLSL( "corpus.fx", preprocessor );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "parse_corpus_lazy",
+        [&]()
+        {
+            HLSL::ParseHLSL( "corpus.fx", preprocessor, true );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "parse_library",
+        [&]()
+        {
+            ParseLibrary( translation_unit_table, preprocessor, library );
+        },
+        static_cast<int>( library.m_PathTable.size() )
+        );
+
+    runner.Run(
+        "generate_fragment",
+        [&]()
+        {
+            std::vector<Base::ObjectRef<AST::TranslationUnit> >::iterator it, end;
+
+            definition_table.clear();
+
+            for( it = translation_unit_table.begin(), end = translation_unit_table.end(); it != end; ++it )
+            {
+                definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( **it ) );
+            }
+        },
+        static_cast<int>( translation_unit_table.size() )
+        );
+
+    runner.Run(
+        "generate_shader",
+        [&]()
+        {
+            Generation::CodeGenerator
+                code_generator;
+
+            used_semantic_table.clear();
+            code_generator.GenerateShader(
+                generated_shader,
+                used_semantic_table,
+                definition_table,
+                library.m_OutputSemanticTable,
+                library.m_InputSemanticTable,
+                *error_handler
+                );
+        }
+        );
+
+    if( !generated_shader )
+    {
+        std::cerr << "error: unable to generate the synthetic shader" << std::endl
+            << error_handler->GetErrorMessage() << std::endl;
+        return 1;
+    }
+
+    runner.Run(
+        "clone_corpus",
+        [&]()
+        {
+            Base::ObjectRef<AST::TranslationUnit>
+                clone = corpus->Clone();
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "print_corpus",
+        [&]()
+        {
+            std::ostringstream
+                output;
+            AST::HLSLPrinter
+                printer( output );
+
+            corpus->Visit( printer );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "flatten_corpus",
+        [&]()
+        {
+            AST::ConvertToFlat( flat_corpus, *corpus );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "clone_corpus_flat",
+        [&]()
+        {
+            AST::FlatTranslationUnit
+                clone( flat_corpus );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "print_corpus_flat",
+        [&]()
+        {
+            std::ostringstream
+                output;
+            AST::FlatHLSLPrinter
+                printer( output );
+
+            printer.Print( flat_corpus );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "remove_semantics",
+        [&]()
+        {
+            Base::ObjectRef<AST::TranslationUnit>
+                clone = corpus->Clone();
+            Generation::SemanticRemover
+                semantic_remover;
+
+            semantic_remover.Dispatch( *clone );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "remove_semantics_flat",
+        [&]()
+        {
+            AST::FlatTranslationUnit
+                clone( flat_corpus );
+            Generation::FlatSemanticRemover
+                semantic_remover;
+
+            semantic_remover.Process( clone );
+        },
+        corpus_settings.m_FunctionCount
+        );
+
+    runner.Run(
+        "print_shader",
+        [&]()
+        {
+            std::ostringstream
+                output;
+            AST::HLSLPrinter
+                printer( output );
+
+            generated_shader->Visit( printer );
+        }
+        );
+
+    if( output_argument.isSet() )
+    {
+        std::ofstream
+            file( output_argument.getValue().c_str() );
+
+        runner.PrintJson( file );
+
+        if( !file )
+        {
+            std::cerr << "Unable to write " << output_argument.getValue() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        runner.PrintJson( std::cout );
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -115,7 +115,7 @@ namespace
 
 EMSCRIPTEN_BINDINGS(ShaderShaker2)
 {
-    emscripten::function("ParseHLSL", &HLSL::ParseHLSL );
+    emscripten::function("ParseHLSL", emscripten::select_overload<Base::ObjectRef<AST::TranslationUnit>( const std::string & )>( &HLSL::ParseHLSL ) );
     emscripten::function( "GenerateFragmentDefinition", &Generation::FragmentDefinition::GenerateFragment );
     emscripten::function( "GetHlslCode", &LOCAL_GetHlslCode );
 
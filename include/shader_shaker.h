@@ -0,0 +1,135 @@
+#ifndef SHADER_SHAKER_H
+    #define SHADER_SHAKER_H
+
+    #include <stddef.h>
+
+    #if defined( _WIN32 ) && defined( SHADERSHAKER_IN_DLL )
+        #define SHADERSHAKER_API __declspec( dllexport )
+    #elif defined( _WIN32 ) && defined( SHADERSHAKER_DLL )
+        #define SHADERSHAKER_API __declspec( dllimport )
+    #elif defined( __GNUC__ )
+        #define SHADERSHAKER_API __attribute__( ( visibility( "default" ) ) )
+    #else
+        #define SHADERSHAKER_API
+    #endif
+
+    #ifdef __cplusplus
+    extern "C"
+    {
+    #endif
+
+        // C interface of the ShaderShakerDll and ShaderShakerLib targets. Define
+        // SHADERSHAKER_DLL when using the Windows DLL.
+        //
+        // A context owns a fragment library: fragments are loaded or parsed once, then
+        // any number of shaders are generated from them. Generated code is printed
+        // directly in the buffers given by the caller. A context must only be used by
+        // one thread at a time, but different contexts are independent.
+
+        typedef struct ShaderShakerContext
+            ShaderShakerContext;
+
+        typedef enum
+        {
+            SHADERSHAKER_OK = 0,
+            SHADERSHAKER_INVALID_ARGUMENT,
+            SHADERSHAKER_PARSE_ERROR,
+            SHADERSHAKER_GENERATION_ERROR,
+            SHADERSHAKER_BUFFER_TOO_SMALL,
+            // An exception was raised, like running out of memory, see ShaderShaker_GetLastError
+            SHADERSHAKER_INTERNAL_ERROR
+        } ShaderShakerResult;
+
+        SHADERSHAKER_API ShaderShakerContext * ShaderShaker_CreateContext( void );
+        SHADERSHAKER_API void ShaderShaker_DestroyContext( ShaderShakerContext * context );
+
+        // Preprocessor configuration, used by the fragments loaded afterwards
+        SHADERSHAKER_API void ShaderShaker_AddIncludePath( ShaderShakerContext * context, const char * path );
+        SHADERSHAKER_API void ShaderShaker_Define( ShaderShakerContext * context, const char * name, const char * value );
+
+        // Function bodies are only parsed when first used
+        SHADERSHAKER_API void ShaderShaker_SetLazyParsing( ShaderShakerContext * context, const int is_lazy );
+
+        // Moves the expressions only reading uniforms out of the generated code, see
+        // ShaderShaker_GetPreshader
+        SHADERSHAKER_API void ShaderShaker_SetPreshader( ShaderShakerContext * context, const int extracts_preshader );
+
+        SHADERSHAKER_API ShaderShakerResult ShaderShaker_LoadFragment( ShaderShakerContext * context, const char * path );
+
+        // The source is also used when name is included by another fragment
+        SHADERSHAKER_API ShaderShakerResult ShaderShaker_ParseFragment(
+            ShaderShakerContext * context,
+            const char * name,
+            const char * source,
+            const size_t source_size
+            );
+
+        // Adds the fragments of an index built with --build_index, they are only parsed
+        // when used or prewarmed
+        SHADERSHAKER_API ShaderShakerResult ShaderShaker_LoadIndex( ShaderShakerContext * context, const char * path );
+
+        // Parses every deferred fragment and function body now, so that generation
+        // does not parse anything
+        SHADERSHAKER_API void ShaderShaker_Prewarm( ShaderShakerContext * context );
+
+        // Removes every fragment and cached include, the configuration is kept
+        SHADERSHAKER_API void ShaderShaker_Reset( ShaderShakerContext * context );
+
+        // The size arguments give the capacity of the code buffers. On success, they are
+        // set to the length of the zero terminated code. When a buffer is too small,
+        // its size is set to the required capacity: buffers can be null to query it.
+        SHADERSHAKER_API ShaderShakerResult ShaderShaker_GenerateShader(
+            ShaderShakerContext * context,
+            const char * const * semantic_table,
+            const size_t semantic_count,
+            const char * const * input_semantic_table,
+            const size_t input_semantic_count,
+            char * code_buffer,
+            size_t * code_size
+            );
+
+        SHADERSHAKER_API ShaderShakerResult ShaderShaker_GenerateTechnique(
+            ShaderShakerContext * context,
+            const char * const * semantic_table,
+            const size_t semantic_count,
+            const char * const * input_semantic_table,
+            const size_t input_semantic_count,
+            const char * const * interpolator_semantic_table,
+            const size_t interpolator_semantic_count,
+            char * vertex_code_buffer,
+            size_t * vertex_code_size,
+            char * pixel_code_buffer,
+            size_t * pixel_code_size
+            );
+
+        // Only checks that the semantics can be generated, without parsing or generating
+        // anything. Unsatisfiable semantics return SHADERSHAKER_GENERATION_ERROR.
+        SHADERSHAKER_API ShaderShakerResult ShaderShaker_QueryShader(
+            ShaderShakerContext * context,
+            const char * const * semantic_table,
+            const size_t semantic_count,
+            const char * const * input_semantic_table,
+            const size_t input_semantic_count
+            );
+
+        // Prints the program computing the uniforms replacing the expressions extracted
+        // by the last generation, with the same buffer convention as the generation.
+        // Returns SHADERSHAKER_GENERATION_ERROR when the last call generated no preshader.
+        SHADERSHAKER_API ShaderShakerResult ShaderShaker_GetPreshader(
+            ShaderShakerContext * context,
+            char * code_buffer,
+            size_t * code_size
+            );
+
+        // Input semantics used by the last generation or query, valid until the next call
+        SHADERSHAKER_API size_t ShaderShaker_GetUsedSemanticCount( const ShaderShakerContext * context );
+        SHADERSHAKER_API const char * ShaderShaker_GetUsedSemantic( const ShaderShakerContext * context, const size_t index );
+
+        // Errors of the last call, valid until the next call
+        SHADERSHAKER_API const char * ShaderShaker_GetLastError( const ShaderShakerContext * context );
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
\ No newline at end of file
@@ -41,6 +41,9 @@ solution "ShaderShaker"
     configuration "gmake or xcode4"
         buildoptions "-std=c++11"
 
+    configuration "linux"
+        links       { "pthread" }
+
 project "ShaderShaker"
 
     kind        "ConsoleApp"
@@ -92,6 +95,21 @@ project "Test"
     configuration "Release"
         targetdir   "bin/release"
 
+project "Benchmark"
+
+    kind "ConsoleApp"
+    targetname  "benchmark"
+    includedirs "contrib/tclap/include"
+
+    files{ "benchmark/src/**.h", "benchmark/src/**.cpp" }
+    excludes{ "src/main.cpp" }
+
+    configuration "Debug"
+        targetdir   "bin/debug"
+
+    configuration "Release"
+        targetdir   "bin/release"
+
 if _ACTION == "clean" then
     os.rmdir("bin")
     os.rmdir("build")
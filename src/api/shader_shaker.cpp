@@ -0,0 +1,739 @@
+#include <shader_shaker.h>
+
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <base/error_handler_interface.h>
+#include <generation/code_generator.h>
+#include <generation/fragment_definition.h>
+#include <generation/fragment_index.h>
+#include <generation/preshader_extractor.h>
+#include <generation/technique_generator.h>
+#include <hlsl_parser/hlsl.h>
+#include <hlsl_parser/include_cache.h>
+#include <hlsl_parser/preprocessor.h>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+
+namespace
+{
+    class ContextErrorHandler : public Base::ErrorHandlerInterface
+    {
+    public:
+
+        virtual void ReportError(
+            const std::string & message,
+            const std::string & file
+            ) override
+        {
+            m_Message += file + ": " + message + "\n";
+        }
+
+        std::string
+            m_Message;
+    };
+
+    // Sources given to ShaderShaker_ParseFragment are found before the files
+    class SourceIncludeCache : public HLSL::IncludeCache
+    {
+    public:
+
+        virtual bool ReadFile(
+            std::string & content,
+            const std::string & path
+            ) const override
+        {
+            std::map<std::string, std::string>::const_iterator
+                source = m_SourceTable.find( path );
+
+            if( source == m_SourceTable.end() )
+            {
+                return HLSL::IncludeCache::ReadFile( content, path );
+            }
+
+            content = (*source).second;
+            return true;
+        }
+
+        std::map<std::string, std::string>
+            m_SourceTable;
+    };
+
+    class ContextFragmentLoader : public Generation::FragmentLoaderInterface
+    {
+    public:
+
+        ContextFragmentLoader( HLSL::Preprocessor & preprocessor ) :
+            m_Preprocessor( preprocessor ),
+            m_IsLazy( false )
+        {
+        }
+
+        virtual Base::ObjectRef<AST::TranslationUnit> LoadTranslationUnit(
+            const std::string & path
+            ) override
+        {
+            return HLSL::ParseHLSL( path, m_Preprocessor, m_IsLazy );
+        }
+
+        virtual void GetIncludedPathTable( std::vector<std::string> & path_table ) const override
+        {
+            path_table = m_Preprocessor.GetIncludedPathTable();
+        }
+
+        virtual void GetDefineTable( std::vector<std::string> & define_table ) const override
+        {
+            m_Preprocessor.GetDefineTable( define_table );
+        }
+
+        HLSL::Preprocessor
+            & m_Preprocessor;
+        bool
+            m_IsLazy;
+    };
+
+    // Writes in a caller buffer, always keeping room for the terminating zero, and
+    // counts what did not fit
+    class BufferStreamBuffer : public std::streambuf
+    {
+    public:
+
+        BufferStreamBuffer( char * buffer, const size_t capacity ) :
+            m_Buffer( buffer ),
+            m_Capacity( buffer ? capacity : 0 ),
+            m_Size( 0 )
+        {
+        }
+
+        size_t GetSize() const { return m_Size; }
+
+    protected:
+
+        virtual int_type overflow( int_type character ) override
+        {
+            if( !traits_type::eq_int_type( character, traits_type::eof() ) )
+            {
+                const char
+                    value = traits_type::to_char_type( character );
+
+                xsputn( &value, 1 );
+            }
+
+            return traits_type::not_eof( character );
+        }
+
+        virtual std::streamsize xsputn( const char * text, std::streamsize size ) override
+        {
+            const size_t
+                text_size = static_cast<size_t>( size );
+
+            if( m_Size + 1 < m_Capacity )
+            {
+                const size_t
+                    available_size = m_Capacity - 1 - m_Size;
+
+                std::copy( text, text + ( text_size < available_size ? text_size : available_size ), m_Buffer + m_Size );
+            }
+
+            m_Size += text_size;
+
+            return size;
+        }
+
+    private:
+
+        char
+            * m_Buffer;
+        size_t
+            m_Capacity,
+            m_Size;
+    };
+
+    bool ReadSemanticTable(
+        std::vector<std::string> & semantic_table,
+        const char * const * string_table,
+        const size_t count
+        )
+    {
+        if( count > 0 && !string_table )
+        {
+            return false;
+        }
+
+        semantic_table.clear();
+        semantic_table.reserve( count );
+
+        for( size_t index = 0; index < count; ++index )
+        {
+            if( !string_table[ index ] )
+            {
+                return false;
+            }
+
+            semantic_table.push_back( string_table[ index ] );
+        }
+
+        return true;
+    }
+
+    ShaderShakerResult PrintCode(
+        char * buffer,
+        size_t * size,
+        const AST::TranslationUnit & translation_unit
+        )
+    {
+        BufferStreamBuffer
+            stream_buffer( buffer, *size );
+        std::ostream
+            stream( &stream_buffer );
+        AST::HLSLPrinter
+            printer( stream );
+
+        translation_unit.Visit( printer );
+
+        if( !buffer || stream_buffer.GetSize() >= *size )
+        {
+            *size = stream_buffer.GetSize() + 1;
+            return SHADERSHAKER_BUFFER_TOO_SMALL;
+        }
+
+        buffer[ stream_buffer.GetSize() ] = 0;
+        *size = stream_buffer.GetSize();
+
+        return SHADERSHAKER_OK;
+    }
+}
+
+struct ShaderShakerContext
+{
+    ShaderShakerContext() :
+        m_ErrorHandler( new ContextErrorHandler ),
+        m_IncludeCache( new SourceIncludeCache ),
+        m_Preprocessor( *m_IncludeCache, *m_ErrorHandler ),
+        m_Loader( new ContextFragmentLoader( m_Preprocessor ) ),
+        m_ExtractsPreshader( false )
+    {
+    }
+
+    ShaderShakerResult AddTranslationUnit( Base::ObjectRef<AST::TranslationUnit> translation_unit )
+    {
+        if( !translation_unit )
+        {
+            return SHADERSHAKER_PARSE_ERROR;
+        }
+
+        m_DefinitionTable.push_back( Generation::FragmentDefinition::GenerateFragment( *translation_unit ) );
+
+        return SHADERSHAKER_OK;
+    }
+
+    // Starts a call, clearing the results of the previous one
+    void Begin()
+    {
+        m_ErrorHandler->m_Message.clear();
+        m_UsedSemanticTable.clear();
+        m_PreshaderProgram = 0;
+    }
+
+    Base::ObjectRef<ContextErrorHandler>
+        m_ErrorHandler;
+    Base::ObjectRef<SourceIncludeCache>
+        m_IncludeCache;
+    HLSL::Preprocessor
+        m_Preprocessor;
+    Base::ObjectRef<ContextFragmentLoader>
+        m_Loader;
+    std::vector<Generation::FragmentDefinition::Ref>
+        m_DefinitionTable;
+    std::vector<std::string>
+        m_UsedSemanticTable;
+    bool
+        m_ExtractsPreshader;
+    Base::ObjectRef<AST::TranslationUnit>
+        m_PreshaderProgram;
+};
+
+namespace
+{
+    // Exceptions must not unwind through the C callers, they are reported as errors
+    ShaderShakerResult ReportException( ShaderShakerContext * context, const char * message )
+    {
+        if( context )
+        {
+            try
+            {
+                context->m_ErrorHandler->m_Message += std::string( "Internal error: " ) + message + "\n";
+            }
+            catch( ... )
+            {
+                context->m_ErrorHandler->m_Message.clear();
+            }
+        }
+
+        return SHADERSHAKER_INTERNAL_ERROR;
+    }
+}
+
+ShaderShakerContext * ShaderShaker_CreateContext( void )
+{
+    try
+    {
+        return new ShaderShakerContext;
+    }
+    // There is no context to report the error in
+    catch( ... )
+    {
+        return 0;
+    }
+}
+
+void ShaderShaker_DestroyContext( ShaderShakerContext * context )
+{
+    delete context;
+}
+
+void ShaderShaker_AddIncludePath( ShaderShakerContext * context, const char * path )
+{
+    try
+    {
+        if( context && path )
+        {
+            context->m_Preprocessor.AddIncludePath( path );
+        }
+    }
+    catch( const std::exception & exception )
+    {
+        ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        ReportException( context, "unknown exception" );
+    }
+}
+
+void ShaderShaker_Define( ShaderShakerContext * context, const char * name, const char * value )
+{
+    try
+    {
+        if( context && name )
+        {
+            context->m_Preprocessor.Define( name, value ? value : "1" );
+        }
+    }
+    catch( const std::exception & exception )
+    {
+        ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        ReportException( context, "unknown exception" );
+    }
+}
+
+void ShaderShaker_SetLazyParsing( ShaderShakerContext * context, const int is_lazy )
+{
+    if( context )
+    {
+        context->m_Loader->m_IsLazy = is_lazy != 0;
+    }
+}
+
+void ShaderShaker_SetPreshader( ShaderShakerContext * context, const int extracts_preshader )
+{
+    if( context )
+    {
+        context->m_ExtractsPreshader = extracts_preshader != 0;
+    }
+}
+
+ShaderShakerResult ShaderShaker_LoadFragment( ShaderShakerContext * context, const char * path )
+{
+    try
+    {
+        if( !context || !path )
+        {
+            return SHADERSHAKER_INVALID_ARGUMENT;
+        }
+
+        context->Begin();
+
+        return context->AddTranslationUnit( context->m_Loader->LoadTranslationUnit( path ) );
+    }
+    catch( const std::exception & exception )
+    {
+        return ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        return ReportException( context, "unknown exception" );
+    }
+}
+
+ShaderShakerResult ShaderShaker_ParseFragment(
+    ShaderShakerContext * context,
+    const char * name,
+    const char * source,
+    const size_t source_size
+    )
+{
+    try
+    {
+        if( !context || !name || ( !source && source_size > 0 ) )
+        {
+            return SHADERSHAKER_INVALID_ARGUMENT;
+        }
+
+        context->Begin();
+        context->m_IncludeCache->m_SourceTable[ HLSL::Preprocessor::NormalizePath( name ) ].assign( source, source_size );
+
+        return context->AddTranslationUnit( context->m_Loader->LoadTranslationUnit( name ) );
+    }
+    catch( const std::exception & exception )
+    {
+        return ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        return ReportException( context, "unknown exception" );
+    }
+}
+
+ShaderShakerResult ShaderShaker_LoadIndex( ShaderShakerContext * context, const char * path )
+{
+    try
+    {
+        if( !context || !path )
+        {
+            return SHADERSHAKER_INVALID_ARGUMENT;
+        }
+
+        Generation::FragmentIndex
+            index;
+        std::ifstream
+            file( path );
+        std::vector<std::string>
+            stale_path_table;
+
+        context->Begin();
+
+        if( !file )
+        {
+            context->m_ErrorHandler->ReportError( "Unable to open file", path );
+            return SHADERSHAKER_PARSE_ERROR;
+        }
+
+        if( !index.Load( file, path, *context->m_ErrorHandler )
+            || !index.CreateFragmentTable( context->m_DefinitionTable, stale_path_table, *context->m_Loader )
+            )
+        {
+            return SHADERSHAKER_PARSE_ERROR;
+        }
+
+        return SHADERSHAKER_OK;
+    }
+    catch( const std::exception & exception )
+    {
+        return ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        return ReportException( context, "unknown exception" );
+    }
+}
+
+void ShaderShaker_Prewarm( ShaderShakerContext * context )
+{
+    try
+    {
+        if( !context )
+        {
+            return;
+        }
+
+        std::vector<Generation::FragmentDefinition::Ref>::const_iterator it, end;
+
+        context->Begin();
+
+        for( it = context->m_DefinitionTable.begin(), end = context->m_DefinitionTable.end(); it != end; ++it )
+        {
+            (*it)->Prewarm();
+        }
+    }
+    catch( const std::exception & exception )
+    {
+        ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        ReportException( context, "unknown exception" );
+    }
+}
+
+void ShaderShaker_Reset( ShaderShakerContext * context )
+{
+    try
+    {
+        if( !context )
+        {
+            return;
+        }
+
+        context->Begin();
+        context->m_DefinitionTable.clear();
+        context->m_IncludeCache->m_SourceTable.clear();
+        context->m_IncludeCache->Clear();
+    }
+    catch( const std::exception & exception )
+    {
+        ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        ReportException( context, "unknown exception" );
+    }
+}
+
+ShaderShakerResult ShaderShaker_GenerateShader(
+    ShaderShakerContext * context,
+    const char * const * semantic_table,
+    const size_t semantic_count,
+    const char * const * input_semantic_table,
+    const size_t input_semantic_count,
+    char * code_buffer,
+    size_t * code_size
+    )
+{
+    try
+    {
+        std::vector<std::string>
+            semantic_vector,
+            input_semantic_vector;
+
+        if( !context || !code_size
+            || !ReadSemanticTable( semantic_vector, semantic_table, semantic_count )
+            || !ReadSemanticTable( input_semantic_vector, input_semantic_table, input_semantic_count )
+            )
+        {
+            return SHADERSHAKER_INVALID_ARGUMENT;
+        }
+
+        Generation::CodeGenerator
+            code_generator;
+        Generation::PreshaderExtractor
+            preshader_extractor;
+        Base::ObjectRef<AST::TranslationUnit>
+            generated_code;
+
+        context->Begin();
+
+        code_generator.SetPreshaderExtractor( context->m_ExtractsPreshader ? &preshader_extractor : 0 );
+        code_generator.GenerateShader(
+            generated_code,
+            context->m_UsedSemanticTable,
+            context->m_DefinitionTable,
+            semantic_vector,
+            input_semantic_vector,
+            *context->m_ErrorHandler
+            );
+
+        if( !generated_code )
+        {
+            return SHADERSHAKER_GENERATION_ERROR;
+        }
+
+        if( context->m_ExtractsPreshader )
+        {
+            context->m_PreshaderProgram = preshader_extractor.CreateEvaluationProgram();
+        }
+
+        return PrintCode( code_buffer, code_size, *generated_code );
+    }
+    catch( const std::exception & exception )
+    {
+        return ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        return ReportException( context, "unknown exception" );
+    }
+}
+
+ShaderShakerResult ShaderShaker_GenerateTechnique(
+    ShaderShakerContext * context,
+    const char * const * semantic_table,
+    const size_t semantic_count,
+    const char * const * input_semantic_table,
+    const size_t input_semantic_count,
+    const char * const * interpolator_semantic_table,
+    const size_t interpolator_semantic_count,
+    char * vertex_code_buffer,
+    size_t * vertex_code_size,
+    char * pixel_code_buffer,
+    size_t * pixel_code_size
+    )
+{
+    try
+    {
+        std::vector<std::string>
+            semantic_vector,
+            input_semantic_vector,
+            interpolator_semantic_vector;
+
+        if( !context || !vertex_code_size || !pixel_code_size
+            || !ReadSemanticTable( semantic_vector, semantic_table, semantic_count )
+            || !ReadSemanticTable( input_semantic_vector, input_semantic_table, input_semantic_count )
+            || !ReadSemanticTable( interpolator_semantic_vector, interpolator_semantic_table, interpolator_semantic_count )
+            )
+        {
+            return SHADERSHAKER_INVALID_ARGUMENT;
+        }
+
+        Generation::TechniqueGenerator
+            generator;
+        Generation::PreshaderExtractor
+            preshader_extractor;
+        Base::ObjectRef<AST::TranslationUnit>
+            vertex_code,
+            pixel_code;
+
+        context->Begin();
+
+        generator.SetOutputSemanticTable( semantic_vector );
+        generator.SetInputSemanticTable( input_semantic_vector );
+        generator.SetInterpolatorSemanticTable( interpolator_semantic_vector );
+        generator.SetPreshaderExtractor( context->m_ExtractsPreshader ? &preshader_extractor : 0 );
+
+        if( !generator.Generate( vertex_code, pixel_code, context->m_UsedSemanticTable, context->m_DefinitionTable, *context->m_ErrorHandler ) )
+        {
+            return SHADERSHAKER_GENERATION_ERROR;
+        }
+
+        if( context->m_ExtractsPreshader )
+        {
+            context->m_PreshaderProgram = preshader_extractor.CreateEvaluationProgram();
+        }
+
+        // Both sizes are always set, so one call is enough to query them
+        const ShaderShakerResult
+            vertex_result = PrintCode( vertex_code_buffer, vertex_code_size, *vertex_code ),
+            pixel_result = PrintCode( pixel_code_buffer, pixel_code_size, *pixel_code );
+
+        return vertex_result != SHADERSHAKER_OK ? vertex_result : pixel_result;
+    }
+    catch( const std::exception & exception )
+    {
+        return ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        return ReportException( context, "unknown exception" );
+    }
+}
+
+ShaderShakerResult ShaderShaker_QueryShader(
+    ShaderShakerContext * context,
+    const char * const * semantic_table,
+    const size_t semantic_count,
+    const char * const * input_semantic_table,
+    const size_t input_semantic_count
+    )
+{
+    try
+    {
+        std::vector<std::string>
+            semantic_vector,
+            input_semantic_vector;
+
+        if( !context
+            || !ReadSemanticTable( semantic_vector, semantic_table, semantic_count )
+            || !ReadSemanticTable( input_semantic_vector, input_semantic_table, input_semantic_count )
+            )
+        {
+            return SHADERSHAKER_INVALID_ARGUMENT;
+        }
+
+        Generation::CodeGenerator
+            code_generator;
+        std::vector<Generation::FunctionDefinition::Ref>
+            function_table;
+
+        context->Begin();
+
+        if( !code_generator.QueryShader(
+                context->m_UsedSemanticTable,
+                function_table,
+                context->m_DefinitionTable,
+                semantic_vector,
+                input_semantic_vector,
+                *context->m_ErrorHandler
+                )
+            )
+        {
+            return SHADERSHAKER_GENERATION_ERROR;
+        }
+
+        return SHADERSHAKER_OK;
+    }
+    catch( const std::exception & exception )
+    {
+        return ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        return ReportException( context, "unknown exception" );
+    }
+}
+
+ShaderShakerResult ShaderShaker_GetPreshader(
+    ShaderShakerContext * context,
+    char * code_buffer,
+    size_t * code_size
+    )
+{
+    try
+    {
+        if( !context || !code_size )
+        {
+            return SHADERSHAKER_INVALID_ARGUMENT;
+        }
+
+        if( !context->m_PreshaderProgram )
+        {
+            return SHADERSHAKER_GENERATION_ERROR;
+        }
+
+        return PrintCode( code_buffer, code_size, *context->m_PreshaderProgram );
+    }
+    catch( const std::exception & exception )
+    {
+        return ReportException( context, exception.what() );
+    }
+    catch( ... )
+    {
+        return ReportException( context, "unknown exception" );
+    }
+}
+
+size_t ShaderShaker_GetUsedSemanticCount( const ShaderShakerContext * context )
+{
+    return context ? context->m_UsedSemanticTable.size() : 0;
+}
+
+const char * ShaderShaker_GetUsedSemantic( const ShaderShakerContext * context, const size_t index )
+{
+    if( !context || index >= context->m_UsedSemanticTable.size() )
+    {
+        return 0;
+    }
+
+    return context->m_UsedSemanticTable[ index ].c_str();
+}
+
+const char * ShaderShaker_GetLastError( const ShaderShakerContext * context )
+{
+    return context ? context->m_ErrorHandler->m_Message.c_str() : "";
+}
\ No newline at end of file
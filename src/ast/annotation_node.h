@@ -10,6 +10,8 @@
         {
             AST_HandleVisitor()
 
+            Annotations() : Node( NodeKind_Annotations ) {}
+
             typedef std::vector< Base::ObjectRef< AnnotationEntry> > AnnotationTableType;
 
             void AddEntry( AnnotationEntry * entry ) { m_AnnotationTable.emplace_back( entry ); }
@@ -24,8 +26,9 @@
         {
             AST_HandleVisitor()
 
-            AnnotationEntry() {}
+            AnnotationEntry() : Node( NodeKind_AnnotationEntry ) {}
             AnnotationEntry( const std::string & type, const std::string & name, const std::string & value ) :
+                Node( NodeKind_AnnotationEntry ),
                 m_Type( type ), m_Name( name ), m_Value( value ) {}
 
             virtual AnnotationEntry * Clone() const override;
@@ -20,6 +20,8 @@
 
         struct Expression : Node
         {
+            explicit Expression( const NodeKind kind ) : Node( kind ) {}
+
             virtual Expression * Clone() const override { return 0; }
 
         };
@@ -28,6 +30,8 @@
         {
             AST_HandleVisitor()
 
+            ConditionalExpression() : Expression( NodeKind_ConditionalExpression ) {}
+
             virtual ConditionalExpression * Clone() const override;
 
             Base::ObjectRef<Expression> m_Condition;
@@ -61,12 +65,13 @@
                 Modulo,
             };
 
-            BinaryOperationExpression() {}
+            BinaryOperationExpression() : Expression( NodeKind_BinaryOperationExpression ) {}
             BinaryOperationExpression(
                 Operation operation,
                 Expression * left_expression,
                 Expression * right_expression
                 ) :
+                Expression( NodeKind_BinaryOperationExpression ),
                 m_Operation( operation ),
                 m_LeftExpression( left_expression ),
                 m_RightExpression( right_expression )
@@ -98,11 +103,12 @@
                 BitwiseNot
             };
 
-            UnaryOperationExpression() {}
+            UnaryOperationExpression() : Expression( NodeKind_UnaryOperationExpression ) {}
             UnaryOperationExpression(
                 Operation operation,
                 Expression * expression
                 ) :
+                Expression( NodeKind_UnaryOperationExpression ),
                 m_Operation( operation ),
                 m_Expression( expression )
             {}
@@ -124,12 +130,13 @@
         struct CastExpression: Expression
         {
             AST_HandleVisitor()
-            CastExpression() {}
+            CastExpression() : Expression( NodeKind_CastExpression ) {}
             CastExpression(
                 Type * type,
                 int array_size,
                 Expression * expression
                 ) :
+                Expression( NodeKind_CastExpression ),
                 m_Type( type ),
                 m_ArraySize( array_size ),
                 m_Expression( expression )
@@ -158,8 +165,8 @@
                 Bool
             };
 
-            LiteralExpression(){}
-            LiteralExpression( Type type, const std::string & value ) : m_Type( type ), m_Value( value )
+            LiteralExpression() : Expression( NodeKind_LiteralExpression ){}
+            LiteralExpression( Type type, const std::string & value ) : Expression( NodeKind_LiteralExpression ), m_Type( type ), m_Value( value )
             {
 
             }
@@ -176,8 +183,8 @@
         {
             AST_HandleVisitor()
 
-            VariableExpression() {}
-            VariableExpression( const std::string & name ) : m_Name( name ){}
+            VariableExpression() : Expression( NodeKind_VariableExpression ) {}
+            VariableExpression( const std::string & name ) : Expression( NodeKind_VariableExpression ), m_Name( name ){}
 
             virtual VariableExpression * Clone() const override;
 
@@ -190,8 +197,8 @@
         struct PostfixExpression : Expression
         {
             AST_HandleVisitor()
-            PostfixExpression() {}
-            PostfixExpression( Expression *expression, PostfixSuffix * suffix ) : m_Expression( expression ), m_Suffix( suffix ){}
+            PostfixExpression() : Expression( NodeKind_PostfixExpression ) {}
+            PostfixExpression( Expression *expression, PostfixSuffix * suffix ) : Expression( NodeKind_PostfixExpression ), m_Expression( expression ), m_Suffix( suffix ){}
 
             virtual PostfixExpression * Clone() const override;
 
@@ -205,6 +212,8 @@
         {
             AST_HandleVisitor()
 
+            ArgumentExpressionList() : Node( NodeKind_ArgumentExpressionList ) {}
+
             void AddExpression( Expression * expression ){ m_ExpressionList.emplace_back( expression ); }
 
             virtual ArgumentExpressionList * Clone() const override;
@@ -217,8 +226,8 @@
         {
             AST_HandleVisitor()
 
-            CallExpression(){}
-            CallExpression( const std::string & name, ArgumentExpressionList * list ) : m_Name( name ), m_ArgumentExpressionList( list ) {}
+            CallExpression() : Expression( NodeKind_CallExpression ){}
+            CallExpression( const std::string & name, ArgumentExpressionList * list ) : Expression( NodeKind_CallExpression ), m_Name( name ), m_ArgumentExpressionList( list ) {}
 
             virtual CallExpression * Clone() const override;
 
@@ -233,8 +242,8 @@
         {
             AST_HandleVisitor()
 
-            ConstructorExpression() {}
-            ConstructorExpression( Type * type, ArgumentExpressionList * list ) : m_Type( type ), m_ArgumentExpressionList( list ) {}
+            ConstructorExpression() : Expression( NodeKind_ConstructorExpression ) {}
+            ConstructorExpression( Type * type, ArgumentExpressionList * list ) : Expression( NodeKind_ConstructorExpression ), m_Type( type ), m_ArgumentExpressionList( list ) {}
 
             virtual ConstructorExpression * Clone() const override;
 
@@ -246,14 +255,16 @@
 
         struct PostfixSuffix : Node
         {
+            explicit PostfixSuffix( const NodeKind kind ) : Node( kind ) {}
+
             virtual PostfixSuffix * Clone() const override { return 0; }
         };
 
         struct Swizzle : PostfixSuffix
         {
             AST_HandleVisitor()
-            Swizzle(){}
-            Swizzle( const std::string & swizzle ) : m_Swizzle( swizzle ) {}
+            Swizzle() : PostfixSuffix( NodeKind_Swizzle ){}
+            Swizzle( const std::string & swizzle ) : PostfixSuffix( NodeKind_Swizzle ), m_Swizzle( swizzle ) {}
 
             virtual Swizzle * Clone() const override;
 
@@ -265,8 +276,8 @@
         {
             AST_HandleVisitor()
 
-            PostfixSuffixCall(){}
-            PostfixSuffixCall( CallExpression * call, PostfixSuffix * suffix ) : m_CallExpression( call ), m_Suffix( suffix ) {}
+            PostfixSuffixCall() : PostfixSuffix( NodeKind_PostfixSuffixCall ){}
+            PostfixSuffixCall( CallExpression * call, PostfixSuffix * suffix ) : PostfixSuffix( NodeKind_PostfixSuffixCall ), m_CallExpression( call ), m_Suffix( suffix ) {}
 
             virtual PostfixSuffixCall * Clone() const override;
 
@@ -280,9 +291,9 @@
         {
             AST_HandleVisitor()
 
-            PostfixSuffixVariable() {}
+            PostfixSuffixVariable() : PostfixSuffix( NodeKind_PostfixSuffixVariable ) {}
             PostfixSuffixVariable( VariableExpression * variable, PostfixSuffix * suffix )
-                : m_VariableExpression( variable ), m_Suffix( suffix ) {}
+                : PostfixSuffix( NodeKind_PostfixSuffixVariable ), m_VariableExpression( variable ), m_Suffix( suffix ) {}
 
             virtual PostfixSuffixVariable * Clone() const override;
 
@@ -296,9 +307,9 @@
         {
             AST_HandleVisitor()
 
-            LValueExpression() {}
+            LValueExpression() : Expression( NodeKind_LValueExpression ) {}
             LValueExpression( VariableExpression * variable, PostfixSuffix * suffix = 0 )
-                : m_VariableExpression( variable ), m_Suffix( suffix ) {}
+                : Expression( NodeKind_LValueExpression ), m_VariableExpression( variable ), m_Suffix( suffix ) {}
 
             virtual LValueExpression * Clone() const override;
 
@@ -312,8 +323,8 @@
         {
             AST_HandleVisitor()
 
-            PreModifyExpression() {}
-            PreModifyExpression( const SelfModifyOperator op, LValueExpression * expression ) : m_Operator( op ), m_Expression( expression ) {}
+            PreModifyExpression() : Expression( NodeKind_PreModifyExpression ) {}
+            PreModifyExpression( const SelfModifyOperator op, LValueExpression * expression ) : Expression( NodeKind_PreModifyExpression ), m_Operator( op ), m_Expression( expression ) {}
 
             virtual PreModifyExpression * Clone() const override;
 
@@ -327,8 +338,8 @@
         {
             AST_HandleVisitor()
 
-            PostModifyExpression() {}
-            PostModifyExpression( const SelfModifyOperator op, LValueExpression * expression ) : m_Operator( op ), m_Expression( expression ) {}
+            PostModifyExpression() : Expression( NodeKind_PostModifyExpression ) {}
+            PostModifyExpression( const SelfModifyOperator op, LValueExpression * expression ) : Expression( NodeKind_PostModifyExpression ), m_Operator( op ), m_Expression( expression ) {}
 
             virtual PostModifyExpression * Clone() const override;
 
@@ -347,8 +358,9 @@
         {
             AST_HandleVisitor()
 
-            AssignmentExpression() {}
+            AssignmentExpression() : Expression( NodeKind_AssignmentExpression ) {}
             AssignmentExpression( LValueExpression * lvexp, AssignmentOperator op, Expression * exp ) :
+                Expression( NodeKind_AssignmentExpression ),
                 m_LValueExpression( lvexp ), m_Operator( op ), m_Expression( exp )
             {
 
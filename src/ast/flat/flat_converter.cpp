@@ -0,0 +1,1268 @@
+#include "flat_converter.h"
+
+#include <cassert>
+#include <map>
+#include <ast/node.h>
+
+namespace AST
+{
+    namespace
+    {
+        class FlatBuilder : public ConstVisitor
+        {
+        public:
+
+            FlatBuilder( FlatTranslationUnit & flat_unit ) :
+                m_Unit( flat_unit ),
+                m_Result( FlatTranslationUnit::InvalidIndex )
+            {
+            }
+
+            virtual void Visit( const Node & node ) override
+            {
+                // Types created by the generator have no visitor
+                if( node.m_Kind == NodeKind_Type )
+                {
+                    AddType( static_cast<const Type &>( node ), NodeKind_Type );
+                    return;
+                }
+
+                assert( !"Unsupported node type" );
+            }
+
+            virtual void Visit( const TranslationUnit & translation_unit ) override
+            {
+                uint32_t
+                    index = Create( translation_unit, NodeKind_TranslationUnit );
+                std::vector<uint32_t>
+                    item_table;
+
+                AddTable( item_table, translation_unit.m_GlobalDeclarationTable );
+
+                std::vector< Base::ObjectRef<Technique> >::const_iterator it, end;
+
+                for( it = translation_unit.m_TechniqueTable.begin(), end = translation_unit.m_TechniqueTable.end(); it != end; ++it )
+                {
+                    item_table.push_back( AddTechnique( **it ) );
+                }
+
+                m_Unit.SetList( index, item_table );
+                m_Result = index;
+            }
+
+            virtual void Visit( const VariableDeclaration & declaration ) override
+            {
+                uint32_t
+                    index = Create( declaration, NodeKind_VariableDeclaration );
+
+                AddVariableDeclaration( index, declaration.m_Type, declaration.m_StorageClass, declaration.m_TypeModifier, declaration.m_BodyTable );
+            }
+
+            virtual void Visit( const IntrinsicType & type ) override
+            {
+                AddType( type, NodeKind_IntrinsicType );
+            }
+
+            virtual void Visit( const UserDefinedType & type ) override
+            {
+                AddType( type, NodeKind_UserDefinedType );
+            }
+
+            virtual void Visit( const SamplerType & type ) override
+            {
+                AddType( type, NodeKind_SamplerType );
+            }
+
+            virtual void Visit( const TypeModifier & modifier ) override
+            {
+                uint32_t
+                    index = Create( modifier, NodeKind_TypeModifier );
+
+                SetString( index, FlatNode::String_Value, modifier.m_Value );
+            }
+
+            virtual void Visit( const StorageClass & storage_class ) override
+            {
+                uint32_t
+                    index = Create( storage_class, NodeKind_StorageClass );
+
+                SetString( index, FlatNode::String_Value, storage_class.m_Value );
+            }
+
+            virtual void Visit( const VariableDeclarationBody & body ) override
+            {
+                uint32_t
+                    index = Create( body, NodeKind_VariableDeclarationBody );
+
+                SetString( index, FlatNode::String_Name, body.m_Name );
+                SetString( index, FlatNode::String_Semantic, body.m_Semantic );
+                m_Unit.GetNode( index ).m_Value = body.m_ArraySize;
+                SetChildren( index, Add( body.m_InitialValue ), Add( body.m_Annotations ) );
+            }
+
+            virtual void Visit( const InitialValue & initial_value ) override
+            {
+                uint32_t
+                    index = Create( initial_value, NodeKind_InitialValue );
+
+                m_Unit.GetNode( index ).m_Operator = initial_value.m_Vector;
+                AddList( index, initial_value.m_ExpressionTable );
+            }
+
+            virtual void Visit( const Annotations & annotations ) override
+            {
+                uint32_t
+                    index = Create( annotations, NodeKind_Annotations );
+
+                AddList( index, annotations.m_AnnotationTable );
+            }
+
+            virtual void Visit( const AnnotationEntry & annotation_entry ) override
+            {
+                uint32_t
+                    index = Create( annotation_entry, NodeKind_AnnotationEntry );
+
+                SetString( index, FlatNode::String_Name, annotation_entry.m_Name );
+                SetString( index, FlatNode::String_Type, annotation_entry.m_Type );
+                SetString( index, FlatNode::String_Value, annotation_entry.m_Value );
+            }
+
+            virtual void Visit( const TextureDeclaration & declaration ) override
+            {
+                uint32_t
+                    index = Create( declaration, NodeKind_TextureDeclaration );
+
+                SetString( index, FlatNode::String_Name, declaration.m_Name );
+                SetString( index, FlatNode::String_Semantic, declaration.m_Semantic );
+                SetString( index, FlatNode::String_Type, declaration.m_Type );
+                SetChildren( index, Add( declaration.m_Annotations ) );
+            }
+
+            virtual void Visit( const SamplerDeclaration & declaration ) override
+            {
+                uint32_t
+                    index = Create( declaration, NodeKind_SamplerDeclaration );
+
+                SetString( index, FlatNode::String_Name, declaration.m_Name );
+                SetString( index, FlatNode::String_Type, declaration.m_Type );
+                AddList( index, declaration.m_BodyTable );
+            }
+
+            virtual void Visit( const SamplerBody & body ) override
+            {
+                uint32_t
+                    index = Create( body, NodeKind_SamplerBody );
+
+                SetString( index, FlatNode::String_Name, body.m_Name );
+                SetString( index, FlatNode::String_Value, body.m_Value );
+            }
+
+            virtual void Visit( const StructDefinition & definition ) override
+            {
+                uint32_t
+                    index = Create( definition, NodeKind_StructDefinition );
+                std::vector<uint32_t>
+                    item_table;
+                std::vector<StructDefinition::Member>::const_iterator it, end;
+
+                SetString( index, FlatNode::String_Name, definition.m_Name );
+
+                for( it = definition.m_MemberTable.begin(), end = definition.m_MemberTable.end(); it != end; ++it )
+                {
+                    uint32_t
+                        member_index = Create( definition, NodeKind_StructMember );
+
+                    SetString( member_index, FlatNode::String_Name, (*it).m_Name );
+                    SetString( member_index, FlatNode::String_Semantic, (*it).m_Semantic );
+                    SetString( member_index, FlatNode::String_InterpolationModifier, (*it).m_InterpolationModifier );
+                    SetChildren( member_index, Add( (*it).m_Type ) );
+
+                    item_table.push_back( member_index );
+                }
+
+                m_Unit.SetList( index, item_table );
+                m_Result = index;
+            }
+
+            virtual void Visit( const FunctionDeclaration & declaration ) override
+            {
+                uint32_t
+                    index = Create( declaration, NodeKind_FunctionDeclaration );
+                std::vector<uint32_t>
+                    item_table;
+
+                SetString( index, FlatNode::String_Name, declaration.m_Name );
+                SetString( index, FlatNode::String_Semantic, declaration.m_Semantic );
+
+                declaration.ResolveBody();
+
+                AddTable( item_table, declaration.m_StorageClassTable );
+                AddTable( item_table, declaration.m_StatementTable );
+                m_Unit.SetList( index, item_table );
+
+                SetChildren( index, Add( declaration.m_Type ), Add( declaration.m_ArgumentList ) );
+            }
+
+            virtual void Visit( const ArgumentList & list ) override
+            {
+                uint32_t
+                    index = Create( list, NodeKind_ArgumentList );
+
+                AddList( index, list.m_ArgumentTable );
+            }
+
+            virtual void Visit( const Argument & argument ) override
+            {
+                uint32_t
+                    index = Create( argument, NodeKind_Argument );
+
+                SetString( index, FlatNode::String_Name, argument.m_Name );
+                SetString( index, FlatNode::String_Semantic, argument.m_Semantic );
+                SetString( index, FlatNode::String_InputModifier, argument.m_InputModifier );
+                SetString( index, FlatNode::String_InterpolationModifier, argument.m_InterpolationModifier );
+                SetChildren( index, Add( argument.m_Type ), Add( argument.m_TypeModifier ), Add( argument.m_InitialValue ) );
+            }
+
+            virtual void Visit( const LiteralExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_LiteralExpression );
+
+                SetString( index, FlatNode::String_Value, expression.m_Value );
+                m_Unit.GetNode( index ).m_Operator = static_cast<int16_t>( expression.m_Type );
+            }
+
+            virtual void Visit( const VariableExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_VariableExpression );
+
+                SetString( index, FlatNode::String_Name, expression.m_Name );
+                SetChildren( index, Add( expression.m_SubscriptExpression ) );
+            }
+
+            virtual void Visit( const UnaryOperationExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_UnaryOperationExpression );
+
+                m_Unit.GetNode( index ).m_Operator = static_cast<int16_t>( expression.m_Operation );
+                SetChildren( index, Add( expression.m_Expression ) );
+            }
+
+            virtual void Visit( const BinaryOperationExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_BinaryOperationExpression );
+
+                m_Unit.GetNode( index ).m_Operator = static_cast<int16_t>( expression.m_Operation );
+                SetChildren( index, Add( expression.m_LeftExpression ), Add( expression.m_RightExpression ) );
+            }
+
+            virtual void Visit( const CallExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_CallExpression );
+
+                SetString( index, FlatNode::String_Name, expression.m_Name );
+                SetChildren( index, Add( expression.m_ArgumentExpressionList ) );
+            }
+
+            virtual void Visit( const ArgumentExpressionList & list ) override
+            {
+                uint32_t
+                    index = Create( list, NodeKind_ArgumentExpressionList );
+
+                AddList( index, list.m_ExpressionList );
+            }
+
+            virtual void Visit( const Swizzle & swizzle ) override
+            {
+                uint32_t
+                    index = Create( swizzle, NodeKind_Swizzle );
+
+                SetString( index, FlatNode::String_Value, swizzle.m_Swizzle );
+            }
+
+            virtual void Visit( const PostfixSuffixCall & postfix_suffix ) override
+            {
+                uint32_t
+                    index = Create( postfix_suffix, NodeKind_PostfixSuffixCall );
+
+                SetChildren( index, Add( postfix_suffix.m_CallExpression ), Add( postfix_suffix.m_Suffix ) );
+            }
+
+            virtual void Visit( const PostfixSuffixVariable & postfix_suffix ) override
+            {
+                uint32_t
+                    index = Create( postfix_suffix, NodeKind_PostfixSuffixVariable );
+
+                SetChildren( index, Add( postfix_suffix.m_VariableExpression ), Add( postfix_suffix.m_Suffix ) );
+            }
+
+            virtual void Visit( const ConstructorExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_ConstructorExpression );
+
+                SetChildren( index, Add( expression.m_Type ), Add( expression.m_ArgumentExpressionList ) );
+            }
+
+            virtual void Visit( const ConditionalExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_ConditionalExpression );
+
+                SetChildren( index, Add( expression.m_Condition ), Add( expression.m_IfTrue ), Add( expression.m_IfFalse ) );
+            }
+
+            virtual void Visit( const LValueExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_LValueExpression );
+
+                SetChildren( index, Add( expression.m_VariableExpression ), Add( expression.m_Suffix ) );
+            }
+
+            virtual void Visit( const PreModifyExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_PreModifyExpression );
+
+                m_Unit.GetNode( index ).m_Operator = static_cast<int16_t>( expression.m_Operator );
+                SetChildren( index, Add( expression.m_Expression ) );
+            }
+
+            virtual void Visit( const PostModifyExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_PostModifyExpression );
+
+                m_Unit.GetNode( index ).m_Operator = static_cast<int16_t>( expression.m_Operator );
+                SetChildren( index, Add( expression.m_Expression ) );
+            }
+
+            virtual void Visit( const CastExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_CastExpression );
+
+                m_Unit.GetNode( index ).m_Value = expression.m_ArraySize;
+                SetChildren( index, Add( expression.m_Type ), Add( expression.m_Expression ) );
+            }
+
+            virtual void Visit( const AssignmentExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_AssignmentExpression );
+
+                m_Unit.GetNode( index ).m_Operator = static_cast<int16_t>( expression.m_Operator );
+                SetChildren( index, Add( expression.m_LValueExpression ), Add( expression.m_Expression ) );
+            }
+
+            virtual void Visit( const PostfixExpression & expression ) override
+            {
+                uint32_t
+                    index = Create( expression, NodeKind_PostfixExpression );
+
+                SetChildren( index, Add( expression.m_Expression ), Add( expression.m_Suffix ) );
+            }
+
+            virtual void Visit( const ReturnStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_ReturnStatement );
+
+                SetChildren( index, Add( statement.m_Expression ) );
+            }
+
+            virtual void Visit( const BreakStatement & statement ) override
+            {
+                Create( statement, NodeKind_BreakStatement );
+            }
+
+            virtual void Visit( const ContinueStatement & statement ) override
+            {
+                Create( statement, NodeKind_ContinueStatement );
+            }
+
+            virtual void Visit( const DiscardStatement & statement ) override
+            {
+                Create( statement, NodeKind_DiscardStatement );
+            }
+
+            virtual void Visit( const EmptyStatement & statement ) override
+            {
+                Create( statement, NodeKind_EmptyStatement );
+            }
+
+            virtual void Visit( const ExpressionStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_ExpressionStatement );
+
+                SetChildren( index, Add( statement.m_Expression ) );
+            }
+
+            virtual void Visit( const IfStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_IfStatement );
+
+                SetChildren( index, Add( statement.m_Condition ), Add( statement.m_ThenStatement ), Add( statement.m_ElseStatement ) );
+            }
+
+            virtual void Visit( const WhileStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_WhileStatement );
+
+                SetChildren( index, Add( statement.m_Condition ), Add( statement.m_Statement ) );
+            }
+
+            virtual void Visit( const DoWhileStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_DoWhileStatement );
+
+                SetChildren( index, Add( statement.m_Condition ), Add( statement.m_Statement ) );
+            }
+
+            virtual void Visit( const ForStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_ForStatement );
+
+                SetChildren(
+                    index,
+                    Add( statement.m_InitStatement ),
+                    Add( statement.m_EqualityExpression ),
+                    Add( statement.m_ModifyExpression ),
+                    Add( statement.m_Statement )
+                    );
+            }
+
+            virtual void Visit( const BlockStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_BlockStatement );
+
+                AddList( index, statement.m_StatementTable );
+            }
+
+            virtual void Visit( const AssignmentStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_AssignmentStatement );
+
+                SetChildren( index, Add( statement.m_Expression ) );
+            }
+
+            virtual void Visit( const VariableDeclarationStatement & statement ) override
+            {
+                uint32_t
+                    index = Create( statement, NodeKind_VariableDeclarationStatement );
+
+                AddVariableDeclaration( index, statement.m_Type, statement.m_StorageClass, statement.m_TypeModifier, statement.m_BodyTable );
+            }
+
+        private:
+
+            FlatBuilder & operator =( const FlatBuilder & );
+
+            uint32_t Create( const Node & node, const NodeKind kind )
+            {
+                m_Result = m_Unit.AddNode( kind, node.m_Location );
+
+                return m_Result;
+            }
+
+            template< typename _Node_ >
+            uint32_t Add( const Base::ObjectRef<_Node_> & node )
+            {
+                if( !node )
+                {
+                    return FlatTranslationUnit::InvalidIndex;
+                }
+
+                node->Visit( *this );
+
+                return m_Result;
+            }
+
+            template< class _Table_ >
+            void AddTable( std::vector<uint32_t> & item_table, const _Table_ & table )
+            {
+                typename _Table_::const_iterator it, end;
+
+                for( it = table.begin(), end = table.end(); it != end; ++it )
+                {
+                    item_table.push_back( Add( *it ) );
+                }
+            }
+
+            template< class _Table_ >
+            void AddList( const uint32_t index, const _Table_ & table )
+            {
+                std::vector<uint32_t>
+                    item_table;
+
+                AddTable( item_table, table );
+                m_Unit.SetList( index, item_table );
+                m_Result = index;
+            }
+
+            void SetChildren(
+                const uint32_t index,
+                const uint32_t first,
+                const uint32_t second = FlatTranslationUnit::InvalidIndex,
+                const uint32_t third = FlatTranslationUnit::InvalidIndex,
+                const uint32_t fourth = FlatTranslationUnit::InvalidIndex
+                )
+            {
+                FlatNode
+                    & node = m_Unit.GetNode( index );
+
+                node.m_Child[ 0 ] = first;
+                node.m_Child[ 1 ] = second;
+                node.m_Child[ 2 ] = third;
+                node.m_Child[ 3 ] = fourth;
+                m_Result = index;
+            }
+
+            void SetString( const uint32_t index, const int slot, const std::string & value )
+            {
+                std::map<std::string, uint32_t>::const_iterator
+                    it = m_StringTable.find( value );
+                uint32_t
+                    offset;
+
+                if( it != m_StringTable.end() )
+                {
+                    offset = (*it).second;
+                }
+                else
+                {
+                    offset = m_Unit.AddString( value );
+                    m_StringTable[ value ] = offset;
+                }
+
+                m_Unit.GetNode( index ).m_String[ slot ] = offset;
+            }
+
+            void AddType( const Type & type, const NodeKind kind )
+            {
+                uint32_t
+                    index = Create( type, kind );
+
+                SetString( index, FlatNode::String_Name, type.m_Name );
+            }
+
+            void AddVariableDeclaration(
+                const uint32_t index,
+                const Base::ObjectRef<Type> & type,
+                const std::vector< Base::ObjectRef<StorageClass> > & storage_class_table,
+                const std::vector< Base::ObjectRef<TypeModifier> > & type_modifier_table,
+                const std::vector< Base::ObjectRef<VariableDeclarationBody> > & body_table
+                )
+            {
+                std::vector<uint32_t>
+                    item_table;
+
+                AddTable( item_table, storage_class_table );
+                AddTable( item_table, type_modifier_table );
+                AddTable( item_table, body_table );
+                m_Unit.SetList( index, item_table );
+
+                SetChildren( index, Add( type ) );
+            }
+
+            uint32_t AddTechnique( const Technique & technique )
+            {
+                uint32_t
+                    index = Create( technique, NodeKind_Technique );
+                std::vector<uint32_t>
+                    pass_table;
+                std::vector< Base::ObjectRef<Pass> >::const_iterator it, end;
+
+                SetString( index, FlatNode::String_Name, technique.m_Name );
+
+                for( it = technique.m_PassTable.begin(), end = technique.m_PassTable.end(); it != end; ++it )
+                {
+                    pass_table.push_back( AddPass( **it ) );
+                }
+
+                m_Unit.SetList( index, pass_table );
+
+                return index;
+            }
+
+            uint32_t AddPass( const Pass & pass )
+            {
+                uint32_t
+                    index = Create( pass, NodeKind_Pass );
+                std::vector<uint32_t>
+                    definition_table;
+                std::vector< Base::ObjectRef<ShaderDefinition> >::const_iterator it, end;
+
+                SetString( index, FlatNode::String_Name, pass.m_Name );
+
+                for( it = pass.m_ShaderDefinitionTable.begin(), end = pass.m_ShaderDefinitionTable.end(); it != end; ++it )
+                {
+                    uint32_t
+                        definition_index = Create( **it, NodeKind_ShaderDefinition ),
+                        list_index = FlatTranslationUnit::InvalidIndex;
+
+                    SetString( definition_index, FlatNode::String_Name, (*it)->m_Name );
+                    m_Unit.GetNode( definition_index ).m_Operator = static_cast<int16_t>( (*it)->m_Type );
+
+                    if( (*it)->m_List )
+                    {
+                        list_index = Create( *(*it)->m_List, NodeKind_ShaderArgumentList );
+                        AddList( list_index, (*it)->m_List->m_ShaderArgumentTable );
+                    }
+
+                    SetChildren( definition_index, list_index );
+                    definition_table.push_back( definition_index );
+                }
+
+                m_Unit.SetList( index, definition_table );
+
+                return index;
+            }
+
+            FlatTranslationUnit
+                & m_Unit;
+            uint32_t
+                m_Result;
+            std::map<std::string, uint32_t>
+                m_StringTable;
+        };
+
+        class TreeBuilder
+        {
+        public:
+
+            TreeBuilder( const FlatTranslationUnit & flat_unit ) : m_Unit( flat_unit ) {}
+
+            Node * Create( const uint32_t index ) const
+            {
+                if( index == FlatTranslationUnit::InvalidIndex )
+                {
+                    return 0;
+                }
+
+                const FlatNode
+                    & node = m_Unit.GetNode( index );
+
+                // Nodes take their location from the debug info when constructed
+                Node::SetDebugInfo( node.m_Location );
+
+                switch( node.m_Kind )
+                {
+                    case NodeKind_TranslationUnit:
+                    {
+                        TranslationUnit * translation_unit = new TranslationUnit;
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            if( m_Unit.GetNode( *it ).m_Kind == NodeKind_Technique )
+                            {
+                                translation_unit->AddTechnique( CreateTechnique( *it ) );
+                            }
+                            else
+                            {
+                                translation_unit->AddGlobalDeclaration( CreateAs<GlobalDeclaration>( *it ) );
+                            }
+                        }
+
+                        return translation_unit;
+                    }
+
+                    case NodeKind_VariableDeclaration:
+                    {
+                        VariableDeclaration * declaration = new VariableDeclaration;
+
+                        FillVariableDeclaration( *declaration, node );
+
+                        return declaration;
+                    }
+
+                    case NodeKind_TextureDeclaration:
+                    {
+                        TextureDeclaration * declaration = new TextureDeclaration(
+                            GetString( node, FlatNode::String_Type ),
+                            GetString( node, FlatNode::String_Name ),
+                            GetString( node, FlatNode::String_Semantic ),
+                            0
+                            );
+
+                        declaration->m_Annotations = CreateAs<Annotations>( node.m_Child[ 0 ] );
+
+                        return declaration;
+                    }
+
+                    case NodeKind_SamplerDeclaration:
+                    {
+                        SamplerDeclaration * declaration = new SamplerDeclaration(
+                            GetString( node, FlatNode::String_Type ),
+                            GetString( node, FlatNode::String_Name )
+                            );
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            declaration->AddBody( CreateAs<SamplerBody>( *it ) );
+                        }
+
+                        return declaration;
+                    }
+
+                    case NodeKind_SamplerBody:
+                        return new SamplerBody( GetString( node, FlatNode::String_Name ), GetString( node, FlatNode::String_Value ) );
+
+                    case NodeKind_StructDefinition:
+                    {
+                        StructDefinition * definition = new StructDefinition( GetString( node, FlatNode::String_Name ) );
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            const FlatNode
+                                & member = m_Unit.GetNode( *it );
+
+                            definition->AddMember(
+                                GetString( member, FlatNode::String_Name ),
+                                CreateAs<Type>( member.m_Child[ 0 ] ),
+                                GetString( member, FlatNode::String_Semantic ),
+                                GetString( member, FlatNode::String_InterpolationModifier )
+                                );
+                        }
+
+                        return definition;
+                    }
+
+                    case NodeKind_Type:
+                        return new Type( GetString( node, FlatNode::String_Name ) );
+
+                    case NodeKind_IntrinsicType:
+                        return new IntrinsicType( GetString( node, FlatNode::String_Name ) );
+
+                    case NodeKind_UserDefinedType:
+                        return new UserDefinedType( GetString( node, FlatNode::String_Name ) );
+
+                    case NodeKind_SamplerType:
+                        return new SamplerType( GetString( node, FlatNode::String_Name ) );
+
+                    case NodeKind_TypeModifier:
+                        return new TypeModifier( GetString( node, FlatNode::String_Value ) );
+
+                    case NodeKind_StorageClass:
+                        return new StorageClass( GetString( node, FlatNode::String_Value ) );
+
+                    case NodeKind_VariableDeclarationBody:
+                    {
+                        VariableDeclarationBody * body = new VariableDeclarationBody( GetString( node, FlatNode::String_Name ) );
+
+                        body->m_Semantic = GetString( node, FlatNode::String_Semantic );
+                        body->m_ArraySize = node.m_Value;
+                        body->m_InitialValue = CreateAs<InitialValue>( node.m_Child[ 0 ] );
+                        body->m_Annotations = CreateAs<Annotations>( node.m_Child[ 1 ] );
+
+                        return body;
+                    }
+
+                    case NodeKind_InitialValue:
+                    {
+                        InitialValue * initial_value = new InitialValue;
+
+                        initial_value->m_Vector = node.m_Operator != 0;
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            initial_value->AddExpression( CreateAs<Expression>( *it ) );
+                        }
+
+                        return initial_value;
+                    }
+
+                    case NodeKind_Annotations:
+                    {
+                        Annotations * annotations = new Annotations;
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            annotations->AddEntry( CreateAs<AnnotationEntry>( *it ) );
+                        }
+
+                        return annotations;
+                    }
+
+                    case NodeKind_AnnotationEntry:
+                        return new AnnotationEntry(
+                            GetString( node, FlatNode::String_Type ),
+                            GetString( node, FlatNode::String_Name ),
+                            GetString( node, FlatNode::String_Value )
+                            );
+
+                    case NodeKind_FunctionDeclaration:
+                    {
+                        FunctionDeclaration * declaration = new FunctionDeclaration;
+
+                        declaration->m_Name = GetString( node, FlatNode::String_Name );
+                        declaration->m_Semantic = GetString( node, FlatNode::String_Semantic );
+                        declaration->m_Type = CreateAs<Type>( node.m_Child[ 0 ] );
+                        declaration->m_ArgumentList = CreateAs<ArgumentList>( node.m_Child[ 1 ] );
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            if( m_Unit.GetNode( *it ).m_Kind == NodeKind_StorageClass )
+                            {
+                                declaration->AddStorageClass( CreateAs<StorageClass>( *it ) );
+                            }
+                            else
+                            {
+                                declaration->AddStatement( CreateAs<Statement>( *it ) );
+                            }
+                        }
+
+                        return declaration;
+                    }
+
+                    case NodeKind_ArgumentList:
+                    {
+                        ArgumentList * list = new ArgumentList;
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            list->AddArgument( CreateAs<Argument>( *it ) );
+                        }
+
+                        return list;
+                    }
+
+                    case NodeKind_Argument:
+                    {
+                        Argument * argument = new Argument;
+
+                        argument->m_Name = GetString( node, FlatNode::String_Name );
+                        argument->m_Semantic = GetString( node, FlatNode::String_Semantic );
+                        argument->m_InputModifier = GetString( node, FlatNode::String_InputModifier );
+                        argument->m_InterpolationModifier = GetString( node, FlatNode::String_InterpolationModifier );
+                        argument->m_Type = CreateAs<Type>( node.m_Child[ 0 ] );
+                        argument->m_TypeModifier = CreateAs<TypeModifier>( node.m_Child[ 1 ] );
+                        argument->m_InitialValue = CreateAs<InitialValue>( node.m_Child[ 2 ] );
+
+                        return argument;
+                    }
+
+                    case NodeKind_LiteralExpression:
+                        return new LiteralExpression(
+                            static_cast<LiteralExpression::Type>( node.m_Operator ),
+                            GetString( node, FlatNode::String_Value )
+                            );
+
+                    case NodeKind_VariableExpression:
+                    {
+                        VariableExpression * expression = new VariableExpression( GetString( node, FlatNode::String_Name ) );
+
+                        expression->m_SubscriptExpression = CreateAs<Expression>( node.m_Child[ 0 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_UnaryOperationExpression:
+                    {
+                        UnaryOperationExpression * expression = new UnaryOperationExpression;
+
+                        expression->m_Operation = static_cast<UnaryOperationExpression::Operation>( node.m_Operator );
+                        expression->m_Expression = CreateAs<Expression>( node.m_Child[ 0 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_BinaryOperationExpression:
+                    {
+                        BinaryOperationExpression * expression = new BinaryOperationExpression;
+
+                        expression->m_Operation = static_cast<BinaryOperationExpression::Operation>( node.m_Operator );
+                        expression->m_LeftExpression = CreateAs<Expression>( node.m_Child[ 0 ] );
+                        expression->m_RightExpression = CreateAs<Expression>( node.m_Child[ 1 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_CallExpression:
+                    {
+                        CallExpression * expression = new CallExpression( GetString( node, FlatNode::String_Name ), 0 );
+
+                        expression->m_ArgumentExpressionList = CreateAs<ArgumentExpressionList>( node.m_Child[ 0 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_ArgumentExpressionList:
+                    {
+                        ArgumentExpressionList * list = new ArgumentExpressionList;
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            list->AddExpression( CreateAs<Expression>( *it ) );
+                        }
+
+                        return list;
+                    }
+
+                    case NodeKind_Swizzle:
+                        return new Swizzle( GetString( node, FlatNode::String_Value ) );
+
+                    case NodeKind_PostfixSuffixCall:
+                    {
+                        PostfixSuffixCall * suffix = new PostfixSuffixCall;
+
+                        suffix->m_CallExpression = CreateAs<CallExpression>( node.m_Child[ 0 ] );
+                        suffix->m_Suffix = CreateAs<PostfixSuffix>( node.m_Child[ 1 ] );
+
+                        return suffix;
+                    }
+
+                    case NodeKind_PostfixSuffixVariable:
+                    {
+                        PostfixSuffixVariable * suffix = new PostfixSuffixVariable;
+
+                        suffix->m_VariableExpression = CreateAs<VariableExpression>( node.m_Child[ 0 ] );
+                        suffix->m_Suffix = CreateAs<PostfixSuffix>( node.m_Child[ 1 ] );
+
+                        return suffix;
+                    }
+
+                    case NodeKind_ConstructorExpression:
+                    {
+                        ConstructorExpression * expression = new ConstructorExpression;
+
+                        expression->m_Type = CreateAs<Type>( node.m_Child[ 0 ] );
+                        expression->m_ArgumentExpressionList = CreateAs<ArgumentExpressionList>( node.m_Child[ 1 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_ConditionalExpression:
+                    {
+                        ConditionalExpression * expression = new ConditionalExpression;
+
+                        expression->m_Condition = CreateAs<Expression>( node.m_Child[ 0 ] );
+                        expression->m_IfTrue = CreateAs<Expression>( node.m_Child[ 1 ] );
+                        expression->m_IfFalse = CreateAs<Expression>( node.m_Child[ 2 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_LValueExpression:
+                    {
+                        LValueExpression * expression = new LValueExpression;
+
+                        expression->m_VariableExpression = CreateAs<VariableExpression>( node.m_Child[ 0 ] );
+                        expression->m_Suffix = CreateAs<PostfixSuffix>( node.m_Child[ 1 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_PreModifyExpression:
+                    {
+                        PreModifyExpression * expression = new PreModifyExpression;
+
+                        expression->m_Operator = static_cast<SelfModifyOperator>( node.m_Operator );
+                        expression->m_Expression = CreateAs<LValueExpression>( node.m_Child[ 0 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_PostModifyExpression:
+                    {
+                        PostModifyExpression * expression = new PostModifyExpression;
+
+                        expression->m_Operator = static_cast<SelfModifyOperator>( node.m_Operator );
+                        expression->m_Expression = CreateAs<LValueExpression>( node.m_Child[ 0 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_CastExpression:
+                    {
+                        CastExpression * expression = new CastExpression;
+
+                        expression->m_ArraySize = node.m_Value;
+                        expression->m_Type = CreateAs<Type>( node.m_Child[ 0 ] );
+                        expression->m_Expression = CreateAs<Expression>( node.m_Child[ 1 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_AssignmentExpression:
+                    {
+                        AssignmentExpression * expression = new AssignmentExpression;
+
+                        expression->m_Operator = static_cast<AssignmentOperator>( node.m_Operator );
+                        expression->m_LValueExpression = CreateAs<LValueExpression>( node.m_Child[ 0 ] );
+                        expression->m_Expression = CreateAs<Expression>( node.m_Child[ 1 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_PostfixExpression:
+                    {
+                        PostfixExpression * expression = new PostfixExpression;
+
+                        expression->m_Expression = CreateAs<Expression>( node.m_Child[ 0 ] );
+                        expression->m_Suffix = CreateAs<PostfixSuffix>( node.m_Child[ 1 ] );
+
+                        return expression;
+                    }
+
+                    case NodeKind_ReturnStatement:
+                    {
+                        ReturnStatement * statement = new ReturnStatement;
+
+                        statement->m_Expression = CreateAs<Expression>( node.m_Child[ 0 ] );
+
+                        return statement;
+                    }
+
+                    case NodeKind_BreakStatement:
+                        return new BreakStatement;
+
+                    case NodeKind_ContinueStatement:
+                        return new ContinueStatement;
+
+                    case NodeKind_DiscardStatement:
+                        return new DiscardStatement;
+
+                    case NodeKind_EmptyStatement:
+                        return new EmptyStatement;
+
+                    case NodeKind_ExpressionStatement:
+                    {
+                        ExpressionStatement * statement = new ExpressionStatement;
+
+                        statement->m_Expression = CreateAs<Expression>( node.m_Child[ 0 ] );
+
+                        return statement;
+                    }
+
+                    case NodeKind_IfStatement:
+                    {
+                        IfStatement * statement = new IfStatement;
+
+                        statement->m_Condition = CreateAs<Expression>( node.m_Child[ 0 ] );
+                        statement->m_ThenStatement = CreateAs<Statement>( node.m_Child[ 1 ] );
+                        statement->m_ElseStatement = CreateAs<Statement>( node.m_Child[ 2 ] );
+
+                        return statement;
+                    }
+
+                    case NodeKind_WhileStatement:
+                    {
+                        WhileStatement * statement = new WhileStatement;
+
+                        statement->m_Condition = CreateAs<Expression>( node.m_Child[ 0 ] );
+                        statement->m_Statement = CreateAs<Statement>( node.m_Child[ 1 ] );
+
+                        return statement;
+                    }
+
+                    case NodeKind_DoWhileStatement:
+                    {
+                        DoWhileStatement * statement = new DoWhileStatement;
+
+                        statement->m_Condition = CreateAs<Expression>( node.m_Child[ 0 ] );
+                        statement->m_Statement = CreateAs<Statement>( node.m_Child[ 1 ] );
+
+                        return statement;
+                    }
+
+                    case NodeKind_ForStatement:
+                    {
+                        ForStatement * statement = new ForStatement;
+
+                        statement->m_InitStatement = CreateAs<Statement>( node.m_Child[ 0 ] );
+                        statement->m_EqualityExpression = CreateAs<Expression>( node.m_Child[ 1 ] );
+                        statement->m_ModifyExpression = CreateAs<Expression>( node.m_Child[ 2 ] );
+                        statement->m_Statement = CreateAs<Statement>( node.m_Child[ 3 ] );
+
+                        return statement;
+                    }
+
+                    case NodeKind_BlockStatement:
+                    {
+                        BlockStatement * statement = new BlockStatement;
+
+                        for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                        {
+                            statement->AddStatement( CreateAs<Statement>( *it ) );
+                        }
+
+                        return statement;
+                    }
+
+                    case NodeKind_AssignmentStatement:
+                    {
+                        AssignmentStatement * statement = new AssignmentStatement;
+
+                        statement->m_Expression = CreateAs<AssignmentExpression>( node.m_Child[ 0 ] );
+
+                        return statement;
+                    }
+
+                    case NodeKind_VariableDeclarationStatement:
+                    {
+                        VariableDeclarationStatement * statement = new VariableDeclarationStatement;
+
+                        FillVariableDeclaration( *statement, node );
+
+                        return statement;
+                    }
+
+                    default:
+                        assert( !"Unsupported node kind" );
+                        return 0;
+                }
+            }
+
+        private:
+
+            TreeBuilder & operator =( const TreeBuilder & );
+
+            template< typename _Node_ >
+            _Node_ * CreateAs( const uint32_t index ) const
+            {
+                Node
+                    * node = Create( index );
+
+                assert( !node || dynamic_cast<_Node_ *>( node ) );
+
+                return static_cast<_Node_ *>( node );
+            }
+
+            std::string GetString( const FlatNode & node, const int slot ) const
+            {
+                return m_Unit.GetString( node, slot );
+            }
+
+            template< class _Declaration_ >
+            void FillVariableDeclaration( _Declaration_ & declaration, const FlatNode & node ) const
+            {
+                declaration.SetType( CreateAs<Type>( node.m_Child[ 0 ] ) );
+
+                for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                {
+                    switch( m_Unit.GetNode( *it ).m_Kind )
+                    {
+                        case NodeKind_StorageClass:
+                            declaration.AddStorageClass( CreateAs<StorageClass>( *it ) );
+                            break;
+
+                        case NodeKind_TypeModifier:
+                            declaration.AddTypeModifier( CreateAs<TypeModifier>( *it ) );
+                            break;
+
+                        default:
+                            declaration.AddBody( CreateAs<VariableDeclarationBody>( *it ) );
+                            break;
+                    }
+                }
+            }
+
+            Technique * CreateTechnique( const uint32_t index ) const
+            {
+                const FlatNode
+                    & node = m_Unit.GetNode( index );
+
+                Node::SetDebugInfo( node.m_Location );
+
+                Technique
+                    * technique = new Technique( GetString( node, FlatNode::String_Name ) );
+
+                for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                {
+                    technique->AddPass( CreatePass( *it ) );
+                }
+
+                return technique;
+            }
+
+            Pass * CreatePass( const uint32_t index ) const
+            {
+                const FlatNode
+                    & node = m_Unit.GetNode( index );
+
+                Node::SetDebugInfo( node.m_Location );
+
+                Pass
+                    * pass = new Pass( GetString( node, FlatNode::String_Name ) );
+
+                for( const uint32_t * it = m_Unit.GetListBegin( node ); it != m_Unit.GetListEnd( node ); ++it )
+                {
+                    const FlatNode
+                        & definition = m_Unit.GetNode( *it );
+                    ShaderArgumentList
+                        * list = 0;
+
+                    if( definition.m_Child[ 0 ] != FlatTranslationUnit::InvalidIndex )
+                    {
+                        const FlatNode
+                            & list_node = m_Unit.GetNode( definition.m_Child[ 0 ] );
+
+                        Node::SetDebugInfo( list_node.m_Location );
+                        list = new ShaderArgumentList;
+
+                        for( const uint32_t * argument_it = m_Unit.GetListBegin( list_node ); argument_it != m_Unit.GetListEnd( list_node ); ++argument_it )
+                        {
+                            list->AddArgument( CreateAs<Expression>( *argument_it ) );
+                        }
+                    }
+
+                    Node::SetDebugInfo( definition.m_Location );
+                    pass->AddShaderDefinition(
+                        new ShaderDefinition( static_cast<ShaderType>( definition.m_Operator ), GetString( definition, FlatNode::String_Name ), list )
+                        );
+                }
+
+                return pass;
+            }
+
+            const FlatTranslationUnit
+                & m_Unit;
+        };
+    }
+
+    void ConvertToFlat(
+        FlatTranslationUnit & flat_unit,
+        const TranslationUnit & translation_unit
+        )
+    {
+        FlatBuilder
+            builder( flat_unit );
+
+        flat_unit.Clear();
+        translation_unit.Visit( builder );
+    }
+
+    Base::ObjectRef<TranslationUnit> ConvertToTree(
+        const FlatTranslationUnit & flat_unit
+        )
+    {
+        SourceLocation
+            previous_location = Node::GetCurrentLocation();
+        TreeBuilder
+            builder( flat_unit );
+        Base::ObjectRef<TranslationUnit>
+            translation_unit;
+
+        if( !flat_unit.IsEmpty() )
+        {
+            translation_unit = static_cast<TranslationUnit *>( builder.Create( FlatTranslationUnit::RootIndex ) );
+        }
+
+        Node::SetDebugInfo( previous_location );
+
+        return translation_unit;
+    }
+}
\ No newline at end of file
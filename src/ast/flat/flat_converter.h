@@ -0,0 +1,22 @@
+#ifndef FLAT_CONVERTER_H
+    #define FLAT_CONVERTER_H
+
+    #include "ast/flat/flat_translation_unit.h"
+    #include "base/object_ref.h"
+
+    namespace AST
+    {
+        struct TranslationUnit;
+
+        // Deferred function bodies are parsed before the conversion
+        void ConvertToFlat(
+            FlatTranslationUnit & flat_unit,
+            const TranslationUnit & translation_unit
+            );
+
+        Base::ObjectRef<TranslationUnit> ConvertToTree(
+            const FlatTranslationUnit & flat_unit
+            );
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,582 @@
+#include "flat_hlsl_printer.h"
+
+#include <cassert>
+#include <utils/indentation.h>
+#include <ast/node.h>
+
+namespace AST
+{
+    void FlatHLSLPrinter::Print( const FlatTranslationUnit & flat_unit )
+    {
+        if( !flat_unit.IsEmpty() )
+        {
+            Print( flat_unit, FlatTranslationUnit::RootIndex );
+        }
+    }
+
+    void FlatHLSLPrinter::Print( const FlatTranslationUnit & flat_unit, const uint32_t index )
+    {
+        m_Unit = &flat_unit;
+        PrintNode( index );
+        m_Unit = 0;
+    }
+
+    void FlatHLSLPrinter::PrintNode( const uint32_t index )
+    {
+        const FlatNode
+            & node = m_Unit->GetNode( index );
+        const uint32_t
+            * list_begin = m_Unit->GetListBegin( node ),
+            * list_end = m_Unit->GetListEnd( node );
+
+        switch( node.m_Kind )
+        {
+            case NodeKind_TranslationUnit:
+            {
+                for( const uint32_t * it = list_begin; it != list_end; ++it )
+                {
+                    // Techniques are not part of the generated code
+                    if( m_Unit->GetNode( *it ).m_Kind != NodeKind_Technique )
+                    {
+                        PrintNode( *it );
+                    }
+                }
+            }
+            break;
+
+            case NodeKind_VariableDeclaration:
+            case NodeKind_VariableDeclarationStatement:
+                PrintVariableDeclaration( node );
+                break;
+
+            case NodeKind_TextureDeclaration:
+            {
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Type ) << " " << m_Unit->GetString( node, FlatNode::String_Name );
+
+                if( m_Unit->HasString( node, FlatNode::String_Semantic ) )
+                {
+                    m_Stream << " : " << m_Unit->GetString( node, FlatNode::String_Semantic );
+                }
+
+                if( node.m_Child[ 0 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 0 ] );
+                }
+
+                m_Stream << ";" << endl_ind;
+            }
+            break;
+
+            case NodeKind_SamplerDeclaration:
+            {
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Type ) << " "
+                    << m_Unit->GetString( node, FlatNode::String_Name ) << endl_ind
+                    << "{" << inc_ind << endl_ind;
+
+                PrintItems( list_begin, list_end, "", false );
+
+                m_Stream << dec_ind << endl_ind << "}" << endl_ind;
+            }
+            break;
+
+            case NodeKind_SamplerBody:
+            {
+                if( std::string( m_Unit->GetString( node, FlatNode::String_Name ) ) == "texture" )
+                {
+                    m_Stream << "texture=<" << m_Unit->GetString( node, FlatNode::String_Value ) << ">";
+                }
+                else
+                {
+                    m_Stream << m_Unit->GetString( node, FlatNode::String_Name ) << " = " << m_Unit->GetString( node, FlatNode::String_Value );
+                }
+
+                m_Stream << ";" << endl_ind;
+            }
+            break;
+
+            case NodeKind_StructDefinition:
+            {
+                m_Stream << " struct " << m_Unit->GetString( node, FlatNode::String_Name ) << endl_ind;
+                m_Stream << "{" << inc_ind << endl_ind;
+
+                PrintItems( list_begin, list_end, "", false );
+            }
+            break;
+
+            case NodeKind_StructMember:
+            {
+                if( m_Unit->HasString( node, FlatNode::String_InterpolationModifier ) )
+                {
+                    m_Stream << m_Unit->GetString( node, FlatNode::String_InterpolationModifier ) << " ";
+                }
+
+                PrintNode( node.m_Child[ 0 ] );
+
+                m_Stream << " " << m_Unit->GetString( node, FlatNode::String_Name );
+
+                if( m_Unit->HasString( node, FlatNode::String_Semantic ) )
+                {
+                    m_Stream << " : " << m_Unit->GetString( node, FlatNode::String_Semantic );
+                }
+            }
+            break;
+
+            case NodeKind_Type:
+            case NodeKind_IntrinsicType:
+            case NodeKind_UserDefinedType:
+            case NodeKind_SamplerType:
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Name );
+                break;
+
+            case NodeKind_TypeModifier:
+            case NodeKind_StorageClass:
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Value );
+                break;
+
+            case NodeKind_VariableDeclarationBody:
+            {
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Name );
+
+                if( node.m_Value )
+                {
+                    m_Stream << "[" << node.m_Value << "]";
+                }
+
+                if( m_Unit->HasString( node, FlatNode::String_Semantic ) )
+                {
+                    m_Stream << " : " << m_Unit->GetString( node, FlatNode::String_Semantic );
+                }
+
+                if( node.m_Child[ 1 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 1 ] );
+                }
+
+                if( node.m_Child[ 0 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    m_Stream << " = ";
+
+                    PrintNode( node.m_Child[ 0 ] );
+                }
+            }
+            break;
+
+            case NodeKind_InitialValue:
+            {
+                if( node.m_Operator )
+                {
+                    m_Stream << "{ ";
+                    PrintItems( list_begin, list_end, ", ", false );
+                    m_Stream << " }";
+                }
+                else
+                {
+                    assert( node.m_ListItemCount == 1 );
+                    PrintNode( *list_begin );
+                }
+            }
+            break;
+
+            case NodeKind_Annotations:
+            {
+                m_Stream << " < ";
+                PrintItems( list_begin, list_end, "", false );
+                m_Stream << ">";
+            }
+            break;
+
+            case NodeKind_AnnotationEntry:
+            {
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Type ) << " " << m_Unit->GetString( node, FlatNode::String_Name )
+                    << " = " << m_Unit->GetString( node, FlatNode::String_Value ) << "; ";
+            }
+            break;
+
+            case NodeKind_FunctionDeclaration:
+            {
+                const uint32_t
+                    * statement_begin = SkipKind( list_begin, list_end, NodeKind_StorageClass );
+
+                PrintItems( list_begin, statement_begin, "", false );
+
+                if( node.m_Child[ 0 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 0 ] );
+                }
+                else
+                {
+                    m_Stream << "void";
+                }
+
+                m_Stream << " " << m_Unit->GetString( node, FlatNode::String_Name ) << "(";
+
+                if( node.m_Child[ 1 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 1 ] );
+                }
+
+                m_Stream << ")";
+
+                if( m_Unit->HasString( node, FlatNode::String_Semantic ) )
+                {
+                    m_Stream << " : " << m_Unit->GetString( node, FlatNode::String_Semantic );
+                }
+
+                m_Stream << endl_ind << "{" << inc_ind << endl_ind;
+
+                PrintItems( statement_begin, list_end, "", false );
+
+                m_Stream << dec_ind << endl_ind << "}" << endl_ind;
+            }
+            break;
+
+            case NodeKind_ArgumentList:
+                PrintItems( list_begin, list_end, ", ", false );
+                break;
+
+            case NodeKind_Argument:
+            {
+                if( m_Unit->HasString( node, FlatNode::String_InputModifier ) )
+                {
+                    m_Stream << m_Unit->GetString( node, FlatNode::String_InputModifier ) << " ";
+                }
+
+                if( node.m_Child[ 1 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 1 ] );
+                }
+
+                m_Stream << m_Unit->GetString( m_Unit->GetNode( node.m_Child[ 0 ] ), FlatNode::String_Name )
+                    << " " << m_Unit->GetString( node, FlatNode::String_Name );
+
+                if( m_Unit->HasString( node, FlatNode::String_Semantic ) )
+                {
+                    m_Stream << " : " << m_Unit->GetString( node, FlatNode::String_Semantic );
+                }
+
+                if( m_Unit->HasString( node, FlatNode::String_InterpolationModifier ) )
+                {
+                    m_Stream << " " << m_Unit->GetString( node, FlatNode::String_InterpolationModifier );
+                }
+
+                if( node.m_Child[ 2 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    m_Stream << " = ";
+
+                    PrintNode( node.m_Child[ 2 ] );
+                }
+            }
+            break;
+
+            case NodeKind_LiteralExpression:
+            case NodeKind_Swizzle:
+            {
+                if( node.m_Kind == NodeKind_Swizzle )
+                {
+                    m_Stream << ".";
+                }
+
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Value );
+            }
+            break;
+
+            case NodeKind_VariableExpression:
+            {
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Name );
+
+                if( node.m_Child[ 0 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    m_Stream << '[';
+                    PrintNode( node.m_Child[ 0 ] );
+                    m_Stream << ']';
+                }
+            }
+            break;
+
+            case NodeKind_UnaryOperationExpression:
+            {
+                m_Stream << static_cast<UnaryOperationExpression::Operation>( node.m_Operator ) << "( ";
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << " )";
+            }
+            break;
+
+            case NodeKind_BinaryOperationExpression:
+            {
+                m_Stream << "( ";
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << " ) " << static_cast<BinaryOperationExpression::Operation>( node.m_Operator ) << " ( ";
+                PrintNode( node.m_Child[ 1 ] );
+                m_Stream << " )";
+            }
+            break;
+
+            case NodeKind_CallExpression:
+            {
+                m_Stream << m_Unit->GetString( node, FlatNode::String_Name ) << "(";
+
+                if( node.m_Child[ 0 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 0 ] );
+                }
+
+                m_Stream << ")";
+            }
+            break;
+
+            case NodeKind_ArgumentExpressionList:
+                PrintItems( list_begin, list_end, ", ", false );
+                break;
+
+            case NodeKind_PostfixSuffixCall:
+            case NodeKind_PostfixSuffixVariable:
+                m_Stream << ".";
+                // fall through
+
+            case NodeKind_LValueExpression:
+            case NodeKind_PostfixExpression:
+            {
+                PrintNode( node.m_Child[ 0 ] );
+
+                if( node.m_Child[ 1 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 1 ] );
+                }
+            }
+            break;
+
+            case NodeKind_ConstructorExpression:
+            {
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << "(";
+
+                if( node.m_Child[ 1 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    PrintNode( node.m_Child[ 1 ] );
+                }
+
+                m_Stream << ")";
+            }
+            break;
+
+            case NodeKind_ConditionalExpression:
+            {
+                m_Stream << "( ";
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << " ) ? ( ";
+                PrintNode( node.m_Child[ 1 ] );
+                m_Stream << " ) : ( ";
+                PrintNode( node.m_Child[ 2 ] );
+                m_Stream << " )";
+            }
+            break;
+
+            case NodeKind_PreModifyExpression:
+            {
+                m_Stream << static_cast<SelfModifyOperator>( node.m_Operator );
+                PrintNode( node.m_Child[ 0 ] );
+            }
+            break;
+
+            case NodeKind_PostModifyExpression:
+            {
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << static_cast<SelfModifyOperator>( node.m_Operator );
+            }
+            break;
+
+            case NodeKind_CastExpression:
+            {
+                m_Stream << "( ";
+                PrintNode( node.m_Child[ 0 ] );
+
+                if( node.m_Value != -1 )
+                {
+                    m_Stream << "[" << node.m_Value << "]";
+                }
+
+                m_Stream << " )( ";
+                PrintNode( node.m_Child[ 1 ] );
+                m_Stream << " )";
+            }
+            break;
+
+            case NodeKind_AssignmentExpression:
+            {
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << " " << static_cast<AssignmentOperator>( node.m_Operator ) << " ";
+                PrintNode( node.m_Child[ 1 ] );
+            }
+            break;
+
+            case NodeKind_ReturnStatement:
+            {
+                m_Stream << "return";
+
+                if( node.m_Child[ 0 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    m_Stream << " ";
+                    PrintNode( node.m_Child[ 0 ] );
+                }
+
+                m_Stream << ";" << endl_ind;
+            }
+            break;
+
+            case NodeKind_BreakStatement:
+                m_Stream << "break;" << endl_ind;
+                break;
+
+            case NodeKind_ContinueStatement:
+                m_Stream << "continue;" << endl_ind;
+                break;
+
+            case NodeKind_DiscardStatement:
+                m_Stream << "discard;" << endl_ind;
+                break;
+
+            case NodeKind_EmptyStatement:
+                m_Stream << ";" << endl_ind;
+                break;
+
+            case NodeKind_ExpressionStatement:
+            case NodeKind_AssignmentStatement:
+            {
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << ";" << endl_ind;
+            }
+            break;
+
+            case NodeKind_IfStatement:
+            {
+                m_Stream << "if( ";
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << " ) ";
+                PrintNode( node.m_Child[ 1 ] );
+
+                if( node.m_Child[ 2 ] != FlatTranslationUnit::InvalidIndex )
+                {
+                    m_Stream << "else ";
+                    PrintNode( node.m_Child[ 2 ] );
+                }
+            }
+            break;
+
+            case NodeKind_WhileStatement:
+            {
+                m_Stream << "while( ";
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << " ) ";
+                PrintNode( node.m_Child[ 1 ] );
+            }
+            break;
+
+            case NodeKind_DoWhileStatement:
+            {
+                m_Stream << "do ";
+                PrintNode( node.m_Child[ 1 ] );
+                m_Stream << "while( ";
+                PrintNode( node.m_Child[ 0 ] );
+                m_Stream << " );\n";
+            }
+            break;
+
+            case NodeKind_ForStatement:
+            {
+                m_Stream << "for( ";
+                PrintNode( node.m_Child[ 0 ] );
+                PrintNode( node.m_Child[ 1 ] );
+                m_Stream << "; ";
+                PrintNode( node.m_Child[ 2 ] );
+                m_Stream << " ) ";
+                PrintNode( node.m_Child[ 3 ] );
+            }
+            break;
+
+            case NodeKind_BlockStatement:
+            {
+                if( node.m_ListItemCount == 0 )
+                {
+                    m_Stream << "{}" << endl_ind;
+                }
+                else
+                {
+                    m_Stream << "{" << inc_ind << endl_ind;
+
+                    PrintItems( list_begin, list_end, "", false );
+
+                    m_Stream << dec_ind << endl_ind << "}" << endl_ind;
+                }
+            }
+            break;
+
+            default:
+                assert( !"Unsupported node kind" );
+                break;
+        }
+    }
+
+    void FlatHLSLPrinter::PrintItems(
+        const uint32_t * begin,
+        const uint32_t * end,
+        const char * separator,
+        const bool add_endl
+        )
+    {
+        for( const uint32_t * it = begin; it != end; ++it )
+        {
+            if( it != begin )
+            {
+                m_Stream << separator;
+
+                if( add_endl )
+                {
+                    m_Stream << endl_ind;
+                }
+            }
+
+            PrintNode( *it );
+        }
+    }
+
+    void FlatHLSLPrinter::PrintVariableDeclaration( const FlatNode & node )
+    {
+        const uint32_t
+            * storage_class_begin = m_Unit->GetListBegin( node ),
+            * list_end = m_Unit->GetListEnd( node ),
+            * type_modifier_begin = SkipKind( storage_class_begin, list_end, NodeKind_StorageClass ),
+            * body_begin = SkipKind( type_modifier_begin, list_end, NodeKind_TypeModifier );
+
+        PrintItems( storage_class_begin, type_modifier_begin, " ", false );
+
+        if( storage_class_begin != type_modifier_begin )
+            m_Stream << " ";
+
+        PrintItems( type_modifier_begin, body_begin, " ", false );
+
+        if( type_modifier_begin != body_begin )
+            m_Stream << " ";
+
+        m_Stream << m_Unit->GetString( m_Unit->GetNode( node.m_Child[ 0 ] ), FlatNode::String_Name );
+
+        m_Stream << inc_ind << endl_ind;
+        PrintItems( body_begin, list_end, ",", true );
+        m_Stream << dec_ind;
+
+        m_Stream << ";" << endl_ind;
+    }
+
+    const uint32_t * FlatHLSLPrinter::SkipKind(
+        const uint32_t * begin,
+        const uint32_t * end,
+        const NodeKind kind
+        ) const
+    {
+        while( begin != end && m_Unit->GetNode( *begin ).m_Kind == kind )
+        {
+            ++begin;
+        }
+
+        return begin;
+    }
+}
\ No newline at end of file
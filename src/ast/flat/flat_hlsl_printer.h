@@ -0,0 +1,45 @@
+#ifndef FLAT_HLSL_PRINTER_H
+    #define FLAT_HLSL_PRINTER_H
+
+    #include "ast/flat/flat_translation_unit.h"
+    #include <ostream>
+
+    namespace AST
+    {
+        // Prints the same code as HLSLPrinter, without building the tree
+
+        class FlatHLSLPrinter
+        {
+        public:
+
+            FlatHLSLPrinter( std::ostream & stream ) : m_Stream( stream ), m_Unit( 0 ) {}
+
+            void Print( const FlatTranslationUnit & flat_unit );
+            void Print( const FlatTranslationUnit & flat_unit, const uint32_t index );
+
+        private:
+
+            FlatHLSLPrinter & operator =( const FlatHLSLPrinter & );
+
+            void PrintNode( const uint32_t index );
+            void PrintItems(
+                const uint32_t * begin,
+                const uint32_t * end,
+                const char * separator,
+                const bool add_endl
+                );
+            void PrintVariableDeclaration( const FlatNode & node );
+            const uint32_t * SkipKind(
+                const uint32_t * begin,
+                const uint32_t * end,
+                const NodeKind kind
+                ) const;
+
+            std::ostream
+                & m_Stream;
+            const FlatTranslationUnit
+                * m_Unit;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "flat_translation_unit.h"
+
+#include <cassert>
+
+namespace AST
+{
+    FlatTranslationUnit::FlatTranslationUnit()
+    {
+        Clear();
+    }
+
+    uint32_t FlatTranslationUnit::AddNode(
+        const NodeKind kind,
+        const SourceLocation & location
+        )
+    {
+        FlatNode
+            node;
+
+        node.m_Kind = static_cast<uint16_t>( kind );
+        node.m_Operator = 0;
+        node.m_Value = 0;
+        node.m_FirstListItem = 0;
+        node.m_ListItemCount = 0;
+        node.m_Location = location;
+
+        for( int string_index = 0; string_index < FlatNode::StringCount; ++string_index )
+        {
+            node.m_String[ string_index ] = 0;
+        }
+
+        for( int child_index = 0; child_index < FlatNode::ChildCount; ++child_index )
+        {
+            node.m_Child[ child_index ] = InvalidIndex;
+        }
+
+        m_NodeTable.push_back( node );
+
+        return static_cast<uint32_t>( m_NodeTable.size() - 1 );
+    }
+
+    uint32_t FlatTranslationUnit::AddString( const std::string & value )
+    {
+        // Offset 0 is the shared empty string
+        if( value.empty() )
+        {
+            return 0;
+        }
+
+        uint32_t
+            offset = static_cast<uint32_t>( m_StringData.size() );
+
+        m_StringData.insert( m_StringData.end(), value.begin(), value.end() );
+        m_StringData.push_back( '\0' );
+
+        return offset;
+    }
+
+    void FlatTranslationUnit::SetList(
+        const uint32_t node_index,
+        const std::vector<uint32_t> & item_table
+        )
+    {
+        FlatNode
+            & node = m_NodeTable[ node_index ];
+
+        assert( node.m_ListItemCount == 0 );
+
+        node.m_FirstListItem = static_cast<uint32_t>( m_ListTable.size() );
+        node.m_ListItemCount = static_cast<uint32_t>( item_table.size() );
+
+        m_ListTable.insert( m_ListTable.end(), item_table.begin(), item_table.end() );
+    }
+
+    void FlatTranslationUnit::Clear()
+    {
+        m_NodeTable.clear();
+        m_ListTable.clear();
+        m_StringData.assign( 1, '\0' );
+    }
+
+    size_t FlatTranslationUnit::GetMemorySize() const
+    {
+        return m_NodeTable.size() * sizeof( FlatNode )
+            + m_ListTable.size() * sizeof( uint32_t )
+            + m_StringData.size();
+    }
+}
\ No newline at end of file
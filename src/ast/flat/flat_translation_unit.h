@@ -0,0 +1,173 @@
+#ifndef FLAT_TRANSLATION_UNIT_H
+    #define FLAT_TRANSLATION_UNIT_H
+
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+    #include "ast/node_kind.h"
+    #include "ast/source_location.h"
+
+    namespace AST
+    {
+        // Node of a FlatTranslationUnit. The meaning of the slots depends on the kind:
+        //
+        // kind                     strings                             children                    list
+        // TranslationUnit                                                                          declarations, techniques
+        // VariableDeclaration                                          type                        storage classes, type modifiers, bodies
+        // TextureDeclaration       name, semantic, type                annotations
+        // SamplerDeclaration       name, type                                                      bodies
+        // SamplerBody              name, value
+        // StructDefinition         name                                                            members
+        // StructMember             name, semantic, interpolation       type
+        // *Type                    name
+        // TypeModifier             value
+        // StorageClass             value
+        // VariableDeclarationBody  name, semantic                      initial value, annotations
+        // InitialValue                                                                             expressions
+        // Annotations                                                                              entries
+        // AnnotationEntry          name, type, value
+        // FunctionDeclaration      name, semantic                      type, arguments             storage classes, statements
+        // ArgumentList                                                                             arguments
+        // Argument                 name, semantic, input modifier,     type, type modifier,
+        //                          interpolation                       initial value
+        // LiteralExpression        value
+        // VariableExpression       name                                subscript
+        // Unary/PreModify/PostModify                                   expression
+        // BinaryOperation                                              left, right
+        // CallExpression           name                                arguments
+        // ArgumentExpressionList                                                                   expressions
+        // Swizzle                  value
+        // PostfixSuffixCall                                            call, suffix
+        // PostfixSuffixVariable                                        variable, suffix
+        // ConstructorExpression                                        type, arguments
+        // ConditionalExpression                                        condition, true, false
+        // LValueExpression                                             variable, suffix
+        // CastExpression                                               type, expression
+        // AssignmentExpression                                         lvalue, expression
+        // PostfixExpression                                            expression, suffix
+        // Return/ExpressionStatement                                   expression
+        // IfStatement                                                  condition, then, else
+        // While/DoWhileStatement                                       condition, statement
+        // ForStatement                                                 init, condition, modify,
+        //                                                              statement
+        // BlockStatement                                                                           statements
+        // AssignmentStatement                                          expression
+        // VariableDeclarationStatement                                 type                        storage classes, type modifiers, bodies
+        // Technique/Pass           name                                                            passes/shader definitions
+        // ShaderDefinition         name                                arguments
+        // ShaderArgumentList                                                                       expressions
+        //
+        // m_Operator holds the operation, literal type, self modify or assignment operator, shader
+        // type and the vector flag of InitialValue. m_Value holds the array sizes.
+
+        struct FlatNode
+        {
+            enum
+            {
+                StringCount = 4,
+                ChildCount = 4
+            };
+
+            enum
+            {
+                String_Name = 0,
+                String_Semantic = 1,
+                String_Type = 2,
+                String_InputModifier = 2,
+                String_Value = 3,
+                String_InterpolationModifier = 3
+            };
+
+            uint16_t
+                m_Kind;
+            int16_t
+                m_Operator;
+            int32_t
+                m_Value;
+            uint32_t
+                m_String[ StringCount ],
+                m_Child[ ChildCount ],
+                m_FirstListItem,
+                m_ListItemCount;
+            SourceLocation
+                m_Location;
+        };
+
+        // Translation unit stored in three contiguous arrays: the nodes, the child lists and the
+        // strings. Nodes only refer to each other with 32 bit indices, so copying a unit copies
+        // the arrays and nothing else.
+
+        class FlatTranslationUnit
+        {
+        public:
+
+            enum
+            {
+                InvalidIndex = 0xFFFFFFFF,
+                RootIndex = 0
+            };
+
+            FlatTranslationUnit();
+
+            uint32_t AddNode(
+                const NodeKind kind,
+                const SourceLocation & location
+                );
+            uint32_t AddString( const std::string & value );
+            void SetList(
+                const uint32_t node_index,
+                const std::vector<uint32_t> & item_table
+                );
+            void Clear();
+
+            FlatNode & GetNode( const uint32_t index ) { return m_NodeTable[ index ]; }
+            const FlatNode & GetNode( const uint32_t index ) const { return m_NodeTable[ index ]; }
+            size_t GetNodeCount() const { return m_NodeTable.size(); }
+            bool IsEmpty() const { return m_NodeTable.empty(); }
+
+            // Returned pointer is invalidated by AddString
+            const char * GetString( const uint32_t offset ) const { return &m_StringData[ offset ]; }
+            const char * GetString( const FlatNode & node, const int slot ) const { return GetString( node.m_String[ slot ] ); }
+            bool HasString( const FlatNode & node, const int slot ) const { return node.m_String[ slot ] != 0; }
+
+            const uint32_t * GetListBegin( const FlatNode & node ) const { return m_ListTable.data() + node.m_FirstListItem; }
+            const uint32_t * GetListEnd( const FlatNode & node ) const { return GetListBegin( node ) + node.m_ListItemCount; }
+
+            size_t GetMemorySize() const;
+
+            // Calls function( unit, index ) on the node and its descendants, children before the
+            // list items. Descendants are skipped when the function returns false.
+            template< typename _Function_ >
+            void Traverse( const uint32_t index, _Function_ & function ) const
+            {
+                if( index == InvalidIndex || !function( *this, index ) )
+                {
+                    return;
+                }
+
+                const FlatNode
+                    & node = m_NodeTable[ index ];
+
+                for( int child_index = 0; child_index < FlatNode::ChildCount; ++child_index )
+                {
+                    Traverse( node.m_Child[ child_index ], function );
+                }
+
+                for( uint32_t item_index = 0; item_index < node.m_ListItemCount; ++item_index )
+                {
+                    Traverse( m_ListTable[ node.m_FirstListItem + item_index ], function );
+                }
+            }
+
+        private:
+
+            std::vector<FlatNode>
+                m_NodeTable;
+            std::vector<uint32_t>
+                m_ListTable;
+            std::vector<char>
+                m_StringData;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -14,17 +14,33 @@ namespace AST
             } \
         }
 
+    void FunctionDeclaration::ResolveBody() const
+    {
+        if( m_BodySource )
+        {
+            Base::ObjectRef<FunctionBodySource> body_source = m_BodySource;
+
+            m_BodySource = 0;
+            body_source->Parse( const_cast<FunctionDeclaration &>( *this ) );
+        }
+    }
+
     FunctionDeclaration * FunctionDeclaration::Clone() const
     {
         FunctionDeclaration * clone = new FunctionDeclaration;
 
+        ResolveBody();
+
         if( m_Type )
         {
             clone->m_Type = m_Type->Clone();
         }
         clone->m_Name = m_Name;
         clone->m_Semantic = m_Semantic;
-        clone->m_ArgumentList = m_ArgumentList->Clone();
+        if( m_ArgumentList )
+        {
+            clone->m_ArgumentList = m_ArgumentList->Clone();
+        }
         CloneTable( StorageClass, m_StorageClassTable );
         CloneTable( Statement, m_StatementTable );
 
@@ -6,14 +6,30 @@
         struct Statement;
         struct ArgumentList;
         struct Argument;
+        struct FunctionDeclaration;
+
+        // Source of a function body whose parsing has been deferred.
+        struct FunctionBodySource : Base::Object
+        {
+            virtual ~FunctionBodySource() {}
+
+            virtual void Parse( FunctionDeclaration & declaration ) const = 0;
+        };
 
         struct FunctionDeclaration : GlobalDeclaration
         {
             AST_HandleVisitor()
 
+            FunctionDeclaration() : GlobalDeclaration( NodeKind_FunctionDeclaration ) {}
+
             void AddStorageClass( StorageClass * storage ){ m_StorageClassTable.emplace_back( storage ); }
             void AddStatement( Statement * statement ){ m_StatementTable.emplace_back( statement ); }
 
+            // Fills m_StatementTable if the body parsing was deferred. Must be
+            // called before accessing the statements of a parsed declaration.
+            void ResolveBody() const;
+            bool HasDeferredBody() const { return m_BodySource; }
+
             virtual FunctionDeclaration * Clone() const override;
 
             Base::ObjectRef<Type>
@@ -27,6 +43,8 @@
                 m_StorageClassTable;
             std::vector< Base::ObjectRef<Statement> >
                 m_StatementTable;
+            mutable Base::ObjectRef<FunctionBodySource>
+                m_BodySource;
 
         };
 
@@ -34,6 +52,8 @@
         {
             AST_HandleVisitor()
 
+            ArgumentList() : Node( NodeKind_ArgumentList ) {}
+
             void AddArgument( Argument * argument ){ m_ArgumentTable.emplace_back( argument ); }
 
             virtual ArgumentList * Clone() const override;
@@ -46,6 +66,8 @@
         {
             AST_HandleVisitor()
 
+            Argument() : Node( NodeKind_Argument ) {}
+
             virtual Argument * Clone() const override;
 
             Base::ObjectRef<Type>
@@ -1,4 +1,5 @@
 #include "node.h"
+#include "node_allocation.h"
 
 namespace AST
 {
@@ -15,26 +16,37 @@ namespace AST
             } \
         }
 
-    Node::Node():
-        m_FileName( s_CurrentFileName ),
-        m_Line( s_CurrentLine )
+    Node::Node( const NodeKind kind ):
+        m_Location( s_CurrentLocation ),
+        m_Kind( kind )
     {
+        NodeAllocation::Add( m_Kind );
+    }
+
+    Node::Node( const Node & other ):
+        Base::Object(),
+        m_Location( other.m_Location ),
+        m_Kind( other.m_Kind )
+    {
+        NodeAllocation::Add( m_Kind );
+    }
 
+    Node::~Node()
+    {
+        NodeAllocation::Remove( m_Kind );
     }
 
     void Node::SetDebugInfo(
         const std::string & filename,
-        const int line
+        const int line,
+        const int column
         )
     {
-        s_CurrentFileName = filename;
-        s_CurrentLine = line;
+        s_CurrentLocation = SourceLocation( filename, line, column );
     }
 
-    std::string
-        Node::s_CurrentFileName;
-    int
-        Node::s_CurrentLine = -1;
+    thread_local SourceLocation
+        Node::s_CurrentLocation;
 
 
     TranslationUnit * TranslationUnit::Clone() const
@@ -163,9 +175,17 @@ namespace AST
 
         clone->m_Name = m_Name;
         clone->m_Semantic = m_Semantic;
-        clone->m_InitialValue = m_InitialValue->Clone();
         clone->m_ArraySize = m_ArraySize;
-        clone->m_Annotations = m_Annotations->Clone();
+
+        if( m_InitialValue )
+        {
+            clone->m_InitialValue = m_InitialValue->Clone();
+        }
+
+        if( m_Annotations )
+        {
+            clone->m_Annotations = m_Annotations->Clone();
+        }
 
         return clone;
     }
@@ -8,6 +8,8 @@
 
     #include "visitor.h"
     #include "const_visitor.h"
+    #include "source_location.h"
+    #include "node_kind.h"
     #include "base/object.h"
     #include "base/object_ref.h"
 
@@ -35,46 +37,76 @@
 
         struct Node : public Base::Object
         {
-            Node();
+            explicit Node( const NodeKind kind );
+            Node( const Node & other );
             virtual void Visit( AST::Visitor & visitor ){ visitor.Visit( *this ); };
             virtual void Visit( AST::ConstVisitor & visitor ) const { visitor.Visit( *this ); };
 
-            virtual ~Node(){}
+            virtual ~Node();
 
             virtual Node * Clone() const = 0;
 
             static void SetDebugInfo(
                 const std::string & filename,
-                const int line
+                const int line,
+                const int column = 0
                 );
 
+            static void SetDebugInfo(
+                const SourceLocation & location
+                )
+            {
+                s_CurrentLocation = location;
+            }
+
+            static const SourceLocation & GetCurrentLocation()
+            {
+                return s_CurrentLocation;
+            }
+
             static const std::string & GetCurrentFileName()
             {
-                return s_CurrentFileName;
+                return s_CurrentLocation.GetFileName();
             }
 
             static int GetCurrentLine()
             {
-                return s_CurrentLine;
+                return s_CurrentLocation.GetLine();
             }
 
-            const std::string
-                m_FileName;
-            const int
-                m_Line;
+            const std::string & GetFileName() const
+            {
+                return m_Location.GetFileName();
+            }
+
+            int GetLine() const
+            {
+                return m_Location.GetLine();
+            }
+
+            int GetColumn() const
+            {
+                return m_Location.GetColumn();
+            }
+
+            const SourceLocation
+                m_Location;
+            const NodeKind
+                m_Kind;
 
         private:
 
             Node & operator =( const Node & );
 
-            static std::string
-                s_CurrentFileName;
-            static int
-                s_CurrentLine;
+            // Per thread, so that files can be parsed concurrently
+            static thread_local SourceLocation
+                s_CurrentLocation;
         };
 
         struct GlobalDeclaration : Node
         {
+            explicit GlobalDeclaration( const NodeKind kind ) : Node( kind ) {}
+
             virtual GlobalDeclaration * Clone() const override { return 0; }
         };
 
@@ -82,6 +114,8 @@
         {
             AST_HandleVisitor()
 
+            TranslationUnit() : Node( NodeKind_TranslationUnit ) {}
+
             void AddGlobalDeclaration( GlobalDeclaration * declaration )
             {
                 assert( declaration );
@@ -105,6 +139,9 @@
         struct VariableDeclaration : GlobalDeclaration
         {
             AST_HandleVisitor()
+
+            VariableDeclaration() : GlobalDeclaration( NodeKind_VariableDeclaration ) {}
+
             void SetType( Type * type ){ assert( type ); m_Type = type; }
             void AddStorageClass( StorageClass * storage_class ){ assert( storage_class ); m_StorageClass.emplace_back( storage_class ); }
             void AddTypeModifier( TypeModifier * type_modifier ){ assert( type_modifier ); m_TypeModifier.emplace_back( type_modifier ); }
@@ -122,13 +159,14 @@
         {
             AST_HandleVisitor()
 
-            TextureDeclaration() {}
+            TextureDeclaration() : GlobalDeclaration( NodeKind_TextureDeclaration ) {}
             TextureDeclaration(
                 const std::string & type,
                 const std::string & name,
                 const std::string & semantic,
                 Annotations * annotations
                 ) :
+                GlobalDeclaration( NodeKind_TextureDeclaration ),
                 m_Type( type ),
                 m_Name( name ),
                 m_Semantic( semantic ),
@@ -151,11 +189,12 @@
         {
             AST_HandleVisitor()
 
-            SamplerDeclaration() {}
+            SamplerDeclaration() : GlobalDeclaration( NodeKind_SamplerDeclaration ) {}
             SamplerDeclaration(
                 const std::string & type,
                 const std::string & name
                 ) :
+                GlobalDeclaration( NodeKind_SamplerDeclaration ),
                 m_Type( type ),
                 m_Name( name )
             {
@@ -180,11 +219,12 @@
         struct SamplerBody : Node
         {
             AST_HandleVisitor()
-            SamplerBody(){}
+            SamplerBody() : Node( NodeKind_SamplerBody ){}
             SamplerBody(
                 const std::string & name,
                 const std::string & value
                 ) :
+                Node( NodeKind_SamplerBody ),
                 m_Name( name ),
                 m_Value( value )
             {
@@ -201,8 +241,8 @@
         struct StructDefinition: GlobalDeclaration
         {
             AST_HandleVisitor()
-            StructDefinition() {}
-            StructDefinition( const std::string & name ) : m_Name( name ) {}
+            StructDefinition() : GlobalDeclaration( NodeKind_StructDefinition ) {}
+            StructDefinition( const std::string & name ) : GlobalDeclaration( NodeKind_StructDefinition ), m_Name( name ) {}
 
             struct Member
             {
@@ -250,8 +290,9 @@
 
         struct Type : Node
         {
-            Type() {}
-            Type( const std::string & name ) : m_Name( name ) {}
+            explicit Type( const NodeKind kind ) : Node( kind ) {}
+            Type( const NodeKind kind, const std::string & name ) : Node( kind ), m_Name( name ) {}
+            Type( const std::string & name ) : Node( NodeKind_Type ), m_Name( name ) {}
 
             virtual Type * Clone() const override { return 0; }
 
@@ -263,8 +304,8 @@
         {
             AST_HandleVisitor()
 
-            IntrinsicType(){}
-            IntrinsicType( const std::string & name ) : Type( name ) {}
+            IntrinsicType() : Type( NodeKind_IntrinsicType ){}
+            IntrinsicType( const std::string & name ) : Type( NodeKind_IntrinsicType, name ) {}
 
             virtual IntrinsicType * Clone() const override;
         };
@@ -273,16 +314,18 @@
         {
             AST_HandleVisitor()
 
-            UserDefinedType() {}
-            UserDefinedType( const std::string & name ) : Type( name ) {}
+            UserDefinedType() : Type( NodeKind_UserDefinedType ) {}
+            UserDefinedType( const std::string & name ) : Type( NodeKind_UserDefinedType, name ) {}
 
             virtual UserDefinedType * Clone() const override;
         };
 
         struct SamplerType : Type
         {
-            SamplerType() {}
-            SamplerType( const std::string & name ) : Type( name ) {}
+            AST_HandleVisitor()
+
+            SamplerType() : Type( NodeKind_SamplerType ) {}
+            SamplerType( const std::string & name ) : Type( NodeKind_SamplerType, name ) {}
 
             virtual SamplerType * Clone() const override;
         };
@@ -291,8 +334,8 @@
         {
             AST_HandleVisitor()
 
-            TypeModifier() {}
-            TypeModifier( const std::string & modifier ) : m_Value( modifier ){}
+            TypeModifier() : Node( NodeKind_TypeModifier ) {}
+            TypeModifier( const std::string & modifier ) : Node( NodeKind_TypeModifier ), m_Value( modifier ){}
 
             virtual TypeModifier * Clone() const override;
             std::string m_Value;
@@ -302,8 +345,8 @@
         {
             AST_HandleVisitor()
 
-            StorageClass(){}
-            StorageClass( const std::string & storage_class ) : m_Value( storage_class ){}
+            StorageClass() : Node( NodeKind_StorageClass ){}
+            StorageClass( const std::string & storage_class ) : Node( NodeKind_StorageClass ), m_Value( storage_class ){}
             virtual StorageClass * Clone() const override;
             std::string m_Value;
         };
@@ -312,8 +355,8 @@
         {
             AST_HandleVisitor()
 
-            VariableDeclarationBody() : m_ArraySize( 0 ) {}
-            VariableDeclarationBody( const std::string & name ) : m_Name( name ), m_ArraySize( 0 ) {}
+            VariableDeclarationBody() : Node( NodeKind_VariableDeclarationBody ), m_ArraySize( 0 ) {}
+            VariableDeclarationBody( const std::string & name ) : Node( NodeKind_VariableDeclarationBody ), m_Name( name ), m_ArraySize( 0 ) {}
 
             virtual VariableDeclarationBody * Clone() const override;
 
@@ -332,7 +375,7 @@
         {
             AST_HandleVisitor()
 
-            InitialValue() : m_Vector( false ){}
+            InitialValue() : Node( NodeKind_InitialValue ), m_Vector( false ){}
 
             void AddExpression( Expression * expression ){ assert( expression ); m_ExpressionTable.emplace_back( expression ); }
 
@@ -0,0 +1,229 @@
+#include "node_allocation.h"
+
+#include "ast/node.h"
+#include "base/statistics.h"
+#include <iomanip>
+#include <string>
+
+namespace AST
+{
+    namespace
+    {
+        struct KindInformation
+        {
+            NodeKind
+                m_Kind;
+            const char
+                * m_Name;
+        };
+
+        #define AST_NodeAllocationEntry( _Type_ ) { NodeKind_##_Type_, #_Type_ }
+
+        // Same order as NodeKind
+        const KindInformation
+            KindInformationTable[] =
+        {
+            AST_NodeAllocationEntry( TranslationUnit ),
+            AST_NodeAllocationEntry( VariableDeclaration ),
+            AST_NodeAllocationEntry( TextureDeclaration ),
+            AST_NodeAllocationEntry( SamplerDeclaration ),
+            AST_NodeAllocationEntry( SamplerBody ),
+            AST_NodeAllocationEntry( StructDefinition ),
+            AST_NodeAllocationEntry( StructMember ),
+            AST_NodeAllocationEntry( Type ),
+            AST_NodeAllocationEntry( IntrinsicType ),
+            AST_NodeAllocationEntry( UserDefinedType ),
+            AST_NodeAllocationEntry( SamplerType ),
+            AST_NodeAllocationEntry( TypeModifier ),
+            AST_NodeAllocationEntry( StorageClass ),
+            AST_NodeAllocationEntry( VariableDeclarationBody ),
+            AST_NodeAllocationEntry( InitialValue ),
+            AST_NodeAllocationEntry( Annotations ),
+            AST_NodeAllocationEntry( AnnotationEntry ),
+            AST_NodeAllocationEntry( FunctionDeclaration ),
+            AST_NodeAllocationEntry( ArgumentList ),
+            AST_NodeAllocationEntry( Argument ),
+            AST_NodeAllocationEntry( LiteralExpression ),
+            AST_NodeAllocationEntry( VariableExpression ),
+            AST_NodeAllocationEntry( UnaryOperationExpression ),
+            AST_NodeAllocationEntry( BinaryOperationExpression ),
+            AST_NodeAllocationEntry( CallExpression ),
+            AST_NodeAllocationEntry( ArgumentExpressionList ),
+            AST_NodeAllocationEntry( Swizzle ),
+            AST_NodeAllocationEntry( PostfixSuffixCall ),
+            AST_NodeAllocationEntry( PostfixSuffixVariable ),
+            AST_NodeAllocationEntry( ConstructorExpression ),
+            AST_NodeAllocationEntry( ConditionalExpression ),
+            AST_NodeAllocationEntry( LValueExpression ),
+            AST_NodeAllocationEntry( PreModifyExpression ),
+            AST_NodeAllocationEntry( PostModifyExpression ),
+            AST_NodeAllocationEntry( CastExpression ),
+            AST_NodeAllocationEntry( AssignmentExpression ),
+            AST_NodeAllocationEntry( PostfixExpression ),
+            AST_NodeAllocationEntry( ReturnStatement ),
+            AST_NodeAllocationEntry( BreakStatement ),
+            AST_NodeAllocationEntry( ContinueStatement ),
+            AST_NodeAllocationEntry( DiscardStatement ),
+            AST_NodeAllocationEntry( EmptyStatement ),
+            AST_NodeAllocationEntry( ExpressionStatement ),
+            AST_NodeAllocationEntry( IfStatement ),
+            AST_NodeAllocationEntry( WhileStatement ),
+            AST_NodeAllocationEntry( DoWhileStatement ),
+            AST_NodeAllocationEntry( ForStatement ),
+            AST_NodeAllocationEntry( BlockStatement ),
+            AST_NodeAllocationEntry( AssignmentStatement ),
+            AST_NodeAllocationEntry( VariableDeclarationStatement ),
+            AST_NodeAllocationEntry( Technique ),
+            AST_NodeAllocationEntry( Pass ),
+            AST_NodeAllocationEntry( ShaderDefinition ),
+            AST_NodeAllocationEntry( ShaderArgumentList )
+        };
+
+        #undef AST_NodeAllocationEntry
+
+        static_assert(
+            sizeof( KindInformationTable ) / sizeof( KindInformationTable[ 0 ] ) == NodeKind_Count,
+            "Every node kind needs an allocation entry"
+            );
+    }
+
+    // Same order as NodeKind
+    const size_t
+        NodeAllocation::s_SizeTable[ NodeKind_Count ] =
+    {
+        sizeof( TranslationUnit ),
+        sizeof( VariableDeclaration ),
+        sizeof( TextureDeclaration ),
+        sizeof( SamplerDeclaration ),
+        sizeof( SamplerBody ),
+        sizeof( StructDefinition ),
+        0, // Members are not nodes, the kind is only used by flat units
+        sizeof( Type ),
+        sizeof( IntrinsicType ),
+        sizeof( UserDefinedType ),
+        sizeof( SamplerType ),
+        sizeof( TypeModifier ),
+        sizeof( StorageClass ),
+        sizeof( VariableDeclarationBody ),
+        sizeof( InitialValue ),
+        sizeof( Annotations ),
+        sizeof( AnnotationEntry ),
+        sizeof( FunctionDeclaration ),
+        sizeof( ArgumentList ),
+        sizeof( Argument ),
+        sizeof( LiteralExpression ),
+        sizeof( VariableExpression ),
+        sizeof( UnaryOperationExpression ),
+        sizeof( BinaryOperationExpression ),
+        sizeof( CallExpression ),
+        sizeof( ArgumentExpressionList ),
+        sizeof( Swizzle ),
+        sizeof( PostfixSuffixCall ),
+        sizeof( PostfixSuffixVariable ),
+        sizeof( ConstructorExpression ),
+        sizeof( ConditionalExpression ),
+        sizeof( LValueExpression ),
+        sizeof( PreModifyExpression ),
+        sizeof( PostModifyExpression ),
+        sizeof( CastExpression ),
+        sizeof( AssignmentExpression ),
+        sizeof( PostfixExpression ),
+        sizeof( ReturnStatement ),
+        sizeof( BreakStatement ),
+        sizeof( ContinueStatement ),
+        sizeof( DiscardStatement ),
+        sizeof( EmptyStatement ),
+        sizeof( ExpressionStatement ),
+        sizeof( IfStatement ),
+        sizeof( WhileStatement ),
+        sizeof( DoWhileStatement ),
+        sizeof( ForStatement ),
+        sizeof( BlockStatement ),
+        sizeof( AssignmentStatement ),
+        sizeof( VariableDeclarationStatement ),
+        sizeof( Technique ),
+        sizeof( Pass ),
+        sizeof( ShaderDefinition ),
+        sizeof( ShaderArgumentList )
+    };
+
+    std::atomic<size_t>
+        NodeAllocation::s_LiveCountTable[ NodeKind_Count ],
+        NodeAllocation::s_PeakCountTable[ NodeKind_Count ],
+        NodeAllocation::s_LiveSize( 0 ),
+        NodeAllocation::s_PeakSize( 0 );
+
+    const char * NodeAllocation::GetName( const NodeKind kind )
+    {
+        assert( KindInformationTable[ kind ].m_Kind == kind );
+
+        return KindInformationTable[ kind ].m_Name;
+    }
+
+    void NodeAllocation::ResetPeak()
+    {
+        for( int kind = 0; kind < NodeKind_Count; ++kind )
+        {
+            s_PeakCountTable[ kind ] = s_LiveCountTable[ kind ].load();
+        }
+
+        s_PeakSize = s_LiveSize.load();
+    }
+
+    void NodeAllocation::Print( std::ostream & stream )
+    {
+        std::ios::fmtflags
+            flags = stream.flags();
+
+        stream << std::left << std::setw( 30 ) << "node type"
+            << std::right << std::setw( 6 ) << "size"
+            << std::setw( 10 ) << "live"
+            << std::setw( 10 ) << "peak"
+            << std::setw( 14 ) << "live bytes"
+            << std::setw( 14 ) << "peak bytes" << "\n";
+
+        for( int kind = 0; kind < NodeKind_Count; ++kind )
+        {
+            if( s_PeakCountTable[ kind ].load() == 0 )
+            {
+                continue;
+            }
+
+            stream << std::left << std::setw( 30 ) << KindInformationTable[ kind ].m_Name
+                << std::right << std::setw( 6 ) << s_SizeTable[ kind ]
+                << std::setw( 10 ) << s_LiveCountTable[ kind ].load()
+                << std::setw( 10 ) << s_PeakCountTable[ kind ].load()
+                << std::setw( 14 ) << s_LiveCountTable[ kind ].load() * s_SizeTable[ kind ]
+                << std::setw( 14 ) << s_PeakCountTable[ kind ].load() * s_SizeTable[ kind ] << "\n";
+        }
+
+        stream << std::left << std::setw( 56 ) << "total"
+            << std::right << std::setw( 14 ) << s_LiveSize.load()
+            << std::setw( 14 ) << s_PeakSize.load() << "\n";
+
+        stream.flags( flags );
+    }
+
+    void NodeAllocation::AddStatistics()
+    {
+        Base::Statistics::AddCount( "ast_live_bytes", s_LiveSize.load() );
+        Base::Statistics::AddCount( "ast_peak_bytes", s_PeakSize.load() );
+
+        for( int kind = 0; kind < NodeKind_Count; ++kind )
+        {
+            if( s_PeakCountTable[ kind ].load() == 0 )
+            {
+                continue;
+            }
+
+            const std::string
+                name = KindInformationTable[ kind ].m_Name;
+            const size_t
+                live_count = s_LiveCountTable[ kind ].load();
+
+            Base::Statistics::AddCount( ( "ast_live_count." + name ).c_str(), live_count );
+            Base::Statistics::AddCount( ( "ast_live_bytes." + name ).c_str(), live_count * s_SizeTable[ kind ] );
+            Base::Statistics::AddCount( ( "ast_peak_bytes." + name ).c_str(), s_PeakCountTable[ kind ].load() * s_SizeTable[ kind ] );
+        }
+    }
+}
\ No newline at end of file
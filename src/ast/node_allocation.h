@@ -0,0 +1,67 @@
+#ifndef NODE_ALLOCATION_H
+    #define NODE_ALLOCATION_H
+
+    #include "ast/node_kind.h"
+    #include <atomic>
+    #include <cstddef>
+    #include <ostream>
+
+    namespace AST
+    {
+        // Live and peak node counts per kind, kept up to date by the Node constructors and
+        // destructor. Sizes are those of the node objects, strings and tables they own are
+        // not included. Counters are atomic as nodes are created by several server threads.
+
+        class NodeAllocation
+        {
+        public:
+
+            static void Add( const NodeKind kind )
+            {
+                UpdatePeak( s_PeakCountTable[ kind ], s_LiveCountTable[ kind ].fetch_add( 1, std::memory_order_relaxed ) + 1 );
+                UpdatePeak( s_PeakSize, s_LiveSize.fetch_add( s_SizeTable[ kind ], std::memory_order_relaxed ) + s_SizeTable[ kind ] );
+            }
+
+            static void Remove( const NodeKind kind )
+            {
+                s_LiveCountTable[ kind ].fetch_sub( 1, std::memory_order_relaxed );
+                s_LiveSize.fetch_sub( s_SizeTable[ kind ], std::memory_order_relaxed );
+            }
+
+            static const char * GetName( const NodeKind kind );
+            static size_t GetSize( const NodeKind kind ) { return s_SizeTable[ kind ]; }
+            static size_t GetLiveCount( const NodeKind kind ) { return s_LiveCountTable[ kind ].load(); }
+            static size_t GetPeakCount( const NodeKind kind ) { return s_PeakCountTable[ kind ].load(); }
+            static size_t GetLiveSize() { return s_LiveSize.load(); }
+            static size_t GetPeakSize() { return s_PeakSize.load(); }
+
+            // Peaks restart from the live values
+            static void ResetPeak();
+
+            static void Print( std::ostream & stream );
+            static void AddStatistics();
+
+        private:
+
+            static void UpdatePeak( std::atomic<size_t> & peak, const size_t value )
+            {
+                size_t
+                    current_peak = peak.load( std::memory_order_relaxed );
+
+                while( value > current_peak
+                    && !peak.compare_exchange_weak( current_peak, value, std::memory_order_relaxed ) )
+                {
+                }
+            }
+
+            static const size_t
+                s_SizeTable[ NodeKind_Count ];
+            static std::atomic<size_t>
+                s_LiveCountTable[ NodeKind_Count ],
+                s_PeakCountTable[ NodeKind_Count ],
+                s_LiveSize,
+                s_PeakSize;
+        };
+    }
+
+#endif
\ No newline at end of file
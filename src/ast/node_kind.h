@@ -0,0 +1,73 @@
+#ifndef NODE_KIND_H
+    #define NODE_KIND_H
+
+    namespace AST
+    {
+        enum NodeKind
+        {
+            NodeKind_TranslationUnit,
+            NodeKind_VariableDeclaration,
+            NodeKind_TextureDeclaration,
+            NodeKind_SamplerDeclaration,
+            NodeKind_SamplerBody,
+            NodeKind_StructDefinition,
+            NodeKind_StructMember,
+            NodeKind_Type,
+            NodeKind_IntrinsicType,
+            NodeKind_UserDefinedType,
+            NodeKind_SamplerType,
+            NodeKind_TypeModifier,
+            NodeKind_StorageClass,
+            NodeKind_VariableDeclarationBody,
+            NodeKind_InitialValue,
+            NodeKind_Annotations,
+            NodeKind_AnnotationEntry,
+            NodeKind_FunctionDeclaration,
+            NodeKind_ArgumentList,
+            NodeKind_Argument,
+
+            // Expressions
+            NodeKind_LiteralExpression,
+            NodeKind_VariableExpression,
+            NodeKind_UnaryOperationExpression,
+            NodeKind_BinaryOperationExpression,
+            NodeKind_CallExpression,
+            NodeKind_ArgumentExpressionList,
+            NodeKind_Swizzle,
+            NodeKind_PostfixSuffixCall,
+            NodeKind_PostfixSuffixVariable,
+            NodeKind_ConstructorExpression,
+            NodeKind_ConditionalExpression,
+            NodeKind_LValueExpression,
+            NodeKind_PreModifyExpression,
+            NodeKind_PostModifyExpression,
+            NodeKind_CastExpression,
+            NodeKind_AssignmentExpression,
+            NodeKind_PostfixExpression,
+
+            // Statements
+            NodeKind_ReturnStatement,
+            NodeKind_BreakStatement,
+            NodeKind_ContinueStatement,
+            NodeKind_DiscardStatement,
+            NodeKind_EmptyStatement,
+            NodeKind_ExpressionStatement,
+            NodeKind_IfStatement,
+            NodeKind_WhileStatement,
+            NodeKind_DoWhileStatement,
+            NodeKind_ForStatement,
+            NodeKind_BlockStatement,
+            NodeKind_AssignmentStatement,
+            NodeKind_VariableDeclarationStatement,
+
+            // Techniques
+            NodeKind_Technique,
+            NodeKind_Pass,
+            NodeKind_ShaderDefinition,
+            NodeKind_ShaderArgumentList,
+
+            NodeKind_Count
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "node_size_report.h"
+
+#include <cassert>
+#include <iomanip>
+
+#include <ast/node.h>
+
+namespace AST
+{
+    void NodeSizeReport::Visit( const Node & /*node*/ )
+    {
+        assert( !"Unsupported node type, implement in base class" );
+    }
+
+    void NodeSizeReport::Visit( const FunctionDeclaration & declaration )
+    {
+        Count( declaration, "FunctionDeclaration" );
+
+        if( !declaration.HasDeferredBody() )
+        {
+            TreeTraverser::Visit( declaration );
+            return;
+        }
+
+        VisitTable( *this, declaration.m_StorageClassTable );
+
+        if ( declaration.m_Type )
+        {
+            declaration.m_Type->Visit( *this );
+        }
+
+        if ( declaration.m_ArgumentList )
+        {
+            declaration.m_ArgumentList->Visit( *this );
+        }
+    }
+
+    void NodeSizeReport::Print( std::ostream & stream ) const
+    {
+        std::map<std::string, Entry>::const_iterator it, end;
+
+        stream << std::left << std::setw( 32 ) << "node" << std::right
+            << std::setw( 8 ) << "size"
+            << std::setw( 10 ) << "count"
+            << std::setw( 12 ) << "bytes" << "\n";
+
+        for( it = m_EntryTable.begin(), end = m_EntryTable.end(); it != end; ++it )
+        {
+            stream << std::left << std::setw( 32 ) << (*it).first << std::right
+                << std::setw( 8 ) << (*it).second.m_Size
+                << std::setw( 10 ) << (*it).second.m_Count
+                << std::setw( 12 ) << (*it).second.m_Size * (*it).second.m_Count << "\n";
+        }
+
+        stream << std::left << std::setw( 32 ) << "total" << std::right
+            << std::setw( 8 ) << ""
+            << std::setw( 10 ) << m_NodeCount
+            << std::setw( 12 ) << m_TotalSize << "\n";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef NODE_SIZE_REPORT_H
+    #define NODE_SIZE_REPORT_H
+
+    #include "ast/tree_traverser.h"
+    #include <map>
+    #include <ostream>
+    #include <string>
+
+    namespace AST
+    {
+        // Counts the nodes of a tree with their size, deferred function bodies are not parsed
+
+        class NodeSizeReport : public TreeTraverser
+        {
+        public:
+
+            struct Entry
+            {
+                Entry() : m_Count( 0 ), m_Size( 0 ) {}
+
+                size_t
+                    m_Count,
+                    m_Size;
+            };
+
+            NodeSizeReport() : m_NodeCount( 0 ), m_TotalSize( 0 ) {}
+
+            #define AST_NodeSizeReportVisit( _Type_ ) \
+                virtual void Visit( const _Type_ & node ) override { Count( node, #_Type_ ); TreeTraverser::Visit( node ); }
+
+            AST_NodeSizeReportVisit( TranslationUnit )
+            AST_NodeSizeReportVisit( VariableDeclaration )
+            AST_NodeSizeReportVisit( IntrinsicType )
+            AST_NodeSizeReportVisit( UserDefinedType )
+            AST_NodeSizeReportVisit( SamplerType )
+            AST_NodeSizeReportVisit( TypeModifier )
+            AST_NodeSizeReportVisit( StorageClass )
+            AST_NodeSizeReportVisit( ArgumentList )
+            AST_NodeSizeReportVisit( VariableDeclarationBody )
+            AST_NodeSizeReportVisit( InitialValue )
+            AST_NodeSizeReportVisit( Annotations )
+            AST_NodeSizeReportVisit( AnnotationEntry )
+            AST_NodeSizeReportVisit( TextureDeclaration )
+            AST_NodeSizeReportVisit( SamplerDeclaration )
+            AST_NodeSizeReportVisit( SamplerBody )
+            AST_NodeSizeReportVisit( StructDefinition )
+            AST_NodeSizeReportVisit( Argument )
+            AST_NodeSizeReportVisit( LiteralExpression )
+            AST_NodeSizeReportVisit( VariableExpression )
+            AST_NodeSizeReportVisit( UnaryOperationExpression )
+            AST_NodeSizeReportVisit( BinaryOperationExpression )
+            AST_NodeSizeReportVisit( CallExpression )
+            AST_NodeSizeReportVisit( ArgumentExpressionList )
+            AST_NodeSizeReportVisit( Swizzle )
+            AST_NodeSizeReportVisit( PostfixSuffixCall )
+            AST_NodeSizeReportVisit( PostfixSuffixVariable )
+            AST_NodeSizeReportVisit( ConstructorExpression )
+            AST_NodeSizeReportVisit( ConditionalExpression )
+            AST_NodeSizeReportVisit( LValueExpression )
+            AST_NodeSizeReportVisit( PreModifyExpression )
+            AST_NodeSizeReportVisit( PostModifyExpression )
+            AST_NodeSizeReportVisit( CastExpression )
+            AST_NodeSizeReportVisit( AssignmentExpression )
+            AST_NodeSizeReportVisit( PostfixExpression )
+            AST_NodeSizeReportVisit( ReturnStatement )
+            AST_NodeSizeReportVisit( BreakStatement )
+            AST_NodeSizeReportVisit( ContinueStatement )
+            AST_NodeSizeReportVisit( DiscardStatement )
+            AST_NodeSizeReportVisit( EmptyStatement )
+            AST_NodeSizeReportVisit( ExpressionStatement )
+            AST_NodeSizeReportVisit( IfStatement )
+            AST_NodeSizeReportVisit( WhileStatement )
+            AST_NodeSizeReportVisit( DoWhileStatement )
+            AST_NodeSizeReportVisit( ForStatement )
+            AST_NodeSizeReportVisit( BlockStatement )
+            AST_NodeSizeReportVisit( AssignmentStatement )
+            AST_NodeSizeReportVisit( VariableDeclarationStatement )
+
+            #undef AST_NodeSizeReportVisit
+
+            virtual void Visit( const Node & node ) override;
+            virtual void Visit( const FunctionDeclaration & declaration ) override;
+
+            void Print( std::ostream & stream ) const;
+
+            size_t GetNodeCount() const { return m_NodeCount; }
+            size_t GetTotalSize() const { return m_TotalSize; }
+            const std::map<std::string, Entry> & GetEntryTable() const { return m_EntryTable; }
+
+        private:
+
+            template< typename _Node_ >
+            void Count( const _Node_ & /*node*/, const char * name )
+            {
+                Entry
+                    & entry = m_EntryTable[ name ];
+
+                entry.m_Size = sizeof( _Node_ );
+                ++entry.m_Count;
+                ++m_NodeCount;
+                m_TotalSize += sizeof( _Node_ );
+            }
+
+            std::map<std::string, Entry>
+                m_EntryTable;
+            size_t
+                m_NodeCount,
+                m_TotalSize;
+        };
+    }
+#endif
\ No newline at end of file
@@ -578,6 +578,35 @@ namespace AST
         std::cout << dec_ind << endl_ind << "}" << endl_ind;
     }
 
+    void PrintVisitor::Visit( const ForStatement & statement )
+    {
+        std::cout
+            << "ForStatement" << endl_ind
+            << "{ " << inc_ind << endl_ind;
+
+        if( statement.m_InitStatement )
+        {
+            statement.m_InitStatement->Visit( *this );
+        }
+
+        if( statement.m_EqualityExpression )
+        {
+            statement.m_EqualityExpression->Visit( *this );
+        }
+
+        if( statement.m_ModifyExpression )
+        {
+            statement.m_ModifyExpression->Visit( *this );
+        }
+
+        if( statement.m_Statement )
+        {
+            statement.m_Statement->Visit( *this );
+        }
+
+        std::cout << dec_ind << endl_ind << "}" << endl_ind;
+    }
+
     void PrintVisitor::Visit( const BlockStatement & statement )
     {
         std::cout
@@ -55,6 +55,7 @@
             virtual void Visit( const IfStatement & statement ) override;
             virtual void Visit( const WhileStatement & statement ) override;
             virtual void Visit( const DoWhileStatement & statement ) override;
+            virtual void Visit( const ForStatement & statement ) override;
             virtual void Visit( const BlockStatement & statement ) override;
 
         };
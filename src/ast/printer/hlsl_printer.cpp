@@ -166,6 +166,7 @@ namespace AST
 
         m_Stream << endl_ind << "{" << inc_ind << endl_ind;
 
+        declaration.ResolveBody();
         AST::VisitTable( *this, declaration.m_StatementTable );
 
         m_Stream << dec_ind << endl_ind << "}" << endl_ind;
@@ -292,6 +292,18 @@ namespace AST
         m_Stream << " );\n";
     }
 
+    void XLSLPrinter::Visit( const ForStatement & statement )
+    {
+        // The init statement prints its own semicolon
+        m_Stream << "for( ";
+        statement.m_InitStatement->Visit( *this );
+        statement.m_EqualityExpression->Visit( *this );
+        m_Stream << "; ";
+        statement.m_ModifyExpression->Visit( *this );
+        m_Stream << " ) ";
+        statement.m_Statement->Visit( *this );
+    }
+
     void XLSLPrinter::Visit( const BlockStatement & statement )
     {
         if( statement.m_StatementTable.empty() )
@@ -0,0 +1,113 @@
+#include "source_location.h"
+
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace AST
+{
+    namespace
+    {
+        struct FileTable
+        {
+            FileTable() : m_LastIndex( 0 )
+            {
+                m_NameTable.push_back( std::string() );
+                m_IndexTable[ std::string() ] = 0;
+            }
+
+            // A deque keeps the returned references valid when names are added
+            std::deque<std::string>
+                m_NameTable;
+            std::map<std::string, uint32_t>
+                m_IndexTable;
+            uint32_t
+                m_LastIndex;
+            std::mutex
+                m_Mutex;
+        };
+
+        FileTable & GetFileTable()
+        {
+            static FileTable
+                file_table;
+
+            return file_table;
+        }
+    }
+
+    SourceLocation::SourceLocation(
+        const std::string & filename,
+        const int line,
+        const int column
+        ) :
+        m_FileIndex( FindOrAddFile( filename ) ),
+        m_LineColumn( 0 )
+    {
+        uint32_t
+            encoded_line = line < 0 ? 0 : static_cast<uint32_t>( line > MaxLine ? MaxLine : line ) + 1,
+            encoded_column = column < 0 ? 0 : static_cast<uint32_t>( column > MaxColumn ? MaxColumn : column );
+
+        m_LineColumn = ( encoded_line << ColumnBitCount ) | encoded_column;
+    }
+
+    const std::string & SourceLocation::GetFileName() const
+    {
+        FileTable
+            & file_table = GetFileTable();
+        std::lock_guard<std::mutex>
+            lock( file_table.m_Mutex );
+
+        return file_table.m_NameTable[ m_FileIndex ];
+    }
+
+    int SourceLocation::GetLine() const
+    {
+        return static_cast<int>( m_LineColumn >> ColumnBitCount ) - 1;
+    }
+
+    int SourceLocation::GetColumn() const
+    {
+        return static_cast<int>( m_LineColumn & MaxColumn );
+    }
+
+    uint32_t SourceLocation::FindOrAddFile( const std::string & filename )
+    {
+        FileTable
+            & file_table = GetFileTable();
+        std::lock_guard<std::mutex>
+            lock( file_table.m_Mutex );
+
+        // Consecutive nodes nearly always come from the same file
+        if( file_table.m_NameTable[ file_table.m_LastIndex ] == filename )
+        {
+            return file_table.m_LastIndex;
+        }
+
+        std::map<std::string, uint32_t>::const_iterator
+            it = file_table.m_IndexTable.find( filename );
+
+        if( it != file_table.m_IndexTable.end() )
+        {
+            file_table.m_LastIndex = (*it).second;
+        }
+        else
+        {
+            file_table.m_LastIndex = static_cast<uint32_t>( file_table.m_NameTable.size() );
+            file_table.m_NameTable.push_back( filename );
+            file_table.m_IndexTable[ filename ] = file_table.m_LastIndex;
+        }
+
+        return file_table.m_LastIndex;
+    }
+
+    size_t SourceLocation::GetFileCount()
+    {
+        FileTable
+            & file_table = GetFileTable();
+        std::lock_guard<std::mutex>
+            lock( file_table.m_Mutex );
+
+        return file_table.m_NameTable.size();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef SOURCE_LOCATION_H
+    #define SOURCE_LOCATION_H
+
+    #include <cstdint>
+    #include <string>
+
+    namespace AST
+    {
+        // File names are interned once in a shared table, nodes only keep an index into it.
+        // The table is shared by every parse as nodes outlive them through the include cache,
+        // the lazy function bodies and the merged translation units.
+
+        struct SourceLocation
+        {
+            enum
+            {
+                ColumnBitCount = 12,
+                MaxColumn = ( 1 << ColumnBitCount ) - 1,
+                MaxLine = ( 1 << ( 32 - ColumnBitCount ) ) - 2
+            };
+
+            SourceLocation() : m_FileIndex( 0 ), m_LineColumn( 0 ) {}
+
+            SourceLocation(
+                const std::string & filename,
+                const int line,
+                const int column = 0
+                );
+
+            const std::string & GetFileName() const;
+            int GetLine() const;
+            int GetColumn() const;
+
+            static uint32_t FindOrAddFile( const std::string & filename );
+            static size_t GetFileCount();
+
+            uint32_t
+                m_FileIndex,
+                m_LineColumn;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -77,10 +77,22 @@ namespace AST
     {
         ForStatement * clone = new ForStatement;
 
-        clone->m_InitStatement = m_InitStatement->Clone();
         clone->m_Statement = m_Statement->Clone();
-        clone->m_EqualityExpression = m_EqualityExpression->Clone();
-        clone->m_ModifyExpression = m_ModifyExpression->Clone();
+
+        if( m_InitStatement )
+        {
+            clone->m_InitStatement = m_InitStatement->Clone();
+        }
+
+        if( m_EqualityExpression )
+        {
+            clone->m_EqualityExpression = m_EqualityExpression->Clone();
+        }
+
+        if( m_ModifyExpression )
+        {
+            clone->m_ModifyExpression = m_ModifyExpression->Clone();
+        }
 
         return clone;
     }
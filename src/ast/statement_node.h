@@ -7,6 +7,8 @@
 
         struct Statement : Node
         {
+            explicit Statement( const NodeKind kind ) : Node( kind ) {}
+
             virtual Statement * Clone() const override { return 0; }
         };
 
@@ -14,8 +16,8 @@
         {
             AST_HandleVisitor()
 
-            ReturnStatement(){}
-            ReturnStatement( Expression * expression ) : m_Expression( expression ) {}
+            ReturnStatement() : Statement( NodeKind_ReturnStatement ){}
+            ReturnStatement( Expression * expression ) : Statement( NodeKind_ReturnStatement ), m_Expression( expression ) {}
 
             virtual ReturnStatement * Clone() const override;
 
@@ -27,6 +29,8 @@
         {
             AST_HandleVisitor()
 
+            BreakStatement() : Statement( NodeKind_BreakStatement ) {}
+
             virtual BreakStatement * Clone() const { return new BreakStatement; }
         };
 
@@ -34,6 +38,8 @@
         {
             AST_HandleVisitor()
 
+            ContinueStatement() : Statement( NodeKind_ContinueStatement ) {}
+
             virtual ContinueStatement * Clone() const { return new ContinueStatement;}
         };
 
@@ -41,6 +47,8 @@
         {
             AST_HandleVisitor()
 
+            DiscardStatement() : Statement( NodeKind_DiscardStatement ) {}
+
             virtual DiscardStatement * Clone() const { return new DiscardStatement;}
         };
 
@@ -48,6 +56,8 @@
         {
             AST_HandleVisitor()
 
+            EmptyStatement() : Statement( NodeKind_EmptyStatement ) {}
+
             virtual EmptyStatement * Clone() const { return new EmptyStatement; }
         };
 
@@ -55,8 +65,8 @@
         {
             AST_HandleVisitor()
 
-            ExpressionStatement() {}
-            ExpressionStatement( Expression * expression ) : m_Expression( expression ) {}
+            ExpressionStatement() : Statement( NodeKind_ExpressionStatement ) {}
+            ExpressionStatement( Expression * expression ) : Statement( NodeKind_ExpressionStatement ), m_Expression( expression ) {}
 
             virtual ExpressionStatement * Clone() const override;
 
@@ -68,9 +78,10 @@
         {
             AST_HandleVisitor()
 
-            IfStatement() {}
+            IfStatement() : Statement( NodeKind_IfStatement ) {}
             IfStatement( Expression * condition, Statement * then_statement, Statement * else_statement )
                 :
+                Statement( NodeKind_IfStatement ),
                 m_Condition( condition ),
                 m_ThenStatement( then_statement ),
                 m_ElseStatement( else_statement )
@@ -91,8 +102,8 @@
         {
             AST_HandleVisitor()
 
-            WhileStatement() {}
-            WhileStatement( Expression * condition, Statement * statement ) : m_Condition( condition ), m_Statement( statement ) {}
+            WhileStatement() : Statement( NodeKind_WhileStatement ) {}
+            WhileStatement( Expression * condition, Statement * statement ) : Statement( NodeKind_WhileStatement ), m_Condition( condition ), m_Statement( statement ) {}
 
             virtual WhileStatement * Clone() const override;
 
@@ -106,8 +117,8 @@
         {
             AST_HandleVisitor()
 
-            DoWhileStatement() {}
-            DoWhileStatement( Expression * condition, Statement * statement ) : m_Condition( condition ), m_Statement( statement ) {}
+            DoWhileStatement() : Statement( NodeKind_DoWhileStatement ) {}
+            DoWhileStatement( Expression * condition, Statement * statement ) : Statement( NodeKind_DoWhileStatement ), m_Condition( condition ), m_Statement( statement ) {}
 
             virtual DoWhileStatement * Clone() const override;
 
@@ -119,8 +130,11 @@
 
         struct ForStatement : Statement
         {
-            ForStatement() {}
+            AST_HandleVisitor()
+
+            ForStatement() : Statement( NodeKind_ForStatement ) {}
             ForStatement( Statement * init_statement, Expression * equality_expression, Expression * modify_expression, Statement * statement ) :
+                Statement( NodeKind_ForStatement ),
                 m_InitStatement( init_statement ), m_Statement( statement ),
                 m_EqualityExpression( equality_expression ), m_ModifyExpression( modify_expression ){}
 
@@ -138,6 +152,8 @@
         {
             AST_HandleVisitor()
 
+            BlockStatement() : Statement( NodeKind_BlockStatement ) {}
+
             void AddStatement( Statement * statement ){ m_StatementTable.emplace_back( statement ); }
 
             virtual BlockStatement * Clone() const override;
@@ -150,6 +166,8 @@
         {
             AST_HandleVisitor()
 
+            VariableDeclarationStatement() : Statement( NodeKind_VariableDeclarationStatement ) {}
+
             void SetType( Type * type ){ assert( type ); m_Type = type; }
             void AddStorageClass( StorageClass * storage_class ){ assert( storage_class ); m_StorageClass.emplace_back( storage_class ); }
             void AddTypeModifier( TypeModifier * type_modifier ){ assert( type_modifier ); m_TypeModifier.emplace_back( type_modifier ); }
@@ -167,8 +185,9 @@
         {
             AST_HandleVisitor()
 
-            AssignmentStatement() {}
+            AssignmentStatement() : Statement( NodeKind_AssignmentStatement ) {}
             AssignmentStatement( LValueExpression * lvexp, AssignmentOperator op, Expression * exp ) :
+                Statement( NodeKind_AssignmentStatement ),
                 m_Expression( new AssignmentExpression( lvexp, op, exp ) )
             {
 
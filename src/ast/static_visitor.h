@@ -0,0 +1,396 @@
+#ifndef STATIC_VISITOR_H
+    #define STATIC_VISITOR_H
+
+    #include "ast/node.h"
+    #include <type_traits>
+
+    namespace AST
+    {
+        // Compile-time counterpart of VisitorBase. Dispatch() switches on the node kind and
+        // calls _Derived_::Visit directly, so the calls can be inlined. A derived class only
+        // declares the Visit it needs and keeps the empty defaults with a using declaration.
+        template< class _Derived_, bool is_const >
+        class StaticVisitor
+        {
+            struct identity{ template<typename T> struct m{typedef T type;}; };
+            struct add_const{ template<typename T> struct m : std::add_const<T>{}; };
+            typedef typename std::conditional<is_const, add_const, identity>::type modifier;
+
+        public:
+
+            #define AST_StaticVisitorCase( _Type_ ) \
+                case NodeKind_##_Type_: \
+                    derived.Visit( static_cast<typename modifier::template m<_Type_>::type &>( node ) ); \
+                    break;
+
+            void Dispatch( typename modifier::template m<Node>::type & node )
+            {
+                _Derived_
+                    & derived = static_cast<_Derived_ &>( *this );
+
+                switch( node.m_Kind )
+                {
+                    AST_StaticVisitorCase( TranslationUnit )
+                    AST_StaticVisitorCase( VariableDeclaration )
+                    AST_StaticVisitorCase( TextureDeclaration )
+                    AST_StaticVisitorCase( SamplerDeclaration )
+                    AST_StaticVisitorCase( SamplerBody )
+                    AST_StaticVisitorCase( StructDefinition )
+                    AST_StaticVisitorCase( IntrinsicType )
+                    AST_StaticVisitorCase( UserDefinedType )
+                    AST_StaticVisitorCase( SamplerType )
+                    AST_StaticVisitorCase( TypeModifier )
+                    AST_StaticVisitorCase( StorageClass )
+                    AST_StaticVisitorCase( VariableDeclarationBody )
+                    AST_StaticVisitorCase( InitialValue )
+                    AST_StaticVisitorCase( Annotations )
+                    AST_StaticVisitorCase( AnnotationEntry )
+                    AST_StaticVisitorCase( FunctionDeclaration )
+                    AST_StaticVisitorCase( ArgumentList )
+                    AST_StaticVisitorCase( Argument )
+                    AST_StaticVisitorCase( LiteralExpression )
+                    AST_StaticVisitorCase( VariableExpression )
+                    AST_StaticVisitorCase( UnaryOperationExpression )
+                    AST_StaticVisitorCase( BinaryOperationExpression )
+                    AST_StaticVisitorCase( CallExpression )
+                    AST_StaticVisitorCase( ArgumentExpressionList )
+                    AST_StaticVisitorCase( Swizzle )
+                    AST_StaticVisitorCase( PostfixSuffixCall )
+                    AST_StaticVisitorCase( PostfixSuffixVariable )
+                    AST_StaticVisitorCase( ConstructorExpression )
+                    AST_StaticVisitorCase( ConditionalExpression )
+                    AST_StaticVisitorCase( LValueExpression )
+                    AST_StaticVisitorCase( PreModifyExpression )
+                    AST_StaticVisitorCase( PostModifyExpression )
+                    AST_StaticVisitorCase( CastExpression )
+                    AST_StaticVisitorCase( AssignmentExpression )
+                    AST_StaticVisitorCase( PostfixExpression )
+                    AST_StaticVisitorCase( ReturnStatement )
+                    AST_StaticVisitorCase( BreakStatement )
+                    AST_StaticVisitorCase( ContinueStatement )
+                    AST_StaticVisitorCase( DiscardStatement )
+                    AST_StaticVisitorCase( EmptyStatement )
+                    AST_StaticVisitorCase( ExpressionStatement )
+                    AST_StaticVisitorCase( IfStatement )
+                    AST_StaticVisitorCase( WhileStatement )
+                    AST_StaticVisitorCase( DoWhileStatement )
+                    AST_StaticVisitorCase( ForStatement )
+                    AST_StaticVisitorCase( BlockStatement )
+                    AST_StaticVisitorCase( AssignmentStatement )
+                    AST_StaticVisitorCase( VariableDeclarationStatement )
+
+                    default:
+                        derived.Visit( node );
+                        break;
+                }
+            }
+
+            #undef AST_StaticVisitorCase
+
+            template< class _Table_ >
+            void DispatchTable( _Table_ & table )
+            {
+                for( size_t index = 0; index < table.size(); ++index )
+                {
+                    Dispatch( *table[ index ] );
+                }
+            }
+
+            template< typename _Node_ >
+            void Visit( _Node_ & /*node*/ )
+            {
+            }
+        };
+
+        // Same traversal order as TreeTraverser. Derived classes call the base Visit to
+        // continue into the children of the nodes they handle.
+        template< class _Derived_ >
+        class StaticTreeTraverser : public StaticVisitor< _Derived_, true >
+        {
+        public:
+
+            using StaticVisitor< _Derived_, true >::Visit;
+
+            void Visit( const TranslationUnit & translation_unit )
+            {
+                this->DispatchTable( translation_unit.m_GlobalDeclarationTable );
+                this->DispatchTable( translation_unit.m_TechniqueTable );
+            }
+
+            void Visit( const VariableDeclaration & variable_declaration )
+            {
+                this->DispatchTable( variable_declaration.m_StorageClass );
+                this->DispatchTable( variable_declaration.m_TypeModifier );
+                this->DispatchTable( variable_declaration.m_BodyTable );
+            }
+
+            void Visit( const ArgumentList & list )
+            {
+                this->DispatchTable( list.m_ArgumentTable );
+            }
+
+            void Visit( const VariableExpression & expression )
+            {
+                if ( expression.m_SubscriptExpression )
+                {
+                    this->Dispatch( *expression.m_SubscriptExpression );
+                }
+            }
+
+            void Visit( const UnaryOperationExpression & expression )
+            {
+                this->Dispatch( *expression.m_Expression );
+            }
+
+            void Visit( const BinaryOperationExpression & expression )
+            {
+                this->Dispatch( *expression.m_LeftExpression );
+                this->Dispatch( *expression.m_RightExpression );
+            }
+
+            void Visit( const CallExpression & expression )
+            {
+                if ( expression.m_ArgumentExpressionList )
+                {
+                    this->Dispatch( *expression.m_ArgumentExpressionList );
+                }
+            }
+
+            void Visit( const ArgumentExpressionList & list )
+            {
+                this->DispatchTable( list.m_ExpressionList );
+            }
+
+            void Visit( const PostfixSuffixCall & postfix_suffix )
+            {
+                this->Dispatch( *postfix_suffix.m_CallExpression );
+
+                if ( postfix_suffix.m_Suffix )
+                {
+                    this->Dispatch( *postfix_suffix.m_Suffix );
+                }
+            }
+
+            void Visit( const PostfixSuffixVariable & postfix_suffix )
+            {
+                this->Dispatch( *postfix_suffix.m_VariableExpression );
+
+                if ( postfix_suffix.m_Suffix )
+                {
+                    this->Dispatch( *postfix_suffix.m_Suffix );
+                }
+            }
+
+            void Visit( const ConstructorExpression & expression )
+            {
+                this->Dispatch( *expression.m_Type );
+
+                if ( expression.m_ArgumentExpressionList )
+                {
+                    this->Dispatch( *expression.m_ArgumentExpressionList );
+                }
+            }
+
+            void Visit( const ConditionalExpression & expression )
+            {
+                this->Dispatch( *expression.m_Condition );
+                this->Dispatch( *expression.m_IfTrue );
+                this->Dispatch( *expression.m_IfFalse );
+            }
+
+            void Visit( const LValueExpression & expression )
+            {
+                this->Dispatch( *expression.m_VariableExpression );
+
+                if ( expression.m_Suffix )
+                {
+                    this->Dispatch( *expression.m_Suffix );
+                }
+            }
+
+            void Visit( const PreModifyExpression & expression )
+            {
+                this->Dispatch( *expression.m_Expression );
+            }
+
+            void Visit( const PostModifyExpression & expression )
+            {
+                this->Dispatch( *expression.m_Expression );
+            }
+
+            void Visit( const CastExpression & expression )
+            {
+                this->Dispatch( *expression.m_Type );
+                this->Dispatch( *expression.m_Expression );
+            }
+
+            void Visit( const AssignmentExpression & expression )
+            {
+                this->Dispatch( *expression.m_LValueExpression );
+                this->Dispatch( *expression.m_Expression );
+            }
+
+            void Visit( const PostfixExpression & expression )
+            {
+                this->Dispatch( *expression.m_Expression );
+
+                if ( expression.m_Suffix )
+                {
+                    this->Dispatch( *expression.m_Suffix );
+                }
+            }
+
+            void Visit( const ReturnStatement & statement )
+            {
+                if ( statement.m_Expression )
+                {
+                    this->Dispatch( *statement.m_Expression );
+                }
+            }
+
+            void Visit( const ExpressionStatement & statement )
+            {
+                this->Dispatch( *statement.m_Expression );
+            }
+
+            void Visit( const IfStatement & statement )
+            {
+                this->Dispatch( *statement.m_Condition );
+                this->Dispatch( *statement.m_ThenStatement );
+
+                if ( statement.m_ElseStatement )
+                {
+                    this->Dispatch( *statement.m_ElseStatement );
+                }
+            }
+
+            void Visit( const WhileStatement & statement )
+            {
+                this->Dispatch( *statement.m_Condition );
+                this->Dispatch( *statement.m_Statement );
+            }
+
+            void Visit( const DoWhileStatement & statement )
+            {
+                this->Dispatch( *statement.m_Statement );
+                this->Dispatch( *statement.m_Condition );
+            }
+
+            void Visit( const ForStatement & statement )
+            {
+                this->Dispatch( *statement.m_InitStatement );
+                this->Dispatch( *statement.m_EqualityExpression );
+                this->Dispatch( *statement.m_ModifyExpression );
+                this->Dispatch( *statement.m_Statement );
+            }
+
+            void Visit( const BlockStatement & statement )
+            {
+                this->DispatchTable( statement.m_StatementTable );
+            }
+
+            void Visit( const AssignmentStatement & statement )
+            {
+                this->Dispatch( *statement.m_Expression );
+            }
+
+            void Visit( const VariableDeclarationStatement & statement )
+            {
+                this->DispatchTable( statement.m_StorageClass );
+                this->DispatchTable( statement.m_TypeModifier );
+                this->DispatchTable( statement.m_BodyTable );
+            }
+
+            void Visit( const VariableDeclarationBody & body )
+            {
+                if ( body.m_Annotations )
+                {
+                    this->Dispatch( *body.m_Annotations );
+                }
+
+                if ( body.m_InitialValue )
+                {
+                    this->Dispatch( *body.m_InitialValue );
+                }
+            }
+
+            void Visit( const InitialValue & initial_value )
+            {
+                if ( initial_value.m_Vector )
+                {
+                    this->DispatchTable( initial_value.m_ExpressionTable );
+                }
+                else
+                {
+                    assert( initial_value.m_ExpressionTable.size() == 1 );
+                    this->Dispatch( *initial_value.m_ExpressionTable[ 0 ] );
+                }
+            }
+
+            void Visit( const Annotations & annotations )
+            {
+                this->DispatchTable( annotations.m_AnnotationTable );
+            }
+
+            void Visit( const TextureDeclaration & declaration )
+            {
+                if ( declaration.m_Annotations )
+                {
+                    this->Dispatch( *declaration.m_Annotations );
+                }
+            }
+
+            void Visit( const SamplerDeclaration & declaration )
+            {
+                this->DispatchTable( declaration.m_BodyTable );
+            }
+
+            void Visit( const StructDefinition & definition )
+            {
+                std::vector< StructDefinition::Member >::const_iterator it, end;
+                it = definition.m_MemberTable.cbegin();
+                end = definition.m_MemberTable.cend();
+
+                for ( ; it != end; ++it )
+                {
+                    const StructDefinition::Member
+                        & member = ( *it );
+
+                    this->Dispatch( *member.m_Type );
+                }
+            }
+
+            void Visit( const FunctionDeclaration & declaration )
+            {
+                this->DispatchTable( declaration.m_StorageClassTable );
+
+                if ( declaration.m_Type )
+                {
+                    this->Dispatch( *declaration.m_Type );
+                }
+
+                if ( declaration.m_ArgumentList )
+                {
+                    this->Dispatch( *declaration.m_ArgumentList );
+                }
+
+                declaration.ResolveBody();
+                this->DispatchTable( declaration.m_StatementTable );
+            }
+
+            void Visit( const Argument & argument )
+            {
+                if ( argument.m_TypeModifier )
+                {
+                    this->Dispatch( *argument.m_TypeModifier );
+                }
+
+                if ( argument.m_InitialValue )
+                {
+                    this->Dispatch( *argument.m_InitialValue );
+                }
+            }
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -11,8 +11,8 @@
 
         struct Technique : Node
         {
-            Technique() {}
-            Technique( const std::string & name ) : m_Name( name ) {}
+            Technique() : Node( NodeKind_Technique ) {}
+            Technique( const std::string & name ) : Node( NodeKind_Technique ), m_Name( name ) {}
 
             void AddPass( Pass * pass )
             {
@@ -30,8 +30,8 @@
 
         struct Pass : Node
         {
-            Pass() {}
-            Pass( const std::string & name ) : m_Name( name ) {}
+            Pass() : Node( NodeKind_Pass ) {}
+            Pass( const std::string & name ) : Node( NodeKind_Pass ), m_Name( name ) {}
 
             void AddShaderDefinition( ShaderDefinition * definition )
             {
@@ -55,8 +55,9 @@
 
         struct ShaderDefinition : Node
         {
-            ShaderDefinition() {}
+            ShaderDefinition() : Node( NodeKind_ShaderDefinition ) {}
             ShaderDefinition( ShaderType type, const std::string & name, ShaderArgumentList * list ) :
+                Node( NodeKind_ShaderDefinition ),
                 m_Name( name ), m_Type( type ), m_List( list ) {}
 
             virtual ShaderDefinition * Clone() const override;
@@ -71,8 +72,8 @@
 
         struct ShaderArgumentList : Node
         {
-            ShaderArgumentList() {}
-            ShaderArgumentList( Expression * argument )
+            ShaderArgumentList() : Node( NodeKind_ShaderArgumentList ) {}
+            ShaderArgumentList( Expression * argument ) : Node( NodeKind_ShaderArgumentList )
             {
                 m_ShaderArgumentTable.emplace_back( argument );
             }
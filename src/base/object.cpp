@@ -8,16 +8,39 @@ namespace Base
 		assert( m_ReferenceCount == 0 );
 	}
 
+	std::atomic<int>
+		Object::s_SharingScopeCount( 0 );
+
+	// Outside of a sharing scope, only one thread uses the objects, so the count is
+	// updated without the cost of a locked instruction
 	void Object::AddRef() const
 	{
-		++m_ReferenceCount;
+		if( s_SharingScopeCount.load( std::memory_order_relaxed ) > 0 )
+		{
+			++m_ReferenceCount;
+		}
+		else
+		{
+			m_ReferenceCount.store( m_ReferenceCount.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		}
 	}
 
 	void Object::RemoveRef() const
 	{
-		--m_ReferenceCount;
+		int
+			reference_count;
+
+		if( s_SharingScopeCount.load( std::memory_order_relaxed ) > 0 )
+		{
+			reference_count = --m_ReferenceCount;
+		}
+		else
+		{
+			reference_count = m_ReferenceCount.load( std::memory_order_relaxed ) - 1;
+			m_ReferenceCount.store( reference_count, std::memory_order_relaxed );
+		}
 
-		if( m_ReferenceCount == 0 )
+		if( reference_count == 0 )
 		{
 			delete this;
 		}
@@ -1,13 +1,37 @@
 #ifndef OBJECT_H
     #define OBJECT_H
 
+    #include <atomic>
+
     namespace Base
     {
         class Object
         {
         public:
 
+            // Objects, like the fragment library of the server, may be shared between
+            // threads while a scope is open. Reference counts are only updated with
+            // atomic operations then, single threaded code keeps plain updates. A scope
+            // must be opened before the threads sharing objects start, and closed
+            // after they stop.
+            class SharingScope
+            {
+            public:
+
+                SharingScope() { ++s_SharingScopeCount; }
+                ~SharingScope() { --s_SharingScopeCount; }
+
+            private:
+
+                SharingScope( const SharingScope & other );
+                SharingScope & operator =( const SharingScope & other );
+            };
+
             Object() : m_ReferenceCount( 0 ) {}
+            Object( const Object & ) : m_ReferenceCount( 0 ) {}
+
+            // The reference count belongs to the object, not to its value
+            Object & operator=( const Object & ) { return *this; }
 
             void AddRef() const;
             void RemoveRef() const;
@@ -18,7 +42,9 @@
 
         private:
 
-            mutable int
+            static std::atomic<int>
+                s_SharingScopeCount;
+            mutable std::atomic<int>
                 m_ReferenceCount;
         };
     }
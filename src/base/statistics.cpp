@@ -0,0 +1,294 @@
+#include "statistics.h"
+
+#include <utils/json.h>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Base
+{
+    namespace
+    {
+        struct TimerEntry
+        {
+            TimerEntry() : m_Milliseconds( 0.0 ), m_CallCount( 0 ) {}
+
+            std::string
+                m_Name;
+            double
+                m_Milliseconds;
+            int
+                m_CallCount;
+        };
+
+        struct CounterEntry
+        {
+            CounterEntry() : m_Count( 0 ) {}
+
+            std::string
+                m_Name;
+            int64_t
+                m_Count;
+        };
+
+        struct SampleEntry
+        {
+            std::string
+                m_Name;
+            std::vector<std::pair<std::string, int64_t> >
+                m_ValueTable;
+        };
+
+        // Few entries, kept in first use order so the report follows the pipeline
+        std::mutex
+            TableMutex;
+        std::vector<TimerEntry>
+            TimerTable;
+        std::vector<CounterEntry>
+            CounterTable;
+        std::vector<SampleEntry>
+            SampleTable;
+
+        template< class _Entry_ >
+        _Entry_ * FindEntry( std::vector<_Entry_> & table, const char * name )
+        {
+            typename std::vector<_Entry_>::iterator it, end;
+
+            for( it = table.begin(), end = table.end(); it != end; ++it )
+            {
+                if( (*it).m_Name == name )
+                {
+                    return &*it;
+                }
+            }
+
+            return 0;
+        }
+
+        template< class _Entry_ >
+        _Entry_ & FindOrAddEntry( std::vector<_Entry_> & table, const char * name )
+        {
+            _Entry_
+                * entry = FindEntry( table, name );
+
+            if( entry )
+            {
+                return *entry;
+            }
+
+            table.push_back( _Entry_() );
+            table.back().m_Name = name;
+
+            return table.back();
+        }
+    }
+
+    bool Statistics::s_Enabled = false;
+
+    void Statistics::AddTime( const char * name, const double milliseconds )
+    {
+        if( !s_Enabled )
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+        TimerEntry
+            & entry = FindOrAddEntry( TimerTable, name );
+
+        entry.m_Milliseconds += milliseconds;
+        ++entry.m_CallCount;
+    }
+
+    void Statistics::AddCount( const char * name, const int64_t count )
+    {
+        if( !s_Enabled )
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+
+        FindOrAddEntry( CounterTable, name ).m_Count += count;
+    }
+
+    void Statistics::AddSample( const char * name, const std::string & label, const int64_t value )
+    {
+        if( !s_Enabled )
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+
+        FindOrAddEntry( SampleTable, name ).m_ValueTable.push_back( std::make_pair( label, value ) );
+    }
+
+    double Statistics::GetTime( const char * name )
+    {
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+        const TimerEntry
+            * entry = FindEntry( TimerTable, name );
+
+        return entry ? entry->m_Milliseconds : 0.0;
+    }
+
+    int Statistics::GetCallCount( const char * name )
+    {
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+        const TimerEntry
+            * entry = FindEntry( TimerTable, name );
+
+        return entry ? entry->m_CallCount : 0;
+    }
+
+    int64_t Statistics::GetCount( const char * name )
+    {
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+        const CounterEntry
+            * entry = FindEntry( CounterTable, name );
+
+        return entry ? entry->m_Count : 0;
+    }
+
+    int Statistics::GetSampleCount( const char * name )
+    {
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+        const SampleEntry
+            * entry = FindEntry( SampleTable, name );
+
+        return entry ? static_cast<int>( entry->m_ValueTable.size() ) : 0;
+    }
+
+    void Statistics::Reset()
+    {
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+
+        TimerTable.clear();
+        CounterTable.clear();
+        SampleTable.clear();
+    }
+
+    void Statistics::Print( std::ostream & stream )
+    {
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+        std::vector<TimerEntry>::const_iterator timer_it, timer_end;
+        std::vector<CounterEntry>::const_iterator counter_it, counter_end;
+        std::vector<SampleEntry>::const_iterator sample_it, sample_end;
+        std::ios::fmtflags
+            flags = stream.flags();
+
+        stream << std::left << std::setw( 28 ) << "phase"
+            << std::right << std::setw( 8 ) << "calls"
+            << std::setw( 14 ) << "time (ms)" << "\n";
+
+        for( timer_it = TimerTable.begin(), timer_end = TimerTable.end(); timer_it != timer_end; ++timer_it )
+        {
+            stream << std::left << std::setw( 28 ) << (*timer_it).m_Name
+                << std::right << std::setw( 8 ) << (*timer_it).m_CallCount
+                << std::setw( 14 ) << std::fixed << std::setprecision( 3 ) << (*timer_it).m_Milliseconds << "\n";
+        }
+
+        stream << "\n" << std::left << std::setw( 28 ) << "counter"
+            << std::right << std::setw( 22 ) << "value" << "\n";
+
+        for( counter_it = CounterTable.begin(), counter_end = CounterTable.end(); counter_it != counter_end; ++counter_it )
+        {
+            stream << std::left << std::setw( 28 ) << (*counter_it).m_Name
+                << std::right << std::setw( 22 ) << (*counter_it).m_Count << "\n";
+        }
+
+        for( sample_it = SampleTable.begin(), sample_end = SampleTable.end(); sample_it != sample_end; ++sample_it )
+        {
+            std::vector<std::pair<std::string, int64_t> >::const_iterator value_it, value_end;
+
+            stream << "\n" << std::left << std::setw( 28 ) << (*sample_it).m_Name
+                << std::right << std::setw( 22 ) << "value" << "\n";
+
+            for( value_it = (*sample_it).m_ValueTable.begin(), value_end = (*sample_it).m_ValueTable.end(); value_it != value_end; ++value_it )
+            {
+                stream << "  " << std::left << std::setw( 26 ) << (*value_it).first
+                    << std::right << std::setw( 22 ) << (*value_it).second << "\n";
+            }
+        }
+
+        stream.flags( flags );
+    }
+
+    void Statistics::PrintJson( std::ostream & stream )
+    {
+        std::lock_guard<std::mutex>
+            lock( TableMutex );
+        std::vector<TimerEntry>::const_iterator timer_it, timer_end;
+        std::vector<CounterEntry>::const_iterator counter_it, counter_end;
+        std::vector<SampleEntry>::const_iterator sample_it, sample_end;
+        const char
+            * separator = "";
+
+        stream << "{\n  \"timers\": {";
+
+        for( timer_it = TimerTable.begin(), timer_end = TimerTable.end(); timer_it != timer_end; ++timer_it )
+        {
+            stream << separator << "\n    ";
+            write_json_string( stream, (*timer_it).m_Name );
+            stream << ": { \"calls\": " << (*timer_it).m_CallCount
+                << ", \"milliseconds\": " << (*timer_it).m_Milliseconds << " }";
+            separator = ",";
+        }
+
+        stream << "\n  },\n  \"counters\": {";
+        separator = "";
+
+        for( counter_it = CounterTable.begin(), counter_end = CounterTable.end(); counter_it != counter_end; ++counter_it )
+        {
+            stream << separator << "\n    ";
+            write_json_string( stream, (*counter_it).m_Name );
+            stream << ": " << (*counter_it).m_Count;
+            separator = ",";
+        }
+
+        stream << "\n  }";
+
+        if( !SampleTable.empty() )
+        {
+            stream << ",\n  \"samples\": {";
+            separator = "";
+
+            for( sample_it = SampleTable.begin(), sample_end = SampleTable.end(); sample_it != sample_end; ++sample_it )
+            {
+                std::vector<std::pair<std::string, int64_t> >::const_iterator value_it, value_end;
+                const char
+                    * value_separator = "";
+
+                stream << separator << "\n    ";
+                write_json_string( stream, (*sample_it).m_Name );
+                stream << ": [";
+
+                for( value_it = (*sample_it).m_ValueTable.begin(), value_end = (*sample_it).m_ValueTable.end(); value_it != value_end; ++value_it )
+                {
+                    stream << value_separator << "\n      { \"label\": ";
+                    write_json_string( stream, (*value_it).first );
+                    stream << ", \"value\": " << (*value_it).second << " }";
+                    value_separator = ",";
+                }
+
+                stream << "\n    ]";
+                separator = ",";
+            }
+
+            stream << "\n  }";
+        }
+
+        stream << "\n}\n";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#ifndef STATISTICS_H
+    #define STATISTICS_H
+
+    #include "tracer.h"
+    #include <chrono>
+    #include <cstdint>
+    #include <ostream>
+    #include <string>
+
+    namespace Base
+    {
+        // Timers and counters of the current run, reported with --stats. Nothing is
+        // recorded while the statistics are disabled, which is the default.
+
+        class Statistics
+        {
+        public:
+
+            static void Enable( const bool enabled = true ) { s_Enabled = enabled; }
+            static bool IsEnabled() { return s_Enabled; }
+
+            static void AddTime( const char * name, const double milliseconds );
+            static void AddCount( const char * name, const int64_t count = 1 );
+
+            // Labeled values of a series, reported one by one, e.g. a cost per permutation
+            static void AddSample( const char * name, const std::string & label, const int64_t value );
+
+            static double GetTime( const char * name );
+            static int GetCallCount( const char * name );
+            static int64_t GetCount( const char * name );
+            static int GetSampleCount( const char * name );
+
+            static void Reset();
+            static void Print( std::ostream & stream );
+            static void PrintJson( std::ostream & stream );
+
+        private:
+
+            static bool
+                s_Enabled;
+        };
+
+        // Adds the time spent in its scope to the named timer, and records a trace event
+        // with the optional detail when tracing. Nested timers are inclusive.
+
+        class ScopedTimer
+        {
+        public:
+
+            explicit ScopedTimer( const char * name ) : m_Name( name )
+            {
+                if( Statistics::IsEnabled() || Tracer::IsEnabled() )
+                {
+                    m_Start = std::chrono::steady_clock::now();
+                }
+            }
+
+            ScopedTimer( const char * name, const std::string & detail ) : m_Name( name )
+            {
+                if( Tracer::IsEnabled() )
+                {
+                    m_Detail = detail;
+                }
+
+                if( Statistics::IsEnabled() || Tracer::IsEnabled() )
+                {
+                    m_Start = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~ScopedTimer()
+            {
+                if( Statistics::IsEnabled() || Tracer::IsEnabled() )
+                {
+                    std::chrono::steady_clock::duration
+                        duration = std::chrono::steady_clock::now() - m_Start;
+
+                    if( Statistics::IsEnabled() )
+                    {
+                        Statistics::AddTime( m_Name, std::chrono::duration<double, std::milli>( duration ).count() );
+                    }
+
+                    if( Tracer::IsEnabled() )
+                    {
+                        Tracer::AddEvent( m_Name, m_Detail, m_Start, duration );
+                    }
+                }
+            }
+
+        private:
+
+            ScopedTimer( const ScopedTimer & );
+            ScopedTimer & operator=( const ScopedTimer & );
+
+            const char
+                * m_Name;
+            std::string
+                m_Detail;
+            std::chrono::steady_clock::time_point
+                m_Start;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "tracer.h"
+
+#include <utils/json.h>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Base
+{
+    namespace
+    {
+        struct Event
+        {
+            const char
+                * m_Name;
+            std::string
+                m_Detail;
+            int64_t
+                m_Start,
+                m_Duration;
+            int
+                m_ThreadIndex;
+        };
+
+        std::mutex
+            EventMutex;
+        std::vector<Event>
+            EventTable;
+        std::map<std::thread::id, int>
+            ThreadIndexTable;
+
+        int64_t ToMicroseconds( const std::chrono::steady_clock::duration duration )
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>( duration ).count();
+        }
+    }
+
+    bool Tracer::s_Enabled = false;
+
+    void Tracer::AddEvent(
+        const char * name,
+        const std::string & detail,
+        const std::chrono::steady_clock::time_point start,
+        const std::chrono::steady_clock::duration duration
+        )
+    {
+        Event
+            event;
+
+        event.m_Name = name;
+        event.m_Detail = detail;
+        event.m_Start = ToMicroseconds( start.time_since_epoch() );
+        event.m_Duration = ToMicroseconds( duration );
+
+        std::lock_guard<std::mutex>
+            lock( EventMutex );
+        std::map<std::thread::id, int>::iterator
+            thread_it = ThreadIndexTable.find( std::this_thread::get_id() );
+
+        // Small thread ids are easier to read in the viewer
+        if( thread_it == ThreadIndexTable.end() )
+        {
+            const int
+                thread_index = static_cast<int>( ThreadIndexTable.size() ) + 1;
+
+            thread_it = ThreadIndexTable.insert( std::make_pair( std::this_thread::get_id(), thread_index ) ).first;
+        }
+
+        event.m_ThreadIndex = (*thread_it).second;
+        EventTable.push_back( event );
+    }
+
+    size_t Tracer::GetEventCount()
+    {
+        std::lock_guard<std::mutex>
+            lock( EventMutex );
+
+        return EventTable.size();
+    }
+
+    void Tracer::Reset()
+    {
+        std::lock_guard<std::mutex>
+            lock( EventMutex );
+
+        EventTable.clear();
+        ThreadIndexTable.clear();
+    }
+
+    void Tracer::Write( std::ostream & stream )
+    {
+        std::lock_guard<std::mutex>
+            lock( EventMutex );
+        std::vector<Event>::const_iterator it, end;
+        const char
+            * separator = "";
+
+        stream << "{\"traceEvents\":[";
+
+        for( it = EventTable.begin(), end = EventTable.end(); it != end; ++it )
+        {
+            stream << separator << "\n{\"name\":";
+            write_json_string( stream, (*it).m_Name );
+            stream << ",\"cat\":\"shader_shaker\",\"ph\":\"X\",\"ts\":" << (*it).m_Start
+                << ",\"dur\":" << (*it).m_Duration
+                << ",\"pid\":1,\"tid\":" << (*it).m_ThreadIndex;
+
+            if( !(*it).m_Detail.empty() )
+            {
+                stream << ",\"args\":{\"detail\":";
+                write_json_string( stream, (*it).m_Detail );
+                stream << "}";
+            }
+
+            stream << "}";
+            separator = ",";
+        }
+
+        stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+}
\ No newline at end of file
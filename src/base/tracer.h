@@ -0,0 +1,45 @@
+#ifndef TRACER_H
+    #define TRACER_H
+
+    #include <chrono>
+    #include <cstddef>
+    #include <ostream>
+    #include <string>
+
+    namespace Base
+    {
+        // Records the pipeline phases of a run as Chrome trace events, to be loaded in
+        // Perfetto or chrome://tracing. Events are added by ScopedTimer and can come from
+        // any thread. Defining SHADERSHAKER_NO_TRACE removes the recording at compile time.
+
+        class Tracer
+        {
+        public:
+
+            static void Enable( const bool enabled = true ) { s_Enabled = enabled; }
+
+            #ifdef SHADERSHAKER_NO_TRACE
+                static bool IsEnabled() { return false; }
+            #else
+                static bool IsEnabled() { return s_Enabled; }
+            #endif
+
+            static void AddEvent(
+                const char * name,
+                const std::string & detail,
+                const std::chrono::steady_clock::time_point start,
+                const std::chrono::steady_clock::duration duration
+                );
+
+            static size_t GetEventCount();
+            static void Reset();
+            static void Write( std::ostream & stream );
+
+        private:
+
+            static bool
+                s_Enabled;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include "call_scheduler.h"
+
+#include <base/statistics.h>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <sstream>
+
+namespace Generation
+{
+    namespace
+    {
+        const size_t
+            NoValue = size_t( -1 );
+
+        // A semantic written by a call
+        struct Value
+        {
+            std::string
+                m_Semantic,
+                m_Type,
+                m_Variable;
+            size_t
+                m_Writer,
+                m_Predecessor;
+            int
+                m_ReaderCount;
+            bool
+                m_IsTemporary;
+        };
+
+        struct Call
+        {
+            Call() : m_HasSuccessor( false ), m_RegisterNeed( 0 ) {}
+
+            const FunctionDefinition
+                * m_Function;
+            // Value read for each read semantic, NoValue for the arguments of main
+            std::map<std::string, size_t>
+                m_ReadValueTable;
+            std::map<std::string, size_t>
+                m_WrittenValueTable;
+            std::set<size_t>
+                m_PredecessorSet;
+            bool
+                m_HasSuccessor;
+            int
+                m_RegisterNeed;
+        };
+
+        void AddDependency( std::vector<Call> & call_table, const size_t first, const size_t second )
+        {
+            if( first != second )
+            {
+                call_table[ second ].m_PredecessorSet.insert( first );
+                call_table[ first ].m_HasSuccessor = true;
+            }
+        }
+
+        void BuildCallTable(
+            std::vector<Call> & call_table,
+            std::vector<Value> & value_table,
+            const std::vector<const FunctionDefinition *> & function_table,
+            const std::set<std::string> & argument_semantic_set
+            )
+        {
+            std::map<std::string, size_t>
+                last_value_table;
+            std::map<std::string, std::vector<size_t> >
+                reader_table;
+
+            call_table.resize( function_table.size() );
+
+            for( size_t index = 0; index < function_table.size(); ++index )
+            {
+                const FunctionDefinition
+                    & function = *function_table[ index ];
+                Call
+                    & call = call_table[ index ];
+                std::set<std::string>
+                    read_semantic_set( function.GetInSemanticSet() ),
+                    written_semantic_set( function.GetOutSemanticSet() );
+                std::set<std::string>::const_iterator it, end;
+
+                read_semantic_set.insert( function.GetInOutSemanticSet().begin(), function.GetInOutSemanticSet().end() );
+                written_semantic_set.insert( function.GetInOutSemanticSet().begin(), function.GetInOutSemanticSet().end() );
+                call.m_Function = &function;
+
+                for( it = read_semantic_set.begin(), end = read_semantic_set.end(); it != end; ++it )
+                {
+                    std::map<std::string, size_t>::const_iterator
+                        value = last_value_table.find( *it );
+
+                    if( value == last_value_table.end() )
+                    {
+                        call.m_ReadValueTable[ *it ] = NoValue;
+                    }
+                    else
+                    {
+                        call.m_ReadValueTable[ *it ] = (*value).second;
+                        ++value_table[ (*value).second ].m_ReaderCount;
+                        AddDependency( call_table, value_table[ (*value).second ].m_Writer, index );
+                    }
+
+                    reader_table[ *it ].push_back( index );
+                }
+
+                for( it = written_semantic_set.begin(), end = written_semantic_set.end(); it != end; ++it )
+                {
+                    std::map<std::string, size_t>::const_iterator
+                        previous_value = last_value_table.find( *it );
+                    std::vector<size_t>
+                        & reader_index_table = reader_table[ *it ];
+                    Value
+                        value;
+
+                    if( previous_value != last_value_table.end() )
+                    {
+                        AddDependency( call_table, value_table[ (*previous_value).second ].m_Writer, index );
+                    }
+
+                    for( size_t reader = 0; reader < reader_index_table.size(); ++reader )
+                    {
+                        AddDependency( call_table, reader_index_table[ reader ], index );
+                    }
+
+                    reader_index_table.clear();
+
+                    value.m_Semantic = *it;
+                    value.m_Type = function.GetSemanticType( *it );
+                    value.m_Writer = index;
+                    value.m_ReaderCount = 0;
+                    value.m_IsTemporary = argument_semantic_set.find( *it ) == argument_semantic_set.end();
+
+                    // An inout semantic keeps the variable of the value it updates
+                    value.m_Predecessor = function.GetInOutSemanticSet().count( *it ) ? call.m_ReadValueTable[ *it ] : NoValue;
+
+                    call.m_WrittenValueTable[ *it ] = value_table.size();
+                    last_value_table[ *it ] = value_table.size();
+                    value_table.push_back( value );
+                }
+            }
+        }
+
+        // Live ranges ended by the call minus the ones it starts
+        int GetLiveCountDecrease(
+            const Call & call,
+            const std::vector<Value> & value_table,
+            const std::vector<int> & remaining_reader_count_table
+            )
+        {
+            std::map<std::string, size_t>::const_iterator it, end;
+            int
+                decrease = 0;
+
+            for( it = call.m_ReadValueTable.begin(), end = call.m_ReadValueTable.end(); it != end; ++it )
+            {
+                if( (*it).second != NoValue
+                    && value_table[ (*it).second ].m_IsTemporary
+                    && remaining_reader_count_table[ (*it).second ] == 1
+                    )
+                {
+                    ++decrease;
+                }
+            }
+
+            for( it = call.m_WrittenValueTable.begin(), end = call.m_WrittenValueTable.end(); it != end; ++it )
+            {
+                if( value_table[ (*it).second ].m_IsTemporary && value_table[ (*it).second ].m_ReaderCount > 0 )
+                {
+                    --decrease;
+                }
+            }
+
+            return decrease;
+        }
+
+        // Sethi-Ullman numbering: temporaries needed to run a call after its producers,
+        // when the producers needing the most run first
+        void ComputeRegisterNeeds(
+            std::vector<Call> & call_table,
+            const std::vector<Value> & value_table
+            )
+        {
+            // Producers always come before their readers
+            for( size_t index = 0; index < call_table.size(); ++index )
+            {
+                Call
+                    & call = call_table[ index ];
+                std::set<size_t>
+                    producer_set;
+                std::vector<int>
+                    need_table;
+                std::map<std::string, size_t>::const_iterator it, end;
+
+                for( it = call.m_ReadValueTable.begin(), end = call.m_ReadValueTable.end(); it != end; ++it )
+                {
+                    if( (*it).second != NoValue && value_table[ (*it).second ].m_IsTemporary )
+                    {
+                        producer_set.insert( value_table[ (*it).second ].m_Writer );
+                    }
+                }
+
+                for( it = call.m_WrittenValueTable.begin(), end = call.m_WrittenValueTable.end(); it != end; ++it )
+                {
+                    if( value_table[ (*it).second ].m_IsTemporary && value_table[ (*it).second ].m_ReaderCount > 0 )
+                    {
+                        ++call.m_RegisterNeed;
+                    }
+                }
+
+                for( std::set<size_t>::const_iterator producer = producer_set.begin(); producer != producer_set.end(); ++producer )
+                {
+                    need_table.push_back( call_table[ *producer ].m_RegisterNeed );
+                }
+
+                std::sort( need_table.begin(), need_table.end(), std::greater<int>() );
+
+                for( size_t producer = 0; producer < need_table.size(); ++producer )
+                {
+                    call.m_RegisterNeed = std::max( call.m_RegisterNeed, need_table[ producer ] + static_cast<int>( producer ) );
+                }
+            }
+        }
+
+        struct IsNeedingMoreRegisters
+        {
+            IsNeedingMoreRegisters( const std::vector<Call> & call_table ) : m_CallTable( call_table ) {}
+
+            bool operator()( const size_t first, const size_t second ) const
+            {
+                if( m_CallTable[ first ].m_RegisterNeed != m_CallTable[ second ].m_RegisterNeed )
+                {
+                    return m_CallTable[ first ].m_RegisterNeed > m_CallTable[ second ].m_RegisterNeed;
+                }
+
+                return first < second;
+            }
+
+            const std::vector<Call>
+                & m_CallTable;
+        };
+
+        void AddToOrder(
+            std::vector<size_t> & order,
+            std::vector<bool> & visited_table,
+            const std::vector<Call> & call_table,
+            const size_t index
+            )
+        {
+            if( visited_table[ index ] )
+            {
+                return;
+            }
+
+            visited_table[ index ] = true;
+
+            std::vector<size_t>
+                predecessor_table( call_table[ index ].m_PredecessorSet.begin(), call_table[ index ].m_PredecessorSet.end() );
+
+            std::sort( predecessor_table.begin(), predecessor_table.end(), IsNeedingMoreRegisters( call_table ) );
+
+            for( std::vector<size_t>::const_iterator it = predecessor_table.begin(), end = predecessor_table.end(); it != end; ++it )
+            {
+                AddToOrder( order, visited_table, call_table, *it );
+            }
+
+            order.push_back( index );
+        }
+
+        int ComputePeakLiveCount(
+            const std::vector<size_t> & order,
+            const std::vector<Call> & call_table,
+            const std::vector<Value> & value_table
+            )
+        {
+            std::vector<int>
+                remaining_reader_count_table( value_table.size() );
+            int
+                live_count = 0,
+                peak_live_count = 0;
+
+            for( size_t index = 0; index < value_table.size(); ++index )
+            {
+                remaining_reader_count_table[ index ] = value_table[ index ].m_ReaderCount;
+            }
+
+            for( size_t index = 0; index < order.size(); ++index )
+            {
+                const Call
+                    & call = call_table[ order[ index ] ];
+                std::map<std::string, size_t>::const_iterator it, end;
+
+                live_count -= GetLiveCountDecrease( call, value_table, remaining_reader_count_table );
+                peak_live_count = std::max( peak_live_count, live_count );
+
+                for( it = call.m_ReadValueTable.begin(), end = call.m_ReadValueTable.end(); it != end; ++it )
+                {
+                    if( (*it).second != NoValue )
+                    {
+                        --remaining_reader_count_table[ (*it).second ];
+                    }
+                }
+            }
+
+            return peak_live_count;
+        }
+
+        Base::ObjectRef<AST::Statement> CreateCallStatement(
+            const Call & call,
+            const std::vector<Value> & value_table
+            )
+        {
+            const FunctionDefinition
+                & function = *call.m_Function;
+            Base::ObjectRef<AST::ArgumentExpressionList>
+                argument_expression_list = new AST::ArgumentExpressionList;
+            std::vector<FunctionDefinition::Argument>::const_iterator it, end;
+
+            for( it = function.GetArgumentTable().begin(), end = function.GetArgumentTable().end(); it != end; ++it )
+            {
+                std::map<std::string, size_t>::const_iterator
+                    value = (*it).m_InputModifier == "out" ? call.m_WrittenValueTable.find( (*it).m_Semantic ) : call.m_ReadValueTable.find( (*it).m_Semantic );
+                const std::string
+                    & name = (*value).second == NoValue ? (*it).m_Semantic : value_table[ (*value).second ].m_Variable;
+
+                argument_expression_list->m_ExpressionList.push_back( new AST::VariableExpression( name ) );
+            }
+
+            Base::ObjectRef<AST::CallExpression>
+                call_expression = new AST::CallExpression( function.GetName(), &*argument_expression_list );
+
+            if( function.GetReturnSemantic().empty() )
+            {
+                return new AST::ExpressionStatement( &*call_expression );
+            }
+
+            return new AST::AssignmentStatement(
+                new AST::LValueExpression(
+                    new AST::VariableExpression( value_table[ (*call.m_WrittenValueTable.find( function.GetReturnSemantic() )).second ].m_Variable )
+                    ),
+                AST::AssignmentOperator_Assign,
+                &*call_expression
+                );
+        }
+    }
+
+    void CallScheduler::Schedule(
+        std::vector<Base::ObjectRef<AST::Statement> > & statement_table,
+        const std::vector<const FunctionDefinition *> & function_table,
+        const std::set<std::string> & argument_semantic_set
+        )
+    {
+        Base::ScopedTimer
+            timer( "schedule_calls" );
+        std::vector<Call>
+            call_table;
+        std::vector<Value>
+            value_table;
+        std::vector<int>
+            remaining_reader_count_table;
+        std::vector<size_t>
+            order;
+        std::vector<bool>
+            visited_table;
+        std::set<std::string>
+            declared_variable_set( argument_semantic_set );
+        std::map<std::string, std::vector<std::string> >
+            free_variable_table;
+
+        m_ReusedTemporaryCount = 0;
+        statement_table.clear();
+
+        BuildCallTable( call_table, value_table, function_table, argument_semantic_set );
+
+        for( size_t index = 0; index < call_table.size(); ++index )
+        {
+            order.push_back( index );
+        }
+
+        m_UnscheduledPeakLiveCount = ComputePeakLiveCount( order, call_table, value_table );
+        order.clear();
+        visited_table.resize( call_table.size(), false );
+        ComputeRegisterNeeds( call_table, value_table );
+
+        // Calls without successor are the ones writing the outputs
+        for( size_t index = 0; index < call_table.size(); ++index )
+        {
+            if( !call_table[ index ].m_HasSuccessor )
+            {
+                AddToOrder( order, visited_table, call_table, index );
+            }
+        }
+
+        for( size_t index = 0; index < value_table.size(); ++index )
+        {
+            remaining_reader_count_table.push_back( value_table[ index ].m_ReaderCount );
+        }
+
+        for( size_t position = 0; position < order.size(); ++position )
+        {
+            const Call
+                & call = call_table[ order[ position ] ];
+            std::map<std::string, size_t>::const_iterator value_it, value_end;
+
+            // Variables of the written values, declared before the call
+            for( value_it = call.m_WrittenValueTable.begin(), value_end = call.m_WrittenValueTable.end(); value_it != value_end; ++value_it )
+            {
+                Value
+                    & value = value_table[ (*value_it).second ];
+                std::vector<std::string>
+                    & free_variable_list = free_variable_table[ value.m_Type ];
+
+                if( !value.m_IsTemporary )
+                {
+                    value.m_Variable = value.m_Semantic;
+                }
+                else if( value.m_Predecessor != NoValue )
+                {
+                    value.m_Variable = value_table[ value.m_Predecessor ].m_Variable;
+                }
+                else if( !free_variable_list.empty() )
+                {
+                    value.m_Variable = free_variable_list.back();
+                    free_variable_list.pop_back();
+                    ++m_ReusedTemporaryCount;
+                }
+                else
+                {
+                    value.m_Variable = value.m_Semantic;
+
+                    for( int suffix = 1; declared_variable_set.find( value.m_Variable ) != declared_variable_set.end(); ++suffix )
+                    {
+                        std::ostringstream
+                            name;
+
+                        name << value.m_Semantic << "_" << suffix;
+                        value.m_Variable = name.str();
+                    }
+
+                    Base::ObjectRef<AST::VariableDeclarationStatement>
+                        variable = new AST::VariableDeclarationStatement;
+
+                    variable->SetType( new AST::Type( value.m_Type ) );
+                    variable->AddBody( new AST::VariableDeclarationBody( value.m_Variable ) );
+                    statement_table.push_back( &*variable );
+                    declared_variable_set.insert( value.m_Variable );
+                }
+            }
+
+            statement_table.push_back( CreateCallStatement( call, value_table ) );
+
+            // Variables of the ended live ranges are free after the call
+            for( value_it = call.m_ReadValueTable.begin(), value_end = call.m_ReadValueTable.end(); value_it != value_end; ++value_it )
+            {
+                if( (*value_it).second == NoValue )
+                {
+                    continue;
+                }
+
+                const Value
+                    & value = value_table[ (*value_it).second ];
+
+                if( --remaining_reader_count_table[ (*value_it).second ] == 0
+                    && value.m_IsTemporary
+                    && call.m_WrittenValueTable.find( value.m_Semantic ) == call.m_WrittenValueTable.end()
+                    )
+                {
+                    free_variable_table[ value.m_Type ].push_back( value.m_Variable );
+                }
+            }
+
+            for( value_it = call.m_WrittenValueTable.begin(), value_end = call.m_WrittenValueTable.end(); value_it != value_end; ++value_it )
+            {
+                const Value
+                    & value = value_table[ (*value_it).second ];
+
+                if( value.m_IsTemporary && value.m_ReaderCount == 0 )
+                {
+                    free_variable_table[ value.m_Type ].push_back( value.m_Variable );
+                }
+            }
+        }
+
+        m_PeakLiveCount = ComputePeakLiveCount( order, call_table, value_table );
+
+        Base::Statistics::AddCount( "scheduled_live_temporary_decrease", m_UnscheduledPeakLiveCount - m_PeakLiveCount );
+        Base::Statistics::AddCount( "reused_temporary_count", m_ReusedTemporaryCount );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef CALL_SCHEDULER_H
+    #define CALL_SCHEDULER_H
+
+    #include <set>
+    #include <string>
+    #include <vector>
+    #include <ast/node.h>
+    #include "function_definition.h"
+
+    namespace Generation
+    {
+        // Orders the calls of a generated main to keep few temporaries alive at once.
+        //
+        // The calls may be reordered as long as every semantic is read after the write
+        // it was read after, and written after the reads of its previous value. Calls
+        // are emitted depth first from the ones writing the outputs, and the producers
+        // needing the most temporaries run first, as in Sethi-Ullman numbering.
+        // Temporaries are declared just before their first definition, and a dead
+        // temporary is reused for the next semantic of the same type.
+
+        class CallScheduler
+        {
+        public:
+
+            CallScheduler() :
+                m_UnscheduledPeakLiveCount( 0 ),
+                m_PeakLiveCount( 0 ),
+                m_ReusedTemporaryCount( 0 )
+            {
+            }
+
+            // The functions are given in a valid execution order. The semantics of the
+            // argument set are the arguments of main, they are neither declared nor reused.
+            void Schedule(
+                std::vector<Base::ObjectRef<AST::Statement> > & statement_table,
+                const std::vector<const FunctionDefinition *> & function_table,
+                const std::set<std::string> & argument_semantic_set
+                );
+
+            // Most temporaries alive at once, in the given order and after scheduling
+            int GetUnscheduledPeakLiveCount() const { return m_UnscheduledPeakLiveCount; }
+            int GetPeakLiveCount() const { return m_PeakLiveCount; }
+
+            int GetReusedTemporaryCount() const { return m_ReusedTemporaryCount; }
+
+        private:
+
+            int
+                m_UnscheduledPeakLiveCount,
+                m_PeakLiveCount,
+                m_ReusedTemporaryCount;
+        };
+    }
+
+#endif
\ No newline at end of file
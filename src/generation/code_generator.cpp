@@ -5,7 +5,16 @@
 #include "graph.h"
 #include "graph_node.h"
 #include "graph_validator.h"
+#include "resolution_cache.h"
+#include "cost_estimator.h"
+#include "call_scheduler.h"
+#include "loop_unroller.h"
+#include "preshader_extractor.h"
+#include "strength_reducer.h"
+#include "texture_fetch_hoister.h"
+#include "vector_narrower.h"
 #include <ast/function_node.h>
+#include <base/statistics.h>
 #include "semantic_remover.h"
 #include <set>
 #include <iostream>
@@ -15,8 +24,225 @@
 
 namespace Generation
 {
+    namespace
+    {
+        // A step of the resolution being recorded for the cache
+        struct RecordedStep
+        {
+            Resolution::Step
+                m_Step;
+            std::vector<FunctionDefinition::Ref>
+                m_SkippedFunctionTable;
+            std::set<std::string>
+                m_SearchedSemanticSet,
+                m_UngeneratedSemanticSet,
+                m_UsedInputSemanticSet;
+        };
+
+        // The first state of the resolution, or one with a single open semantic
+        struct RecordedState
+        {
+            size_t
+                m_FirstStep;
+            std::string
+                m_Key;
+        };
+
+        struct ResolutionRecord
+        {
+            ResolutionRecord() : m_IsResolved( false ) {}
+
+            std::vector<RecordedStep>
+                m_StepTable;
+            std::vector<RecordedState>
+                m_StateTable;
+            // Cached resolution spliced after the recorded steps
+            Resolution::Ref
+                m_Tail;
+            std::set<std::string>
+                m_FailedSemanticSet;
+            std::vector<FunctionDefinition::Ref>
+                m_FailedSkippedFunctionTable;
+            // Used before the resolution started, when it continues a query
+            std::set<FunctionDefinition::Ref>
+                m_InitialFunctionSet;
+            bool
+                m_IsResolved;
+        };
+
+        bool ContainsAny(
+            const std::set<FunctionDefinition::Ref> & function_set,
+            const std::vector<FunctionDefinition::Ref> & function_table
+            )
+        {
+            std::vector<FunctionDefinition::Ref>::const_iterator it, end;
+
+            for( it = function_table.begin(), end = function_table.end(); it != end; ++it )
+            {
+                if( function_set.find( *it ) != function_set.end() )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        class IgnoringErrorHandler : public Base::ErrorHandlerInterface
+        {
+        public:
+
+            virtual void ReportError(
+                const std::string & /*message*/,
+                const std::string & /*file*/
+                ) override
+            {
+            }
+        };
+
+        std::string GetMissingFunctionMessage( const std::set<std::string> & semantic_set )
+        {
+            std::ostringstream message;
+
+            std::ostream_iterator< std::string > output( message, ", " );
+            message << "Unable to find function that generates ";
+            std::copy( semantic_set.begin(), semantic_set.end(), output );
+
+            return message.str();
+        }
+
+        // The steps following a state resolve its open semantics as a new resolution
+        // would, unless one of them skipped a function used before the state, or bound
+        // a semantic generated before it
+        bool IsIndependent( const ResolutionRecord & record, const size_t first_step )
+        {
+            std::set<FunctionDefinition::Ref>
+                previous_function_set( record.m_InitialFunctionSet );
+            std::set<std::string>
+                generated_set;
+
+            for( size_t step_index = 0; step_index < first_step; ++step_index )
+            {
+                previous_function_set.insert( record.m_StepTable[ step_index ].m_Step.m_Function );
+            }
+
+            for( size_t step_index = first_step; step_index < record.m_StepTable.size(); ++step_index )
+            {
+                const RecordedStep
+                    & step = record.m_StepTable[ step_index ];
+                std::vector<std::string>::const_iterator semantic_it, semantic_end;
+
+                if( ContainsAny( previous_function_set, step.m_SkippedFunctionTable ) )
+                {
+                    return false;
+                }
+
+                semantic_it = step.m_Step.m_BoundSemanticTable.begin();
+                semantic_end = step.m_Step.m_BoundSemanticTable.end();
+
+                for( ; semantic_it != semantic_end; ++semantic_it )
+                {
+                    if( generated_set.find( *semantic_it ) == generated_set.end() )
+                    {
+                        return false;
+                    }
+                }
+
+                generated_set.insert( step.m_Step.m_Function->GetOutSemanticSet().begin(), step.m_Step.m_Function->GetOutSemanticSet().end() );
+                generated_set.insert( step.m_Step.m_Function->GetInOutSemanticSet().begin(), step.m_Step.m_Function->GetInOutSemanticSet().end() );
+            }
+
+            return !ContainsAny( previous_function_set, record.m_FailedSkippedFunctionTable );
+        }
+
+        void StoreResolutions( ResolutionCache & cache, const ResolutionRecord & record )
+        {
+            std::vector<RecordedState>::const_iterator it, end;
+
+            for( it = record.m_StateTable.begin(), end = record.m_StateTable.end(); it != end; ++it )
+            {
+                if( !IsIndependent( record, (*it).m_FirstStep ) )
+                {
+                    continue;
+                }
+
+                Resolution::Ref
+                    resolution = new Resolution;
+
+                for( size_t step_index = (*it).m_FirstStep; step_index < record.m_StepTable.size(); ++step_index )
+                {
+                    const RecordedStep
+                        & step = record.m_StepTable[ step_index ];
+
+                    resolution->m_StepTable.push_back( step.m_Step );
+                    resolution->m_SearchedSemanticSet.insert( step.m_SearchedSemanticSet.begin(), step.m_SearchedSemanticSet.end() );
+                    resolution->m_UngeneratedSemanticSet.insert( step.m_UngeneratedSemanticSet.begin(), step.m_UngeneratedSemanticSet.end() );
+                    resolution->m_UsedInputSemanticSet.insert( step.m_UsedInputSemanticSet.begin(), step.m_UsedInputSemanticSet.end() );
+                }
+
+                if( record.m_Tail )
+                {
+                    const Resolution
+                        & tail = *record.m_Tail;
+
+                    resolution->m_StepTable.insert( resolution->m_StepTable.end(), tail.m_StepTable.begin(), tail.m_StepTable.end() );
+                    resolution->m_SearchedSemanticSet.insert( tail.m_SearchedSemanticSet.begin(), tail.m_SearchedSemanticSet.end() );
+                    resolution->m_UngeneratedSemanticSet.insert( tail.m_UngeneratedSemanticSet.begin(), tail.m_UngeneratedSemanticSet.end() );
+                    resolution->m_UsedInputSemanticSet.insert( tail.m_UsedInputSemanticSet.begin(), tail.m_UsedInputSemanticSet.end() );
+                    resolution->m_FailedSemanticSet = tail.m_FailedSemanticSet;
+                    resolution->m_IsResolved = tail.m_IsResolved;
+                }
+                else
+                {
+                    resolution->m_SearchedSemanticSet.insert( record.m_FailedSemanticSet.begin(), record.m_FailedSemanticSet.end() );
+                    resolution->m_FailedSemanticSet = record.m_FailedSemanticSet;
+                    resolution->m_IsResolved = record.m_IsResolved;
+                }
+
+                cache.Add( (*it).m_Key, *resolution );
+            }
+        }
+
+        // A cached resolution is what the search would choose again, as long as none of
+        // its functions is already used and none of the semantics it left open for a
+        // later function is already generated
+        bool CanSplice(
+            const Resolution & resolution,
+            const std::set<FunctionDefinition::Ref> & used_function_set,
+            const std::set<std::string> & generated_set
+            )
+        {
+            std::vector<Resolution::Step>::const_iterator step_it, step_end;
+            std::set<std::string>::const_iterator semantic_it, semantic_end;
+
+            for( step_it = resolution.m_StepTable.begin(), step_end = resolution.m_StepTable.end(); step_it != step_end; ++step_it )
+            {
+                if( used_function_set.find( (*step_it).m_Function ) != used_function_set.end() )
+                {
+                    return false;
+                }
+            }
+
+            semantic_it = resolution.m_UngeneratedSemanticSet.begin();
+            semantic_end = resolution.m_UngeneratedSemanticSet.end();
+
+            for( ; semantic_it != semantic_end; ++semantic_it )
+            {
+                if( generated_set.find( *semantic_it ) != generated_set.end() )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
     bool CodeGenerator::FindMatchingFunction(
         FunctionDefinition::Ref & function,
+        FragmentDefinition::Ref & fragment,
+        std::vector<FunctionDefinition::Ref> * skipped_function_table,
+        std::set<std::string> * searched_semantic_set,
         std::set<FunctionDefinition::Ref> & used_function_set,
         const std::set<std::string> & semantic_set,
         const std::vector<FragmentDefinition::Ref > & definition_table
@@ -27,22 +253,87 @@ namespace Generation
         it = definition_table.rbegin();
         end = definition_table.rend();
 
+        if( m_SelectsCheapest && m_CostEstimator )
+        {
+            FunctionDefinition::Ref
+                candidate;
+            std::set<std::string>
+                candidate_searched_set;
+            int
+                lowest_cost = 0;
+            bool
+                is_resolved = false;
+
+            function = 0;
+
+            // Every used candidate may have been chosen instead, ties keep the last fragment.
+            // Candidates whose inputs cannot be resolved are only kept when no other can, so
+            // the resolution reports the missing semantic.
+            for(; it!=end; ++it )
+            {
+                if( !(*it)->FindFunctionDefinitionMatchingSemanticSet( candidate, semantic_set ) )
+                {
+                    continue;
+                }
+
+                if( used_function_set.find( candidate ) != used_function_set.end() )
+                {
+                    if( skipped_function_table )
+                    {
+                        skipped_function_table->push_back( candidate );
+                    }
+
+                    continue;
+                }
+
+                int
+                    cost = 0;
+
+                if( !GetSubgraphCost( cost, candidate_searched_set, candidate, **it, definition_table ) )
+                {
+                    if( !function )
+                    {
+                        function = candidate;
+                        fragment = *it;
+                    }
+
+                    continue;
+                }
+
+                if( !is_resolved || cost < lowest_cost )
+                {
+                    function = candidate;
+                    fragment = *it;
+                    lowest_cost = cost;
+                    is_resolved = true;
+                }
+            }
+
+            m_SearchedSemanticSet.insert( candidate_searched_set.begin(), candidate_searched_set.end() );
+
+            if( searched_semantic_set )
+            {
+                searched_semantic_set->insert( candidate_searched_set.begin(), candidate_searched_set.end() );
+            }
+
+            return function;
+        }
+
         for(; it!=end; ++it )
         {
             if( (*it)->FindFunctionDefinitionMatchingSemanticSet( function, semantic_set ) )
             {
                 if( used_function_set.find( function ) != used_function_set.end() )
                 {
+                    if( skipped_function_table )
+                    {
+                        skipped_function_table->push_back( function );
+                    }
+
                     continue;
                 }
 
-                //:TRICKY: This is a set, but order should be deterministic
-                if ( std::find( m_UsedTranslationUnitSet.begin(), m_UsedTranslationUnitSet.end(), &(*it)->GetTranslationUnit() )
-                        == m_UsedTranslationUnitSet.end()
-                    )
-                {
-                    m_UsedTranslationUnitSet.push_back( const_cast<AST::TranslationUnit*>( &(*it)->GetTranslationUnit() ) );
-                }
+                fragment = *it;
 
                 return true;
             }
@@ -51,10 +342,87 @@ namespace Generation
         return false;
     }
 
+    bool CodeGenerator::GetSubgraphCost(
+        int & cost,
+        std::set<std::string> & searched_semantic_set,
+        const FunctionDefinition::Ref & function,
+        const FragmentDefinition & fragment,
+        const std::vector<FragmentDefinition::Ref > & definition_table
+        )
+    {
+        CodeGenerator
+            code_generator;
+        QueryState
+            state;
+        Base::ObjectRef<IgnoringErrorHandler>
+            error_handler = new IgnoringErrorHandler;
+        std::vector<std::string>
+            semantic_table,
+            input_semantic_table( m_InputSemanticSet.begin(), m_InputSemanticSet.end() );
+
+        state.m_FunctionTable.push_back( function );
+        state.m_FunctionSet.insert( function );
+        state.m_GeneratedSemanticSet = function->GetOutSemanticSet();
+        state.m_EstimatedCost = m_CostEstimator->GetFunctionCost( function, fragment ).GetTotal();
+
+        Base::Statistics::AddCount( "set_operation_count", 2 );
+
+        std::set_difference(
+            function->GetInSemanticSet().begin(), function->GetInSemanticSet().end(),
+            m_InputSemanticSet.begin(), m_InputSemanticSet.end(),
+            std::back_inserter( semantic_table )
+            );
+
+        std::set_difference(
+            function->GetInOutSemanticSet().begin(), function->GetInOutSemanticSet().end(),
+            m_InputSemanticSet.begin(), m_InputSemanticSet.end(),
+            std::back_inserter( semantic_table )
+            );
+
+        code_generator.SetCostEstimator( m_CostEstimator );
+
+        const bool
+            is_resolved = code_generator.ContinueQuery( state, definition_table, semantic_table, input_semantic_table, *error_handler );
+
+        searched_semantic_set.insert( code_generator.GetSearchedSemanticSet().begin(), code_generator.GetSearchedSemanticSet().end() );
+        cost = state.m_EstimatedCost;
+
+        return is_resolved;
+    }
+
+    void CodeGenerator::AddUsedFunction(
+        std::set<FunctionDefinition::Ref> & used_function_set,
+        const FunctionDefinition::Ref & function,
+        const FragmentDefinition::Ref & fragment
+        )
+    {
+        AddUsedFragment( fragment );
+        used_function_set.insert( function );
+        m_UsedFunctionTable.push_back( function );
+
+        if( m_CostEstimator )
+        {
+            m_EstimatedCost += m_CostEstimator->GetFunctionCost( function, *fragment ).GetTotal();
+        }
+    }
+
+    void CodeGenerator::AddUsedFragment( const FragmentDefinition::Ref & fragment )
+    {
+        //:TRICKY: This is a set, but order should be deterministic
+        if ( std::find( m_UsedFragmentTable.begin(), m_UsedFragmentTable.end(), &*fragment )
+                == m_UsedFragmentTable.end()
+            )
+        {
+            m_UsedFragmentTable.push_back( fragment );
+        }
+    }
+
     void CodeGenerator::RemoveInputSemantics( std::set<std::string> & semantic_set )
     {
         std::set<std::string> new_semantic_set;
 
+        Base::Statistics::AddCount( "set_operation_count", 2 );
+
         std::set_intersection(
             semantic_set.begin(), semantic_set.end(),
             m_InputSemanticSet.begin(), m_InputSemanticSet.end(),
@@ -74,32 +442,28 @@ namespace Generation
         const FunctionDefinition & definition
         )
     {
-        const AST::FunctionDeclaration & function_declaration = definition.GetFunctionDeclaration();
         Base::ObjectRef<AST::ArgumentExpressionList> argument_expression_list = new AST::ArgumentExpressionList;
+        std::vector<FunctionDefinition::Argument>::const_iterator it, end;
 
-        if( function_declaration.m_ArgumentList )
-        {
-            const AST::ArgumentList & argument_list = *function_declaration.m_ArgumentList;
-            std::vector< Base::ObjectRef<AST::Argument> >::const_iterator it, end;
-            it = argument_list.m_ArgumentTable.begin();
-            end = argument_list.m_ArgumentTable.end();
+        // Only the signature is used, the declaration may not be loaded
+        it = definition.GetArgumentTable().begin();
+        end = definition.GetArgumentTable().end();
 
-            for(;it != end; ++it )
-            {
-                argument_expression_list->m_ExpressionList.push_back( new AST::VariableExpression( (*it)->m_Semantic ) );
-            }
+        for(;it != end; ++it )
+        {
+            argument_expression_list->m_ExpressionList.push_back( new AST::VariableExpression( (*it).m_Semantic ) );
         }
 
-        Base::ObjectRef<AST::CallExpression> call_expression = new AST::CallExpression( function_declaration.m_Name, &*argument_expression_list );
+        Base::ObjectRef<AST::CallExpression> call_expression = new AST::CallExpression( definition.GetName(), &*argument_expression_list );
 
-        if( function_declaration.m_Semantic.empty() )
+        if( definition.GetReturnSemantic().empty() )
         {
             return new AST::ExpressionStatement( &*call_expression );
         }
         else
         {
             return new AST::AssignmentStatement(
-                new AST::LValueExpression( new AST::VariableExpression( function_declaration.m_Semantic ) ),
+                new AST::LValueExpression( new AST::VariableExpression( definition.GetReturnSemantic() ) ),
                 AST::AssignmentOperator_Assign,
                 &*call_expression
                 );
@@ -121,6 +485,7 @@ namespace Generation
             }
 
             m_VisitedNodeSet.insert( &node );
+            m_FunctionTable.push_back( &node.GetFunctionDefinition() );
 
             std::set<std::string>::iterator it, end;
             it = node.GetFunctionDefinition().GetOutSemanticSet().begin();
@@ -179,6 +544,8 @@ namespace Generation
             m_DeclaredVariableTable;
         std::set<const GraphNode *>
             m_VisitedNodeSet;
+        std::vector<const FunctionDefinition *>
+            m_FunctionTable;
         std::vector<Base::ObjectRef<AST::Statement> >
             m_StatementTable;
         std::map<std::string, std::string>
@@ -218,12 +585,24 @@ namespace Generation
         const Graph & graph
         )
     {
+        Base::ScopedTimer timer( "generate_code" );
         CodeGeneratorHelper helper;
 
         helper.m_DeclaredVariableTable.insert( m_UsedSemanticSet.begin(), m_UsedSemanticSet.end() );
         helper.m_DeclaredVariableTable.insert( m_OutputSemanticSet.begin(), m_OutputSemanticSet.end());
         graph.VisitDepthFirst( helper );
 
+        if( m_SchedulesCalls )
+        {
+            CallScheduler
+                scheduler;
+            std::set<std::string>
+                argument_semantic_set( m_UsedSemanticSet );
+
+            argument_semantic_set.insert( m_OutputSemanticSet.begin(), m_OutputSemanticSet.end() );
+            scheduler.Schedule( helper.m_StatementTable, helper.m_FunctionTable, argument_semantic_set );
+        }
+
         Base::ObjectRef<AST::ArgumentList> argument_list = new AST::ArgumentList;
 
         std::set<std::string>
@@ -232,6 +611,8 @@ namespace Generation
             output_semantic_set,
             input_output_semantic_set;
 
+        Base::Statistics::AddCount( "set_operation_count", 4 );
+
         std::set_intersection(
             m_InputSemanticSet.begin(), m_InputSemanticSet.end(),
             m_UsedSemanticSet.begin(), m_UsedSemanticSet.end(),
@@ -272,44 +653,132 @@ namespace Generation
     Graph::Ref CodeGenerator::GenerateGraph(
         const std::vector<FragmentDefinition::Ref > & fragment_table
         )
+    {
+        Base::ScopedTimer
+            timer( "generate_graph" );
+        Graph::Ref
+            graph = new Graph;
+        std::set<FunctionDefinition::Ref>
+            used_function_set;
+        std::set<std::string>
+            generated_set;
+
+        if( !ResolveFunctions( &*graph, used_function_set, generated_set, fragment_table ) )
+        {
+            return 0;
+        }
+
+        return graph;
+    }
+
+    bool CodeGenerator::ResolveFunctions(
+        Graph * graph,
+        std::set<FunctionDefinition::Ref> & used_function_set,
+        std::set<std::string> & generated_set,
+        const std::vector<FragmentDefinition::Ref > & fragment_table
+        )
     {
         std::set<std::string>
             open_set,
             closed_set;
-        Graph::Ref
-            graph;
         FunctionDefinition::Ref
             function;
-        std::set<FunctionDefinition::Ref>
-            used_function_set;
+        FragmentDefinition::Ref
+            fragment;
+        ResolutionRecord
+            record;
+        std::string
+            input_key;
+
+        // Semantics generated by the functions already used need no producer
+        std::set_difference(
+            m_OutputSemanticSet.begin(), m_OutputSemanticSet.end(),
+            generated_set.begin(), generated_set.end(),
+            std::inserter( open_set, open_set.begin() )
+            );
 
-        open_set.insert( m_OutputSemanticSet.begin(), m_OutputSemanticSet.end() );
+        if( graph )
+        {
+            graph->Initialize( open_set );
+        }
 
-        graph = new Graph;
-        graph->Initialize( open_set );
+        if( m_ResolutionCache )
+        {
+            input_key = ResolutionCache::MakeInputKey( m_InputSemanticSet );
+            record.m_InitialFunctionSet = used_function_set;
+        }
 
         while( !open_set.empty() )
         {
             std::set<std::string> new_open_set;
-            if( !FindMatchingFunction( function, used_function_set, open_set, fragment_table ) )
+            RecordedStep step;
+
+            m_SearchedSemanticSet.insert( open_set.begin(), open_set.end() );
+
+            if( m_ResolutionCache && ( record.m_StepTable.empty() || open_set.size() == 1 ) )
+            {
+                RecordedState
+                    state;
+
+                state.m_FirstStep = record.m_StepTable.size();
+                state.m_Key = ResolutionCache::MakeKey( open_set, input_key );
+
+                Resolution::Ref
+                    resolution = m_ResolutionCache->Find( state.m_Key );
+
+                if( resolution && CanSplice( *resolution, used_function_set, generated_set ) )
+                {
+                    record.m_Tail = resolution;
+                    StoreResolutions( *m_ResolutionCache, record );
+
+                    return SpliceResolution( graph, used_function_set, *resolution );
+                }
+
+                record.m_StateTable.push_back( state );
+            }
+
+            if( m_ResolutionCache )
             {
-                std::ostringstream message;
+                step.m_SearchedSemanticSet = open_set;
+            }
 
-                std::ostream_iterator< std::string > output( message, ", " );
-                message << "Unable to find function that generates ";
-                std::copy( open_set.begin(), open_set.end(), output );
+            if( !FindMatchingFunction(
+                    function,
+                    fragment,
+                    m_ResolutionCache ? &step.m_SkippedFunctionTable : 0,
+                    m_ResolutionCache ? &step.m_SearchedSemanticSet : 0,
+                    used_function_set,
+                    open_set,
+                    fragment_table
+                    )
+                )
+            {
+                if( m_ResolutionCache )
+                {
+                    record.m_FailedSemanticSet = open_set;
+                    record.m_FailedSkippedFunctionTable = std::move( step.m_SkippedFunctionTable );
+                    StoreResolutions( *m_ResolutionCache, record );
+                }
 
-                m_ErrorHandler->ReportError( message.str(), "" );
+                m_ErrorHandler->ReportError( GetMissingFunctionMessage( open_set ), "" );
 
-                return 0;
+                return false;
             }
 
-            GraphNode::Ref node = new GraphNode( *function );
-            used_function_set.insert( function );
+            GraphNode::Ref node;
 
-            if( !graph->AddNode( *node ) )
+            AddUsedFunction( used_function_set, function, fragment );
+
+            if( graph )
             {
-                return 0;
+                node = new GraphNode( *function );
+
+                if( !graph->AddNode( *node ) )
+                {
+                    return false;
+                }
+
+                Base::Statistics::AddCount( "graph_node_count" );
             }
 
             // Bind to already existing semantic
@@ -322,20 +791,32 @@ namespace Generation
             for( ; it != end; ++it )
             {
                 if( open_set.find( *it ) == open_set.end()
-                    && graph->HasGeneratedSemantic( *it ) )
+                    && generated_set.find( *it ) != generated_set.end() )
                 {
-                    if( !graph->UseGeneratedSemantic( *node, *it ) )
+                    if( graph && !graph->UseGeneratedSemantic( *node, *it ) )
                     {
                         m_ErrorHandler->ReportError( "Cycle detected involving " + *it, "" );
-                        return 0;
+                        return false;
+                    }
+
+                    if( m_ResolutionCache )
+                    {
+                        step.m_Step.m_BoundSemanticTable.push_back( *it );
                     }
                 }
                 else
                 {
+                    if( m_ResolutionCache && open_set.find( *it ) == open_set.end() )
+                    {
+                        step.m_UngeneratedSemanticSet.insert( *it );
+                    }
+
                     unresolved_semantic.insert( *it );
                 }
             }
 
+            Base::Statistics::AddCount( "set_operation_count", 4 );
+
             std::set_difference(
                 open_set.begin(), open_set.end(),
                 function->GetOutSemanticSet().begin(), function->GetOutSemanticSet().end(),
@@ -345,31 +826,199 @@ namespace Generation
             open_set = std::move( new_open_set );
 
             closed_set.insert( function->GetOutSemanticSet().begin(), function->GetOutSemanticSet().end() );
+            generated_set.insert( function->GetOutSemanticSet().begin(), function->GetOutSemanticSet().end() );
+            generated_set.insert( function->GetInOutSemanticSet().begin(), function->GetInOutSemanticSet().end() );
             open_set.insert( unresolved_semantic.begin(), unresolved_semantic.end() );
             open_set.insert( function->GetInOutSemanticSet().begin(), function->GetInOutSemanticSet().end() );
 
+            if( m_ResolutionCache )
+            {
+                std::set_intersection(
+                    open_set.begin(), open_set.end(),
+                    m_InputSemanticSet.begin(), m_InputSemanticSet.end(),
+                    std::inserter( step.m_UsedInputSemanticSet, step.m_UsedInputSemanticSet.begin() )
+                    );
+
+                step.m_Step.m_Function = function;
+                step.m_Step.m_Fragment = fragment;
+                record.m_StepTable.push_back( std::move( step ) );
+            }
+
             RemoveInputSemantics( open_set );
         }
 
-        return graph;
+        if( m_ResolutionCache )
+        {
+            record.m_IsResolved = true;
+            StoreResolutions( *m_ResolutionCache, record );
+        }
+
+        return true;
     }
 
-    void CodeGenerator::GenerateShader(
-        Base::ObjectRef<AST::TranslationUnit> & generated_shader,
-        std::vector<std::string> & used_semantic_set,
-        const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+    bool CodeGenerator::SpliceResolution(
+        Graph * graph,
+        std::set<FunctionDefinition::Ref> & used_function_set,
+        const Resolution & resolution
+        )
+    {
+        std::vector<Resolution::Step>::const_iterator it, end;
+
+        m_SearchedSemanticSet.insert( resolution.m_SearchedSemanticSet.begin(), resolution.m_SearchedSemanticSet.end() );
+        m_UsedSemanticSet.insert( resolution.m_UsedInputSemanticSet.begin(), resolution.m_UsedInputSemanticSet.end() );
+
+        for( it = resolution.m_StepTable.begin(), end = resolution.m_StepTable.end(); it != end; ++it )
+        {
+            FunctionDefinition::Ref
+                function = (*it).m_Function;
+
+            AddUsedFunction( used_function_set, function, (*it).m_Fragment );
+
+            if( !graph )
+            {
+                continue;
+            }
+
+            GraphNode::Ref
+                node = new GraphNode( *function );
+            std::vector<std::string>::const_iterator semantic_it, semantic_end;
+
+            if( !graph->AddNode( *node ) )
+            {
+                return false;
+            }
+
+            Base::Statistics::AddCount( "graph_node_count" );
+
+            semantic_it = (*it).m_BoundSemanticTable.begin();
+            semantic_end = (*it).m_BoundSemanticTable.end();
+
+            for( ; semantic_it != semantic_end; ++semantic_it )
+            {
+                if( !graph->UseGeneratedSemantic( *node, *semantic_it ) )
+                {
+                    m_ErrorHandler->ReportError( "Cycle detected involving " + *semantic_it, "" );
+                    return false;
+                }
+            }
+        }
+
+        if( !resolution.m_IsResolved )
+        {
+            m_ErrorHandler->ReportError( GetMissingFunctionMessage( resolution.m_FailedSemanticSet ), "" );
+            return false;
+        }
+
+        return true;
+    }
+
+    void CodeGenerator::Initialize(
         const std::vector<std::string> & semantic_table,
         const std::vector<std::string> & semantic_input_table,
         Base::ErrorHandlerInterface & error_handler
         )
     {
         m_ErrorHandler = & error_handler;
-        m_UsedTranslationUnitSet.clear();
+        m_UsedFunctionTable.clear();
+        m_UsedFragmentTable.clear();
+        m_EstimatedCost = 0;
+        m_PreshaderOperationCount = 0;
         m_UsedSemanticSet.clear();
+        m_SearchedSemanticSet.clear();
         m_OutputSemanticSet.clear();
         m_InputSemanticSet.clear();
         m_InputSemanticSet.insert( semantic_input_table.begin(), semantic_input_table.end() );
         m_OutputSemanticSet.insert( semantic_table.begin(), semantic_table.end() );
+    }
+
+    bool CodeGenerator::QueryShader(
+        std::vector<std::string> & used_semantic_set,
+        std::vector<FunctionDefinition::Ref> & function_table,
+        const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+        const std::vector<std::string> & semantic_table,
+        const std::vector<std::string> & semantic_input_table,
+        Base::ErrorHandlerInterface & error_handler
+        )
+    {
+        Base::ScopedTimer
+            timer( "query_shader" );
+        std::set<FunctionDefinition::Ref>
+            used_function_set;
+        std::set<std::string>
+            generated_set;
+
+        Initialize( semantic_table, semantic_input_table, error_handler );
+
+        if( !ResolveFunctions( 0, used_function_set, generated_set, definition_table ) )
+        {
+            return false;
+        }
+
+        std::copy( m_UsedSemanticSet.begin(), m_UsedSemanticSet.end(), std::back_inserter( used_semantic_set ) );
+        function_table.insert( function_table.end(), m_UsedFunctionTable.begin(), m_UsedFunctionTable.end() );
+
+        return true;
+    }
+
+    bool CodeGenerator::ContinueQuery(
+        QueryState & state,
+        const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+        const std::vector<std::string> & semantic_table,
+        const std::vector<std::string> & semantic_input_table,
+        Base::ErrorHandlerInterface & error_handler
+        )
+    {
+        Base::ScopedTimer
+            timer( "query_shader" );
+        std::set<FunctionDefinition::Ref>
+            used_function_set( state.m_FunctionSet );
+        std::set<std::string>
+            generated_set( state.m_GeneratedSemanticSet );
+
+        Initialize( semantic_table, semantic_input_table, error_handler );
+        m_UsedFunctionTable = state.m_FunctionTable;
+        m_UsedSemanticSet = state.m_UsedInputSemanticSet;
+        m_EstimatedCost = state.m_EstimatedCost;
+
+        if( !ResolveFunctions( 0, used_function_set, generated_set, definition_table ) )
+        {
+            return false;
+        }
+
+        state.m_FunctionTable = m_UsedFunctionTable;
+        state.m_FunctionSet = std::move( used_function_set );
+        state.m_GeneratedSemanticSet = std::move( generated_set );
+        state.m_UsedInputSemanticSet = m_UsedSemanticSet;
+        state.m_EstimatedCost = m_EstimatedCost;
+
+        return true;
+    }
+
+    void CodeGenerator::GenerateShader(
+        Base::ObjectRef<AST::TranslationUnit> & generated_shader,
+        std::vector<std::string> & used_semantic_set,
+        const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+        const std::vector<std::string> & semantic_table,
+        const std::vector<std::string> & semantic_input_table,
+        Base::ErrorHandlerInterface & error_handler
+        )
+    {
+        std::string
+            permutation;
+
+        if( Base::Tracer::IsEnabled() )
+        {
+            std::ostringstream
+                semantic_list;
+
+            std::copy( semantic_table.begin(), semantic_table.end(), std::ostream_iterator<std::string>( semantic_list, " " ) );
+            permutation = semantic_list.str();
+        }
+
+        Base::ScopedTimer
+            timer( "generate_shader", permutation );
+
+        Initialize( semantic_table, semantic_input_table, error_handler );
 
         Graph::Ref graph = GenerateGraph( definition_table );
 
@@ -391,11 +1040,58 @@ namespace Generation
         }
 
         Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+        std::vector<Base::ObjectRef<AST::TranslationUnit> > used_translation_unit_table;
+        std::vector<FragmentDefinition::Ref>::const_iterator fragment_it, fragment_end;
 
-        MergeTranslationUnit( *translation_unit, m_UsedTranslationUnitSet );
+        for( fragment_it = m_UsedFragmentTable.begin(), fragment_end = m_UsedFragmentTable.end(); fragment_it != fragment_end; ++fragment_it )
+        {
+            used_translation_unit_table.push_back( const_cast<AST::TranslationUnit*>( &(*fragment_it)->GetTranslationUnit() ) );
+        }
+
+        MergeTranslationUnit( *translation_unit, used_translation_unit_table );
 
         translation_unit->m_GlobalDeclarationTable.push_back( &*function );
 
+        if( m_MaximumUnrolledStatementCount > 0 )
+        {
+            LoopUnroller
+                unroller;
+
+            unroller.SetMaximumStatementCount( m_MaximumUnrolledStatementCount );
+            unroller.Unroll( *translation_unit );
+        }
+
+        if( m_ReducesStrength || m_AllowsFastMath )
+        {
+            StrengthReducer
+                reducer;
+
+            reducer.SetFastMath( m_AllowsFastMath );
+            reducer.Reduce( *translation_unit );
+        }
+
+        if( m_NarrowsVectors )
+        {
+            VectorNarrower
+                narrower;
+
+            narrower.Narrow( *translation_unit );
+        }
+
+        if( m_MaximumInFlightFetchCount > 0 )
+        {
+            TextureFetchHoister
+                hoister;
+
+            hoister.SetMaximumInFlightCount( m_MaximumInFlightFetchCount );
+            hoister.Hoist( *translation_unit );
+        }
+
+        if( m_PreshaderExtractor )
+        {
+            m_PreshaderOperationCount = m_PreshaderExtractor->Extract( *translation_unit );
+        }
+
         generated_shader = translation_unit;
         std::copy( m_UsedSemanticSet.begin(), m_UsedSemanticSet.end(), std::back_inserter( used_semantic_set ) );
     }
@@ -405,21 +1101,34 @@ namespace Generation
         const std::vector<Base::ObjectRef<AST::TranslationUnit> > & translation_unit_table
         )
     {
+        Base::ScopedTimer timer( "merge_translation_unit" );
         std::vector<Base::ObjectRef<AST::TranslationUnit> >::const_iterator it, end;
         SemanticRemover semantic_remover;
+        std::set<const AST::GlobalDeclaration *> merged_declaration_set;
 
         it = translation_unit_table.begin();
         end = translation_unit_table.end();
         for( ;it!=end; ++it)
         {
-            Base::ObjectRef<AST::TranslationUnit> clone = (*it)->Clone();
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator declaration_it, declaration_end;
 
-            clone->Visit( semantic_remover );
+            declaration_it = (*it)->m_GlobalDeclarationTable.begin();
+            declaration_end = (*it)->m_GlobalDeclarationTable.end();
 
-            std::copy(
-                clone->m_GlobalDeclarationTable.begin(), clone->m_GlobalDeclarationTable.end(),
-                std::back_inserter( destination_translation_unit.m_GlobalDeclarationTable )
-                );
+            for( ; declaration_it != declaration_end; ++declaration_it )
+            {
+                //:TRICKY: Fragments including the same file share its declarations
+                if( !merged_declaration_set.insert( &**declaration_it ).second )
+                {
+                    continue;
+                }
+
+                Base::ObjectRef<AST::GlobalDeclaration> clone = (*declaration_it)->Clone();
+
+                semantic_remover.Dispatch( *clone );
+
+                destination_translation_unit.m_GlobalDeclarationTable.push_back( clone );
+            }
         }
 
     }
@@ -428,6 +1137,8 @@ namespace Generation
         const Graph & graph
         ) const
     {
+        Base::ScopedTimer
+            timer( "validate_graph" );
         GraphValidator
             validator( *m_ErrorHandler );
 
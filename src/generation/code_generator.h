@@ -14,12 +14,123 @@
     namespace Generation
     {
         struct CodeGeneratorHelper;
+        class CostEstimator;
+        class PreshaderExtractor;
+        struct Resolution;
+        class ResolutionCache;
 
         class CodeGenerator
         {
 
         public:
 
+            // Functions resolved by the queries continued from it, see ContinueQuery
+            struct QueryState
+            {
+                QueryState() : m_EstimatedCost( 0 ) {}
+
+                std::vector<FunctionDefinition::Ref>
+                    m_FunctionTable;
+                std::set<FunctionDefinition::Ref>
+                    m_FunctionSet;
+                std::set<std::string>
+                    m_GeneratedSemanticSet,
+                    m_UsedInputSemanticSet;
+                int
+                    m_EstimatedCost;
+            };
+
+            CodeGenerator() :
+                m_ResolutionCache( 0 ),
+                m_CostEstimator( 0 ),
+                m_PreshaderExtractor( 0 ),
+                m_SelectsCheapest( false ),
+                m_SchedulesCalls( false ),
+                m_ReducesStrength( false ),
+                m_AllowsFastMath( false ),
+                m_NarrowsVectors( false ),
+                m_MaximumUnrolledStatementCount( 0 ),
+                m_MaximumInFlightFetchCount( 0 ),
+                m_EstimatedCost( 0 ),
+                m_PreshaderOperationCount( 0 )
+            {
+            }
+
+            // Resolutions are looked up in the cache and added to it, so generators of
+            // the same batch reuse the functions resolved for each other. The cache
+            // must outlive the generator.
+            void SetResolutionCache( ResolutionCache * cache )
+            {
+                m_ResolutionCache = cache;
+            }
+
+            // Estimates the cost of the resolved functions, see GetEstimatedCost. The
+            // estimator must outlive the generator.
+            void SetCostEstimator( CostEstimator * estimator )
+            {
+                m_CostEstimator = estimator;
+            }
+
+            // Chooses the function generating a semantic whose cost, added to the one of
+            // the functions resolving its inputs, is the lowest, instead of the one of the
+            // last fragment. Needs a cost estimator, and a resolution cache must not be
+            // shared with generators using the other selection.
+            void SetCheapestSelection( const bool selects_cheapest )
+            {
+                m_SelectsCheapest = selects_cheapest;
+            }
+
+            // Reorders the calls of the generated main to shorten the live ranges of the
+            // temporaries, see CallScheduler
+            void SetCallScheduling( const bool schedules_calls )
+            {
+                m_SchedulesCalls = schedules_calls;
+            }
+
+            // Unrolls the loops of the generated functions having a constant trip count,
+            // when the copies of their body add up to at most the given statement count,
+            // see LoopUnroller. 0 disables it.
+            void SetLoopUnrolling( const int maximum_statement_count )
+            {
+                m_MaximumUnrolledStatementCount = maximum_statement_count;
+            }
+
+            // Rewrites the operations of the generated functions into cheaper forms giving
+            // the same result, see StrengthReducer
+            void SetStrengthReduction( const bool reduces_strength )
+            {
+                m_ReducesStrength = reduces_strength;
+            }
+
+            // Also allows the rewrites changing the rounding, implies the strength reduction
+            void SetFastMath( const bool allows_fast_math )
+            {
+                m_AllowsFastMath = allows_fast_math;
+            }
+
+            // Declares the local vectors of the generated functions with only their read
+            // components, see VectorNarrower
+            void SetVectorNarrowing( const bool narrows_vectors )
+            {
+                m_NarrowsVectors = narrows_vectors;
+            }
+
+            // Issues the texture fetches of the generated functions early, with at most
+            // the given count pending at once, see TextureFetchHoister. 0 disables it.
+            void SetTextureFetchHoisting( const int maximum_in_flight_count )
+            {
+                m_MaximumInFlightFetchCount = maximum_in_flight_count;
+            }
+
+            // Moves the expressions only reading uniforms out of the generated functions,
+            // into the evaluation program of the extractor, see PreshaderExtractor. The
+            // extractor must outlive the generator, and the programs generated with the
+            // same extractor share their preshader.
+            void SetPreshaderExtractor( PreshaderExtractor * extractor )
+            {
+                m_PreshaderExtractor = extractor;
+            }
+
             void GenerateShader(
                 Base::ObjectRef<AST::TranslationUnit> & generated_shader,
                 std::vector<std::string> & used_semantic_set,
@@ -29,15 +140,84 @@
                 Base::ErrorHandlerInterface & error_handler
                 );
 
+            // Only resolves the functions generating the semantics, without parsing deferred
+            // fragments or building any AST. Returns false when a semantic has no producer.
+            // Cycles and semantic type conflicts are only detected by GenerateShader.
+            bool QueryShader(
+                std::vector<std::string> & used_semantic_set,
+                std::vector<FunctionDefinition::Ref> & function_table,
+                const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+                const std::vector<std::string> & semantic_table,
+                const std::vector<std::string> & input_semantic_set,
+                Base::ErrorHandlerInterface & error_handler
+                );
+
+            // Resolves the functions generating the semantics on top of the ones already in
+            // the state, so queries sharing semantics only resolve the added ones. Semantics
+            // generated by the state need no function, and its functions are not used again.
+            // Returns false, leaving the state unchanged, when a semantic has no producer.
+            bool ContinueQuery(
+                QueryState & state,
+                const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+                const std::vector<std::string> & semantic_table,
+                const std::vector<std::string> & input_semantic_set,
+                Base::ErrorHandlerInterface & error_handler
+                );
+
+            // Every semantic a producer was searched for during the last generation. The
+            // result can only change when a fragment producing one of them changes.
+            const std::set<std::string> & GetSearchedSemanticSet() const
+            {
+                return m_SearchedSemanticSet;
+            }
+
+            // Estimated cost of the functions used by the last generation, 0 without
+            // cost estimator
+            int GetEstimatedCost() const
+            {
+                return m_EstimatedCost;
+            }
+
+            // Operations moved to the preshader by the last generation, 0 without extractor
+            int GetPreshaderOperationCount() const
+            {
+                return m_PreshaderOperationCount;
+            }
+
         private:
 
+            // Functions matching before the returned one but already used are added to
+            // the skipped table when one is given, and the semantics searched to cost the
+            // candidates to the searched set
             bool FindMatchingFunction(
                 FunctionDefinition::Ref & function,
+                FragmentDefinition::Ref & fragment,
+                std::vector<FunctionDefinition::Ref> * skipped_function_table,
+                std::set<std::string> * searched_semantic_set,
                 std::set<FunctionDefinition::Ref> & used_function_set,
                 const std::set<std::string> & semantic_set,
                 const std::vector<FragmentDefinition::Ref > & definition_table
                 );
 
+            // Cost of the function and of the ones resolving its inputs, chosen from the
+            // last fragments and ignoring the functions already used, so the result only
+            // depends on the fragments. Returns false when an input has no producer.
+            bool GetSubgraphCost(
+                int & cost,
+                std::set<std::string> & searched_semantic_set,
+                const FunctionDefinition::Ref & function,
+                const FragmentDefinition & fragment,
+                const std::vector<FragmentDefinition::Ref > & definition_table
+                );
+
+            void AddUsedFunction(
+                std::set<FunctionDefinition::Ref> & used_function_set,
+                const FunctionDefinition::Ref & function,
+                const FragmentDefinition::Ref & fragment
+                );
+
+            void AddUsedFragment( const FragmentDefinition::Ref & fragment );
+
             void RemoveInputSemantics( std::set<std::string> & semantic_set );
 
             void AddArgumentTable(
@@ -55,6 +235,28 @@
                 const std::vector<FragmentDefinition::Ref > & fragment_table
                 );
 
+            // Chooses the functions generating the output semantics not generated yet,
+            // building the graph of their dependencies when one is given
+            bool ResolveFunctions(
+                Graph * graph,
+                std::set<FunctionDefinition::Ref> & used_function_set,
+                std::set<std::string> & generated_set,
+                const std::vector<FragmentDefinition::Ref > & fragment_table
+                );
+
+            // Replays a cached resolution of the remaining open semantics
+            bool SpliceResolution(
+                Graph * graph,
+                std::set<FunctionDefinition::Ref> & used_function_set,
+                const Resolution & resolution
+                );
+
+            void Initialize(
+                const std::vector<std::string> & semantic_table,
+                const std::vector<std::string> & input_semantic_set,
+                Base::ErrorHandlerInterface & error_handler
+                );
+
             void MergeTranslationUnit(
                 AST::TranslationUnit & destination_translation_unit,
                 const std::vector<Base::ObjectRef<AST::TranslationUnit> > & translation_unit_table
@@ -67,11 +269,31 @@
             std::set<std::string>
                 m_OutputSemanticSet,
                 m_InputSemanticSet,
-                m_UsedSemanticSet;
-            std::vector<Base::ObjectRef<AST::TranslationUnit> >
-                m_UsedTranslationUnitSet;
+                m_UsedSemanticSet,
+                m_SearchedSemanticSet;
+            std::vector<FunctionDefinition::Ref>
+                m_UsedFunctionTable;
+            std::vector<Base::ObjectRef<FragmentDefinition> >
+                m_UsedFragmentTable;
             mutable Base::ErrorHandlerInterface::Ref
                 m_ErrorHandler;
+            ResolutionCache
+                * m_ResolutionCache;
+            CostEstimator
+                * m_CostEstimator;
+            PreshaderExtractor
+                * m_PreshaderExtractor;
+            bool
+                m_SelectsCheapest,
+                m_SchedulesCalls,
+                m_ReducesStrength,
+                m_AllowsFastMath,
+                m_NarrowsVectors;
+            int
+                m_MaximumUnrolledStatementCount,
+                m_MaximumInFlightFetchCount,
+                m_EstimatedCost,
+                m_PreshaderOperationCount;
 
         };
     }
@@ -0,0 +1,560 @@
+#include "cost_estimator.h"
+
+#include "pass_helpers.h"
+#include <ast/node.h>
+#include <ast/tree_traverser.h>
+#include <algorithm>
+#include <set>
+
+namespace Generation
+{
+    namespace
+    {
+        const char
+            * const TextureFetchTable[] =
+            {
+                "Sample", "SampleBias", "SampleCmp", "SampleCmpLevelZero", "SampleGrad", "SampleLevel",
+                "Load", "Gather"
+            },
+            * const TranscendentalTable[] =
+            {
+                "exp", "exp2", "log", "log2", "log10", "pow",
+                "sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sincos", "sinh", "cosh", "tanh",
+                "sqrt", "rsqrt", "rcp", "normalize", "length", "distance", "refract"
+            };
+
+        const AST::FunctionDeclaration * FindFunctionDeclaration(
+            const AST::TranslationUnit & translation_unit,
+            const std::string & name,
+            const size_t argument_count
+            )
+        {
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+
+            for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+            {
+                if( (*it)->m_Kind != AST::NodeKind_FunctionDeclaration )
+                {
+                    continue;
+                }
+
+                const AST::FunctionDeclaration
+                    & function = static_cast<const AST::FunctionDeclaration &>( **it );
+
+                if( function.m_Name == name
+                    && ( function.m_ArgumentList ? function.m_ArgumentList->m_ArgumentTable.size() : 0 ) == argument_count
+                    )
+                {
+                    return &function;
+                }
+            }
+
+            return 0;
+        }
+
+        class CostVisitor : public AST::TreeTraverser
+        {
+        public:
+
+            CostVisitor(
+                ShaderCost & cost,
+                const AST::TranslationUnit * translation_unit,
+                std::set<const AST::FunctionDeclaration *> & active_function_set
+                ) :
+                m_Cost( cost ),
+                m_TranslationUnit( translation_unit ),
+                m_ActiveFunctionSet( active_function_set )
+            {
+            }
+
+            void VisitBody( const AST::FunctionDeclaration & function )
+            {
+                function.ResolveBody();
+
+                m_ActiveFunctionSet.insert( &function );
+
+                std::vector<Base::ObjectRef<AST::Statement> >::const_iterator it, end;
+
+                for( it = function.m_StatementTable.begin(), end = function.m_StatementTable.end(); it != end; ++it )
+                {
+                    (*it)->Visit( *this );
+                }
+
+                m_ActiveFunctionSet.erase( &function );
+            }
+
+            using AST::TreeTraverser::Visit;
+
+            virtual void Visit( const AST::Node & /*node*/ ) override {}
+
+            virtual void Visit( const AST::UnaryOperationExpression & expression ) override
+            {
+                ++m_Cost.m_AluCount;
+                TreeTraverser::Visit( expression );
+            }
+
+            virtual void Visit( const AST::BinaryOperationExpression & expression ) override
+            {
+                ++m_Cost.m_AluCount;
+                TreeTraverser::Visit( expression );
+            }
+
+            virtual void Visit( const AST::ConditionalExpression & expression ) override
+            {
+                ++m_Cost.m_AluCount;
+                TreeTraverser::Visit( expression );
+            }
+
+            virtual void Visit( const AST::PreModifyExpression & expression ) override
+            {
+                ++m_Cost.m_AluCount;
+                TreeTraverser::Visit( expression );
+            }
+
+            virtual void Visit( const AST::PostModifyExpression & expression ) override
+            {
+                ++m_Cost.m_AluCount;
+                TreeTraverser::Visit( expression );
+            }
+
+            virtual void Visit( const AST::AssignmentExpression & expression ) override
+            {
+                if( expression.m_Operator != AST::AssignmentOperator_Assign )
+                {
+                    ++m_Cost.m_AluCount;
+                }
+
+                TreeTraverser::Visit( expression );
+            }
+
+            virtual void Visit( const AST::CallExpression & expression ) override
+            {
+                const size_t
+                    argument_count = expression.m_ArgumentExpressionList ? expression.m_ArgumentExpressionList->m_ExpressionList.size() : 0;
+                const AST::FunctionDeclaration
+                    * function = m_TranslationUnit ? FindFunctionDeclaration( *m_TranslationUnit, expression.m_Name, argument_count ) : 0;
+
+                TreeTraverser::Visit( expression );
+
+                if( function )
+                {
+                    // Recursion is not allowed in HLSL, but is not worth looping over
+                    if( m_ActiveFunctionSet.find( function ) == m_ActiveFunctionSet.end() )
+                    {
+                        VisitBody( *function );
+                    }
+                }
+                else if( IsTextureFetchIntrinsic( expression.m_Name ) || Contains( TextureFetchTable, expression.m_Name ) )
+                {
+                    ++m_Cost.m_TextureFetchCount;
+                }
+                else if( Contains( TranscendentalTable, expression.m_Name ) )
+                {
+                    ++m_Cost.m_TranscendentalCount;
+                }
+                else
+                {
+                    ++m_Cost.m_AluCount;
+                }
+            }
+
+            virtual void Visit( const AST::WhileStatement & statement ) override
+            {
+                VisitLoop( statement, CostEstimator::DefaultTripCount );
+            }
+
+            virtual void Visit( const AST::DoWhileStatement & statement ) override
+            {
+                VisitLoop( statement, CostEstimator::DefaultTripCount );
+            }
+
+            virtual void Visit( const AST::ForStatement & statement ) override
+            {
+                int
+                    trip_count;
+
+                if( !CostEstimator::GetConstantTripCount( trip_count, statement ) )
+                {
+                    trip_count = CostEstimator::DefaultTripCount;
+                }
+
+                if( statement.m_InitStatement )
+                {
+                    statement.m_InitStatement->Visit( *this );
+                }
+
+                ShaderCost
+                    outer_cost = m_Cost;
+
+                m_Cost = ShaderCost();
+
+                if( statement.m_EqualityExpression )
+                {
+                    statement.m_EqualityExpression->Visit( *this );
+                }
+
+                if( statement.m_ModifyExpression )
+                {
+                    statement.m_ModifyExpression->Visit( *this );
+                }
+
+                statement.m_Statement->Visit( *this );
+                AddIterations( outer_cost, trip_count );
+            }
+
+        private:
+
+            CostVisitor & operator=( const CostVisitor & );
+
+            template< class _Loop_ >
+            void VisitLoop( const _Loop_ & statement, const int trip_count )
+            {
+                ShaderCost
+                    outer_cost = m_Cost;
+
+                m_Cost = ShaderCost();
+                statement.m_Condition->Visit( *this );
+                statement.m_Statement->Visit( *this );
+                AddIterations( outer_cost, trip_count );
+            }
+
+            // m_Cost holds the cost of one iteration
+            void AddIterations( const ShaderCost & outer_cost, const int trip_count )
+            {
+                m_Cost.m_AluCount *= trip_count;
+                m_Cost.m_TextureFetchCount *= trip_count;
+                m_Cost.m_TranscendentalCount *= trip_count;
+                m_Cost += outer_cost;
+            }
+
+            ShaderCost
+                & m_Cost;
+            const AST::TranslationUnit
+                * m_TranslationUnit;
+            std::set<const AST::FunctionDeclaration *>
+                & m_ActiveFunctionSet;
+        };
+
+        // Name of the variable of a loop condition or increment
+        const std::string * GetLoopVariable( const AST::Expression & expression )
+        {
+            const AST::LValueExpression
+                * lvalue = 0;
+
+            switch( expression.m_Kind )
+            {
+                case AST::NodeKind_VariableExpression:
+                    return &static_cast<const AST::VariableExpression &>( expression ).m_Name;
+
+                case AST::NodeKind_PreModifyExpression:
+                    lvalue = &*static_cast<const AST::PreModifyExpression &>( expression ).m_Expression;
+                    break;
+
+                case AST::NodeKind_PostModifyExpression:
+                    lvalue = &*static_cast<const AST::PostModifyExpression &>( expression ).m_Expression;
+                    break;
+
+                case AST::NodeKind_AssignmentExpression:
+                    lvalue = &*static_cast<const AST::AssignmentExpression &>( expression ).m_LValueExpression;
+                    break;
+
+                default:
+                    return 0;
+            }
+
+            return lvalue->m_Suffix ? 0 : &lvalue->m_VariableExpression->m_Name;
+        }
+    }
+
+    ShaderCost & ShaderCost::operator+=( const ShaderCost & other )
+    {
+        m_AluCount += other.m_AluCount;
+        m_TextureFetchCount += other.m_TextureFetchCount;
+        m_TranscendentalCount += other.m_TranscendentalCount;
+
+        return *this;
+    }
+
+    int ShaderCost::GetTotal() const
+    {
+        return m_AluCount
+            + m_TextureFetchCount * CostEstimator::TextureFetchWeight
+            + m_TranscendentalCount * CostEstimator::TranscendentalWeight;
+    }
+
+    ShaderCost CostEstimator::GetFunctionCost(
+        const FunctionDefinition::Ref & function,
+        const FragmentDefinition & fragment
+        )
+    {
+        {
+            std::lock_guard<std::mutex>
+                lock( m_Mutex );
+            std::map<FunctionDefinition::Ref, ShaderCost>::const_iterator
+                it = m_FunctionCostTable.find( function );
+
+            if( it != m_FunctionCostTable.end() )
+            {
+                return (*it).second;
+            }
+        }
+
+        // Estimated without the lock, two threads may compute the same cost and the
+        // second insertion is then ignored
+        const AST::TranslationUnit
+            & translation_unit = fragment.GetTranslationUnit();
+        const AST::FunctionDeclaration
+            * declaration = function->HasFunctionDeclaration()
+                ? &function->GetFunctionDeclaration()
+                : FindFunctionDeclaration( translation_unit, function->GetName(), function->GetArgumentTable().size() );
+        ShaderCost
+            cost;
+
+        if( declaration )
+        {
+            EstimateFunction( cost, *declaration, &translation_unit );
+        }
+
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        m_FunctionCostTable.insert( std::make_pair( function, cost ) );
+
+        return cost;
+    }
+
+    int CostEstimator::GetTotalCost(
+        const std::vector<FunctionDefinition::Ref> & function_table,
+        const std::vector<FragmentDefinition::Ref> & definition_table
+        )
+    {
+        std::vector<FunctionDefinition::Ref>::const_iterator it, end;
+        int
+            total = 0;
+
+        for( it = function_table.begin(), end = function_table.end(); it != end; ++it )
+        {
+            std::vector<FragmentDefinition::Ref>::const_iterator fragment_it, fragment_end;
+
+            for( fragment_it = definition_table.begin(), fragment_end = definition_table.end(); fragment_it != fragment_end; ++fragment_it )
+            {
+                const std::vector<FunctionDefinition::Ref>
+                    & fragment_function_table = (*fragment_it)->GetFunctionDefinitionTable();
+
+                if( std::find( fragment_function_table.begin(), fragment_function_table.end(), &**it ) != fragment_function_table.end() )
+                {
+                    total += GetFunctionCost( *it, **fragment_it ).GetTotal();
+                    break;
+                }
+            }
+        }
+
+        return total;
+    }
+
+    void CostEstimator::EstimateFunction(
+        ShaderCost & cost,
+        const AST::FunctionDeclaration & function,
+        const AST::TranslationUnit * translation_unit
+        )
+    {
+        std::set<const AST::FunctionDeclaration *>
+            active_function_set;
+        CostVisitor
+            visitor( cost, translation_unit, active_function_set );
+
+        visitor.VisitBody( function );
+    }
+
+    bool CostEstimator::GetConstantTripCount(
+        int & trip_count,
+        const AST::ForStatement & statement
+        )
+    {
+        ConstantLoop
+            loop;
+
+        if( !GetConstantLoop( loop, statement ) )
+        {
+            return false;
+        }
+
+        trip_count = loop.m_TripCount;
+
+        return true;
+    }
+
+    bool CostEstimator::GetConstantLoop(
+        ConstantLoop & loop,
+        const AST::ForStatement & statement
+        )
+    {
+        const std::string
+            * variable = 0;
+        // Bounds and step, the step of ++i and i-- having none
+        const AST::Expression
+            * literal_table[ 3 ] = { 0, 0, 0 };
+        int
+            first,
+            last,
+            step;
+
+        if( !statement.m_InitStatement || !statement.m_EqualityExpression || !statement.m_ModifyExpression )
+        {
+            return false;
+        }
+
+        // int i = first; or i = first;
+        if( statement.m_InitStatement->m_Kind == AST::NodeKind_VariableDeclarationStatement )
+        {
+            const AST::VariableDeclarationStatement
+                & declaration = static_cast<const AST::VariableDeclarationStatement &>( *statement.m_InitStatement );
+
+            if( declaration.m_BodyTable.size() != 1
+                || !declaration.m_BodyTable[ 0 ]->m_InitialValue
+                || declaration.m_BodyTable[ 0 ]->m_InitialValue->m_ExpressionTable.size() != 1
+                || !GetIntegerLiteral( first, *declaration.m_BodyTable[ 0 ]->m_InitialValue->m_ExpressionTable[ 0 ], true )
+                )
+            {
+                return false;
+            }
+
+            variable = &declaration.m_BodyTable[ 0 ]->m_Name;
+            literal_table[ 0 ] = &*declaration.m_BodyTable[ 0 ]->m_InitialValue->m_ExpressionTable[ 0 ];
+        }
+        else if( statement.m_InitStatement->m_Kind == AST::NodeKind_AssignmentStatement )
+        {
+            const AST::AssignmentExpression
+                & assignment = *static_cast<const AST::AssignmentStatement &>( *statement.m_InitStatement ).m_Expression;
+
+            if( assignment.m_Operator != AST::AssignmentOperator_Assign
+                || !GetIntegerLiteral( first, *assignment.m_Expression, true )
+                )
+            {
+                return false;
+            }
+
+            variable = GetLoopVariable( assignment );
+            literal_table[ 0 ] = &*assignment.m_Expression;
+        }
+
+        if( !variable )
+        {
+            return false;
+        }
+
+        // i < last
+        if( statement.m_EqualityExpression->m_Kind != AST::NodeKind_BinaryOperationExpression )
+        {
+            return false;
+        }
+
+        const AST::BinaryOperationExpression
+            & condition = static_cast<const AST::BinaryOperationExpression &>( *statement.m_EqualityExpression );
+        const std::string
+            * condition_variable = GetLoopVariable( *condition.m_LeftExpression );
+
+        if( !condition_variable || *condition_variable != *variable || !GetIntegerLiteral( last, *condition.m_RightExpression, true ) )
+        {
+            return false;
+        }
+
+        literal_table[ 1 ] = &*condition.m_RightExpression;
+
+        // ++i, i--, i += step
+        const AST::Expression
+            & modify = *statement.m_ModifyExpression;
+        const std::string
+            * modify_variable = GetLoopVariable( modify );
+
+        if( !modify_variable || *modify_variable != *variable )
+        {
+            return false;
+        }
+
+        switch( modify.m_Kind )
+        {
+            case AST::NodeKind_PreModifyExpression:
+                step = static_cast<const AST::PreModifyExpression &>( modify ).m_Operator == AST::SelfModifyOperator_PlusPlus ? 1 : -1;
+                break;
+
+            case AST::NodeKind_PostModifyExpression:
+                step = static_cast<const AST::PostModifyExpression &>( modify ).m_Operator == AST::SelfModifyOperator_PlusPlus ? 1 : -1;
+                break;
+
+            default:
+            {
+                const AST::AssignmentExpression
+                    & assignment = static_cast<const AST::AssignmentExpression &>( modify );
+
+                if( !GetIntegerLiteral( step, *assignment.m_Expression, true ) )
+                {
+                    return false;
+                }
+
+                literal_table[ 2 ] = &*assignment.m_Expression;
+
+                if( assignment.m_Operator == AST::AssignmentOperator_Subtract )
+                {
+                    step = -step;
+                }
+                else if( assignment.m_Operator != AST::AssignmentOperator_Add )
+                {
+                    return false;
+                }
+            }
+        }
+
+        loop.m_Variable = *variable;
+        loop.m_First = first;
+        loop.m_Step = step;
+        loop.m_IsInteger = true;
+
+        for( size_t index = 0; index < 3; ++index )
+        {
+            int
+                value;
+
+            loop.m_IsInteger = loop.m_IsInteger && ( !literal_table[ index ] || GetIntegerLiteral( value, *literal_table[ index ], false ) );
+        }
+
+        switch( condition.m_Operation )
+        {
+            case AST::BinaryOperationExpression::LessThanOrEqual:
+                ++last;
+                // fall through
+            case AST::BinaryOperationExpression::LessThan:
+                if( step <= 0 )
+                {
+                    return false;
+                }
+
+                loop.m_TripCount = last > first ? ( last - first + step - 1 ) / step : 0;
+                return true;
+
+            case AST::BinaryOperationExpression::GreaterThanOrEqual:
+                --last;
+                // fall through
+            case AST::BinaryOperationExpression::GreaterThan:
+                if( step >= 0 )
+                {
+                    return false;
+                }
+
+                loop.m_TripCount = first > last ? ( first - last - step - 1 ) / -step : 0;
+                return true;
+
+            case AST::BinaryOperationExpression::Difference:
+                if( step == 0 || ( last - first ) % step != 0 || ( last - first ) / step < 0 )
+                {
+                    return false;
+                }
+
+                loop.m_TripCount = ( last - first ) / step;
+                return true;
+
+            default:
+                return false;
+        }
+    }
+}
\ No newline at end of file
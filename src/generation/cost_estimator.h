@@ -0,0 +1,108 @@
+#ifndef COST_ESTIMATOR_H
+    #define COST_ESTIMATOR_H
+
+    #include <map>
+    #include <mutex>
+    #include <string>
+    #include <vector>
+    #include <base/object_ref.h>
+    #include "function_definition.h"
+
+    namespace AST
+    {
+        struct FunctionDeclaration;
+        struct ForStatement;
+        struct TranslationUnit;
+    }
+
+    namespace Generation
+    {
+        struct ShaderCost
+        {
+            ShaderCost() : m_AluCount( 0 ), m_TextureFetchCount( 0 ), m_TranscendentalCount( 0 ) {}
+
+            ShaderCost & operator+=( const ShaderCost & other );
+
+            // Weighted sum, in ALU operations
+            int GetTotal() const;
+
+            int
+                m_AluCount,
+                m_TextureFetchCount,
+                m_TranscendentalCount;
+        };
+
+        // Static estimate of the operations executed by the functions of the fragments.
+        //
+        // Calls of functions declared in the same translation unit add the cost of
+        // their body. Loops with a constant trip count multiply the cost of their body,
+        // the others are assumed to run DefaultTripCount times. Both branches of a
+        // condition are counted. Function costs are computed on first use and shared
+        // between threads; the estimator must outlive the generators using it.
+
+        class CostEstimator
+        {
+        public:
+
+            enum
+            {
+                DefaultTripCount = 8,
+                TextureFetchWeight = 8,
+                TranscendentalWeight = 4
+            };
+
+            // Loads the fragment when the function was created from an index, so the
+            // fragments used by several threads must be prewarmed
+            ShaderCost GetFunctionCost(
+                const Base::ObjectRef<FunctionDefinition> & function,
+                const FragmentDefinition & fragment
+                );
+
+            // Total of the functions, which must come from the fragments of the table
+            int GetTotalCost(
+                const std::vector<Base::ObjectRef<FunctionDefinition> > & function_table,
+                const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table
+                );
+
+            static void EstimateFunction(
+                ShaderCost & cost,
+                const AST::FunctionDeclaration & function,
+                const AST::TranslationUnit * translation_unit
+                );
+
+            struct ConstantLoop
+            {
+                std::string
+                    m_Variable;
+                int
+                    m_First,
+                    m_Step,
+                    m_TripCount;
+                // The bounds and the step are integer literals without suffix, so the
+                // values of the variable can be written as such
+                bool
+                    m_IsInteger;
+            };
+
+            // Recognizes for( i = a; i < b; ++i ) loops, and their variants with other
+            // comparisons and constant increments
+            static bool GetConstantLoop(
+                ConstantLoop & loop,
+                const AST::ForStatement & statement
+                );
+
+            static bool GetConstantTripCount(
+                int & trip_count,
+                const AST::ForStatement & statement
+                );
+
+        private:
+
+            std::mutex
+                m_Mutex;
+            std::map<Base::ObjectRef<FunctionDefinition>, ShaderCost>
+                m_FunctionCostTable;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "flat_semantic_remover.h"
+
+#include <ast/flat/flat_translation_unit.h>
+
+namespace Generation
+{
+    void FlatSemanticRemover::Process( AST::FlatTranslationUnit & flat_unit ) const
+    {
+        for( size_t index = 0; index < flat_unit.GetNodeCount(); ++index )
+        {
+            AST::FlatNode
+                & node = flat_unit.GetNode( static_cast<uint32_t>( index ) );
+
+            if( node.m_Kind == AST::NodeKind_FunctionDeclaration || node.m_Kind == AST::NodeKind_Argument )
+            {
+                node.m_String[ AST::FlatNode::String_Semantic ] = 0;
+            }
+        }
+    }
+}
\ No newline at end of file
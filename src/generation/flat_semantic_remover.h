@@ -0,0 +1,20 @@
+#ifndef FLAT_SEMANTIC_REMOVER_H
+    #define FLAT_SEMANTIC_REMOVER_H
+
+    namespace AST
+    {
+        class FlatTranslationUnit;
+    }
+
+    namespace Generation
+    {
+        // Same result as SemanticRemover, in one pass over the node array
+        class FlatSemanticRemover
+        {
+        public:
+
+            void Process( AST::FlatTranslationUnit & flat_unit ) const;
+        };
+    }
+
+#endif
\ No newline at end of file
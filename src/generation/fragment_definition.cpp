@@ -2,7 +2,9 @@
 #include "function_definition.h"
 #include "ast/empty_visitor.h"
 #include "ast/node.h"
+#include "base/statistics.h"
 #include <algorithm>
+#include <cassert>
 
 namespace Generation
 {
@@ -70,6 +72,8 @@ namespace Generation
         AST::TranslationUnit & translation_unit
         )
     {
+        Base::ScopedTimer
+            timer( "generate_fragment" );
         GetFunctionVisitor
             visitor;
         Base::ObjectRef<FragmentDefinition>
@@ -95,6 +99,58 @@ namespace Generation
         return fragment_definition;
     }
 
+    Base::ObjectRef<FragmentDefinition> FragmentDefinition::CreateDeferred(
+        const std::string & path,
+        FragmentLoaderInterface & loader,
+        const std::vector<Base::ObjectRef<FunctionDefinition> > & function_definition_table
+        )
+    {
+        Base::ObjectRef<FragmentDefinition>
+            fragment_definition;
+
+        fragment_definition = new FragmentDefinition;
+
+        fragment_definition->m_SourceFilename = path;
+        fragment_definition->m_Loader = &loader;
+        fragment_definition->m_FunctionDefinitionTable = function_definition_table;
+
+        return fragment_definition;
+    }
+
+    const AST::TranslationUnit & FragmentDefinition::GetTranslationUnit() const
+    {
+        if( !m_TranslationUnit )
+        {
+            assert( m_Loader );
+
+            m_TranslationUnit = m_Loader->LoadTranslationUnit( m_SourceFilename );
+
+            if( !m_TranslationUnit )
+            {
+                // Error already reported by the loader
+                m_TranslationUnit = new AST::TranslationUnit;
+            }
+        }
+
+        return *m_TranslationUnit;
+    }
+
+    void FragmentDefinition::Prewarm() const
+    {
+        std::vector< Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+
+        it = GetTranslationUnit().m_GlobalDeclarationTable.begin();
+        end = GetTranslationUnit().m_GlobalDeclarationTable.end();
+
+        for( ; it != end; ++it )
+        {
+            if( (*it)->m_Kind == AST::NodeKind_FunctionDeclaration )
+            {
+                static_cast<const AST::FunctionDeclaration &>( **it ).ResolveBody();
+            }
+        }
+    }
+
     bool FragmentDefinition::FindFunctionDefinition(
         Base::ObjectRef<FunctionDefinition> & definition,
         const std::string & name
@@ -4,6 +4,7 @@
     #include <memory>
     #include <vector>
     #include <set>
+    #include <string>
     #include "base/object.h"
     #include "base/object_ref.h"
 
@@ -16,6 +17,28 @@
     {
         class FunctionDefinition;
 
+        // Provides the translation unit of a fragment created without it.
+        class FragmentLoaderInterface : public Base::Object
+        {
+        public:
+
+            typedef Base::ObjectRef<FragmentLoaderInterface>
+                Ref;
+
+            virtual ~FragmentLoaderInterface() {}
+
+            // Returns null on failure, after reporting the error
+            virtual Base::ObjectRef<AST::TranslationUnit> LoadTranslationUnit(
+                const std::string & path
+                ) = 0;
+
+            // Files included by the last loaded translation unit, directly or not
+            virtual void GetIncludedPathTable( std::vector<std::string> & /*path_table*/ ) const {}
+
+            // Macros defined for every fragment, as NAME=VALUE sorted by name
+            virtual void GetDefineTable( std::vector<std::string> & /*define_table*/ ) const {}
+        };
+
         class FragmentDefinition : public Base::Object
         {
 
@@ -28,6 +51,13 @@
                 AST::TranslationUnit & translation_unit
                 );
 
+            // The translation unit is only loaded when first requested
+            static Base::ObjectRef<FragmentDefinition> CreateDeferred(
+                const std::string & path,
+                FragmentLoaderInterface & loader,
+                const std::vector<Base::ObjectRef<FunctionDefinition> > & function_definition_table
+                );
+
             bool FindFunctionDefinition(
                 Base::ObjectRef<FunctionDefinition> & definition,
                 const std::string & name
@@ -38,14 +68,28 @@
                 const std::set<std::string> & semantic_set
                 ) const;
 
-            const AST::TranslationUnit & GetTranslationUnit() const { return *m_TranslationUnit; }
+            const AST::TranslationUnit & GetTranslationUnit() const;
+            bool IsLoaded() const { return m_TranslationUnit; }
+
+            // Loads the translation unit and every deferred function body, after which
+            // the fragment is only read and can be shared between threads
+            void Prewarm() const;
+
+            const std::vector<Base::ObjectRef<FunctionDefinition> > & GetFunctionDefinitionTable() const
+            {
+                return m_FunctionDefinitionTable;
+            }
 
         private:
 
-            Base::ObjectRef<AST::TranslationUnit>
+            mutable Base::ObjectRef<AST::TranslationUnit>
                 m_TranslationUnit;
             std::vector<Base::ObjectRef<FunctionDefinition> >
                 m_FunctionDefinitionTable;
+            std::string
+                m_SourceFilename;
+            mutable FragmentLoaderInterface::Ref
+                m_Loader;
 
         };
 
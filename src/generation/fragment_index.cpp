@@ -0,0 +1,424 @@
+#include "fragment_index.h"
+
+#include <ast/node.h>
+#include <utils/hash.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace Generation
+{
+    namespace
+    {
+        const char
+            * const IndexHeader = "shader_shaker_index",
+            * const EmptyField = "-";
+        const int
+            IndexVersion = 2;
+
+        std::string EncodeField( const std::string & value )
+        {
+            return value.empty() ? EmptyField : value;
+        }
+
+        std::string DecodeField( const std::string & value )
+        {
+            return value == EmptyField ? "" : value;
+        }
+
+        // Paths may contain spaces, so they always end the line
+        std::string ReadRemainingText( std::istream & stream )
+        {
+            std::string
+                text;
+
+            std::getline( stream, text );
+
+            size_t
+                first = text.find_first_not_of( ' ' );
+
+            return first == std::string::npos ? "" : text.substr( first );
+        }
+    }
+
+    bool FragmentIndex::Build(
+        const std::vector<std::string> & path_table,
+        FragmentLoaderInterface & loader,
+        Base::ErrorHandlerInterface & error_handler
+        )
+    {
+        std::vector<std::string>::const_iterator it, end;
+        std::vector<std::string>
+            define_table;
+        bool
+            success = true;
+
+        m_EntryTable.clear();
+        loader.GetDefineTable( define_table );
+
+        for( it = path_table.begin(), end = path_table.end(); it != end; ++it )
+        {
+            Entry
+                entry;
+            Base::ObjectRef<AST::TranslationUnit>
+                translation_unit;
+
+            entry.m_Path = *it;
+
+            if( !ReadFileState( entry.m_Timestamp, entry.m_ContentHash, *it ) )
+            {
+                error_handler.ReportError( "Unable to read file", *it );
+                success = false;
+                continue;
+            }
+
+            translation_unit = loader.LoadTranslationUnit( *it );
+
+            if( !translation_unit )
+            {
+                success = false;
+                continue;
+            }
+
+            std::vector<std::string>
+                included_path_table;
+            std::vector<std::string>::const_iterator included_it, included_end;
+
+            loader.GetIncludedPathTable( included_path_table );
+
+            for( included_it = included_path_table.begin(), included_end = included_path_table.end(); included_it != included_end; ++included_it )
+            {
+                IncludedFile
+                    included_file;
+
+                included_file.m_Path = *included_it;
+
+                if( !ReadFileState( included_file.m_Timestamp, included_file.m_ContentHash, *included_it ) )
+                {
+                    error_handler.ReportError( "Unable to read file", *included_it );
+                    success = false;
+                    continue;
+                }
+
+                entry.m_IncludedFileTable.push_back( included_file );
+            }
+
+            entry.m_DefineTable = define_table;
+            entry.m_FunctionDefinitionTable = FragmentDefinition::GenerateFragment( *translation_unit )->GetFunctionDefinitionTable();
+
+            m_EntryTable.push_back( entry );
+        }
+
+        return success;
+    }
+
+    void FragmentIndex::Save( std::ostream & stream ) const
+    {
+        std::vector<Entry>::const_iterator it, end;
+
+        stream << IndexHeader << " " << IndexVersion << "\n";
+
+        for( it = m_EntryTable.begin(), end = m_EntryTable.end(); it != end; ++it )
+        {
+            std::vector<FunctionDefinition::Ref>::const_iterator function_it, function_end;
+            std::vector<IncludedFile>::const_iterator included_it, included_end;
+            std::vector<std::string>::const_iterator define_it, define_end;
+
+            stream << "fragment " << (*it).m_Timestamp << " "
+                << std::hex << (*it).m_ContentHash << std::dec << " "
+                << (*it).m_Path << "\n";
+
+            for( define_it = (*it).m_DefineTable.begin(), define_end = (*it).m_DefineTable.end(); define_it != define_end; ++define_it )
+            {
+                stream << "define " << *define_it << "\n";
+            }
+
+            for( included_it = (*it).m_IncludedFileTable.begin(), included_end = (*it).m_IncludedFileTable.end(); included_it != included_end; ++included_it )
+            {
+                stream << "include " << (*included_it).m_Timestamp << " "
+                    << std::hex << (*included_it).m_ContentHash << std::dec << " "
+                    << (*included_it).m_Path << "\n";
+            }
+
+            function_it = (*it).m_FunctionDefinitionTable.begin();
+            function_end = (*it).m_FunctionDefinitionTable.end();
+
+            for( ; function_it != function_end; ++function_it )
+            {
+                const FunctionDefinition
+                    & definition = **function_it;
+                std::vector<FunctionDefinition::Argument>::const_iterator argument_it, argument_end;
+
+                stream << "function " << definition.GetName() << " "
+                    << definition.GetSourceFileLine() << " "
+                    << EncodeField( definition.GetReturnType() ) << " "
+                    << EncodeField( definition.GetReturnSemantic() ) << " "
+                    << definition.GetSourceFilename() << "\n";
+
+                argument_it = definition.GetArgumentTable().begin();
+                argument_end = definition.GetArgumentTable().end();
+
+                for( ; argument_it != argument_end; ++argument_it )
+                {
+                    stream << "argument "
+                        << EncodeField( (*argument_it).m_InputModifier ) << " "
+                        << EncodeField( (*argument_it).m_Type ) << " "
+                        << EncodeField( (*argument_it).m_Semantic ) << "\n";
+                }
+            }
+        }
+    }
+
+    bool FragmentIndex::Load(
+        std::istream & stream,
+        const std::string & index_path,
+        Base::ErrorHandlerInterface & error_handler
+        )
+    {
+        std::string
+            line_text;
+        int
+            line = 0;
+        FunctionDefinition::Ref
+            function_definition;
+
+        m_EntryTable.clear();
+
+        while( std::getline( stream, line_text ) )
+        {
+            std::istringstream
+                line_stream( line_text );
+            std::string
+                keyword;
+            bool
+                is_valid = true;
+
+            ++line;
+            line_stream >> keyword;
+
+            if( line == 1 )
+            {
+                int
+                    version = 0;
+
+                line_stream >> version;
+                is_valid = keyword == IndexHeader && version == IndexVersion;
+            }
+            else if( keyword == "fragment" )
+            {
+                Entry
+                    entry;
+
+                line_stream >> entry.m_Timestamp >> std::hex >> entry.m_ContentHash >> std::dec;
+                entry.m_Path = ReadRemainingText( line_stream );
+                is_valid = !entry.m_Path.empty();
+
+                m_EntryTable.push_back( entry );
+                function_definition = 0;
+            }
+            else if( keyword == "define" && !m_EntryTable.empty() )
+            {
+                const std::string
+                    definition = ReadRemainingText( line_stream );
+
+                is_valid = definition.find( '=' ) != std::string::npos;
+                m_EntryTable.back().m_DefineTable.push_back( definition );
+            }
+            else if( keyword == "include" && !m_EntryTable.empty() )
+            {
+                IncludedFile
+                    included_file;
+
+                line_stream >> included_file.m_Timestamp >> std::hex >> included_file.m_ContentHash >> std::dec;
+                included_file.m_Path = ReadRemainingText( line_stream );
+                is_valid = !included_file.m_Path.empty();
+
+                m_EntryTable.back().m_IncludedFileTable.push_back( included_file );
+            }
+            else if( keyword == "function" && !m_EntryTable.empty() )
+            {
+                std::string
+                    name,
+                    return_type,
+                    return_semantic;
+                int
+                    source_line = 0;
+
+                line_stream >> name >> source_line >> return_type >> return_semantic;
+
+                function_definition = new FunctionDefinition;
+                function_definition->SetName( name );
+                function_definition->SetSourceLocation( ReadRemainingText( line_stream ), source_line );
+
+                if( return_semantic != EmptyField )
+                {
+                    function_definition->SetReturnValue( DecodeField( return_type ), return_semantic );
+                }
+
+                m_EntryTable.back().m_FunctionDefinitionTable.push_back( function_definition );
+            }
+            else if( keyword == "argument" && function_definition )
+            {
+                FunctionDefinition::Argument
+                    argument;
+
+                line_stream >> argument.m_InputModifier >> argument.m_Type >> argument.m_Semantic;
+
+                argument.m_InputModifier = DecodeField( argument.m_InputModifier );
+                argument.m_Type = DecodeField( argument.m_Type );
+                argument.m_Semantic = DecodeField( argument.m_Semantic );
+
+                function_definition->AddArgument( argument );
+            }
+            else if( !keyword.empty() )
+            {
+                is_valid = false;
+            }
+
+            if( !is_valid || line_stream.bad() || ( line_stream.fail() && !line_stream.eof() ) )
+            {
+                std::ostringstream
+                    message;
+
+                message << "line " << line << ": invalid fragment index entry";
+                error_handler.ReportError( message.str(), index_path );
+                m_EntryTable.clear();
+
+                return false;
+            }
+        }
+
+        if( line == 0 )
+        {
+            error_handler.ReportError( "empty fragment index", index_path );
+            return false;
+        }
+
+        return true;
+    }
+
+    bool FragmentIndex::CreateFragmentTable(
+        std::vector<FragmentDefinition::Ref> & definition_table,
+        std::vector<std::string> & stale_path_table,
+        FragmentLoaderInterface & loader
+        ) const
+    {
+        std::vector<Entry>::const_iterator it, end;
+        std::vector<std::string>
+            define_table;
+        bool
+            success = true;
+
+        loader.GetDefineTable( define_table );
+
+        for( it = m_EntryTable.begin(), end = m_EntryTable.end(); it != end; ++it )
+        {
+            if( IsUpToDate( *it, define_table ) )
+            {
+                definition_table.push_back(
+                    FragmentDefinition::CreateDeferred( (*it).m_Path, loader, (*it).m_FunctionDefinitionTable )
+                    );
+                continue;
+            }
+
+            Base::ObjectRef<AST::TranslationUnit>
+                translation_unit = loader.LoadTranslationUnit( (*it).m_Path );
+
+            stale_path_table.push_back( (*it).m_Path );
+
+            if( !translation_unit )
+            {
+                success = false;
+                continue;
+            }
+
+            definition_table.push_back( FragmentDefinition::GenerateFragment( *translation_unit ) );
+        }
+
+        return success;
+    }
+
+    bool FragmentIndex::ReadFileState(
+        int64_t & timestamp,
+        uint64_t & content_hash,
+        const std::string & path
+        )
+    {
+        struct stat
+            file_status;
+
+        if( stat( path.c_str(), &file_status ) != 0 )
+        {
+            return false;
+        }
+
+        std::ifstream
+            file( path.c_str(), std::ios::in | std::ios::binary );
+        std::ostringstream
+            content;
+
+        if( !file )
+        {
+            return false;
+        }
+
+        content << file.rdbuf();
+
+        timestamp = static_cast<int64_t>( file_status.st_mtime );
+        content_hash = compute_content_hash( content.str() );
+
+        return true;
+    }
+
+    bool FragmentIndex::IsUpToDate(
+        const Entry & entry,
+        const std::vector<std::string> & define_table
+        ) const
+    {
+        std::vector<IncludedFile>::const_iterator it, end;
+
+        if( entry.m_DefineTable != define_table || !IsFileUpToDate( entry.m_Path, entry.m_Timestamp, entry.m_ContentHash ) )
+        {
+            return false;
+        }
+
+        for( it = entry.m_IncludedFileTable.begin(), end = entry.m_IncludedFileTable.end(); it != end; ++it )
+        {
+            if( !IsFileUpToDate( (*it).m_Path, (*it).m_Timestamp, (*it).m_ContentHash ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool FragmentIndex::IsFileUpToDate(
+        const std::string & path,
+        const int64_t timestamp,
+        const uint64_t content_hash
+        )
+    {
+        struct stat
+            file_status;
+
+        if( stat( path.c_str(), &file_status ) != 0 )
+        {
+            return false;
+        }
+
+        if( static_cast<int64_t>( file_status.st_mtime ) == timestamp )
+        {
+            return true;
+        }
+
+        // Touched files are still valid when their content did not change
+        int64_t
+            current_timestamp;
+        uint64_t
+            current_content_hash;
+
+        return ReadFileState( current_timestamp, current_content_hash, path )
+            && current_content_hash == content_hash;
+    }
+}
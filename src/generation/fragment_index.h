@@ -0,0 +1,99 @@
+#ifndef FRAGMENT_INDEX_H
+    #define FRAGMENT_INDEX_H
+
+    #include <cstdint>
+    #include <iosfwd>
+    #include <string>
+    #include <vector>
+    #include <base/error_handler_interface.h>
+    #include "fragment_definition.h"
+    #include "function_definition.h"
+
+    namespace Generation
+    {
+        // Function signatures of a fragment library, saved in a text file so
+        // semantics can be resolved without parsing the fragments. Each entry
+        // remembers the timestamp and content hash of its source file and of the
+        // files it includes, and the macros it was preprocessed with. The entry is
+        // stale when any of them changed.
+
+        class FragmentIndex
+        {
+        public:
+
+            bool Build(
+                const std::vector<std::string> & path_table,
+                FragmentLoaderInterface & loader,
+                Base::ErrorHandlerInterface & error_handler
+                );
+
+            void Save( std::ostream & stream ) const;
+
+            bool Load(
+                std::istream & stream,
+                const std::string & index_path,
+                Base::ErrorHandlerInterface & error_handler
+                );
+
+            // Up to date entries give fragments whose translation unit is loaded on
+            // first use. Modified files are loaded now and added to stale_path_table.
+            bool CreateFragmentTable(
+                std::vector<FragmentDefinition::Ref> & definition_table,
+                std::vector<std::string> & stale_path_table,
+                FragmentLoaderInterface & loader
+                ) const;
+
+            size_t GetFragmentCount() const { return m_EntryTable.size(); }
+            const std::string & GetFragmentPath( const size_t index ) const { return m_EntryTable[ index ].m_Path; }
+
+            static bool ReadFileState(
+                int64_t & timestamp,
+                uint64_t & content_hash,
+                const std::string & path
+                );
+
+        private:
+
+            struct IncludedFile
+            {
+                std::string
+                    m_Path;
+                int64_t
+                    m_Timestamp;
+                uint64_t
+                    m_ContentHash;
+            };
+
+            struct Entry
+            {
+                std::string
+                    m_Path;
+                int64_t
+                    m_Timestamp;
+                uint64_t
+                    m_ContentHash;
+                std::vector<IncludedFile>
+                    m_IncludedFileTable;
+                std::vector<std::string>
+                    m_DefineTable;
+                std::vector<FunctionDefinition::Ref>
+                    m_FunctionDefinitionTable;
+            };
+
+            bool IsUpToDate(
+                const Entry & entry,
+                const std::vector<std::string> & define_table
+                ) const;
+
+            static bool IsFileUpToDate(
+                const std::string & path,
+                const int64_t timestamp,
+                const uint64_t content_hash
+                );
+
+            std::vector<Entry>
+                m_EntryTable;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -6,6 +6,12 @@
 namespace  Generation
 {
 
+    FunctionDefinition::FunctionDefinition() :
+        m_SourceFileLine( 0 )
+    {
+
+    }
+
     void FunctionDefinition::FillFromFunctionDeclaration(
         AST::FunctionDeclaration & declaration
         )
@@ -13,6 +19,8 @@ namespace  Generation
         m_Name = declaration.m_Name;
         m_FunctionDeclaration = &declaration;
 
+        SetSourceLocation( declaration.GetFileName(), declaration.GetLine() );
+
         if( declaration.m_ArgumentList )
         {
             std::vector< Base::ObjectRef<AST::Argument> >
@@ -25,31 +33,56 @@ namespace  Generation
 
             for(;it!=end;++it)
             {
-                const AST::Argument & argument = **it;
-
-                if( argument.m_InputModifier == "out" )
-                {
-                    m_OutSemanticSet.insert( argument.m_Semantic );
-                }
-                else if( argument.m_InputModifier == "inout" )
-                {
-                    m_InOutSemanticSet.insert( argument.m_Semantic );
-                }
-                else
-                {
-                    m_InSemanticSet.insert( argument.m_Semantic );
-                }
-
-                SetTypeForSemantic( argument.m_Type->m_Name, argument.m_Semantic );
+                Argument argument;
+
+                argument.m_InputModifier = (*it)->m_InputModifier;
+                argument.m_Type = (*it)->m_Type->m_Name;
+                argument.m_Semantic = (*it)->m_Semantic;
+
+                AddArgument( argument );
             }
         }
 
         if( !declaration.m_Semantic.empty() )
         {
-            m_OutSemanticSet.insert( declaration.m_Semantic );
+            SetReturnValue( declaration.m_Type->m_Name, declaration.m_Semantic );
+        }
+    }
 
-            SetTypeForSemantic( declaration.m_Type->m_Name, declaration.m_Semantic );
+    void FunctionDefinition::AddArgument( const Argument & argument )
+    {
+        if( argument.m_InputModifier == "out" )
+        {
+            m_OutSemanticSet.insert( argument.m_Semantic );
+        }
+        else if( argument.m_InputModifier == "inout" )
+        {
+            m_InOutSemanticSet.insert( argument.m_Semantic );
         }
+        else
+        {
+            m_InSemanticSet.insert( argument.m_Semantic );
+        }
+
+        SetTypeForSemantic( argument.m_Type, argument.m_Semantic );
+
+        m_ArgumentTable.push_back( argument );
+    }
+
+    void FunctionDefinition::SetReturnValue( const std::string & type, const std::string & semantic )
+    {
+        m_ReturnType = type;
+        m_ReturnSemantic = semantic;
+
+        m_OutSemanticSet.insert( semantic );
+
+        SetTypeForSemantic( type, semantic );
+    }
+
+    void FunctionDefinition::SetSourceLocation( const std::string & filename, const int line )
+    {
+        m_SourceFilename = filename;
+        m_SourceFileLine = line;
     }
 
     void FunctionDefinition::GetAllOutSemanticSet( std::set<std::string> & set)
@@ -107,11 +140,11 @@ namespace  Generation
 
     const std::string & FunctionDefinition::GetSourceFilename() const
     {
-        return m_FunctionDeclaration->m_FileName;
+        return m_SourceFilename;
     }
 
     int FunctionDefinition::GetSourceFileLine() const
     {
-        return m_FunctionDeclaration->m_Line;
+        return m_SourceFileLine;
     }
 }
\ No newline at end of file
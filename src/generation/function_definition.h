@@ -4,6 +4,7 @@
     #include <set>
     #include <map>
     #include <string>
+    #include <vector>
     #include <memory>
     #include "fragment_definition.h"
     #include "base/object.h"
@@ -20,10 +21,27 @@
             typedef Base::ObjectRef<FunctionDefinition>
                 Ref;
 
+            struct Argument
+            {
+                std::string
+                    m_InputModifier,
+                    m_Type,
+                    m_Semantic;
+            };
+
+            FunctionDefinition();
+
             void FillFromFunctionDeclaration(
                 AST::FunctionDeclaration & declaration
                 );
 
+            // Used to rebuild a definition without its declaration, e.g. from a
+            // FragmentIndex.
+            void SetName( const std::string & name ) { m_Name = name; }
+            void AddArgument( const Argument & argument );
+            void SetReturnValue( const std::string & type, const std::string & semantic );
+            void SetSourceLocation( const std::string & filename, const int line );
+
             const std::set<std::string> & GetInSemanticSet() const
             {
                 return m_InSemanticSet;
@@ -39,7 +57,13 @@
                 return m_InOutSemanticSet;
             }
 
+            // Not available for definitions rebuilt from an index
             const AST::FunctionDeclaration & GetFunctionDeclaration() const {return *m_FunctionDeclaration;}
+            bool HasFunctionDeclaration() const { return m_FunctionDeclaration; }
+
+            const std::vector<Argument> & GetArgumentTable() const { return m_ArgumentTable; }
+            const std::string & GetReturnType() const { return m_ReturnType; }
+            const std::string & GetReturnSemantic() const { return m_ReturnSemantic; }
 
             void GetAllOutSemanticSet( std::set<std::string> & set);
             void GetAllInSemanticSet( std::set<std::string> & set);
@@ -64,7 +88,14 @@
                 );
 
             std::string
-                m_Name;
+                m_Name,
+                m_ReturnType,
+                m_ReturnSemantic,
+                m_SourceFilename;
+            int
+                m_SourceFileLine;
+            std::vector<Argument>
+                m_ArgumentTable;
             std::set<std::string>
                 m_InSemanticSet,
                 m_OutSemanticSet,
@@ -0,0 +1,385 @@
+#include "interpolator_packer.h"
+
+#include <ast/function_node.h>
+#include <base/statistics.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace Generation
+{
+    namespace
+    {
+        const char
+            * const ComponentNames = "xyzw";
+        const int
+            SlotComponentCount = 4;
+
+        // Components of a float scalar or vector, 0 for the types which are not packed
+        int GetComponentCount( const std::string & type )
+        {
+            if( type == "float" )
+            {
+                return 1;
+            }
+
+            if( type.size() == 6 && type.compare( 0, 5, "float" ) == 0 && type[ 5 ] >= '1' && type[ 5 ] <= '4' )
+            {
+                return type[ 5 ] - '0';
+            }
+
+            return 0;
+        }
+
+        // Matrices use one register per row
+        int GetRegisterCount( const std::string & type )
+        {
+            if( type.size() == 8 && type.compare( 0, 5, "float" ) == 0 && type[ 6 ] == 'x' && type[ 5 ] >= '1' && type[ 5 ] <= '4' )
+            {
+                return type[ 5 ] - '0';
+            }
+
+            return 1;
+        }
+
+        bool IsInput( const AST::Argument & argument )
+        {
+            return argument.m_InputModifier.empty() || argument.m_InputModifier == "in";
+        }
+
+        bool HasMoreComponents(
+            const Base::ObjectRef<AST::Argument> & first,
+            const Base::ObjectRef<AST::Argument> & second
+            )
+        {
+            return GetComponentCount( first->m_Type->m_Name ) > GetComponentCount( second->m_Type->m_Name );
+        }
+
+        AST::FunctionDeclaration * FindMainFunction( AST::TranslationUnit & translation_unit )
+        {
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::reverse_iterator it, end;
+
+            for( it = translation_unit.m_GlobalDeclarationTable.rbegin(), end = translation_unit.m_GlobalDeclarationTable.rend(); it != end; ++it )
+            {
+                AST::FunctionDeclaration
+                    * function = dynamic_cast<AST::FunctionDeclaration *>( &**it );
+
+                if( function && function->m_Name == "main" && function->m_ArgumentList )
+                {
+                    return function;
+                }
+            }
+
+            return 0;
+        }
+
+        AST::Argument * CreateSlotArgument( const std::string & name, const std::string & input_modifier )
+        {
+            AST::Argument
+                * argument = new AST::Argument;
+
+            argument->m_Type = new AST::Type( "float4" );
+            argument->m_Name = name;
+            argument->m_Semantic = name;
+            argument->m_InputModifier = input_modifier;
+
+            return argument;
+        }
+
+        AST::VariableDeclarationStatement * CreateDeclaration(
+            const AST::Argument & argument,
+            AST::Expression * initial_value
+            )
+        {
+            AST::VariableDeclarationStatement
+                * declaration = new AST::VariableDeclarationStatement;
+            AST::VariableDeclarationBody
+                * body = new AST::VariableDeclarationBody( argument.m_Name );
+
+            if( initial_value )
+            {
+                body->m_InitialValue = new AST::InitialValue;
+                body->m_InitialValue->AddExpression( initial_value );
+            }
+
+            declaration->SetType( new AST::Type( argument.m_Type->m_Name ) );
+            declaration->AddBody( body );
+
+            return declaration;
+        }
+
+        AST::Statement * CreateSlotAssignment(
+            const std::string & slot_name,
+            const std::string & swizzle,
+            AST::Expression * expression
+            )
+        {
+            return new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( slot_name ), new AST::Swizzle( swizzle ) ),
+                AST::AssignmentOperator_Assign,
+                expression
+                );
+        }
+    }
+
+    bool InterpolatorPacker::Pack(
+        AST::TranslationUnit & vertex_program,
+        AST::TranslationUnit & pixel_program
+        )
+    {
+        AST::FunctionDeclaration
+            * vertex_main = FindMainFunction( vertex_program ),
+            * pixel_main = FindMainFunction( pixel_program );
+        std::set<std::string>
+            vertex_output_semantic_set;
+        std::vector<Base::ObjectRef<AST::Argument> >
+            candidate_table;
+        std::vector<Base::ObjectRef<AST::Argument> >::const_iterator it, end;
+        std::vector<Slot>
+            slot_table,
+            packed_slot_table;
+
+        m_UnpackedSlotCount = 0;
+        m_SlotCount = 0;
+
+        if( !vertex_main || !pixel_main )
+        {
+            return false;
+        }
+
+        Base::ScopedTimer
+            timer( "pack_interpolators" );
+
+        for( it = vertex_main->m_ArgumentList->m_ArgumentTable.begin(), end = vertex_main->m_ArgumentList->m_ArgumentTable.end(); it != end; ++it )
+        {
+            if( !IsInput( **it ) )
+            {
+                vertex_output_semantic_set.insert( (*it)->m_Semantic );
+            }
+        }
+
+        for( it = pixel_main->m_ArgumentList->m_ArgumentTable.begin(), end = pixel_main->m_ArgumentList->m_ArgumentTable.end(); it != end; ++it )
+        {
+            if( !IsInput( **it ) || vertex_output_semantic_set.find( (*it)->m_Semantic ) == vertex_output_semantic_set.end() )
+            {
+                continue;
+            }
+
+            m_UnpackedSlotCount += GetRegisterCount( (*it)->m_Type->m_Name );
+
+            if( GetComponentCount( (*it)->m_Type->m_Name ) > 0 )
+            {
+                candidate_table.push_back( *it );
+            }
+        }
+
+        m_SlotCount = m_UnpackedSlotCount;
+
+        // First fit decreasing, the order of the arguments breaks the ties
+        std::stable_sort( candidate_table.begin(), candidate_table.end(), HasMoreComponents );
+
+        for( it = candidate_table.begin(), end = candidate_table.end(); it != end; ++it )
+        {
+            const int
+                component_count = GetComponentCount( (*it)->m_Type->m_Name );
+            std::vector<Slot>::iterator
+                slot = slot_table.begin();
+
+            while( slot != slot_table.end() && (*slot).m_ComponentCount + component_count > SlotComponentCount )
+            {
+                ++slot;
+            }
+
+            if( slot == slot_table.end() )
+            {
+                slot = slot_table.insert( slot_table.end(), Slot() );
+            }
+
+            (*slot).m_ArgumentTable.push_back( *it );
+            (*slot).m_SwizzleTable.push_back( std::string( ComponentNames + (*slot).m_ComponentCount, component_count ) );
+            (*slot).m_ComponentCount += component_count;
+        }
+
+        // A semantic alone in its slot keeps its own argument
+        for( std::vector<Slot>::iterator slot = slot_table.begin(); slot != slot_table.end(); ++slot )
+        {
+            if( (*slot).m_ArgumentTable.size() < 2 )
+            {
+                continue;
+            }
+
+            std::ostringstream
+                name;
+
+            name << "PackedInterpolator" << packed_slot_table.size();
+            (*slot).m_Name = name.str();
+            m_SlotCount -= static_cast<int>( (*slot).m_ArgumentTable.size() ) - 1;
+
+            packed_slot_table.push_back( *slot );
+        }
+
+        Base::Statistics::AddCount( "interpolator_slot_count", m_SlotCount );
+        Base::Statistics::AddCount( "interpolator_saved_slot_count", m_UnpackedSlotCount - m_SlotCount );
+
+        if( !packed_slot_table.empty() )
+        {
+            RewriteVertexMain( *vertex_main, packed_slot_table );
+            RewritePixelMain( *pixel_main, packed_slot_table );
+        }
+
+        return true;
+    }
+
+    void InterpolatorPacker::RewriteVertexMain(
+        AST::FunctionDeclaration & function,
+        const std::vector<Slot> & slot_table
+        ) const
+    {
+        std::set<std::string>
+            packed_semantic_set;
+        std::vector<Base::ObjectRef<AST::Argument> >
+            argument_table;
+        std::vector<Base::ObjectRef<AST::Statement> >
+            statement_table;
+        std::vector<Slot>::const_iterator slot_it, slot_end;
+        std::vector<Base::ObjectRef<AST::Argument> >::const_iterator it, end;
+        bool
+            slots_are_declared = false;
+
+        for( slot_it = slot_table.begin(), slot_end = slot_table.end(); slot_it != slot_end; ++slot_it )
+        {
+            for( it = (*slot_it).m_ArgumentTable.begin(), end = (*slot_it).m_ArgumentTable.end(); it != end; ++it )
+            {
+                packed_semantic_set.insert( (*it)->m_Semantic );
+            }
+        }
+
+        for( it = function.m_ArgumentList->m_ArgumentTable.begin(), end = function.m_ArgumentList->m_ArgumentTable.end(); it != end; ++it )
+        {
+            if( IsInput( **it ) || packed_semantic_set.find( (*it)->m_Semantic ) == packed_semantic_set.end() )
+            {
+                argument_table.push_back( *it );
+                continue;
+            }
+
+            if( !slots_are_declared )
+            {
+                for( slot_it = slot_table.begin(), slot_end = slot_table.end(); slot_it != slot_end; ++slot_it )
+                {
+                    argument_table.push_back( CreateSlotArgument( (*slot_it).m_Name, "out" ) );
+                }
+
+                slots_are_declared = true;
+            }
+
+            // Semantics read from the vertex stream stay inputs
+            if( (*it)->m_InputModifier == "inout" )
+            {
+                Base::ObjectRef<AST::Argument>
+                    argument = *it;
+
+                argument->m_InputModifier = "in";
+                argument_table.push_back( argument );
+            }
+            else
+            {
+                statement_table.push_back( CreateDeclaration( **it, 0 ) );
+            }
+        }
+
+        statement_table.insert( statement_table.end(), function.m_StatementTable.begin(), function.m_StatementTable.end() );
+
+        for( slot_it = slot_table.begin(), slot_end = slot_table.end(); slot_it != slot_end; ++slot_it )
+        {
+            for( size_t index = 0; index < (*slot_it).m_ArgumentTable.size(); ++index )
+            {
+                statement_table.push_back(
+                    CreateSlotAssignment(
+                        (*slot_it).m_Name,
+                        (*slot_it).m_SwizzleTable[ index ],
+                        new AST::VariableExpression( (*slot_it).m_ArgumentTable[ index ]->m_Name )
+                        )
+                    );
+            }
+
+            // Outputs must be completely initialized
+            if( (*slot_it).m_ComponentCount < SlotComponentCount )
+            {
+                statement_table.push_back(
+                    CreateSlotAssignment(
+                        (*slot_it).m_Name,
+                        ComponentNames + (*slot_it).m_ComponentCount,
+                        new AST::LiteralExpression( AST::LiteralExpression::Int, "0" )
+                        )
+                    );
+            }
+        }
+
+        function.m_ArgumentList->m_ArgumentTable = std::move( argument_table );
+        function.m_StatementTable = std::move( statement_table );
+    }
+
+    void InterpolatorPacker::RewritePixelMain(
+        AST::FunctionDeclaration & function,
+        const std::vector<Slot> & slot_table
+        ) const
+    {
+        std::map<const AST::Argument *, std::pair<std::string, std::string> >
+            packed_argument_table;
+        std::vector<Base::ObjectRef<AST::Argument> >
+            argument_table;
+        std::vector<Base::ObjectRef<AST::Statement> >
+            statement_table;
+        std::vector<Slot>::const_iterator slot_it, slot_end;
+        std::vector<Base::ObjectRef<AST::Argument> >::const_iterator it, end;
+        bool
+            slots_are_declared = false;
+
+        for( slot_it = slot_table.begin(), slot_end = slot_table.end(); slot_it != slot_end; ++slot_it )
+        {
+            for( size_t index = 0; index < (*slot_it).m_ArgumentTable.size(); ++index )
+            {
+                packed_argument_table[ &*(*slot_it).m_ArgumentTable[ index ] ] =
+                    std::make_pair( (*slot_it).m_Name, (*slot_it).m_SwizzleTable[ index ] );
+            }
+        }
+
+        for( it = function.m_ArgumentList->m_ArgumentTable.begin(), end = function.m_ArgumentList->m_ArgumentTable.end(); it != end; ++it )
+        {
+            std::map<const AST::Argument *, std::pair<std::string, std::string> >::const_iterator
+                packed_semantic = packed_argument_table.find( &**it );
+
+            if( packed_semantic == packed_argument_table.end() )
+            {
+                argument_table.push_back( *it );
+                continue;
+            }
+
+            if( !slots_are_declared )
+            {
+                for( slot_it = slot_table.begin(), slot_end = slot_table.end(); slot_it != slot_end; ++slot_it )
+                {
+                    argument_table.push_back( CreateSlotArgument( (*slot_it).m_Name, "in" ) );
+                }
+
+                slots_are_declared = true;
+            }
+
+            statement_table.push_back(
+                CreateDeclaration(
+                    **it,
+                    new AST::PostfixExpression(
+                        new AST::VariableExpression( (*packed_semantic).second.first ),
+                        new AST::Swizzle( (*packed_semantic).second.second )
+                        )
+                    )
+                );
+        }
+
+        statement_table.insert( statement_table.end(), function.m_StatementTable.begin(), function.m_StatementTable.end() );
+
+        function.m_ArgumentList->m_ArgumentTable = std::move( argument_table );
+        function.m_StatementTable = std::move( statement_table );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef INTERPOLATOR_PACKER_H
+    #define INTERPOLATOR_PACKER_H
+
+    #include <string>
+    #include <vector>
+    #include <ast/node.h>
+    #include <base/object_ref.h>
+
+    namespace Generation
+    {
+        // Packs the float semantics passed from the main function of the vertex program to
+        // the main function of the pixel program into the fewest float4 interpolators.
+        // The vertex program writes each semantic to a swizzle of its interpolator, and
+        // the pixel program reads it back into a local variable of the same name.
+        // Semantics which share no interpolator, and matrix or non float semantics, are
+        // left as they are.
+
+        class InterpolatorPacker
+        {
+        public:
+
+            InterpolatorPacker() : m_UnpackedSlotCount( 0 ), m_SlotCount( 0 ) {}
+
+            // Returns false when a program has no main function
+            bool Pack(
+                AST::TranslationUnit & vertex_program,
+                AST::TranslationUnit & pixel_program
+                );
+
+            // Interpolator registers used before and after the last packing
+            int GetUnpackedSlotCount() const { return m_UnpackedSlotCount; }
+            int GetSlotCount() const { return m_SlotCount; }
+
+        private:
+
+            struct Slot
+            {
+                Slot() : m_ComponentCount( 0 ) {}
+
+                std::string
+                    m_Name;
+                std::vector<Base::ObjectRef<AST::Argument> >
+                    m_ArgumentTable;
+                std::vector<std::string>
+                    m_SwizzleTable;
+                int
+                    m_ComponentCount;
+            };
+
+            void RewriteVertexMain(
+                AST::FunctionDeclaration & function,
+                const std::vector<Slot> & slot_table
+                ) const;
+
+            void RewritePixelMain(
+                AST::FunctionDeclaration & function,
+                const std::vector<Slot> & slot_table
+                ) const;
+
+            int
+                m_UnpackedSlotCount,
+                m_SlotCount;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,894 @@
+#include "loop_unroller.h"
+
+#include "cost_estimator.h"
+#include "pass_helpers.h"
+#include <ast/function_node.h>
+#include <base/statistics.h>
+#include <climits>
+#include <set>
+#include <sstream>
+
+namespace Generation
+{
+    namespace
+    {
+        struct Context
+        {
+            std::set<std::string>
+                m_FunctionNameSet;
+            int
+                m_MaximumStatementCount,
+                m_UnrolledLoopCount,
+                m_FoldedExpressionCount;
+        };
+
+        // Value of the induction variable in one copy of the body
+        struct Iteration
+        {
+            std::string
+                m_Variable;
+            int
+                m_Value;
+        };
+
+        bool GetBoolLiteral( bool & value, const AST::Expression & expression )
+        {
+            if( expression.m_Kind != AST::NodeKind_LiteralExpression
+                || static_cast<const AST::LiteralExpression &>( expression ).m_Type != AST::LiteralExpression::Bool
+                )
+            {
+                return false;
+            }
+
+            value = static_cast<const AST::LiteralExpression &>( expression ).m_Value == "true";
+
+            return true;
+        }
+
+        AST::LiteralExpression * CreateIntegerLiteral( const int value )
+        {
+            std::ostringstream
+                text;
+
+            text << value;
+
+            return new AST::LiteralExpression( AST::LiteralExpression::Int, text.str() );
+        }
+
+        AST::LiteralExpression * CreateBoolLiteral( const bool value )
+        {
+            return new AST::LiteralExpression( AST::LiteralExpression::Bool, value ? "true" : "false" );
+        }
+
+        // Operation between literals, or 0 when it must be kept
+        AST::Expression * FoldOperation( const AST::BinaryOperationExpression & operation )
+        {
+            int
+                left,
+                right;
+            bool
+                left_condition,
+                right_condition;
+
+            if( GetBoolLiteral( left_condition, *operation.m_LeftExpression ) && GetBoolLiteral( right_condition, *operation.m_RightExpression ) )
+            {
+                switch( operation.m_Operation )
+                {
+                    case AST::BinaryOperationExpression::LogicalAnd: return CreateBoolLiteral( left_condition && right_condition );
+                    case AST::BinaryOperationExpression::LogicalOr: return CreateBoolLiteral( left_condition || right_condition );
+                    case AST::BinaryOperationExpression::Equality: return CreateBoolLiteral( left_condition == right_condition );
+                    case AST::BinaryOperationExpression::Difference: return CreateBoolLiteral( left_condition != right_condition );
+                    default: return 0;
+                }
+            }
+
+            if( !GetIntegerLiteral( left, *operation.m_LeftExpression, false ) || !GetIntegerLiteral( right, *operation.m_RightExpression, false ) )
+            {
+                return 0;
+            }
+
+            long long
+                result;
+
+            switch( operation.m_Operation )
+            {
+                case AST::BinaryOperationExpression::Equality: return CreateBoolLiteral( left == right );
+                case AST::BinaryOperationExpression::Difference: return CreateBoolLiteral( left != right );
+                case AST::BinaryOperationExpression::LessThan: return CreateBoolLiteral( left < right );
+                case AST::BinaryOperationExpression::GreaterThan: return CreateBoolLiteral( left > right );
+                case AST::BinaryOperationExpression::LessThanOrEqual: return CreateBoolLiteral( left <= right );
+                case AST::BinaryOperationExpression::GreaterThanOrEqual: return CreateBoolLiteral( left >= right );
+                case AST::BinaryOperationExpression::Addition: result = static_cast<long long>( left ) + right; break;
+                case AST::BinaryOperationExpression::Subtraction: result = static_cast<long long>( left ) - right; break;
+                case AST::BinaryOperationExpression::Multiplication: result = static_cast<long long>( left ) * right; break;
+                case AST::BinaryOperationExpression::BitwiseAnd: result = left & right; break;
+                case AST::BinaryOperationExpression::BitwiseOr: result = left | right; break;
+                case AST::BinaryOperationExpression::BitwiseXor: result = left ^ right; break;
+
+                case AST::BinaryOperationExpression::Division:
+                    if( right == 0 )
+                    {
+                        return 0;
+                    }
+
+                    result = static_cast<long long>( left ) / right;
+                    break;
+
+                case AST::BinaryOperationExpression::Modulo:
+                    if( right == 0 )
+                    {
+                        return 0;
+                    }
+
+                    result = static_cast<long long>( left ) % right;
+                    break;
+
+                case AST::BinaryOperationExpression::BitwiseLeftShift:
+                    if( left < 0 || right < 0 || right > 31 )
+                    {
+                        return 0;
+                    }
+
+                    result = static_cast<long long>( left ) << right;
+                    break;
+
+                case AST::BinaryOperationExpression::BitwiseRightShift:
+                    if( left < 0 || right < 0 || right > 31 )
+                    {
+                        return 0;
+                    }
+
+                    result = left >> right;
+                    break;
+
+                default:
+                    return 0;
+            }
+
+            if( result < INT_MIN || result > INT_MAX )
+            {
+                return 0;
+            }
+
+            return CreateIntegerLiteral( static_cast<int>( result ) );
+        }
+
+        AST::Expression * FoldUnaryOperation( const AST::UnaryOperationExpression & operation )
+        {
+            int
+                value;
+            bool
+                condition;
+
+            if( operation.m_Operation == AST::UnaryOperationExpression::Not && GetBoolLiteral( condition, *operation.m_Expression ) )
+            {
+                return CreateBoolLiteral( !condition );
+            }
+
+            if( !GetIntegerLiteral( value, *operation.m_Expression, false ) )
+            {
+                return 0;
+            }
+
+            switch( operation.m_Operation )
+            {
+                case AST::UnaryOperationExpression::Plus: return CreateIntegerLiteral( value );
+                case AST::UnaryOperationExpression::Minus: return value == INT_MIN ? 0 : CreateIntegerLiteral( -value );
+                case AST::UnaryOperationExpression::BitwiseNot: return CreateIntegerLiteral( ~value );
+                default: return 0;
+            }
+        }
+
+        void FoldExpression( Context & context, const Iteration & iteration, Base::ObjectRef<AST::Expression> & expression );
+
+        void FoldArguments( Context & context, const Iteration & iteration, AST::ArgumentExpressionList * argument_list )
+        {
+            if( !argument_list )
+            {
+                return;
+            }
+
+            std::vector<Base::ObjectRef<AST::Expression> >::iterator it, end;
+
+            for( it = argument_list->m_ExpressionList.begin(), end = argument_list->m_ExpressionList.end(); it != end; ++it )
+            {
+                FoldExpression( context, iteration, *it );
+            }
+        }
+
+        void FoldLValue( Context & context, const Iteration & iteration, AST::LValueExpression & expression )
+        {
+            FoldExpression( context, iteration, expression.m_VariableExpression->m_SubscriptExpression );
+        }
+
+        // The induction variable is replaced by its value, then the operations on
+        // literals are computed
+        void FoldExpression( Context & context, const Iteration & iteration, Base::ObjectRef<AST::Expression> & expression )
+        {
+            AST::Expression
+                * folded_expression = 0;
+
+            if( !expression )
+            {
+                return;
+            }
+
+            switch( expression->m_Kind )
+            {
+                case AST::NodeKind_VariableExpression:
+                {
+                    AST::VariableExpression
+                        & variable = static_cast<AST::VariableExpression &>( *expression );
+
+                    if( variable.m_Name == iteration.m_Variable && !variable.m_SubscriptExpression )
+                    {
+                        expression = CreateIntegerLiteral( iteration.m_Value );
+                        return;
+                    }
+
+                    FoldExpression( context, iteration, variable.m_SubscriptExpression );
+                    break;
+                }
+
+                case AST::NodeKind_BinaryOperationExpression:
+                {
+                    AST::BinaryOperationExpression
+                        & operation = static_cast<AST::BinaryOperationExpression &>( *expression );
+
+                    FoldExpression( context, iteration, operation.m_LeftExpression );
+                    FoldExpression( context, iteration, operation.m_RightExpression );
+                    folded_expression = FoldOperation( operation );
+                    break;
+                }
+
+                case AST::NodeKind_UnaryOperationExpression:
+                {
+                    AST::UnaryOperationExpression
+                        & operation = static_cast<AST::UnaryOperationExpression &>( *expression );
+
+                    FoldExpression( context, iteration, operation.m_Expression );
+                    folded_expression = FoldUnaryOperation( operation );
+                    break;
+                }
+
+                case AST::NodeKind_CastExpression:
+                    FoldExpression( context, iteration, static_cast<AST::CastExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_ConditionalExpression:
+                {
+                    AST::ConditionalExpression
+                        & conditional = static_cast<AST::ConditionalExpression &>( *expression );
+                    bool
+                        condition;
+
+                    FoldExpression( context, iteration, conditional.m_Condition );
+                    FoldExpression( context, iteration, conditional.m_IfTrue );
+                    FoldExpression( context, iteration, conditional.m_IfFalse );
+
+                    if( GetBoolLiteral( condition, *conditional.m_Condition ) )
+                    {
+                        folded_expression = condition ? &*conditional.m_IfTrue : &*conditional.m_IfFalse;
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_CallExpression:
+                    FoldArguments( context, iteration, &*static_cast<AST::CallExpression &>( *expression ).m_ArgumentExpressionList );
+                    break;
+
+                case AST::NodeKind_ConstructorExpression:
+                    FoldArguments( context, iteration, &*static_cast<AST::ConstructorExpression &>( *expression ).m_ArgumentExpressionList );
+                    break;
+
+                case AST::NodeKind_PostfixExpression:
+                {
+                    AST::PostfixExpression
+                        & postfix = static_cast<AST::PostfixExpression &>( *expression );
+
+                    FoldExpression( context, iteration, postfix.m_Expression );
+
+                    for( AST::PostfixSuffix * suffix = &*postfix.m_Suffix; suffix; )
+                    {
+                        if( suffix->m_Kind == AST::NodeKind_PostfixSuffixCall )
+                        {
+                            AST::PostfixSuffixCall
+                                & call = static_cast<AST::PostfixSuffixCall &>( *suffix );
+
+                            FoldArguments( context, iteration, &*call.m_CallExpression->m_ArgumentExpressionList );
+                            suffix = &*call.m_Suffix;
+                        }
+                        else if( suffix->m_Kind == AST::NodeKind_PostfixSuffixVariable )
+                        {
+                            AST::PostfixSuffixVariable
+                                & member = static_cast<AST::PostfixSuffixVariable &>( *suffix );
+
+                            FoldExpression( context, iteration, member.m_VariableExpression->m_SubscriptExpression );
+                            suffix = &*member.m_Suffix;
+                        }
+                        else
+                        {
+                            suffix = 0;
+                        }
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_PreModifyExpression:
+                    FoldLValue( context, iteration, *static_cast<AST::PreModifyExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_PostModifyExpression:
+                    FoldLValue( context, iteration, *static_cast<AST::PostModifyExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_AssignmentExpression:
+                {
+                    AST::AssignmentExpression
+                        & assignment = static_cast<AST::AssignmentExpression &>( *expression );
+
+                    FoldLValue( context, iteration, *assignment.m_LValueExpression );
+                    FoldExpression( context, iteration, assignment.m_Expression );
+                    break;
+                }
+
+                default:
+                    break;
+            }
+
+            if( folded_expression )
+            {
+                expression = folded_expression;
+                ++context.m_FoldedExpressionCount;
+            }
+        }
+
+        bool DeclaresVariables( const AST::BlockStatement & block )
+        {
+            std::vector<Base::ObjectRef<AST::Statement> >::const_iterator it, end;
+
+            for( it = block.m_StatementTable.begin(), end = block.m_StatementTable.end(); it != end; ++it )
+            {
+                if( (*it)->m_Kind == AST::NodeKind_VariableDeclarationStatement )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void FoldStatement( Context & context, const Iteration & iteration, Base::ObjectRef<AST::Statement> & statement );
+
+        // Blocks left by the folded conditions are merged when they declare nothing
+        void FoldStatementTable( Context & context, const Iteration & iteration, std::vector<Base::ObjectRef<AST::Statement> > & table )
+        {
+            for( size_t index = 0; index < table.size(); )
+            {
+                FoldStatement( context, iteration, table[ index ] );
+
+                if( table[ index ]->m_Kind == AST::NodeKind_EmptyStatement )
+                {
+                    table.erase( table.begin() + index );
+                }
+                else if( table[ index ]->m_Kind == AST::NodeKind_BlockStatement
+                    && !DeclaresVariables( static_cast<const AST::BlockStatement &>( *table[ index ] ) )
+                    )
+                {
+                    const Base::ObjectRef<AST::Statement>
+                        block = table[ index ];
+                    const std::vector<Base::ObjectRef<AST::Statement> >
+                        & block_table = static_cast<const AST::BlockStatement &>( *block ).m_StatementTable;
+
+                    table.erase( table.begin() + index );
+                    table.insert( table.begin() + index, block_table.begin(), block_table.end() );
+                    index += block_table.size();
+                }
+                else
+                {
+                    ++index;
+                }
+            }
+        }
+
+        void FoldStatement( Context & context, const Iteration & iteration, Base::ObjectRef<AST::Statement> & statement )
+        {
+            if( !statement )
+            {
+                return;
+            }
+
+            switch( statement->m_Kind )
+            {
+                case AST::NodeKind_ExpressionStatement:
+                    FoldExpression( context, iteration, static_cast<AST::ExpressionStatement &>( *statement ).m_Expression );
+                    break;
+
+                case AST::NodeKind_AssignmentStatement:
+                {
+                    AST::AssignmentExpression
+                        & assignment = *static_cast<AST::AssignmentStatement &>( *statement ).m_Expression;
+
+                    FoldLValue( context, iteration, *assignment.m_LValueExpression );
+                    FoldExpression( context, iteration, assignment.m_Expression );
+                    break;
+                }
+
+                case AST::NodeKind_ReturnStatement:
+                    FoldExpression( context, iteration, static_cast<AST::ReturnStatement &>( *statement ).m_Expression );
+                    break;
+
+                case AST::NodeKind_IfStatement:
+                {
+                    AST::IfStatement
+                        & if_statement = static_cast<AST::IfStatement &>( *statement );
+                    bool
+                        condition;
+
+                    FoldExpression( context, iteration, if_statement.m_Condition );
+                    FoldStatement( context, iteration, if_statement.m_ThenStatement );
+                    FoldStatement( context, iteration, if_statement.m_ElseStatement );
+
+                    if( GetBoolLiteral( condition, *if_statement.m_Condition ) )
+                    {
+                        Base::ObjectRef<AST::Statement>
+                            taken_statement = condition ? if_statement.m_ThenStatement : if_statement.m_ElseStatement;
+
+                        statement = taken_statement ? &*taken_statement : new AST::EmptyStatement;
+                        ++context.m_FoldedExpressionCount;
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_WhileStatement:
+                {
+                    AST::WhileStatement
+                        & while_statement = static_cast<AST::WhileStatement &>( *statement );
+
+                    FoldExpression( context, iteration, while_statement.m_Condition );
+                    FoldStatement( context, iteration, while_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_DoWhileStatement:
+                {
+                    AST::DoWhileStatement
+                        & do_while_statement = static_cast<AST::DoWhileStatement &>( *statement );
+
+                    FoldStatement( context, iteration, do_while_statement.m_Statement );
+                    FoldExpression( context, iteration, do_while_statement.m_Condition );
+                    break;
+                }
+
+                case AST::NodeKind_ForStatement:
+                {
+                    AST::ForStatement
+                        & for_statement = static_cast<AST::ForStatement &>( *statement );
+
+                    FoldStatement( context, iteration, for_statement.m_InitStatement );
+                    FoldExpression( context, iteration, for_statement.m_EqualityExpression );
+                    FoldExpression( context, iteration, for_statement.m_ModifyExpression );
+                    FoldStatement( context, iteration, for_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_BlockStatement:
+                    FoldStatementTable( context, iteration, static_cast<AST::BlockStatement &>( *statement ).m_StatementTable );
+                    break;
+
+                case AST::NodeKind_VariableDeclarationStatement:
+                {
+                    AST::VariableDeclarationStatement
+                        & declaration = static_cast<AST::VariableDeclarationStatement &>( *statement );
+                    std::vector<Base::ObjectRef<AST::VariableDeclarationBody> >::iterator it, end;
+
+                    for( it = declaration.m_BodyTable.begin(), end = declaration.m_BodyTable.end(); it != end; ++it )
+                    {
+                        if( !(*it)->m_InitialValue )
+                        {
+                            continue;
+                        }
+
+                        std::vector<Base::ObjectRef<AST::Expression> >::iterator expression_it, expression_end;
+
+                        expression_it = (*it)->m_InitialValue->m_ExpressionTable.begin();
+                        expression_end = (*it)->m_InitialValue->m_ExpressionTable.end();
+
+                        for( ; expression_it != expression_end; ++expression_it )
+                        {
+                            FoldExpression( context, iteration, *expression_it );
+                        }
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        int CountStatements( const AST::Statement * statement )
+        {
+            if( !statement )
+            {
+                return 0;
+            }
+
+            switch( statement->m_Kind )
+            {
+                case AST::NodeKind_BlockStatement:
+                {
+                    std::vector<Base::ObjectRef<AST::Statement> >::const_iterator it, end;
+                    const AST::BlockStatement
+                        & block = static_cast<const AST::BlockStatement &>( *statement );
+                    int
+                        count = 0;
+
+                    for( it = block.m_StatementTable.begin(), end = block.m_StatementTable.end(); it != end; ++it )
+                    {
+                        count += CountStatements( &**it );
+                    }
+
+                    return count;
+                }
+
+                case AST::NodeKind_IfStatement:
+                {
+                    const AST::IfStatement
+                        & if_statement = static_cast<const AST::IfStatement &>( *statement );
+
+                    return 1 + CountStatements( &*if_statement.m_ThenStatement ) + CountStatements( &*if_statement.m_ElseStatement );
+                }
+
+                case AST::NodeKind_WhileStatement:
+                    return 1 + CountStatements( &*static_cast<const AST::WhileStatement &>( *statement ).m_Statement );
+
+                case AST::NodeKind_DoWhileStatement:
+                    return 1 + CountStatements( &*static_cast<const AST::DoWhileStatement &>( *statement ).m_Statement );
+
+                case AST::NodeKind_ForStatement:
+                    return 1 + CountStatements( &*static_cast<const AST::ForStatement &>( *statement ).m_Statement );
+
+                default:
+                    return 1;
+            }
+        }
+
+        AST::Statement * CreateAssignment( const std::string & variable, const int value )
+        {
+            return new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( variable ) ),
+                AST::AssignmentOperator_Assign,
+                CreateIntegerLiteral( value )
+                );
+        }
+
+        // Copies of the body, or false when the loop must be kept
+        bool UnrollBody(
+            std::vector<Base::ObjectRef<AST::Statement> > & unrolled_table,
+            Context & context,
+            const CostEstimator::ConstantLoop & loop,
+            const AST::Statement & body
+            )
+        {
+            Effect
+                effect;
+            EffectCollector
+                collector( effect, context.m_FunctionNameSet );
+            Iteration
+                iteration;
+
+            collector.Dispatch( body );
+
+            if( !loop.m_IsInteger
+                || effect.m_LeavesLoop
+                || effect.m_WrittenVariableSet.count( loop.m_Variable )
+                || effect.m_DeclaredVariableSet.count( loop.m_Variable )
+                || static_cast<long long>( loop.m_TripCount ) * CountStatements( &body ) > context.m_MaximumStatementCount
+                )
+            {
+                return false;
+            }
+
+            iteration.m_Variable = loop.m_Variable;
+
+            for( int index = 0; index < loop.m_TripCount; ++index )
+            {
+                Base::ObjectRef<AST::Statement>
+                    copy = body.Clone();
+
+                iteration.m_Value = loop.m_First + index * loop.m_Step;
+                FoldStatement( context, iteration, copy );
+
+                // The declarations of the copies stay in their own scope
+                if( copy->m_Kind == AST::NodeKind_BlockStatement && !DeclaresVariables( static_cast<const AST::BlockStatement &>( *copy ) ) )
+                {
+                    const std::vector<Base::ObjectRef<AST::Statement> >
+                        & copy_table = static_cast<const AST::BlockStatement &>( *copy ).m_StatementTable;
+
+                    unrolled_table.insert( unrolled_table.end(), copy_table.begin(), copy_table.end() );
+                }
+                else if( copy->m_Kind == AST::NodeKind_VariableDeclarationStatement )
+                {
+                    AST::BlockStatement
+                        * block = new AST::BlockStatement;
+
+                    block->AddStatement( &*copy );
+                    unrolled_table.push_back( block );
+                }
+                else if( copy->m_Kind != AST::NodeKind_EmptyStatement )
+                {
+                    unrolled_table.push_back( copy );
+                }
+            }
+
+            ++context.m_UnrolledLoopCount;
+
+            return true;
+        }
+
+        bool UnrollFor(
+            std::vector<Base::ObjectRef<AST::Statement> > & unrolled_table,
+            Context & context,
+            const AST::ForStatement & statement
+            )
+        {
+            CostEstimator::ConstantLoop
+                loop;
+
+            if( !CostEstimator::GetConstantLoop( loop, statement ) || !UnrollBody( unrolled_table, context, loop, *statement.m_Statement ) )
+            {
+                return false;
+            }
+
+            // for( i = first; ... ) leaves the variable declared outside of the loop
+            if( statement.m_InitStatement->m_Kind == AST::NodeKind_AssignmentStatement )
+            {
+                unrolled_table.push_back( CreateAssignment( loop.m_Variable, loop.m_First + loop.m_TripCount * loop.m_Step ) );
+            }
+
+            return true;
+        }
+
+        // int i = first; while( i < last ) { ...; ++i; }
+        bool UnrollWhile(
+            std::vector<Base::ObjectRef<AST::Statement> > & unrolled_table,
+            bool & removes_declaration,
+            Context & context,
+            std::vector<Base::ObjectRef<AST::Statement> > & table,
+            const size_t index
+            )
+        {
+            AST::WhileStatement
+                & statement = static_cast<AST::WhileStatement &>( *table[ index ] );
+            AST::Expression
+                * modify_expression;
+
+            if( index == 0
+                || table[ index - 1 ]->m_Kind != AST::NodeKind_VariableDeclarationStatement
+                || statement.m_Statement->m_Kind != AST::NodeKind_BlockStatement
+                )
+            {
+                return false;
+            }
+
+            std::vector<Base::ObjectRef<AST::Statement> >
+                & statement_table = static_cast<AST::BlockStatement &>( *statement.m_Statement ).m_StatementTable;
+
+            if( statement_table.empty() )
+            {
+                return false;
+            }
+
+            switch( statement_table.back()->m_Kind )
+            {
+                case AST::NodeKind_ExpressionStatement:
+                {
+                    Base::ObjectRef<AST::Expression>
+                        & expression = static_cast<AST::ExpressionStatement &>( *statement_table.back() ).m_Expression;
+
+                    if( !expression )
+                    {
+                        return false;
+                    }
+
+                    modify_expression = &*expression;
+                    break;
+                }
+
+                case AST::NodeKind_AssignmentStatement:
+                    modify_expression = &*static_cast<AST::AssignmentStatement &>( *statement_table.back() ).m_Expression;
+                    break;
+
+                default:
+                    return false;
+            }
+
+            Base::ObjectRef<AST::BlockStatement>
+                body = new AST::BlockStatement;
+
+            body->m_StatementTable.assign( statement_table.begin(), statement_table.end() - 1 );
+
+            const Base::ObjectRef<AST::ForStatement>
+                for_statement = new AST::ForStatement( &*table[ index - 1 ], &*statement.m_Condition, modify_expression, &*body );
+            CostEstimator::ConstantLoop
+                loop;
+
+            if( !CostEstimator::GetConstantLoop( loop, *for_statement )
+                || !UnrollBody( unrolled_table, context, loop, *body )
+                )
+            {
+                return false;
+            }
+
+            Effect
+                effect;
+            EffectCollector
+                collector( effect, context.m_FunctionNameSet );
+
+            for( size_t next_index = index + 1; next_index < table.size(); ++next_index )
+            {
+                collector.Dispatch( *table[ next_index ] );
+            }
+
+            removes_declaration = !effect.m_ReadVariableSet.count( loop.m_Variable );
+
+            if( !removes_declaration )
+            {
+                unrolled_table.push_back( CreateAssignment( loop.m_Variable, loop.m_First + loop.m_TripCount * loop.m_Step ) );
+            }
+
+            return true;
+        }
+
+        void UnrollStatementTable( Context & context, std::vector<Base::ObjectRef<AST::Statement> > & table );
+        void UnrollNestedLoops( Context & context, AST::Statement & statement );
+
+        // A loop which is not in a statement table is replaced by a block
+        void UnrollSlot( Context & context, Base::ObjectRef<AST::Statement> & statement )
+        {
+            std::vector<Base::ObjectRef<AST::Statement> >
+                unrolled_table;
+
+            if( !statement )
+            {
+                return;
+            }
+
+            UnrollNestedLoops( context, *statement );
+
+            if( statement->m_Kind == AST::NodeKind_ForStatement
+                && UnrollFor( unrolled_table, context, static_cast<const AST::ForStatement &>( *statement ) )
+                )
+            {
+                AST::BlockStatement
+                    * block = new AST::BlockStatement;
+
+                block->m_StatementTable.swap( unrolled_table );
+                statement = block;
+            }
+        }
+
+        void UnrollNestedLoops( Context & context, AST::Statement & statement )
+        {
+            switch( statement.m_Kind )
+            {
+                case AST::NodeKind_IfStatement:
+                {
+                    AST::IfStatement
+                        & if_statement = static_cast<AST::IfStatement &>( statement );
+
+                    UnrollSlot( context, if_statement.m_ThenStatement );
+                    UnrollSlot( context, if_statement.m_ElseStatement );
+                    break;
+                }
+
+                case AST::NodeKind_WhileStatement:
+                    UnrollSlot( context, static_cast<AST::WhileStatement &>( statement ).m_Statement );
+                    break;
+
+                case AST::NodeKind_DoWhileStatement:
+                    UnrollSlot( context, static_cast<AST::DoWhileStatement &>( statement ).m_Statement );
+                    break;
+
+                case AST::NodeKind_ForStatement:
+                    UnrollSlot( context, static_cast<AST::ForStatement &>( statement ).m_Statement );
+                    break;
+
+                case AST::NodeKind_BlockStatement:
+                    UnrollStatementTable( context, static_cast<AST::BlockStatement &>( statement ).m_StatementTable );
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        void UnrollStatementTable( Context & context, std::vector<Base::ObjectRef<AST::Statement> > & table )
+        {
+            for( size_t index = 0; index < table.size(); )
+            {
+                std::vector<Base::ObjectRef<AST::Statement> >
+                    unrolled_table;
+                bool
+                    removes_declaration = false;
+                size_t
+                    first_index = index;
+
+                UnrollNestedLoops( context, *table[ index ] );
+
+                if( table[ index ]->m_Kind == AST::NodeKind_ForStatement )
+                {
+                    if( !UnrollFor( unrolled_table, context, static_cast<const AST::ForStatement &>( *table[ index ] ) ) )
+                    {
+                        ++index;
+                        continue;
+                    }
+                }
+                else if( table[ index ]->m_Kind == AST::NodeKind_WhileStatement )
+                {
+                    if( !UnrollWhile( unrolled_table, removes_declaration, context, table, index ) )
+                    {
+                        ++index;
+                        continue;
+                    }
+                }
+                else
+                {
+                    ++index;
+                    continue;
+                }
+
+                if( removes_declaration )
+                {
+                    --first_index;
+                }
+
+                table.erase( table.begin() + first_index, table.begin() + index + 1 );
+                table.insert( table.begin() + first_index, unrolled_table.begin(), unrolled_table.end() );
+                index = first_index + unrolled_table.size();
+            }
+        }
+    }
+
+    void LoopUnroller::Unroll( AST::TranslationUnit & translation_unit )
+    {
+        Base::ScopedTimer
+            timer( "unroll_loops" );
+        Context
+            context;
+        std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::iterator it, end;
+
+        context.m_MaximumStatementCount = m_MaximumStatementCount;
+        context.m_UnrolledLoopCount = 0;
+        context.m_FoldedExpressionCount = 0;
+
+        for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            if( const AST::FunctionDeclaration * function = dynamic_cast<const AST::FunctionDeclaration *>( &**it ) )
+            {
+                context.m_FunctionNameSet.insert( function->m_Name );
+            }
+        }
+
+        for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            AST::FunctionDeclaration
+                * function = dynamic_cast<AST::FunctionDeclaration *>( &**it );
+
+            if( !function )
+            {
+                continue;
+            }
+
+            function->ResolveBody();
+            UnrollStatementTable( context, function->m_StatementTable );
+        }
+
+        m_UnrolledLoopCount = context.m_UnrolledLoopCount;
+        m_FoldedExpressionCount = context.m_FoldedExpressionCount;
+
+        Base::Statistics::AddCount( "unrolled_loop_count", m_UnrolledLoopCount );
+        Base::Statistics::AddCount( "unroll_folded_expression_count", m_FoldedExpressionCount );
+    }
+}
\ No newline at end of file
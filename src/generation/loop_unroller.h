@@ -0,0 +1,48 @@
+#ifndef LOOP_UNROLLER_H
+    #define LOOP_UNROLLER_H
+
+    #include <ast/node.h>
+
+    namespace Generation
+    {
+        // Replaces the loops of the generated functions having a constant trip count
+        // by a copy of their body per iteration, the induction variable being replaced
+        // by its value. The copies are then folded, so the indices become literals and
+        // the conditions on the induction variable keep only their taken branch.
+        //
+        // The for loops recognized by CostEstimator::GetConstantLoop are unrolled, as
+        // are the while loops following the declaration of their induction variable and
+        // ending by its increment. A loop is kept when its bounds or step are not integer
+        // literals, when it breaks or continues, when its body writes the induction
+        // variable, or when the copies would add up to more statements than the budget.
+        // Inner loops are unrolled first.
+
+        class LoopUnroller
+        {
+        public:
+
+            LoopUnroller() :
+                m_MaximumStatementCount( 64 ),
+                m_UnrolledLoopCount( 0 ),
+                m_FoldedExpressionCount( 0 )
+            {
+            }
+
+            // Statements of all the copies of a loop body
+            void SetMaximumStatementCount( const int count ) { m_MaximumStatementCount = count; }
+
+            void Unroll( AST::TranslationUnit & translation_unit );
+
+            int GetUnrolledLoopCount() const { return m_UnrolledLoopCount; }
+            int GetFoldedExpressionCount() const { return m_FoldedExpressionCount; }
+
+        private:
+
+            int
+                m_MaximumStatementCount,
+                m_UnrolledLoopCount,
+                m_FoldedExpressionCount;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "pass_helpers.h"
+
+#include <ast/function_node.h>
+#include <cstdlib>
+
+namespace Generation
+{
+    namespace
+    {
+        const char
+            * const OutIntrinsicTable[] =
+            {
+                "sincos", "modf", "frexp"
+            },
+            * const TextureFetchIntrinsicTable[] =
+            {
+                "tex1D", "tex1Dbias", "tex1Dgrad", "tex1Dlod", "tex1Dproj",
+                "tex2D", "tex2Dbias", "tex2Dgrad", "tex2Dlod", "tex2Dproj",
+                "tex3D", "tex3Dbias", "tex3Dgrad", "tex3Dlod", "tex3Dproj",
+                "texCUBE", "texCUBEbias", "texCUBEgrad", "texCUBElod", "texCUBEproj"
+            };
+    }
+
+    bool IsOutIntrinsic( const std::string & name )
+    {
+        return Contains( OutIntrinsicTable, name );
+    }
+
+    bool IsTextureFetchIntrinsic( const std::string & name )
+    {
+        return Contains( TextureFetchIntrinsicTable, name );
+    }
+
+    bool GetIntegerLiteral( int & value, const AST::Expression & expression, const bool accepts_float )
+    {
+        if( expression.m_Kind != AST::NodeKind_LiteralExpression )
+        {
+            return false;
+        }
+
+        const AST::LiteralExpression
+            & literal = static_cast<const AST::LiteralExpression &>( expression );
+        const char
+            * text = literal.m_Value.c_str();
+        char
+            * text_end;
+
+        if( literal.m_Type == AST::LiteralExpression::Bool
+            || ( !accepts_float && literal.m_Type != AST::LiteralExpression::Int )
+            )
+        {
+            return false;
+        }
+
+        const double
+            number = literal.m_Type == AST::LiteralExpression::Int ? std::strtol( text, &text_end, 0 ) : std::strtod( text, &text_end );
+
+        value = static_cast<int>( number );
+
+        return text_end != text && ( accepts_float || *text_end == 0 ) && value == number;
+    }
+
+    void EffectCollector::Visit( const AST::VariableExpression & expression )
+    {
+        m_Effect.m_ReadVariableSet.insert( expression.m_Name );
+        StaticTreeTraverser<EffectCollector>::Visit( expression );
+    }
+
+    void EffectCollector::Visit( const AST::LValueExpression & expression )
+    {
+        m_Effect.m_WrittenVariableSet.insert( expression.m_VariableExpression->m_Name );
+        StaticTreeTraverser<EffectCollector>::Visit( expression );
+    }
+
+    void EffectCollector::Visit( const AST::VariableDeclarationBody & body )
+    {
+        m_Effect.m_WrittenVariableSet.insert( body.m_Name );
+        m_Effect.m_DeclaredVariableSet.insert( body.m_Name );
+        StaticTreeTraverser<EffectCollector>::Visit( body );
+    }
+
+    void EffectCollector::Visit( const AST::Argument & argument )
+    {
+        m_Effect.m_DeclaredVariableSet.insert( argument.m_Name );
+        StaticTreeTraverser<EffectCollector>::Visit( argument );
+    }
+
+    // Members are not variables
+    void EffectCollector::Visit( const AST::PostfixSuffixVariable & postfix_suffix )
+    {
+        if( postfix_suffix.m_Suffix )
+        {
+            Dispatch( *postfix_suffix.m_Suffix );
+        }
+    }
+
+    void EffectCollector::Visit( const AST::CallExpression & expression )
+    {
+        const bool
+            is_function = m_FunctionNameSet.find( expression.m_Name ) != m_FunctionNameSet.end();
+
+        m_Effect.m_CallsFunction = m_Effect.m_CallsFunction || is_function;
+
+        if( ( is_function || IsOutIntrinsic( expression.m_Name ) ) && expression.m_ArgumentExpressionList )
+        {
+            std::vector<Base::ObjectRef<AST::Expression> >::const_iterator it, end;
+
+            for( it = expression.m_ArgumentExpressionList->m_ExpressionList.begin(), end = expression.m_ArgumentExpressionList->m_ExpressionList.end(); it != end; ++it )
+            {
+                const AST::Expression
+                    * argument = &**it;
+
+                if( argument->m_Kind == AST::NodeKind_PostfixExpression )
+                {
+                    argument = &*static_cast<const AST::PostfixExpression *>( argument )->m_Expression;
+                }
+
+                if( argument->m_Kind == AST::NodeKind_VariableExpression )
+                {
+                    m_Effect.m_WrittenVariableSet.insert( static_cast<const AST::VariableExpression *>( argument )->m_Name );
+                }
+            }
+        }
+
+        StaticTreeTraverser<EffectCollector>::Visit( expression );
+    }
+
+    void EffectCollector::Visit( const AST::ReturnStatement & statement )
+    {
+        m_Effect.m_Exits = true;
+        StaticTreeTraverser<EffectCollector>::Visit( statement );
+    }
+
+    void EffectCollector::Visit( const AST::DiscardStatement & statement )
+    {
+        m_Effect.m_Exits = true;
+        StaticTreeTraverser<EffectCollector>::Visit( statement );
+    }
+
+    void EffectCollector::Visit( const AST::BreakStatement & )
+    {
+        m_Effect.m_LeavesLoop = m_Effect.m_LeavesLoop || m_LoopDepth == 0;
+    }
+
+    void EffectCollector::Visit( const AST::ContinueStatement & )
+    {
+        m_Effect.m_LeavesLoop = m_Effect.m_LeavesLoop || m_LoopDepth == 0;
+    }
+
+    void EffectCollector::Visit( const AST::WhileStatement & statement )
+    {
+        ++m_LoopDepth;
+        StaticTreeTraverser<EffectCollector>::Visit( statement );
+        --m_LoopDepth;
+    }
+
+    void EffectCollector::Visit( const AST::DoWhileStatement & statement )
+    {
+        ++m_LoopDepth;
+        StaticTreeTraverser<EffectCollector>::Visit( statement );
+        --m_LoopDepth;
+    }
+
+    // for( ;; ) has no init, condition or increment
+    void EffectCollector::Visit( const AST::ForStatement & statement )
+    {
+        ++m_LoopDepth;
+
+        if( statement.m_InitStatement )
+        {
+            Dispatch( *statement.m_InitStatement );
+        }
+
+        if( statement.m_EqualityExpression )
+        {
+            Dispatch( *statement.m_EqualityExpression );
+        }
+
+        if( statement.m_ModifyExpression )
+        {
+            Dispatch( *statement.m_ModifyExpression );
+        }
+
+        Dispatch( *statement.m_Statement );
+        --m_LoopDepth;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef PASS_HELPERS_H
+    #define PASS_HELPERS_H
+
+    #include <set>
+    #include <string>
+    #include <ast/node.h>
+    #include <ast/static_visitor.h>
+
+    namespace Generation
+    {
+        // Helpers shared by the passes rewriting the generated functions
+
+        template< size_t _Size_ >
+        bool Contains( const char * const ( & table )[ _Size_ ], const std::string & name )
+        {
+            for( size_t index = 0; index < _Size_; ++index )
+            {
+                if( name == table[ index ] )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Intrinsics writing their last arguments
+        bool IsOutIntrinsic( const std::string & name );
+
+        // Sampler fetch intrinsics, which all return a float4
+        bool IsTextureFetchIntrinsic( const std::string & name );
+
+        // Integer literals without suffix, which keep their type once folded. Float and
+        // suffixed literals with an integral value are also accepted when asked.
+        bool GetIntegerLiteral( int & value, const AST::Expression & expression, const bool accepts_float );
+
+        // Variables read and possibly written by statements or expressions. The
+        // variables given to a function may be out arguments, so they count as written.
+        struct Effect
+        {
+            Effect() : m_CallsFunction( false ), m_Exits( false ), m_LeavesLoop( false ) {}
+
+            std::set<std::string>
+                m_ReadVariableSet,
+                m_WrittenVariableSet,
+                m_DeclaredVariableSet;
+            bool
+                m_CallsFunction,
+                // Returns or discards
+                m_Exits,
+                // Breaks or continues the loop containing the visited nodes
+                m_LeavesLoop;
+        };
+
+        // Adds the effect of the visited nodes. Functions of the set are the ones
+        // declared in the translation unit, which hide the intrinsics of the same name.
+        // The collector is run on every statement considered by the passes, so it uses
+        // the static dispatch instead of the virtual one.
+        class EffectCollector : public AST::StaticTreeTraverser<EffectCollector>
+        {
+        public:
+
+            EffectCollector( Effect & effect, const std::set<std::string> & function_name_set ) :
+                m_Effect( effect ),
+                m_FunctionNameSet( function_name_set ),
+                m_LoopDepth( 0 )
+            {
+            }
+
+            using AST::StaticTreeTraverser<EffectCollector>::Visit;
+
+            void Visit( const AST::VariableExpression & expression );
+            void Visit( const AST::LValueExpression & expression );
+            void Visit( const AST::VariableDeclarationBody & body );
+            void Visit( const AST::Argument & argument );
+            void Visit( const AST::PostfixSuffixVariable & postfix_suffix );
+            void Visit( const AST::CallExpression & expression );
+            void Visit( const AST::ReturnStatement & statement );
+            void Visit( const AST::DiscardStatement & statement );
+            void Visit( const AST::BreakStatement & statement );
+            void Visit( const AST::ContinueStatement & statement );
+            void Visit( const AST::WhileStatement & statement );
+            void Visit( const AST::DoWhileStatement & statement );
+            void Visit( const AST::ForStatement & statement );
+
+        private:
+
+            EffectCollector & operator =( const EffectCollector & other );
+
+            Effect
+                & m_Effect;
+            const std::set<std::string>
+                & m_FunctionNameSet;
+            int
+                m_LoopDepth;
+        };
+    }
+
+#endif
\ No newline at end of file
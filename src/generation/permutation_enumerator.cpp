@@ -0,0 +1,391 @@
+#include "permutation_enumerator.h"
+
+#include "code_generator.h"
+#include "fragment_definition.h"
+#include <base/object.h>
+#include <base/statistics.h>
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
+
+namespace Generation
+{
+    namespace
+    {
+        class IgnoringErrorHandler : public Base::ErrorHandlerInterface
+        {
+        public:
+
+            virtual void ReportError(
+                const std::string & /*message*/,
+                const std::string & /*file*/
+                ) override
+            {
+            }
+        };
+
+        // A combination that can be generated, still to be extended with the candidate
+        // semantics starting at m_NextCandidate. Its children continue its resolution.
+        struct Node
+        {
+            uint64_t
+                m_Mask;
+            size_t
+                m_NextCandidate;
+            CodeGenerator::QueryState
+                m_State;
+        };
+
+        struct Result
+        {
+            uint64_t
+                m_Mask;
+            CodeGenerator::QueryState
+                m_State;
+        };
+
+        int CountBits( uint64_t mask )
+        {
+            int
+                count = 0;
+
+            for( ; mask != 0; mask &= mask - 1 )
+            {
+                ++count;
+            }
+
+            return count;
+        }
+
+        bool IsBefore( const Result & first, const Result & second )
+        {
+            const int
+                first_count = CountBits( first.m_Mask ),
+                second_count = CountBits( second.m_Mask );
+
+            if( first_count != second_count )
+            {
+                return first_count < second_count;
+            }
+
+            // The combination with the first differing semantic comes first
+            const uint64_t
+                difference = first.m_Mask ^ second.m_Mask;
+
+            return ( first.m_Mask & ( difference & ( ~difference + 1 ) ) ) != 0;
+        }
+
+        // Only reads its tables, so one explorer is shared by all the threads
+        class Explorer
+        {
+        public:
+
+            Explorer(
+                const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+                const std::vector<std::string> & required_semantic_table,
+                const std::vector<std::string> & optional_semantic_table,
+                const std::vector<std::string> & input_semantic_table,
+                ResolutionCache * resolution_cache,
+                CostEstimator * cost_estimator,
+                const bool selects_cheapest
+                ) :
+                m_DefinitionTable( definition_table ),
+                m_RequiredSemanticTable( required_semantic_table ),
+                m_OptionalSemanticTable( optional_semantic_table ),
+                m_InputSemanticTable( input_semantic_table ),
+                m_ResolutionCache( resolution_cache ),
+                m_CostEstimator( cost_estimator ),
+                m_SelectsCheapest( selects_cheapest )
+            {
+                for( size_t index = 0; index < optional_semantic_table.size(); ++index )
+                {
+                    m_CandidateTable.push_back( index );
+                }
+            }
+
+            // Continues the resolution of the state with the given semantics
+            bool Query(
+                CodeGenerator::QueryState & state,
+                const std::vector<std::string> & semantic_table
+                ) const
+            {
+                CodeGenerator
+                    code_generator;
+                Base::ObjectRef<IgnoringErrorHandler>
+                    error_handler = new IgnoringErrorHandler;
+
+                code_generator.SetResolutionCache( m_ResolutionCache );
+                code_generator.SetCostEstimator( m_CostEstimator );
+                code_generator.SetCheapestSelection( m_SelectsCheapest );
+                Base::Statistics::AddCount( "permutation_query_count" );
+
+                return code_generator.ContinueQuery(
+                    state,
+                    m_DefinitionTable,
+                    semantic_table,
+                    m_InputSemanticTable,
+                    *error_handler
+                    );
+            }
+
+            bool QueryRoot( Node & root ) const
+            {
+                root.m_Mask = 0;
+                root.m_NextCandidate = 0;
+
+                return Query( root.m_State, m_RequiredSemanticTable );
+            }
+
+            // Children only resolve their added semantic. A semantic already generated by
+            // the node adds no function, so neither the child nor its subtree, which
+            // continues the same resolution as the subtree of the node, is kept.
+            void Expand(
+                std::vector<Node> & child_table,
+                std::vector<Result> & result_table,
+                const Node & node
+                ) const
+            {
+                for( size_t candidate = node.m_NextCandidate; candidate < m_CandidateTable.size(); ++candidate )
+                {
+                    Node
+                        child;
+                    const std::string
+                        & semantic = m_OptionalSemanticTable[ m_CandidateTable[ candidate ] ];
+
+                    child.m_Mask = node.m_Mask | ( uint64_t( 1 ) << m_CandidateTable[ candidate ] );
+                    child.m_NextCandidate = candidate + 1;
+                    child.m_State = node.m_State;
+
+                    if( node.m_State.m_GeneratedSemanticSet.find( semantic ) != node.m_State.m_GeneratedSemanticSet.end() )
+                    {
+                        Base::Statistics::AddCount( "permutation_duplicate_count" );
+                        continue;
+                    }
+
+                    if( !Query( child.m_State, std::vector<std::string>( 1, semantic ) ) )
+                    {
+                        Base::Statistics::AddCount( "permutation_pruned_count" );
+                        continue;
+                    }
+
+                    Result
+                        result;
+
+                    result.m_Mask = child.m_Mask;
+                    result.m_State = child.m_State;
+
+                    result_table.push_back( std::move( result ) );
+                    child_table.push_back( std::move( child ) );
+                }
+            }
+
+            void Explore( std::vector<Result> & result_table, const Node & node ) const
+            {
+                std::vector<Node>
+                    child_table;
+
+                Expand( child_table, result_table, node );
+
+                for( std::vector<Node>::const_iterator it = child_table.begin(), end = child_table.end(); it != end; ++it )
+                {
+                    Explore( result_table, *it );
+                }
+            }
+
+            // Semantics which cannot be generated alone are never tried again
+            void SetCandidateTable( const std::vector<Node> & single_semantic_node_table )
+            {
+                m_CandidateTable.clear();
+
+                for( std::vector<Node>::const_iterator it = single_semantic_node_table.begin(), end = single_semantic_node_table.end(); it != end; ++it )
+                {
+                    m_CandidateTable.push_back( CountTrailingZeros( (*it).m_Mask ) );
+                }
+            }
+
+        private:
+
+            static size_t CountTrailingZeros( const uint64_t mask )
+            {
+                size_t
+                    count = 0;
+
+                while( ( mask & ( uint64_t( 1 ) << count ) ) == 0 )
+                {
+                    ++count;
+                }
+
+                return count;
+            }
+
+            const std::vector<Base::ObjectRef<FragmentDefinition> >
+                & m_DefinitionTable;
+            const std::vector<std::string>
+                & m_RequiredSemanticTable,
+                & m_OptionalSemanticTable,
+                & m_InputSemanticTable;
+            ResolutionCache
+                * m_ResolutionCache;
+            CostEstimator
+                * m_CostEstimator;
+            const bool
+                m_SelectsCheapest;
+            std::vector<size_t>
+                m_CandidateTable;
+        };
+    }
+
+    bool PermutationEnumerator::Enumerate(
+        std::vector<Permutation> & permutation_table,
+        const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+        const std::vector<std::string> & required_semantic_table,
+        const std::vector<std::string> & optional_semantic_table,
+        const std::vector<std::string> & input_semantic_table,
+        Base::ErrorHandlerInterface & error_handler
+        ) const
+    {
+        Base::ScopedTimer
+            timer( "enumerate_permutations" );
+        Explorer
+            explorer( definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, m_ResolutionCache, m_CostEstimator, m_SelectsCheapest );
+        std::vector<Result>
+            result_table;
+        std::vector<Node>
+            node_table,
+            child_table;
+        Node
+            root;
+        const size_t
+            thread_count = m_ThreadCount > 0 ? m_ThreadCount : std::max( 1u, std::thread::hardware_concurrency() );
+
+        if( optional_semantic_table.size() > 64 )
+        {
+            error_handler.ReportError( "At most 64 optional semantics can be enumerated", "" );
+            return false;
+        }
+
+        if( !explorer.QueryRoot( root ) )
+        {
+            error_handler.ReportError( "Required semantics cannot be generated", "" );
+            return false;
+        }
+
+        if( !required_semantic_table.empty() )
+        {
+            Result
+                root_result;
+
+            root_result.m_Mask = root.m_Mask;
+            root_result.m_State = root.m_State;
+            result_table.push_back( root_result );
+        }
+
+        explorer.Expand( node_table, result_table, root );
+        explorer.SetCandidateTable( node_table );
+
+        // Nodes are renumbered against the remaining candidates
+        for( size_t index = 0; index < node_table.size(); ++index )
+        {
+            node_table[ index ].m_NextCandidate = index + 1;
+        }
+
+        // Enough subtrees to balance the threads
+        while( !node_table.empty() && node_table.size() < thread_count * 4 )
+        {
+            child_table.clear();
+
+            for( std::vector<Node>::const_iterator it = node_table.begin(), end = node_table.end(); it != end; ++it )
+            {
+                explorer.Expand( child_table, result_table, *it );
+            }
+
+            node_table.swap( child_table );
+        }
+
+        std::vector<std::vector<Result> >
+            subtree_result_table( node_table.size() );
+        // The threads share the fragments and the states of the nodes
+        Base::Object::SharingScope
+            sharing_scope;
+        std::vector<std::thread>
+            thread_table;
+        std::atomic<size_t>
+            next_node( 0 );
+
+        for( size_t thread_index = 0; thread_index < std::min( thread_count, node_table.size() ); ++thread_index )
+        {
+            thread_table.push_back( std::thread( [&]()
+                {
+                    for( size_t node_index = next_node++; node_index < node_table.size(); node_index = next_node++ )
+                    {
+                        explorer.Explore( subtree_result_table[ node_index ], node_table[ node_index ] );
+                    }
+                }
+                ) );
+        }
+
+        for( std::vector<std::thread>::iterator it = thread_table.begin(), end = thread_table.end(); it != end; ++it )
+        {
+            (*it).join();
+        }
+
+        for( std::vector<std::vector<Result> >::const_iterator it = subtree_result_table.begin(), end = subtree_result_table.end(); it != end; ++it )
+        {
+            result_table.insert( result_table.end(), (*it).begin(), (*it).end() );
+        }
+
+        std::sort( result_table.begin(), result_table.end(), IsBefore );
+
+        std::set<std::set<FunctionDefinition::Ref> >
+            function_set_set;
+        size_t
+            permutation_count = 0;
+
+        for( std::vector<Result>::const_iterator it = result_table.begin(), end = result_table.end(); it != end; ++it )
+        {
+            Permutation
+                permutation;
+
+            // Combinations resolving to the functions of a previous one generate the same
+            // shader, only the one with the fewest semantics is kept
+            if( !function_set_set.insert( (*it).m_State.m_FunctionSet ).second )
+            {
+                Base::Statistics::AddCount( "permutation_duplicate_count" );
+                continue;
+            }
+
+            permutation.m_SemanticTable = required_semantic_table;
+
+            for( size_t index = 0; index < optional_semantic_table.size(); ++index )
+            {
+                if( (*it).m_Mask & ( uint64_t( 1 ) << index ) )
+                {
+                    permutation.m_SemanticTable.push_back( optional_semantic_table[ index ] );
+                }
+            }
+
+            permutation.m_UsedInputSemanticTable.assign( (*it).m_State.m_UsedInputSemanticSet.begin(), (*it).m_State.m_UsedInputSemanticSet.end() );
+            permutation.m_EstimatedCost = (*it).m_State.m_EstimatedCost;
+            permutation_table.push_back( permutation );
+            ++permutation_count;
+
+            if( m_CostEstimator )
+            {
+                std::string
+                    label;
+
+                for( std::vector<std::string>::const_iterator semantic = permutation.m_SemanticTable.begin(); semantic != permutation.m_SemanticTable.end(); ++semantic )
+                {
+                    label += ( label.empty() ? "" : " " ) + *semantic;
+                }
+
+                Base::Statistics::AddSample( "permutation_estimated_cost", label, permutation.m_EstimatedCost );
+            }
+        }
+
+        Base::Statistics::AddCount( "permutation_count", permutation_count );
+
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef PERMUTATION_ENUMERATOR_H
+    #define PERMUTATION_ENUMERATOR_H
+
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+    #include <base/error_handler_interface.h>
+    #include <base/object_ref.h>
+
+    namespace Generation
+    {
+        class CostEstimator;
+        class FragmentDefinition;
+        class ResolutionCache;
+
+        // Lists the combinations of optional output semantics that the fragment library
+        // can generate, with CodeGenerator::QueryShader so no code is generated.
+        //
+        // Combinations are explored as a prefix tree: a combination is only extended
+        // with later optional semantics when it can be generated itself, so a branch is
+        // pruned as soon as one semantic makes it unsatisfiable. Semantics that cannot
+        // be generated on their own are never tried. Each combination continues the
+        // resolution of its prefix, see CodeGenerator::ContinueQuery, so its functions
+        // are the ones of the prefix followed by the ones of the added semantic. The
+        // first levels of the tree are expanded on the calling thread, then the subtrees
+        // are explored in parallel.
+        //
+        // Combinations resolving to the same functions are listed once, with the fewest
+        // semantics, the others only adding outputs which their functions already
+        // generate as intermediate or by-product semantics.
+
+        class PermutationEnumerator
+        {
+        public:
+
+            struct Permutation
+            {
+                // Required semantics followed by the chosen optional ones
+                std::vector<std::string>
+                    m_SemanticTable,
+                    m_UsedInputSemanticTable;
+                // 0 without cost estimator
+                int
+                    m_EstimatedCost;
+            };
+
+            PermutationEnumerator() :
+                m_ThreadCount( 0 ),
+                m_ResolutionCache( 0 ),
+                m_CostEstimator( 0 ),
+                m_SelectsCheapest( false )
+            {
+            }
+
+            // 0 uses one thread per core
+            void SetThreadCount( const int thread_count ) { m_ThreadCount = thread_count; }
+
+            // Shared by the queries of all the threads, it must outlive the enumeration
+            void SetResolutionCache( ResolutionCache * cache ) { m_ResolutionCache = cache; }
+
+            // Estimates the cost of each permutation, also added to the statistics as the
+            // permutation_estimated_cost samples. The estimator must outlive the enumeration.
+            void SetCostEstimator( CostEstimator * estimator ) { m_CostEstimator = estimator; }
+
+            // See CodeGenerator::SetCheapestSelection
+            void SetCheapestSelection( const bool selects_cheapest ) { m_SelectsCheapest = selects_cheapest; }
+
+            // Permutations are sorted by semantic count, then in the order of the optional
+            // semantics. Returns false when the required semantics cannot be generated.
+            bool Enumerate(
+                std::vector<Permutation> & permutation_table,
+                const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table,
+                const std::vector<std::string> & required_semantic_table,
+                const std::vector<std::string> & optional_semantic_table,
+                const std::vector<std::string> & input_semantic_table,
+                Base::ErrorHandlerInterface & error_handler
+                ) const;
+
+        private:
+
+            int
+                m_ThreadCount;
+            ResolutionCache
+                * m_ResolutionCache;
+            CostEstimator
+                * m_CostEstimator;
+            bool
+                m_SelectsCheapest;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,686 @@
+#include "preshader_extractor.h"
+#include "value_type.h"
+
+#include <ast/function_node.h>
+#include <ast/tree_traverser.h>
+#include <ast/printer/hlsl_printer.h>
+#include <base/statistics.h>
+#include <set>
+#include <sstream>
+
+namespace Generation
+{
+    namespace
+    {
+        struct Analysis
+        {
+            Analysis() : m_IsUniform( false ), m_ReadsUniform( false ), m_OperationCount( 0 ) {}
+
+            bool
+                m_IsUniform,
+                m_ReadsUniform;
+            int
+                m_OperationCount;
+            ValueType
+                m_Type;
+        };
+
+        struct Candidate
+        {
+            Base::ObjectRef<AST::Expression>
+                * m_Expression;
+            std::string
+                m_Type;
+            int
+                m_OperationCount;
+        };
+
+        // Finds the largest expressions of a function which only read uniforms and literals
+        class UniformExpressionFinder
+        {
+        public:
+
+            UniformExpressionFinder(
+                const std::map<std::string, ValueType> & uniform_type_table,
+                const std::set<std::string> & function_name_set,
+                const std::set<std::string> & local_variable_set
+                ) :
+                m_UniformTypeTable( uniform_type_table ),
+                m_FunctionNameSet( function_name_set ),
+                m_LocalVariableSet( local_variable_set )
+            {
+            }
+
+            void FindInStatement( AST::Statement & statement );
+
+            std::vector<Candidate>
+                m_CandidateTable;
+
+        private:
+
+            UniformExpressionFinder & operator =( const UniformExpressionFinder & other );
+
+            void Find( Base::ObjectRef<AST::Expression> & expression )
+            {
+                if( expression )
+                {
+                    Analysis
+                        analysis;
+
+                    Analyze( analysis, expression );
+                    AddCandidate( expression, analysis );
+                }
+            }
+
+            void FindInArguments( AST::ArgumentExpressionList * argument_list )
+            {
+                if( argument_list )
+                {
+                    for( size_t index = 0; index < argument_list->m_ExpressionList.size(); ++index )
+                    {
+                        Find( argument_list->m_ExpressionList[ index ] );
+                    }
+                }
+            }
+
+            void AddCandidate( Base::ObjectRef<AST::Expression> & expression, const Analysis & analysis )
+            {
+                if( analysis.m_IsUniform && analysis.m_ReadsUniform && analysis.m_OperationCount > 0 )
+                {
+                    Candidate
+                        candidate;
+
+                    candidate.m_Expression = &expression;
+                    candidate.m_Type = analysis.m_Type.GetName();
+                    candidate.m_OperationCount = analysis.m_OperationCount;
+                    m_CandidateTable.push_back( candidate );
+                }
+            }
+
+            void Analyze( Analysis & analysis, Base::ObjectRef<AST::Expression> & expression );
+
+            const std::map<std::string, ValueType>
+                & m_UniformTypeTable;
+            const std::set<std::string>
+                & m_FunctionNameSet,
+                & m_LocalVariableSet;
+        };
+
+        void UniformExpressionFinder::Analyze( Analysis & analysis, Base::ObjectRef<AST::Expression> & expression )
+        {
+            std::vector<Base::ObjectRef<AST::Expression> *>
+                operand_table;
+            std::vector<Analysis>
+                operand_analysis_table;
+            std::vector<ValueType>
+                operand_type_table;
+            bool
+                operands_are_uniform = true,
+                has_type = false;
+
+            switch( expression->m_Kind )
+            {
+                case AST::NodeKind_LiteralExpression:
+                {
+                    const AST::LiteralExpression
+                        & literal = static_cast<const AST::LiteralExpression &>( *expression );
+
+                    analysis.m_IsUniform = true;
+                    ParseType( analysis.m_Type, literal.m_Type == AST::LiteralExpression::Float ? "float" : literal.m_Type == AST::LiteralExpression::Int ? "int" : "bool" );
+                    return;
+                }
+
+                case AST::NodeKind_VariableExpression:
+                {
+                    AST::VariableExpression
+                        & variable = static_cast<AST::VariableExpression &>( *expression );
+                    std::map<std::string, ValueType>::const_iterator
+                        uniform = m_UniformTypeTable.find( variable.m_Name );
+
+                    // Uniform arrays are not extracted
+                    if( variable.m_SubscriptExpression )
+                    {
+                        Find( variable.m_SubscriptExpression );
+                    }
+                    else if( uniform != m_UniformTypeTable.end() && m_LocalVariableSet.find( variable.m_Name ) == m_LocalVariableSet.end() )
+                    {
+                        analysis.m_IsUniform = true;
+                        analysis.m_ReadsUniform = true;
+                        analysis.m_Type = (*uniform).second;
+                    }
+                    return;
+                }
+
+                case AST::NodeKind_AssignmentExpression:
+                    Find( static_cast<AST::AssignmentExpression &>( *expression ).m_Expression );
+                    return;
+
+                case AST::NodeKind_BinaryOperationExpression:
+                {
+                    AST::BinaryOperationExpression
+                        & operation = static_cast<AST::BinaryOperationExpression &>( *expression );
+
+                    operand_table.push_back( &operation.m_LeftExpression );
+                    operand_table.push_back( &operation.m_RightExpression );
+                    break;
+                }
+
+                case AST::NodeKind_UnaryOperationExpression:
+                    operand_table.push_back( &static_cast<AST::UnaryOperationExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_CastExpression:
+                    operand_table.push_back( &static_cast<AST::CastExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_ConditionalExpression:
+                {
+                    AST::ConditionalExpression
+                        & conditional = static_cast<AST::ConditionalExpression &>( *expression );
+
+                    operand_table.push_back( &conditional.m_Condition );
+                    operand_table.push_back( &conditional.m_IfTrue );
+                    operand_table.push_back( &conditional.m_IfFalse );
+                    break;
+                }
+
+                case AST::NodeKind_CallExpression:
+                case AST::NodeKind_ConstructorExpression:
+                {
+                    AST::ArgumentExpressionList
+                        * argument_list = expression->m_Kind == AST::NodeKind_CallExpression
+                            ? &*static_cast<AST::CallExpression &>( *expression ).m_ArgumentExpressionList
+                            : &*static_cast<AST::ConstructorExpression &>( *expression ).m_ArgumentExpressionList;
+
+                    for( size_t index = 0; argument_list && index < argument_list->m_ExpressionList.size(); ++index )
+                    {
+                        operand_table.push_back( &argument_list->m_ExpressionList[ index ] );
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_PostfixExpression:
+                {
+                    AST::PostfixExpression
+                        & postfix = static_cast<AST::PostfixExpression &>( *expression );
+
+                    operand_table.push_back( &postfix.m_Expression );
+
+                    if( postfix.m_Suffix && postfix.m_Suffix->m_Kind == AST::NodeKind_PostfixSuffixCall )
+                    {
+                        FindInArguments( &*static_cast<AST::PostfixSuffixCall &>( *postfix.m_Suffix ).m_CallExpression->m_ArgumentExpressionList );
+                    }
+                    break;
+                }
+
+                default:
+                    return;
+            }
+
+            operand_analysis_table.resize( operand_table.size() );
+
+            for( size_t index = 0; index < operand_table.size(); ++index )
+            {
+                Analyze( operand_analysis_table[ index ], *operand_table[ index ] );
+                operands_are_uniform = operands_are_uniform && operand_analysis_table[ index ].m_IsUniform;
+                operand_type_table.push_back( operand_analysis_table[ index ].m_Type );
+                analysis.m_ReadsUniform = analysis.m_ReadsUniform || operand_analysis_table[ index ].m_ReadsUniform;
+                analysis.m_OperationCount += operand_analysis_table[ index ].m_OperationCount;
+            }
+
+            if( operands_are_uniform )
+            {
+                switch( expression->m_Kind )
+                {
+                    case AST::NodeKind_BinaryOperationExpression:
+                    {
+                        const AST::BinaryOperationExpression::Operation
+                            operation = static_cast<const AST::BinaryOperationExpression &>( *expression ).m_Operation;
+
+                        has_type = CombineTypes( analysis.m_Type, operand_type_table[ 0 ], operand_type_table[ 1 ] );
+
+                        if( operation <= AST::BinaryOperationExpression::LogicalAnd
+                            || ( operation >= AST::BinaryOperationExpression::Equality && operation <= AST::BinaryOperationExpression::GreaterThanOrEqual )
+                            )
+                        {
+                            analysis.m_Type.m_Rank = 0;
+                        }
+
+                        ++analysis.m_OperationCount;
+                        break;
+                    }
+
+                    case AST::NodeKind_UnaryOperationExpression:
+                        analysis.m_Type = operand_type_table[ 0 ];
+                        has_type = true;
+
+                        if( static_cast<const AST::UnaryOperationExpression &>( *expression ).m_Operation == AST::UnaryOperationExpression::Not )
+                        {
+                            analysis.m_Type.m_Rank = 0;
+                        }
+
+                        ++analysis.m_OperationCount;
+                        break;
+
+                    case AST::NodeKind_CastExpression:
+                    {
+                        const AST::CastExpression
+                            & cast = static_cast<const AST::CastExpression &>( *expression );
+
+                        has_type = cast.m_ArraySize == -1 && ParseType( analysis.m_Type, cast.m_Type->m_Name );
+                        break;
+                    }
+
+                    case AST::NodeKind_ConstructorExpression:
+                        has_type = ParseType( analysis.m_Type, static_cast<const AST::ConstructorExpression &>( *expression ).m_Type->m_Name );
+                        break;
+
+                    case AST::NodeKind_ConditionalExpression:
+                        has_type = CombineTypes( analysis.m_Type, operand_type_table[ 1 ], operand_type_table[ 2 ] );
+                        ++analysis.m_OperationCount;
+                        break;
+
+                    case AST::NodeKind_CallExpression:
+                    {
+                        const std::string
+                            & name = static_cast<const AST::CallExpression &>( *expression ).m_Name;
+
+                        has_type = m_FunctionNameSet.find( name ) == m_FunctionNameSet.end()
+                            && GetIntrinsicCallType( analysis.m_Type, name, operand_type_table );
+                        ++analysis.m_OperationCount;
+                        break;
+                    }
+
+                    case AST::NodeKind_PostfixExpression:
+                    {
+                        const AST::PostfixExpression
+                            & postfix = static_cast<const AST::PostfixExpression &>( *expression );
+
+                        has_type = postfix.m_Suffix
+                            && postfix.m_Suffix->m_Kind == AST::NodeKind_Swizzle
+                            && GetSwizzleType( analysis.m_Type, operand_type_table[ 0 ], static_cast<const AST::Swizzle &>( *postfix.m_Suffix ).m_Swizzle );
+                        break;
+                    }
+
+                    default:
+                        break;
+                }
+            }
+
+            if( operands_are_uniform && has_type )
+            {
+                analysis.m_IsUniform = true;
+                return;
+            }
+
+            // The largest uniform expressions are the uniform operands of the others
+            for( size_t index = 0; index < operand_table.size(); ++index )
+            {
+                AddCandidate( *operand_table[ index ], operand_analysis_table[ index ] );
+            }
+        }
+
+        void UniformExpressionFinder::FindInStatement( AST::Statement & statement )
+        {
+            switch( statement.m_Kind )
+            {
+                case AST::NodeKind_ReturnStatement:
+                    Find( static_cast<AST::ReturnStatement &>( statement ).m_Expression );
+                    break;
+
+                case AST::NodeKind_ExpressionStatement:
+                    Find( static_cast<AST::ExpressionStatement &>( statement ).m_Expression );
+                    break;
+
+                case AST::NodeKind_AssignmentStatement:
+                    Find( static_cast<AST::AssignmentStatement &>( statement ).m_Expression->m_Expression );
+                    break;
+
+                case AST::NodeKind_IfStatement:
+                {
+                    AST::IfStatement
+                        & if_statement = static_cast<AST::IfStatement &>( statement );
+
+                    Find( if_statement.m_Condition );
+                    FindInStatement( *if_statement.m_ThenStatement );
+
+                    if( if_statement.m_ElseStatement )
+                    {
+                        FindInStatement( *if_statement.m_ElseStatement );
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_WhileStatement:
+                {
+                    AST::WhileStatement
+                        & while_statement = static_cast<AST::WhileStatement &>( statement );
+
+                    Find( while_statement.m_Condition );
+                    FindInStatement( *while_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_DoWhileStatement:
+                {
+                    AST::DoWhileStatement
+                        & do_while_statement = static_cast<AST::DoWhileStatement &>( statement );
+
+                    Find( do_while_statement.m_Condition );
+                    FindInStatement( *do_while_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_ForStatement:
+                {
+                    AST::ForStatement
+                        & for_statement = static_cast<AST::ForStatement &>( statement );
+
+                    if( for_statement.m_InitStatement )
+                    {
+                        FindInStatement( *for_statement.m_InitStatement );
+                    }
+
+                    Find( for_statement.m_EqualityExpression );
+                    Find( for_statement.m_ModifyExpression );
+                    FindInStatement( *for_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_BlockStatement:
+                {
+                    AST::BlockStatement
+                        & block = static_cast<AST::BlockStatement &>( statement );
+
+                    for( size_t index = 0; index < block.m_StatementTable.size(); ++index )
+                    {
+                        FindInStatement( *block.m_StatementTable[ index ] );
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_VariableDeclarationStatement:
+                {
+                    AST::VariableDeclarationStatement
+                        & declaration = static_cast<AST::VariableDeclarationStatement &>( statement );
+                    std::vector<Base::ObjectRef<AST::VariableDeclarationBody> >::iterator it, end;
+
+                    for( it = declaration.m_BodyTable.begin(), end = declaration.m_BodyTable.end(); it != end; ++it )
+                    {
+                        for( size_t index = 0; (*it)->m_InitialValue && index < (*it)->m_InitialValue->m_ExpressionTable.size(); ++index )
+                        {
+                            Find( (*it)->m_InitialValue->m_ExpressionTable[ index ] );
+                        }
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        // Names declared or read by the program, locals included
+        class NameCollector : public AST::TreeTraverser
+        {
+        public:
+
+            using AST::TreeTraverser::Visit;
+
+            virtual void Visit( const AST::Node & ) override {}
+
+            virtual void Visit( const AST::VariableExpression & expression ) override
+            {
+                m_NameSet.insert( expression.m_Name );
+                TreeTraverser::Visit( expression );
+            }
+
+            virtual void Visit( const AST::VariableDeclarationBody & body ) override
+            {
+                m_NameSet.insert( body.m_Name );
+                m_DeclaredNameSet.insert( body.m_Name );
+                TreeTraverser::Visit( body );
+            }
+
+            virtual void Visit( const AST::Argument & argument ) override
+            {
+                m_NameSet.insert( argument.m_Name );
+                m_DeclaredNameSet.insert( argument.m_Name );
+                TreeTraverser::Visit( argument );
+            }
+
+            virtual void Visit( const AST::FunctionDeclaration & declaration ) override
+            {
+                m_NameSet.insert( declaration.m_Name );
+                TreeTraverser::Visit( declaration );
+            }
+
+            std::set<std::string>
+                m_NameSet,
+                m_DeclaredNameSet;
+        };
+
+        bool IsStatic( const AST::VariableDeclaration & declaration )
+        {
+            for( size_t index = 0; index < declaration.m_StorageClass.size(); ++index )
+            {
+                if( declaration.m_StorageClass[ index ]->m_Value == "static" )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    }
+
+    int PreshaderExtractor::Extract( AST::TranslationUnit & program )
+    {
+        Base::ScopedTimer
+            timer( "extract_preshader" );
+        std::map<std::string, ValueType>
+            uniform_type_table;
+        std::set<std::string>
+            function_name_set,
+            declared_uniform_set;
+        std::vector<Base::ObjectRef<AST::GlobalDeclaration> >
+            uniform_declaration_table;
+        std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+        NameCollector
+            name_collector;
+        int
+            removed_operation_count = 0;
+
+        // Also parses the deferred function bodies
+        program.Visit( name_collector );
+
+        for( it = program.m_GlobalDeclarationTable.begin(), end = program.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            if( const AST::FunctionDeclaration * function = dynamic_cast<const AST::FunctionDeclaration *>( &**it ) )
+            {
+                function_name_set.insert( function->m_Name );
+            }
+
+            const AST::VariableDeclaration
+                * declaration = dynamic_cast<const AST::VariableDeclaration *>( &**it );
+
+            if( !declaration || IsStatic( *declaration ) )
+            {
+                continue;
+            }
+
+            ValueType
+                type;
+
+            if( !ParseType( type, declaration->m_Type->m_Name ) )
+            {
+                continue;
+            }
+
+            for( size_t index = 0; index < declaration->m_BodyTable.size(); ++index )
+            {
+                if( declaration->m_BodyTable[ index ]->m_ArraySize == 0 )
+                {
+                    uniform_type_table[ declaration->m_BodyTable[ index ]->m_Name ] = type;
+                }
+            }
+        }
+
+        for( size_t declaration_index = 0; declaration_index < program.m_GlobalDeclarationTable.size(); ++declaration_index )
+        {
+            AST::FunctionDeclaration
+                * function = dynamic_cast<AST::FunctionDeclaration *>( &*program.m_GlobalDeclarationTable[ declaration_index ] );
+
+            if( !function )
+            {
+                continue;
+            }
+
+            NameCollector
+                local_collector;
+
+            // Locals hiding a uniform are not uniform
+            if( function->m_ArgumentList )
+            {
+                function->m_ArgumentList->Visit( local_collector );
+            }
+
+            for( size_t index = 0; index < function->m_StatementTable.size(); ++index )
+            {
+                function->m_StatementTable[ index ]->Visit( local_collector );
+            }
+
+            UniformExpressionFinder
+                finder( uniform_type_table, function_name_set, local_collector.m_DeclaredNameSet );
+            std::vector<Candidate>::const_iterator candidate, candidate_end;
+
+            for( size_t index = 0; index < function->m_StatementTable.size(); ++index )
+            {
+                finder.FindInStatement( *function->m_StatementTable[ index ] );
+            }
+
+            for( candidate = finder.m_CandidateTable.begin(), candidate_end = finder.m_CandidateTable.end(); candidate != candidate_end; ++candidate )
+            {
+                Base::ObjectRef<AST::Expression>
+                    & expression = *(*candidate).m_Expression;
+                std::ostringstream
+                    key;
+                AST::HLSLPrinter
+                    printer( key );
+
+                expression->Visit( printer );
+                key << " : " << (*candidate).m_Type;
+
+                std::map<std::string, size_t>::const_iterator
+                    index = m_UniformIndexTable.find( key.str() );
+
+                if( index == m_UniformIndexTable.end() )
+                {
+                    Uniform
+                        uniform;
+                    NameCollector
+                        read_collector;
+                    std::set<std::string>::const_iterator name, name_end;
+
+                    for( size_t suffix = m_UniformTable.size(); uniform.m_Name.empty() || name_collector.m_NameSet.find( uniform.m_Name ) != name_collector.m_NameSet.end(); ++suffix )
+                    {
+                        std::ostringstream
+                            stream;
+
+                        stream << "preshader_" << suffix;
+                        uniform.m_Name = stream.str();
+                    }
+
+                    uniform.m_Type = (*candidate).m_Type;
+                    uniform.m_Expression = expression;
+                    index = m_UniformIndexTable.insert( std::make_pair( key.str(), m_UniformTable.size() ) ).first;
+                    m_UniformTable.push_back( uniform );
+
+                    expression->Visit( read_collector );
+
+                    for( name = read_collector.m_NameSet.begin(), name_end = read_collector.m_NameSet.end(); name != name_end; ++name )
+                    {
+                        std::map<std::string, ValueType>::const_iterator
+                            uniform_type = uniform_type_table.find( *name );
+
+                        if( uniform_type != uniform_type_table.end()
+                            && m_ReadUniformTypeTable.insert( std::make_pair( *name, (*uniform_type).second.GetName() ) ).second
+                            )
+                        {
+                            m_ReadUniformTable.push_back( *name );
+                        }
+                    }
+                }
+
+                const Uniform
+                    & uniform = m_UniformTable[ (*index).second ];
+
+                if( declared_uniform_set.insert( uniform.m_Name ).second )
+                {
+                    Base::ObjectRef<AST::VariableDeclaration>
+                        declaration = new AST::VariableDeclaration;
+
+                    declaration->SetType( new AST::Type( uniform.m_Type ) );
+                    declaration->AddBody( new AST::VariableDeclarationBody( uniform.m_Name ) );
+                    uniform_declaration_table.push_back( &*declaration );
+                }
+
+                expression = new AST::VariableExpression( uniform.m_Name );
+                removed_operation_count += (*candidate).m_OperationCount;
+            }
+        }
+
+        program.m_GlobalDeclarationTable.insert( program.m_GlobalDeclarationTable.begin(), uniform_declaration_table.begin(), uniform_declaration_table.end() );
+
+        Base::Statistics::AddCount( "preshader_removed_operation_count", removed_operation_count );
+
+        return removed_operation_count;
+    }
+
+    Base::ObjectRef<AST::TranslationUnit> PreshaderExtractor::CreateEvaluationProgram() const
+    {
+        Base::ObjectRef<AST::TranslationUnit>
+            program = new AST::TranslationUnit;
+        Base::ObjectRef<AST::FunctionDeclaration>
+            function = new AST::FunctionDeclaration;
+        std::vector<std::string>::const_iterator it, end;
+
+        for( it = m_ReadUniformTable.begin(), end = m_ReadUniformTable.end(); it != end; ++it )
+        {
+            Base::ObjectRef<AST::VariableDeclaration>
+                declaration = new AST::VariableDeclaration;
+
+            declaration->SetType( new AST::Type( (*m_ReadUniformTypeTable.find( *it )).second ) );
+            declaration->AddBody( new AST::VariableDeclarationBody( *it ) );
+            program->AddGlobalDeclaration( &*declaration );
+        }
+
+        function->m_Name = "EvaluatePreshader";
+        function->m_ArgumentList = new AST::ArgumentList;
+
+        for( size_t index = 0; index < m_UniformTable.size(); ++index )
+        {
+            const Uniform
+                & uniform = m_UniformTable[ index ];
+            Base::ObjectRef<AST::Argument>
+                argument = new AST::Argument;
+
+            argument->m_Type = new AST::Type( uniform.m_Type );
+            argument->m_Name = uniform.m_Name;
+            argument->m_InputModifier = "out";
+            function->m_ArgumentList->AddArgument( &*argument );
+
+            function->AddStatement(
+                new AST::AssignmentStatement(
+                    new AST::LValueExpression( new AST::VariableExpression( uniform.m_Name ) ),
+                    AST::AssignmentOperator_Assign,
+                    uniform.m_Expression->Clone()
+                    )
+                );
+        }
+
+        program->AddGlobalDeclaration( &*function );
+
+        return program;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef PRESHADER_EXTRACTOR_H
+    #define PRESHADER_EXTRACTOR_H
+
+    #include <map>
+    #include <string>
+    #include <vector>
+    #include <ast/node.h>
+    #include <base/object_ref.h>
+
+    namespace Generation
+    {
+        // Moves the expressions computed only from uniforms and literals, like
+        // normalize( LightDirection ), out of the generated programs. They are the same
+        // for every vertex and pixel of a draw, so the engine runs the evaluation
+        // program once per draw and sets the new uniforms replacing them.
+        //
+        // An expression is extracted when it reads a uniform, has at least one
+        // operation, and its type can be deduced. Only intrinsic calls are followed,
+        // and identical expressions share their uniform, also between programs.
+
+        class PreshaderExtractor
+        {
+        public:
+
+            PreshaderExtractor() {}
+
+            // Returns the count of operations removed from the functions of the program
+            int Extract( AST::TranslationUnit & program );
+
+            // Declares the uniforms read by the extracted expressions, and computes the
+            // new uniforms as the out arguments of EvaluatePreshader
+            Base::ObjectRef<AST::TranslationUnit> CreateEvaluationProgram() const;
+
+            size_t GetUniformCount() const { return m_UniformTable.size(); }
+
+        private:
+
+            struct Uniform
+            {
+                std::string
+                    m_Name,
+                    m_Type;
+                Base::ObjectRef<AST::Expression>
+                    m_Expression;
+            };
+
+            std::vector<Uniform>
+                m_UniformTable;
+            std::map<std::string, size_t>
+                m_UniformIndexTable;
+            // Uniforms of the programs read by the extracted expressions, with their type
+            std::map<std::string, std::string>
+                m_ReadUniformTypeTable;
+            std::vector<std::string>
+                m_ReadUniformTable;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "resolution_cache.h"
+
+#include <base/statistics.h>
+
+namespace Generation
+{
+    namespace
+    {
+        // Rough overhead of a node of std::set
+        const size_t
+            SetNodeSize = 32;
+
+        size_t GetSetSize( const std::set<std::string> & semantic_set )
+        {
+            std::set<std::string>::const_iterator it, end;
+            size_t
+                size = 0;
+
+            for( it = semantic_set.begin(), end = semantic_set.end(); it != end; ++it )
+            {
+                size += SetNodeSize + sizeof( std::string ) + (*it).size();
+            }
+
+            return size;
+        }
+    }
+
+    size_t Resolution::GetSize() const
+    {
+        std::vector<Step>::const_iterator it, end;
+        size_t
+            size = sizeof( Resolution );
+
+        for( it = m_StepTable.begin(), end = m_StepTable.end(); it != end; ++it )
+        {
+            std::vector<std::string>::const_iterator semantic_it, semantic_end;
+
+            size += sizeof( Step );
+
+            semantic_it = (*it).m_BoundSemanticTable.begin();
+            semantic_end = (*it).m_BoundSemanticTable.end();
+
+            for( ; semantic_it != semantic_end; ++semantic_it )
+            {
+                size += sizeof( std::string ) + (*semantic_it).size();
+            }
+        }
+
+        size += GetSetSize( m_UsedInputSemanticSet );
+        size += GetSetSize( m_SearchedSemanticSet );
+        size += GetSetSize( m_UngeneratedSemanticSet );
+        size += GetSetSize( m_FailedSemanticSet );
+
+        return size;
+    }
+
+    ResolutionCache::ResolutionCache( const size_t capacity ) :
+        m_Capacity( capacity ),
+        m_Size( 0 ),
+        m_HitCount( 0 ),
+        m_MissCount( 0 ),
+        m_EvictionCount( 0 )
+    {
+    }
+
+    std::string ResolutionCache::MakeKey(
+        const std::set<std::string> & open_semantic_set,
+        const std::string & input_key
+        )
+    {
+        std::set<std::string>::const_iterator it, end;
+        std::string
+            key;
+
+        for( it = open_semantic_set.begin(), end = open_semantic_set.end(); it != end; ++it )
+        {
+            key += *it;
+            key += ' ';
+        }
+
+        key += '|';
+        key += input_key;
+
+        return key;
+    }
+
+    std::string ResolutionCache::MakeInputKey( const std::set<std::string> & input_semantic_set )
+    {
+        std::set<std::string>::const_iterator it, end;
+        std::string
+            key;
+
+        for( it = input_semantic_set.begin(), end = input_semantic_set.end(); it != end; ++it )
+        {
+            key += ' ';
+            key += *it;
+        }
+
+        return key;
+    }
+
+    Resolution::Ref ResolutionCache::Find( const std::string & key )
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+        std::unordered_map<std::string, EntryList::iterator>::iterator
+            entry = m_EntryTable.find( key );
+
+        if( entry == m_EntryTable.end() )
+        {
+            ++m_MissCount;
+            Base::Statistics::AddCount( "resolution_cache_miss_count" );
+
+            return 0;
+        }
+
+        ++m_HitCount;
+        Base::Statistics::AddCount( "resolution_cache_hit_count" );
+
+        m_EntryList.splice( m_EntryList.begin(), m_EntryList, (*entry).second );
+
+        return (*(*entry).second).second;
+    }
+
+    void ResolutionCache::Add( const std::string & key, Resolution & resolution )
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+        std::unordered_map<std::string, EntryList::iterator>::iterator
+            entry = m_EntryTable.find( key );
+
+        // Another thread may have resolved the same semantics meanwhile
+        if( entry != m_EntryTable.end() )
+        {
+            m_Size -= key.size() + (*(*entry).second).second->GetSize();
+            m_EntryList.erase( (*entry).second );
+            m_EntryTable.erase( entry );
+        }
+
+        m_EntryList.push_front( std::make_pair( key, Resolution::Ref( &resolution ) ) );
+        m_EntryTable[ key ] = m_EntryList.begin();
+        m_Size += key.size() + resolution.GetSize();
+
+        while( m_Size > m_Capacity && !m_EntryList.empty() )
+        {
+            const EntryList::value_type
+                & oldest = m_EntryList.back();
+
+            m_Size -= oldest.first.size() + oldest.second->GetSize();
+            m_EntryTable.erase( oldest.first );
+            m_EntryList.pop_back();
+
+            ++m_EvictionCount;
+            Base::Statistics::AddCount( "resolution_cache_eviction_count" );
+        }
+    }
+
+    void ResolutionCache::Clear()
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        m_EntryList.clear();
+        m_EntryTable.clear();
+        m_Size = 0;
+    }
+
+    int64_t ResolutionCache::GetHitCount() const
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        return m_HitCount;
+    }
+
+    int64_t ResolutionCache::GetMissCount() const
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        return m_MissCount;
+    }
+
+    int64_t ResolutionCache::GetEvictionCount() const
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        return m_EvictionCount;
+    }
+
+    size_t ResolutionCache::GetEntryCount() const
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        return m_EntryList.size();
+    }
+
+    size_t ResolutionCache::GetSize() const
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        return m_Size;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef RESOLUTION_CACHE_H
+    #define RESOLUTION_CACHE_H
+
+    #include <cstdint>
+    #include <list>
+    #include <mutex>
+    #include <set>
+    #include <string>
+    #include <unordered_map>
+    #include <utility>
+    #include <vector>
+    #include <base/object.h>
+    #include <base/object_ref.h>
+    #include "fragment_definition.h"
+    #include "function_definition.h"
+
+    namespace Generation
+    {
+        // Functions chosen by CodeGenerator to generate an open semantic set from
+        // scratch, with what is needed to splice them in another resolution.
+        struct Resolution : public Base::Object
+        {
+            typedef Base::ObjectRef<Resolution>
+                Ref;
+
+            struct Step
+            {
+                FunctionDefinition::Ref
+                    m_Function;
+                FragmentDefinition::Ref
+                    m_Fragment;
+                // Input semantics bound to an output of a previous step
+                std::vector<std::string>
+                    m_BoundSemanticTable;
+            };
+
+            Resolution() : m_IsResolved( false ) {}
+
+            // Estimated memory used by the resolution, for the cache capacity
+            size_t GetSize() const;
+
+            std::vector<Step>
+                m_StepTable;
+            std::set<std::string>
+                m_UsedInputSemanticSet,
+                m_SearchedSemanticSet,
+                // Semantics which were requested but not generated yet: the resolution
+                // would differ if another function already generated them
+                m_UngeneratedSemanticSet,
+                // Open semantics when no producer was found
+                m_FailedSemanticSet;
+            bool
+                m_IsResolved;
+        };
+
+        // Resolutions keyed by (open semantic set, input semantic set), shared by the
+        // code generators of a batch, which can run on several threads. Entries are
+        // only valid for the fragment library they were resolved with: Clear the cache
+        // when it changes. The least recently used entries are evicted once the
+        // estimated size exceeds the capacity. Lookups and evictions are counted in
+        // Base::Statistics.
+
+        class ResolutionCache
+        {
+        public:
+
+            explicit ResolutionCache( const size_t capacity = 16 * 1024 * 1024 );
+
+            static std::string MakeKey(
+                const std::set<std::string> & open_semantic_set,
+                const std::string & input_key
+                );
+
+            static std::string MakeInputKey( const std::set<std::string> & input_semantic_set );
+
+            Resolution::Ref Find( const std::string & key );
+            void Add( const std::string & key, Resolution & resolution );
+            void Clear();
+
+            int64_t GetHitCount() const;
+            int64_t GetMissCount() const;
+            int64_t GetEvictionCount() const;
+            size_t GetEntryCount() const;
+            size_t GetSize() const;
+
+        private:
+
+            typedef std::list<std::pair<std::string, Resolution::Ref> >
+                EntryList;
+
+            mutable std::mutex
+                m_Mutex;
+            // Most recently used first
+            EntryList
+                m_EntryList;
+            std::unordered_map<std::string, EntryList::iterator>
+                m_EntryTable;
+            size_t
+                m_Capacity,
+                m_Size;
+            int64_t
+                m_HitCount,
+                m_MissCount,
+                m_EvictionCount;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -1,16 +1,20 @@
 #ifndef SEMANTIC_REMOVER_H
     #define SEMANTIC_REMOVER_H
 
-    #include <ast/empty_visitor.h>
+    #include <ast/static_visitor.h>
 
     namespace Generation
     {
-        class SemanticRemover : public AST::EmptyVisitor
+        class SemanticRemover : public AST::StaticVisitor<SemanticRemover, false>
         {
-            virtual void Visit( AST::TranslationUnit & translation_unit ) override;
-            virtual void Visit( AST::FunctionDeclaration & function_declaration ) override;
-            virtual void Visit( AST::ArgumentList & argument_list ) override;
-            virtual void Visit( AST::Argument & argument ) override;
+        public:
+
+            using AST::StaticVisitor<SemanticRemover, false>::Visit;
+
+            void Visit( AST::TranslationUnit & translation_unit );
+            void Visit( AST::FunctionDeclaration & function_declaration );
+            void Visit( AST::ArgumentList & argument_list );
+            void Visit( AST::Argument & argument );
         };
     }
 
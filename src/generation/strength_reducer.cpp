@@ -0,0 +1,646 @@
+#include "strength_reducer.h"
+
+#include <ast/function_node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <base/statistics.h>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+namespace Generation
+{
+    namespace
+    {
+        const char
+            * const HitCountNameTable[] =
+            {
+                "strength_reduction_power_identity_count",
+                "strength_reduction_power_square_count",
+                "strength_reduction_power_of_two_division_count",
+                "strength_reduction_power_cube_count",
+                "strength_reduction_power_square_root_count",
+                "strength_reduction_constant_division_count",
+                "strength_reduction_length_product_count",
+                "strength_reduction_reciprocal_square_root_count"
+            };
+
+        struct Context
+        {
+            std::set<std::string>
+                m_FunctionNameSet;
+            bool
+                m_AllowsFastMath;
+            int
+                * m_HitCountTable;
+        };
+
+        // Integer and float literals, with their suffix
+        bool GetLiteralValue( double & value, const AST::Expression & expression )
+        {
+            if( expression.m_Kind != AST::NodeKind_LiteralExpression )
+            {
+                return false;
+            }
+
+            const AST::LiteralExpression
+                & literal = static_cast<const AST::LiteralExpression &>( expression );
+            const char
+                * text = literal.m_Value.c_str();
+            char
+                * text_end;
+
+            if( literal.m_Type == AST::LiteralExpression::Bool )
+            {
+                return false;
+            }
+
+            value = literal.m_Type == AST::LiteralExpression::Int ? std::strtol( text, &text_end, 0 ) : std::strtod( text, &text_end );
+
+            return text_end != text && std::string( text_end ).find_first_not_of( "fFhHlLuU" ) == std::string::npos;
+        }
+
+        AST::LiteralExpression * CreateFloatLiteral( const double value )
+        {
+            std::ostringstream
+                text;
+
+            // Enough digits to read back the same float
+            text.precision( 9 );
+            text << value;
+
+            if( text.str().find_first_of( ".e" ) == std::string::npos )
+            {
+                text << ".0";
+            }
+
+            return new AST::LiteralExpression( AST::LiteralExpression::Float, text.str() );
+        }
+
+        // Cheap enough to be evaluated twice
+        bool IsSimple( const AST::Expression & expression )
+        {
+            switch( expression.m_Kind )
+            {
+                case AST::NodeKind_LiteralExpression:
+                    return true;
+
+                case AST::NodeKind_VariableExpression:
+                {
+                    const AST::VariableExpression
+                        & variable = static_cast<const AST::VariableExpression &>( expression );
+
+                    return !variable.m_SubscriptExpression || variable.m_SubscriptExpression->m_Kind == AST::NodeKind_LiteralExpression;
+                }
+
+                case AST::NodeKind_PostfixExpression:
+                {
+                    const AST::PostfixExpression
+                        & postfix = static_cast<const AST::PostfixExpression &>( expression );
+
+                    return IsSimple( *postfix.m_Expression )
+                        && ( !postfix.m_Suffix || postfix.m_Suffix->m_Kind != AST::NodeKind_PostfixSuffixCall );
+                }
+
+                default:
+                    return false;
+            }
+        }
+
+        std::string Print( const AST::Node & node )
+        {
+            std::ostringstream
+                output;
+            AST::HLSLPrinter
+                printer( output );
+
+            node.Visit( printer );
+
+            return output.str();
+        }
+
+        // Returns the arguments of a call to the given intrinsic
+        const std::vector<Base::ObjectRef<AST::Expression> > * GetIntrinsicArguments(
+            const Context & context,
+            const AST::Expression & expression,
+            const std::string & name,
+            const size_t argument_count
+            )
+        {
+            if( expression.m_Kind != AST::NodeKind_CallExpression )
+            {
+                return 0;
+            }
+
+            const AST::CallExpression
+                & call = static_cast<const AST::CallExpression &>( expression );
+
+            if( call.m_Name != name
+                || context.m_FunctionNameSet.find( name ) != context.m_FunctionNameSet.end()
+                || !call.m_ArgumentExpressionList
+                || call.m_ArgumentExpressionList->m_ExpressionList.size() != argument_count
+                )
+            {
+                return 0;
+            }
+
+            return &call.m_ArgumentExpressionList->m_ExpressionList;
+        }
+
+        AST::Expression * CreateMultiplication( AST::Expression * left_expression, AST::Expression * right_expression )
+        {
+            return new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Multiplication, left_expression, right_expression );
+        }
+
+        AST::Expression * CreateCall( const std::string & name, AST::Expression * first_argument, AST::Expression * second_argument = 0 )
+        {
+            AST::ArgumentExpressionList
+                * argument_list = new AST::ArgumentExpressionList;
+
+            argument_list->AddExpression( first_argument );
+
+            if( second_argument )
+            {
+                argument_list->AddExpression( second_argument );
+            }
+
+            return new AST::CallExpression( name, argument_list );
+        }
+
+        void Hit( Context & context, const StrengthReducer::Rule rule )
+        {
+            ++context.m_HitCountTable[ rule ];
+        }
+
+        bool ReducePower( Context & context, Base::ObjectRef<AST::Expression> & expression )
+        {
+            const std::vector<Base::ObjectRef<AST::Expression> >
+                * argument_table = GetIntrinsicArguments( context, *expression, "pow", 2 );
+            double
+                exponent;
+
+            if( !argument_table || !GetLiteralValue( exponent, *(*argument_table)[ 1 ] ) )
+            {
+                return false;
+            }
+
+            Base::ObjectRef<AST::Expression>
+                base = (*argument_table)[ 0 ];
+
+            if( exponent == 1.0 )
+            {
+                expression = base;
+                Hit( context, StrengthReducer::Rule_PowerIdentity );
+                return true;
+            }
+
+            if( exponent == 2.0 && IsSimple( *base ) )
+            {
+                expression = CreateMultiplication( &*base, base->Clone() );
+                Hit( context, StrengthReducer::Rule_PowerSquare );
+                return true;
+            }
+
+            if( !context.m_AllowsFastMath )
+            {
+                return false;
+            }
+
+            if( exponent == 3.0 && IsSimple( *base ) )
+            {
+                expression = CreateMultiplication( CreateMultiplication( &*base, base->Clone() ), base->Clone() );
+                Hit( context, StrengthReducer::Rule_PowerCube );
+                return true;
+            }
+
+            if( exponent == 0.5 )
+            {
+                expression = CreateCall( "sqrt", &*base );
+                Hit( context, StrengthReducer::Rule_PowerSquareRoot );
+                return true;
+            }
+
+            return false;
+        }
+
+        bool ReduceDivision( Context & context, Base::ObjectRef<AST::Expression> & expression )
+        {
+            AST::BinaryOperationExpression
+                & operation = static_cast<AST::BinaryOperationExpression &>( *expression );
+            const std::vector<Base::ObjectRef<AST::Expression> >
+                * argument_table = GetIntrinsicArguments( context, *operation.m_RightExpression, "sqrt", 1 );
+            double
+                value;
+
+            if( argument_table )
+            {
+                if( !context.m_AllowsFastMath
+                    || !GetLiteralValue( value, *operation.m_LeftExpression )
+                    || value != 1.0
+                    )
+                {
+                    return false;
+                }
+
+                Base::ObjectRef<AST::Expression>
+                    argument = (*argument_table)[ 0 ];
+
+                expression = CreateCall( "rsqrt", &*argument );
+                Hit( context, StrengthReducer::Rule_ReciprocalSquareRoot );
+                return true;
+            }
+
+            // An integer divisor may be an integer division
+            if( operation.m_RightExpression->m_Kind != AST::NodeKind_LiteralExpression
+                || static_cast<const AST::LiteralExpression &>( *operation.m_RightExpression ).m_Type != AST::LiteralExpression::Float
+                || !GetLiteralValue( value, *operation.m_RightExpression )
+                || value == 0.0
+                )
+            {
+                return false;
+            }
+
+            int
+                exponent;
+            const double
+                mantissa = std::frexp( value, &exponent );
+            const bool
+                is_exact = std::fabs( mantissa ) == 0.5 && exponent > -100 && exponent < 100;
+
+            if( !is_exact && !context.m_AllowsFastMath )
+            {
+                return false;
+            }
+
+            expression = CreateMultiplication( &*operation.m_LeftExpression, CreateFloatLiteral( 1.0 / value ) );
+            Hit( context, is_exact ? StrengthReducer::Rule_PowerOfTwoDivision : StrengthReducer::Rule_ConstantDivision );
+
+            return true;
+        }
+
+        bool ReduceMultiplication( Context & context, Base::ObjectRef<AST::Expression> & expression )
+        {
+            AST::BinaryOperationExpression
+                & operation = static_cast<AST::BinaryOperationExpression &>( *expression );
+            const std::vector<Base::ObjectRef<AST::Expression> >
+                * left_argument_table = GetIntrinsicArguments( context, *operation.m_LeftExpression, "length", 1 ),
+                * right_argument_table = GetIntrinsicArguments( context, *operation.m_RightExpression, "length", 1 );
+
+            if( !context.m_AllowsFastMath
+                || !left_argument_table
+                || !right_argument_table
+                || Print( *(*left_argument_table)[ 0 ] ) != Print( *(*right_argument_table)[ 0 ] )
+                )
+            {
+                return false;
+            }
+
+            Base::ObjectRef<AST::Expression>
+                left_argument = (*left_argument_table)[ 0 ],
+                right_argument = (*right_argument_table)[ 0 ];
+
+            expression = CreateCall( "dot", &*left_argument, &*right_argument );
+            Hit( context, StrengthReducer::Rule_LengthProduct );
+
+            return true;
+        }
+
+        bool ReduceOnce( Context & context, Base::ObjectRef<AST::Expression> & expression )
+        {
+            if( expression->m_Kind == AST::NodeKind_CallExpression )
+            {
+                return ReducePower( context, expression );
+            }
+
+            if( expression->m_Kind != AST::NodeKind_BinaryOperationExpression )
+            {
+                return false;
+            }
+
+            switch( static_cast<const AST::BinaryOperationExpression &>( *expression ).m_Operation )
+            {
+                case AST::BinaryOperationExpression::Division:
+                    return ReduceDivision( context, expression );
+
+                case AST::BinaryOperationExpression::Multiplication:
+                    return ReduceMultiplication( context, expression );
+
+                default:
+                    return false;
+            }
+        }
+
+        void ReduceExpression( Context & context, Base::ObjectRef<AST::Expression> & expression );
+
+        void ReduceArguments( Context & context, AST::ArgumentExpressionList * argument_list )
+        {
+            if( !argument_list )
+            {
+                return;
+            }
+
+            std::vector<Base::ObjectRef<AST::Expression> >::iterator it, end;
+
+            for( it = argument_list->m_ExpressionList.begin(), end = argument_list->m_ExpressionList.end(); it != end; ++it )
+            {
+                ReduceExpression( context, *it );
+            }
+        }
+
+        void ReduceLValue( Context & context, AST::LValueExpression & expression )
+        {
+            ReduceExpression( context, expression.m_VariableExpression->m_SubscriptExpression );
+        }
+
+        // The operands are reduced first, so the rules see their final form
+        void ReduceExpression( Context & context, Base::ObjectRef<AST::Expression> & expression )
+        {
+            if( !expression )
+            {
+                return;
+            }
+
+            switch( expression->m_Kind )
+            {
+                case AST::NodeKind_VariableExpression:
+                    ReduceExpression( context, static_cast<AST::VariableExpression &>( *expression ).m_SubscriptExpression );
+                    break;
+
+                case AST::NodeKind_BinaryOperationExpression:
+                {
+                    AST::BinaryOperationExpression
+                        & operation = static_cast<AST::BinaryOperationExpression &>( *expression );
+
+                    ReduceExpression( context, operation.m_LeftExpression );
+                    ReduceExpression( context, operation.m_RightExpression );
+                    break;
+                }
+
+                case AST::NodeKind_UnaryOperationExpression:
+                    ReduceExpression( context, static_cast<AST::UnaryOperationExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_CastExpression:
+                    ReduceExpression( context, static_cast<AST::CastExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_ConditionalExpression:
+                {
+                    AST::ConditionalExpression
+                        & conditional = static_cast<AST::ConditionalExpression &>( *expression );
+
+                    ReduceExpression( context, conditional.m_Condition );
+                    ReduceExpression( context, conditional.m_IfTrue );
+                    ReduceExpression( context, conditional.m_IfFalse );
+                    break;
+                }
+
+                case AST::NodeKind_CallExpression:
+                    ReduceArguments( context, &*static_cast<AST::CallExpression &>( *expression ).m_ArgumentExpressionList );
+                    break;
+
+                case AST::NodeKind_ConstructorExpression:
+                    ReduceArguments( context, &*static_cast<AST::ConstructorExpression &>( *expression ).m_ArgumentExpressionList );
+                    break;
+
+                case AST::NodeKind_PostfixExpression:
+                {
+                    AST::PostfixExpression
+                        & postfix = static_cast<AST::PostfixExpression &>( *expression );
+
+                    ReduceExpression( context, postfix.m_Expression );
+
+                    for( AST::PostfixSuffix * suffix = &*postfix.m_Suffix; suffix; )
+                    {
+                        if( suffix->m_Kind == AST::NodeKind_PostfixSuffixCall )
+                        {
+                            AST::PostfixSuffixCall
+                                & call = static_cast<AST::PostfixSuffixCall &>( *suffix );
+
+                            ReduceArguments( context, &*call.m_CallExpression->m_ArgumentExpressionList );
+                            suffix = &*call.m_Suffix;
+                        }
+                        else if( suffix->m_Kind == AST::NodeKind_PostfixSuffixVariable )
+                        {
+                            suffix = &*static_cast<AST::PostfixSuffixVariable &>( *suffix ).m_Suffix;
+                        }
+                        else
+                        {
+                            suffix = 0;
+                        }
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_PreModifyExpression:
+                    ReduceLValue( context, *static_cast<AST::PreModifyExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_PostModifyExpression:
+                    ReduceLValue( context, *static_cast<AST::PostModifyExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_AssignmentExpression:
+                {
+                    AST::AssignmentExpression
+                        & assignment = static_cast<AST::AssignmentExpression &>( *expression );
+
+                    ReduceLValue( context, *assignment.m_LValueExpression );
+                    ReduceExpression( context, assignment.m_Expression );
+                    break;
+                }
+
+                default:
+                    break;
+            }
+
+            while( ReduceOnce( context, expression ) )
+            {
+            }
+        }
+
+        void ReduceStatement( Context & context, AST::Statement * statement )
+        {
+            if( !statement )
+            {
+                return;
+            }
+
+            switch( statement->m_Kind )
+            {
+                case AST::NodeKind_ExpressionStatement:
+                    ReduceExpression( context, static_cast<AST::ExpressionStatement *>( statement )->m_Expression );
+                    break;
+
+                case AST::NodeKind_AssignmentStatement:
+                {
+                    AST::AssignmentExpression
+                        & assignment = *static_cast<AST::AssignmentStatement *>( statement )->m_Expression;
+
+                    ReduceLValue( context, *assignment.m_LValueExpression );
+                    ReduceExpression( context, assignment.m_Expression );
+                    break;
+                }
+
+                case AST::NodeKind_ReturnStatement:
+                    ReduceExpression( context, static_cast<AST::ReturnStatement *>( statement )->m_Expression );
+                    break;
+
+                case AST::NodeKind_IfStatement:
+                {
+                    AST::IfStatement
+                        & if_statement = *static_cast<AST::IfStatement *>( statement );
+
+                    ReduceExpression( context, if_statement.m_Condition );
+                    ReduceStatement( context, &*if_statement.m_ThenStatement );
+                    ReduceStatement( context, &*if_statement.m_ElseStatement );
+                    break;
+                }
+
+                case AST::NodeKind_WhileStatement:
+                {
+                    AST::WhileStatement
+                        & while_statement = *static_cast<AST::WhileStatement *>( statement );
+
+                    ReduceExpression( context, while_statement.m_Condition );
+                    ReduceStatement( context, &*while_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_DoWhileStatement:
+                {
+                    AST::DoWhileStatement
+                        & do_while_statement = *static_cast<AST::DoWhileStatement *>( statement );
+
+                    ReduceStatement( context, &*do_while_statement.m_Statement );
+                    ReduceExpression( context, do_while_statement.m_Condition );
+                    break;
+                }
+
+                case AST::NodeKind_ForStatement:
+                {
+                    AST::ForStatement
+                        & for_statement = *static_cast<AST::ForStatement *>( statement );
+
+                    ReduceStatement( context, &*for_statement.m_InitStatement );
+                    ReduceExpression( context, for_statement.m_EqualityExpression );
+                    ReduceExpression( context, for_statement.m_ModifyExpression );
+                    ReduceStatement( context, &*for_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_BlockStatement:
+                {
+                    std::vector<Base::ObjectRef<AST::Statement> >::iterator it, end;
+                    AST::BlockStatement
+                        & block = *static_cast<AST::BlockStatement *>( statement );
+
+                    for( it = block.m_StatementTable.begin(), end = block.m_StatementTable.end(); it != end; ++it )
+                    {
+                        ReduceStatement( context, &**it );
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_VariableDeclarationStatement:
+                {
+                    AST::VariableDeclarationStatement
+                        & declaration = *static_cast<AST::VariableDeclarationStatement *>( statement );
+                    std::vector<Base::ObjectRef<AST::VariableDeclarationBody> >::iterator it, end;
+
+                    for( it = declaration.m_BodyTable.begin(), end = declaration.m_BodyTable.end(); it != end; ++it )
+                    {
+                        if( !(*it)->m_InitialValue )
+                        {
+                            continue;
+                        }
+
+                        std::vector<Base::ObjectRef<AST::Expression> >::iterator expression_it, expression_end;
+
+                        expression_it = (*it)->m_InitialValue->m_ExpressionTable.begin();
+                        expression_end = (*it)->m_InitialValue->m_ExpressionTable.end();
+
+                        for( ; expression_it != expression_end; ++expression_it )
+                        {
+                            ReduceExpression( context, *expression_it );
+                        }
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+    }
+
+    void StrengthReducer::Reduce( AST::TranslationUnit & translation_unit )
+    {
+        Base::ScopedTimer
+            timer( "reduce_strength" );
+        Context
+            context;
+        std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::iterator it, end;
+
+        ResetHitCounts();
+
+        context.m_AllowsFastMath = m_AllowsFastMath;
+        context.m_HitCountTable = m_HitCountTable;
+
+        // Functions named like an intrinsic hide it
+        for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            if( const AST::FunctionDeclaration * function = dynamic_cast<const AST::FunctionDeclaration *>( &**it ) )
+            {
+                context.m_FunctionNameSet.insert( function->m_Name );
+            }
+        }
+
+        for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            AST::FunctionDeclaration
+                * function = dynamic_cast<AST::FunctionDeclaration *>( &**it );
+
+            if( !function )
+            {
+                continue;
+            }
+
+            function->ResolveBody();
+
+            for( size_t index = 0; index < function->m_StatementTable.size(); ++index )
+            {
+                ReduceStatement( context, &*function->m_StatementTable[ index ] );
+            }
+        }
+
+        for( int rule = 0; rule < Rule_Count; ++rule )
+        {
+            if( m_HitCountTable[ rule ] > 0 )
+            {
+                Base::Statistics::AddCount( HitCountNameTable[ rule ], m_HitCountTable[ rule ] );
+            }
+        }
+    }
+
+    int StrengthReducer::GetTotalHitCount() const
+    {
+        int
+            count = 0;
+
+        for( int rule = 0; rule < Rule_Count; ++rule )
+        {
+            count += m_HitCountTable[ rule ];
+        }
+
+        return count;
+    }
+
+    void StrengthReducer::ResetHitCounts()
+    {
+        for( int rule = 0; rule < Rule_Count; ++rule )
+        {
+            m_HitCountTable[ rule ] = 0;
+        }
+    }
+}
\ No newline at end of file
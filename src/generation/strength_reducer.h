@@ -0,0 +1,67 @@
+#ifndef STRENGTH_REDUCER_H
+    #define STRENGTH_REDUCER_H
+
+    #include <ast/node.h>
+
+    namespace Generation
+    {
+        // Rewrites the intrinsic calls and the operations of the generated functions
+        // into cheaper equivalent forms.
+        //
+        // By default only the rewrites giving the same result are made. The fast math
+        // ones may change the rounding, or use the approximated intrinsics, and must
+        // be allowed. An operand is only duplicated when it is a variable, a swizzle,
+        // a member or a literal.
+
+        class StrengthReducer
+        {
+        public:
+
+            enum Rule
+            {
+                // pow( x, 1 ) -> x
+                Rule_PowerIdentity,
+                // pow( x, 2 ) -> x * x
+                Rule_PowerSquare,
+                // x / 4.0 -> x * 0.25
+                Rule_PowerOfTwoDivision,
+                // Fast math, pow( x, 3 ) -> x * x * x
+                Rule_PowerCube,
+                // Fast math, pow( x, 0.5 ) -> sqrt( x )
+                Rule_PowerSquareRoot,
+                // Fast math, x / 3.0 -> x * 0.333333333
+                Rule_ConstantDivision,
+                // Fast math, length( v ) * length( v ) -> dot( v, v )
+                Rule_LengthProduct,
+                // Fast math, 1 / sqrt( x ) -> rsqrt( x )
+                Rule_ReciprocalSquareRoot,
+                Rule_Count
+            };
+
+            StrengthReducer() :
+                m_AllowsFastMath( false )
+            {
+                ResetHitCounts();
+            }
+
+            void SetFastMath( const bool allows_fast_math ) { m_AllowsFastMath = allows_fast_math; }
+
+            void Reduce( AST::TranslationUnit & translation_unit );
+
+            // Rewrites of the last reduction, also added to the statistics as the
+            // strength_reduction_<rule>_count counters
+            int GetHitCount( const Rule rule ) const { return m_HitCountTable[ rule ]; }
+            int GetTotalHitCount() const;
+
+        private:
+
+            void ResetHitCounts();
+
+            bool
+                m_AllowsFastMath;
+            int
+                m_HitCountTable[ Rule_Count ];
+        };
+    }
+
+#endif
\ No newline at end of file
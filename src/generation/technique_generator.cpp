@@ -1,5 +1,8 @@
 #include "technique_generator.h"
 #include "code_generator.h"
+#include "interpolator_packer.h"
+#include "preshader_extractor.h"
+#include <base/text_error_handler.h>
 
 namespace Generation
 {
@@ -18,6 +21,22 @@ namespace Generation
         std::vector<std::string>
             interpolator_semantic_list;
 
+        code_generator.SetCostEstimator( m_CostEstimator );
+        code_generator.SetCheapestSelection( m_CostEstimator != 0 );
+        code_generator.SetCallScheduling( m_SchedulesCalls );
+        code_generator.SetLoopUnrolling( m_MaximumUnrolledStatementCount );
+        code_generator.SetStrengthReduction( m_ReducesStrength );
+        code_generator.SetFastMath( m_AllowsFastMath );
+        code_generator.SetVectorNarrowing( m_NarrowsVectors );
+        code_generator.SetTextureFetchHoisting( m_MaximumInFlightFetchCount );
+
+        m_SearchedSemanticSet.clear();
+        m_UnpackedInterpolatorSlotCount = 0;
+        m_InterpolatorSlotCount = 0;
+        m_VertexPreshaderOperationCount = 0;
+        m_PixelPreshaderOperationCount = 0;
+        m_MovedFunctionTable.clear();
+
         std::copy(
             m_InputSemanticTable.begin(),
             m_InputSemanticTable.end(),
@@ -39,11 +58,22 @@ namespace Generation
             error_handler
             );
 
+        m_SearchedSemanticSet = code_generator.GetSearchedSemanticSet();
+
         if( !pixel_program )
         {
             return false;
         }
 
+        if( m_MovesToVertexStage
+            && MoveToVertexStage( vertex_program, pixel_program, input_semantic_table, interpolator_semantic_list, definition_table )
+            )
+        {
+            ExtractPreshader( *vertex_program, *pixel_program );
+            return true;
+        }
+
+        code_generator.SetTextureFetchHoisting( 0 );
         code_generator.GenerateShader(
             vertex_program,
             input_semantic_table,
@@ -53,13 +83,135 @@ namespace Generation
             error_handler
             );
 
+        m_SearchedSemanticSet.insert( code_generator.GetSearchedSemanticSet().begin(), code_generator.GetSearchedSemanticSet().end() );
+
         if( !vertex_program )
         {
             pixel_program = 0;
             return false;
         }
 
+        PackInterpolators( *vertex_program, *pixel_program );
+        ExtractPreshader( *vertex_program, *pixel_program );
+
         return true;
     }
 
+    bool TechniqueGenerator::MoveToVertexStage(
+        Base::ObjectRef<AST::TranslationUnit> & vertex_program,
+        Base::ObjectRef<AST::TranslationUnit> & pixel_program,
+        std::vector<std::string> & input_semantic_table,
+        const std::vector<std::string> & interpolator_semantic_list,
+        const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table
+        ) const
+    {
+        VertexStageMover
+            mover;
+        std::vector<std::string>
+            moved_interpolator_semantic_list = interpolator_semantic_list,
+            moved_pixel_used_semantic_set,
+            moved_input_semantic_table;
+        Base::ObjectRef<AST::TranslationUnit>
+            moved_vertex_program,
+            moved_pixel_program;
+        Base::ObjectRef<Base::TextErrorHandler>
+            error_handler = new Base::TextErrorHandler;
+        Generation::CodeGenerator
+            code_generator;
+
+        code_generator.SetCostEstimator( m_CostEstimator );
+        code_generator.SetCheapestSelection( m_CostEstimator != 0 );
+        code_generator.SetCallScheduling( m_SchedulesCalls );
+        code_generator.SetLoopUnrolling( m_MaximumUnrolledStatementCount );
+        code_generator.SetStrengthReduction( m_ReducesStrength );
+        code_generator.SetFastMath( m_AllowsFastMath );
+        code_generator.SetVectorNarrowing( m_NarrowsVectors );
+        code_generator.SetTextureFetchHoisting( m_MaximumInFlightFetchCount );
+        mover.FindMovableSemantics( moved_interpolator_semantic_list, *pixel_program );
+
+        if( mover.GetMovedFunctionTable().empty() )
+        {
+            return false;
+        }
+
+        // Both programs are generated again, and the original ones are kept when the
+        // vertex program can not produce the moved semantics
+        code_generator.GenerateShader(
+            moved_pixel_program,
+            moved_pixel_used_semantic_set,
+            definition_table,
+            m_OutputSemanticTable,
+            moved_interpolator_semantic_list,
+            *error_handler
+            );
+
+        if( !moved_pixel_program )
+        {
+            return false;
+        }
+
+        m_SearchedSemanticSet.insert( code_generator.GetSearchedSemanticSet().begin(), code_generator.GetSearchedSemanticSet().end() );
+
+        code_generator.SetTextureFetchHoisting( 0 );
+        code_generator.GenerateShader(
+            moved_vertex_program,
+            moved_input_semantic_table,
+            definition_table,
+            moved_pixel_used_semantic_set,
+            m_InputSemanticTable,
+            *error_handler
+            );
+
+        m_SearchedSemanticSet.insert( code_generator.GetSearchedSemanticSet().begin(), code_generator.GetSearchedSemanticSet().end() );
+
+        if( !moved_vertex_program )
+        {
+            return false;
+        }
+
+        vertex_program = moved_vertex_program;
+        pixel_program = moved_pixel_program;
+        input_semantic_table = moved_input_semantic_table;
+        m_MovedFunctionTable = mover.GetMovedFunctionTable();
+
+        PackInterpolators( *vertex_program, *pixel_program );
+
+        return true;
+    }
+
+    void TechniqueGenerator::PackInterpolators(
+        AST::TranslationUnit & vertex_program,
+        AST::TranslationUnit & pixel_program
+        ) const
+    {
+        if( !m_PacksInterpolators )
+        {
+            return;
+        }
+
+        InterpolatorPacker
+            packer;
+
+        packer.Pack( vertex_program, pixel_program );
+
+        m_UnpackedInterpolatorSlotCount = packer.GetUnpackedSlotCount();
+        m_InterpolatorSlotCount = packer.GetSlotCount();
+    }
+
+    // The programs generated by MoveToVertexStage may be dropped, so the extraction
+    // waits for the final ones
+    void TechniqueGenerator::ExtractPreshader(
+        AST::TranslationUnit & vertex_program,
+        AST::TranslationUnit & pixel_program
+        ) const
+    {
+        if( !m_PreshaderExtractor )
+        {
+            return;
+        }
+
+        m_VertexPreshaderOperationCount = m_PreshaderExtractor->Extract( vertex_program );
+        m_PixelPreshaderOperationCount = m_PreshaderExtractor->Extract( pixel_program );
+    }
+
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <set>
 #include <string>
 #include <vector>
 #include <ast/node.h>
@@ -7,17 +8,38 @@
 #include <base/error_handler_interface.h>
 #include "function_definition.h"
 #include "graph.h"
+#include "vertex_stage_mover.h"
 
 namespace AST{struct FunctionDeclaration;}
 
 namespace Generation
 {
     struct CodeGeneratorHelper;
+    class CostEstimator;
+    class PreshaderExtractor;
 
     class TechniqueGenerator
     {
     public:
 
+        TechniqueGenerator() :
+            m_PacksInterpolators( false ),
+            m_MovesToVertexStage( false ),
+            m_SchedulesCalls( false ),
+            m_ReducesStrength( false ),
+            m_AllowsFastMath( false ),
+            m_NarrowsVectors( false ),
+            m_CostEstimator( 0 ),
+            m_PreshaderExtractor( 0 ),
+            m_MaximumUnrolledStatementCount( 0 ),
+            m_MaximumInFlightFetchCount( 0 ),
+            m_UnpackedInterpolatorSlotCount( 0 ),
+            m_InterpolatorSlotCount( 0 ),
+            m_VertexPreshaderOperationCount( 0 ),
+            m_PixelPreshaderOperationCount( 0 )
+        {
+        }
+
         void SetInputSemanticTable(
             const std::vector<std::string> & input_semantic_table
             )
@@ -39,6 +61,68 @@ namespace Generation
             m_InterpolatorSemanticTable = interpolator_semantic_table;
         }
 
+        // Packs the semantics passed to the pixel program into float4 interpolators
+        void SetInterpolatorPacking( const bool packs_interpolators )
+        {
+            m_PacksInterpolators = packs_interpolators;
+        }
+
+        // Computes the affine pixel functions of interpolated semantics per vertex
+        void SetVertexStageMoving( const bool moves_to_vertex_stage )
+        {
+            m_MovesToVertexStage = moves_to_vertex_stage;
+        }
+
+        // Chooses the cheapest function generating each semantic when an estimator is
+        // given, see CodeGenerator::SetCheapestSelection
+        void SetCostEstimator( CostEstimator * estimator )
+        {
+            m_CostEstimator = estimator;
+        }
+
+        // See CodeGenerator::SetCallScheduling
+        void SetCallScheduling( const bool schedules_calls )
+        {
+            m_SchedulesCalls = schedules_calls;
+        }
+
+        // See CodeGenerator::SetLoopUnrolling
+        void SetLoopUnrolling( const int maximum_statement_count )
+        {
+            m_MaximumUnrolledStatementCount = maximum_statement_count;
+        }
+
+        // See CodeGenerator::SetStrengthReduction
+        void SetStrengthReduction( const bool reduces_strength )
+        {
+            m_ReducesStrength = reduces_strength;
+        }
+
+        // See CodeGenerator::SetFastMath
+        void SetFastMath( const bool allows_fast_math )
+        {
+            m_AllowsFastMath = allows_fast_math;
+        }
+
+        // See CodeGenerator::SetVectorNarrowing
+        void SetVectorNarrowing( const bool narrows_vectors )
+        {
+            m_NarrowsVectors = narrows_vectors;
+        }
+
+        // Only applied to the pixel program, see CodeGenerator::SetTextureFetchHoisting
+        void SetTextureFetchHoisting( const int maximum_in_flight_count )
+        {
+            m_MaximumInFlightFetchCount = maximum_in_flight_count;
+        }
+
+        // Applied to both final programs, once the functions are moved and the
+        // interpolators packed, see CodeGenerator::SetPreshaderExtractor
+        void SetPreshaderExtractor( PreshaderExtractor * extractor )
+        {
+            m_PreshaderExtractor = extractor;
+        }
+
         bool Generate(
             Base::ObjectRef<AST::TranslationUnit> & vertex_program,
             Base::ObjectRef<AST::TranslationUnit> & pixel_program,
@@ -47,12 +131,73 @@ namespace Generation
             Base::ErrorHandlerInterface & error_handler
             ) const;
 
+        // Union of the semantics searched by both programs of the last generation
+        const std::set<std::string> & GetSearchedSemanticSet() const
+        {
+            return m_SearchedSemanticSet;
+        }
+
+        // Interpolator registers of the last generation, before and after packing
+        int GetUnpackedInterpolatorSlotCount() const { return m_UnpackedInterpolatorSlotCount; }
+        int GetInterpolatorSlotCount() const { return m_InterpolatorSlotCount; }
+
+        // Operations moved to the preshader by the last generation
+        int GetVertexPreshaderOperationCount() const { return m_VertexPreshaderOperationCount; }
+        int GetPixelPreshaderOperationCount() const { return m_PixelPreshaderOperationCount; }
+
+        // Functions of the last generation computed in the vertex program
+        const std::vector<VertexStageMover::MovedFunction> & GetMovedFunctionTable() const
+        {
+            return m_MovedFunctionTable;
+        }
+
     private:
 
+        bool MoveToVertexStage(
+            Base::ObjectRef<AST::TranslationUnit> & vertex_program,
+            Base::ObjectRef<AST::TranslationUnit> & pixel_program,
+            std::vector<std::string> & input_semantic_table,
+                const std::vector<std::string> & interpolator_semantic_list,
+            const std::vector<Base::ObjectRef<FragmentDefinition> > & definition_table
+            ) const;
+
+        void PackInterpolators(
+            AST::TranslationUnit & vertex_program,
+            AST::TranslationUnit & pixel_program
+            ) const;
+
+        void ExtractPreshader(
+            AST::TranslationUnit & vertex_program,
+            AST::TranslationUnit & pixel_program
+            ) const;
+
         std::vector<std::string>
             m_OutputSemanticTable,
             m_InterpolatorSemanticTable,
             m_InputSemanticTable;
+        mutable std::set<std::string>
+            m_SearchedSemanticSet;
+        bool
+            m_PacksInterpolators,
+            m_MovesToVertexStage,
+            m_SchedulesCalls,
+            m_ReducesStrength,
+            m_AllowsFastMath,
+            m_NarrowsVectors;
+        CostEstimator
+            * m_CostEstimator;
+        PreshaderExtractor
+            * m_PreshaderExtractor;
+        int
+            m_MaximumUnrolledStatementCount,
+            m_MaximumInFlightFetchCount;
+        mutable int
+            m_UnpackedInterpolatorSlotCount,
+            m_InterpolatorSlotCount,
+            m_VertexPreshaderOperationCount,
+            m_PixelPreshaderOperationCount;
+        mutable std::vector<VertexStageMover::MovedFunction>
+            m_MovedFunctionTable;
 
     };
 
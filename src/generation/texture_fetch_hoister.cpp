@@ -0,0 +1,600 @@
+#include "texture_fetch_hoister.h"
+
+#include "pass_helpers.h"
+#include <ast/function_node.h>
+#include <base/statistics.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace Generation
+{
+    namespace
+    {
+        const char
+            // They return the element type of their texture
+            * const SampleMethodTable[] =
+            {
+                "Sample", "SampleBias", "SampleGrad", "SampleLevel"
+            },
+            // Their elements are float4 when no type is given
+            * const TextureTypeTable[] =
+            {
+                "Texture", "Texture1D", "Texture1DArray", "Texture2D", "Texture2DArray", "Texture3D", "TextureCube"
+            };
+
+        bool Intersects( const std::set<std::string> & first, const std::set<std::string> & second )
+        {
+            std::set<std::string>::const_iterator it, end;
+
+            for( it = first.begin(), end = first.end(); it != end; ++it )
+            {
+                if( second.find( *it ) != second.end() )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        struct Fetch
+        {
+            Base::ObjectRef<AST::Expression>
+                * m_Expression;
+            std::string
+                m_Type;
+        };
+
+        std::string RemoveSpaces( const std::string & text )
+        {
+            const size_t
+                first = text.find_first_not_of( ' ' );
+
+            if( first == std::string::npos )
+            {
+                return "";
+            }
+
+            return text.substr( first, text.find_last_not_of( ' ' ) - first + 1 );
+        }
+
+        // Type of the texture elements, empty when unknown
+        std::string GetElementType( const std::string & texture_type )
+        {
+            const size_t
+                first = texture_type.find( '<' ),
+                last = texture_type.rfind( '>' );
+
+            if( first == std::string::npos )
+            {
+                return Contains( TextureTypeTable, texture_type ) ? "float4" : "";
+            }
+
+            if( last == std::string::npos
+                || last < first
+                || !Contains( TextureTypeTable, RemoveSpaces( texture_type.substr( 0, first ) ) )
+                )
+            {
+                return "";
+            }
+
+            return RemoveSpaces( texture_type.substr( first + 1, last - first - 1 ) );
+        }
+
+        void AddTexture(
+            std::map<std::string, std::string> & element_type_table,
+            const std::string & texture_type,
+            const std::string & name
+            )
+        {
+            const std::string
+                element_type = GetElementType( texture_type );
+
+            if( !element_type.empty() )
+            {
+                element_type_table[ name ] = element_type;
+            }
+        }
+
+        // Textures declared as globals, or as variables of a texture type
+        void FindTextures(
+            std::map<std::string, std::string> & element_type_table,
+            const AST::TranslationUnit & translation_unit
+            )
+        {
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+
+            for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+            {
+                if( (*it)->m_Kind == AST::NodeKind_TextureDeclaration )
+                {
+                    const AST::TextureDeclaration
+                        & declaration = static_cast<const AST::TextureDeclaration &>( **it );
+
+                    AddTexture( element_type_table, declaration.m_Type, declaration.m_Name );
+                }
+                else if( (*it)->m_Kind == AST::NodeKind_VariableDeclaration )
+                {
+                    const AST::VariableDeclaration
+                        & declaration = static_cast<const AST::VariableDeclaration &>( **it );
+
+                    for( size_t index = 0; declaration.m_Type && index < declaration.m_BodyTable.size(); ++index )
+                    {
+                        AddTexture( element_type_table, declaration.m_Type->m_Name, declaration.m_BodyTable[ index ]->m_Name );
+                    }
+                }
+            }
+        }
+
+        // The type of the fetch result is the element type of the texture, a fetch
+        // from an unknown texture is not moved
+        bool IsTextureFetch(
+            std::string & type,
+            const AST::Expression & expression,
+            const std::set<std::string> & function_name_set,
+            const std::map<std::string, std::string> & element_type_table
+            )
+        {
+            if( expression.m_Kind == AST::NodeKind_CallExpression )
+            {
+                const std::string
+                    & name = static_cast<const AST::CallExpression &>( expression ).m_Name;
+
+                type = "float4";
+
+                return IsTextureFetchIntrinsic( name ) && function_name_set.find( name ) == function_name_set.end();
+            }
+
+            if( expression.m_Kind != AST::NodeKind_PostfixExpression )
+            {
+                return false;
+            }
+
+            const AST::PostfixExpression
+                & postfix = static_cast<const AST::PostfixExpression &>( expression );
+
+            if( postfix.m_Expression->m_Kind != AST::NodeKind_VariableExpression
+                || !postfix.m_Suffix
+                || postfix.m_Suffix->m_Kind != AST::NodeKind_PostfixSuffixCall
+                )
+            {
+                return false;
+            }
+
+            const AST::PostfixSuffixCall
+                & suffix = static_cast<const AST::PostfixSuffixCall &>( *postfix.m_Suffix );
+            const AST::VariableExpression
+                & texture = static_cast<const AST::VariableExpression &>( *postfix.m_Expression );
+            std::map<std::string, std::string>::const_iterator
+                element_type = element_type_table.find( texture.m_Name );
+
+            if( suffix.m_Suffix
+                || !Contains( SampleMethodTable, suffix.m_CallExpression->m_Name )
+                || texture.m_SubscriptExpression
+                || element_type == element_type_table.end()
+                )
+            {
+                return false;
+            }
+
+            type = (*element_type).second;
+
+            return true;
+        }
+
+        void FindFetches(
+            std::vector<Fetch> & fetch_table,
+            Base::ObjectRef<AST::Expression> & expression,
+            const std::set<std::string> & function_name_set,
+            const std::map<std::string, std::string> & element_type_table
+            );
+
+        void FindFetches(
+            std::vector<Fetch> & fetch_table,
+            AST::ArgumentExpressionList * argument_list,
+            const std::set<std::string> & function_name_set,
+            const std::map<std::string, std::string> & element_type_table
+            )
+        {
+            if( !argument_list )
+            {
+                return;
+            }
+
+            std::vector<Base::ObjectRef<AST::Expression> >::iterator it, end;
+
+            for( it = argument_list->m_ExpressionList.begin(), end = argument_list->m_ExpressionList.end(); it != end; ++it )
+            {
+                FindFetches( fetch_table, *it, function_name_set, element_type_table );
+            }
+        }
+
+        // Fetches nested in other fetches move with them. Assignments are left in place.
+        void FindFetches(
+            std::vector<Fetch> & fetch_table,
+            Base::ObjectRef<AST::Expression> & expression,
+            const std::set<std::string> & function_name_set,
+            const std::map<std::string, std::string> & element_type_table
+            )
+        {
+            Fetch
+                fetch;
+
+            if( !expression )
+            {
+                return;
+            }
+
+            if( IsTextureFetch( fetch.m_Type, *expression, function_name_set, element_type_table ) )
+            {
+                fetch.m_Expression = &expression;
+                fetch_table.push_back( fetch );
+                return;
+            }
+
+            switch( expression->m_Kind )
+            {
+                case AST::NodeKind_BinaryOperationExpression:
+                {
+                    AST::BinaryOperationExpression
+                        & operation = static_cast<AST::BinaryOperationExpression &>( *expression );
+
+                    FindFetches( fetch_table, operation.m_LeftExpression, function_name_set, element_type_table );
+                    FindFetches( fetch_table, operation.m_RightExpression, function_name_set, element_type_table );
+                    break;
+                }
+
+                case AST::NodeKind_UnaryOperationExpression:
+                    FindFetches( fetch_table, static_cast<AST::UnaryOperationExpression &>( *expression ).m_Expression, function_name_set, element_type_table );
+                    break;
+
+                case AST::NodeKind_CastExpression:
+                    FindFetches( fetch_table, static_cast<AST::CastExpression &>( *expression ).m_Expression, function_name_set, element_type_table );
+                    break;
+
+                case AST::NodeKind_ConditionalExpression:
+                {
+                    AST::ConditionalExpression
+                        & conditional = static_cast<AST::ConditionalExpression &>( *expression );
+
+                    FindFetches( fetch_table, conditional.m_Condition, function_name_set, element_type_table );
+                    FindFetches( fetch_table, conditional.m_IfTrue, function_name_set, element_type_table );
+                    FindFetches( fetch_table, conditional.m_IfFalse, function_name_set, element_type_table );
+                    break;
+                }
+
+                case AST::NodeKind_CallExpression:
+                    FindFetches( fetch_table, &*static_cast<AST::CallExpression &>( *expression ).m_ArgumentExpressionList, function_name_set, element_type_table );
+                    break;
+
+                case AST::NodeKind_ConstructorExpression:
+                    FindFetches( fetch_table, &*static_cast<AST::ConstructorExpression &>( *expression ).m_ArgumentExpressionList, function_name_set, element_type_table );
+                    break;
+
+                case AST::NodeKind_PostfixExpression:
+                    FindFetches( fetch_table, static_cast<AST::PostfixExpression &>( *expression ).m_Expression, function_name_set, element_type_table );
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        // Expressions evaluated every time the statement runs, before it writes anything
+        void FindEvaluatedExpressions(
+            std::vector<Base::ObjectRef<AST::Expression> *> & expression_table,
+            AST::Statement & statement
+            )
+        {
+            switch( statement.m_Kind )
+            {
+                case AST::NodeKind_ExpressionStatement:
+                    expression_table.push_back( &static_cast<AST::ExpressionStatement &>( statement ).m_Expression );
+                    break;
+
+                case AST::NodeKind_AssignmentStatement:
+                    expression_table.push_back( &static_cast<AST::AssignmentStatement &>( statement ).m_Expression->m_Expression );
+                    break;
+
+                case AST::NodeKind_ReturnStatement:
+                    expression_table.push_back( &static_cast<AST::ReturnStatement &>( statement ).m_Expression );
+                    break;
+
+                case AST::NodeKind_IfStatement:
+                    expression_table.push_back( &static_cast<AST::IfStatement &>( statement ).m_Condition );
+                    break;
+
+                case AST::NodeKind_VariableDeclarationStatement:
+                {
+                    AST::VariableDeclarationStatement
+                        & declaration = static_cast<AST::VariableDeclarationStatement &>( statement );
+                    std::vector<Base::ObjectRef<AST::VariableDeclarationBody> >::iterator it, end;
+
+                    for( it = declaration.m_BodyTable.begin(), end = declaration.m_BodyTable.end(); it != end; ++it )
+                    {
+                        if( !(*it)->m_InitialValue )
+                        {
+                            continue;
+                        }
+
+                        std::vector<Base::ObjectRef<AST::Expression> >::iterator expression_it, expression_end;
+
+                        expression_it = (*it)->m_InitialValue->m_ExpressionTable.begin();
+                        expression_end = (*it)->m_InitialValue->m_ExpressionTable.end();
+
+                        for( ; expression_it != expression_end; ++expression_it )
+                        {
+                            expression_table.push_back( &*expression_it );
+                        }
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        // Static globals are the only ones a called function can write
+        void FindWritableGlobals(
+            std::set<std::string> & variable_set,
+            const AST::TranslationUnit & translation_unit
+            )
+        {
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+
+            for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+            {
+                const AST::VariableDeclaration
+                    * declaration = dynamic_cast<const AST::VariableDeclaration *>( &**it );
+
+                if( !declaration )
+                {
+                    continue;
+                }
+
+                bool
+                    is_static = false,
+                    is_const = false;
+
+                for( size_t index = 0; index < declaration->m_StorageClass.size(); ++index )
+                {
+                    is_static = is_static || declaration->m_StorageClass[ index ]->m_Value == "static";
+                }
+
+                for( size_t index = 0; index < declaration->m_TypeModifier.size(); ++index )
+                {
+                    is_const = is_const || declaration->m_TypeModifier[ index ]->m_Value == "const";
+                }
+
+                if( is_static && !is_const )
+                {
+                    for( size_t index = 0; index < declaration->m_BodyTable.size(); ++index )
+                    {
+                        variable_set.insert( declaration->m_BodyTable[ index ]->m_Name );
+                    }
+                }
+            }
+        }
+    }
+
+    void TextureFetchHoister::Hoist( AST::TranslationUnit & translation_unit )
+    {
+        Base::ScopedTimer
+            timer( "hoist_texture_fetches" );
+        std::set<std::string>
+            function_name_set,
+            writable_global_set,
+            used_name_set;
+        std::map<std::string, std::string>
+            element_type_table;
+        std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::iterator it, end;
+        int
+            hoisted_distance = 0,
+            name_index = 0;
+
+        m_HoistedFetchCount = 0;
+
+        for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            if( const AST::FunctionDeclaration * function = dynamic_cast<const AST::FunctionDeclaration *>( &**it ) )
+            {
+                function_name_set.insert( function->m_Name );
+            }
+        }
+
+        FindWritableGlobals( writable_global_set, translation_unit );
+        FindTextures( element_type_table, translation_unit );
+
+        // Also parses the deferred function bodies
+        {
+            Effect
+                effect;
+            EffectCollector
+                collector( effect, function_name_set );
+
+            collector.Dispatch( translation_unit );
+            used_name_set = effect.m_ReadVariableSet;
+            used_name_set.insert( effect.m_DeclaredVariableSet.begin(), effect.m_DeclaredVariableSet.end() );
+            used_name_set.insert( function_name_set.begin(), function_name_set.end() );
+        }
+
+        for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            AST::FunctionDeclaration
+                * function = dynamic_cast<AST::FunctionDeclaration *>( &**it );
+
+            if( !function )
+            {
+                continue;
+            }
+
+            std::vector<Base::ObjectRef<AST::Statement> >
+                & statement_table = function->m_StatementTable;
+            std::vector<Effect>
+                effect_table( statement_table.size() );
+            std::vector<int>
+                in_flight_count_table( statement_table.size(), 0 );
+            std::vector<std::vector<Base::ObjectRef<AST::Statement> > >
+                hoisted_statement_table( statement_table.size() );
+            std::map<std::string, std::string>
+                function_element_type_table( element_type_table );
+
+            if( function->m_ArgumentList )
+            {
+                std::vector<Base::ObjectRef<AST::Argument> >::const_iterator argument_it, argument_end;
+
+                argument_it = function->m_ArgumentList->m_ArgumentTable.begin();
+                argument_end = function->m_ArgumentList->m_ArgumentTable.end();
+
+                for( ; argument_it != argument_end; ++argument_it )
+                {
+                    function_element_type_table.erase( (*argument_it)->m_Name );
+
+                    if( (*argument_it)->m_Type )
+                    {
+                        AddTexture( function_element_type_table, (*argument_it)->m_Type->m_Name, (*argument_it)->m_Name );
+                    }
+                }
+            }
+
+            for( size_t index = 0; index < statement_table.size(); ++index )
+            {
+                EffectCollector
+                    collector( effect_table[ index ], function_name_set );
+
+                collector.Dispatch( *statement_table[ index ] );
+            }
+
+            for( size_t index = 0; index < statement_table.size(); ++index )
+            {
+                std::vector<Base::ObjectRef<AST::Expression> *>
+                    expression_table;
+                std::vector<Fetch>
+                    fetch_table;
+                Effect
+                    statement_effect;
+                EffectCollector
+                    statement_collector( statement_effect, function_name_set );
+
+                FindEvaluatedExpressions( expression_table, *statement_table[ index ] );
+
+                // Writes inside the statement may happen before a fetch is evaluated
+                for( size_t expression = 0; expression < expression_table.size(); ++expression )
+                {
+                    if( *expression_table[ expression ] )
+                    {
+                        statement_collector.Dispatch( **expression_table[ expression ] );
+                        FindFetches( fetch_table, *expression_table[ expression ], function_name_set, function_element_type_table );
+                    }
+                }
+
+                if( statement_table[ index ]->m_Kind == AST::NodeKind_VariableDeclarationStatement )
+                {
+                    statement_collector.Dispatch( *statement_table[ index ] );
+                }
+
+                for( size_t fetch = 0; fetch < fetch_table.size(); ++fetch )
+                {
+                    Effect
+                        fetch_effect;
+                    EffectCollector
+                        fetch_collector( fetch_effect, function_name_set );
+                    size_t
+                        position = index;
+
+                    fetch_collector.Dispatch( **fetch_table[ fetch ].m_Expression );
+
+                    if( fetch_effect.m_CallsFunction
+                        || !fetch_effect.m_WrittenVariableSet.empty()
+                        || Intersects( fetch_effect.m_ReadVariableSet, statement_effect.m_WrittenVariableSet )
+                        || ( statement_effect.m_CallsFunction && Intersects( fetch_effect.m_ReadVariableSet, writable_global_set ) )
+                        )
+                    {
+                        continue;
+                    }
+
+                    while( position > 0 )
+                    {
+                        const Effect
+                            & effect = effect_table[ position - 1 ];
+
+                        if( effect.m_Exits
+                            || Intersects( fetch_effect.m_ReadVariableSet, effect.m_WrittenVariableSet )
+                            || ( effect.m_CallsFunction && Intersects( fetch_effect.m_ReadVariableSet, writable_global_set ) )
+                            )
+                        {
+                            break;
+                        }
+
+                        --position;
+                    }
+
+                    for( size_t statement = index; statement > position; --statement )
+                    {
+                        if( in_flight_count_table[ statement - 1 ] >= m_MaximumInFlightCount )
+                        {
+                            position = statement;
+                            break;
+                        }
+                    }
+
+                    if( position == index )
+                    {
+                        continue;
+                    }
+
+                    std::string
+                        name;
+
+                    do
+                    {
+                        std::ostringstream
+                            stream;
+
+                        stream << "fetch_" << name_index++;
+                        name = stream.str();
+                    }
+                    while( !used_name_set.insert( name ).second );
+
+                    Base::ObjectRef<AST::VariableDeclarationStatement>
+                        declaration = new AST::VariableDeclarationStatement;
+                    Base::ObjectRef<AST::VariableDeclarationBody>
+                        body = new AST::VariableDeclarationBody( name );
+
+                    body->m_InitialValue = new AST::InitialValue;
+                    body->m_InitialValue->AddExpression( &**fetch_table[ fetch ].m_Expression );
+                    declaration->SetType( new AST::Type( fetch_table[ fetch ].m_Type ) );
+                    declaration->AddBody( &*body );
+                    hoisted_statement_table[ position ].push_back( &*declaration );
+                    *fetch_table[ fetch ].m_Expression = new AST::VariableExpression( name );
+
+                    for( size_t statement = position; statement < index; ++statement )
+                    {
+                        ++in_flight_count_table[ statement ];
+                    }
+
+                    ++m_HoistedFetchCount;
+                    hoisted_distance += static_cast<int>( index - position );
+                }
+            }
+
+            std::vector<Base::ObjectRef<AST::Statement> >
+                hoisted_function_statement_table;
+
+            for( size_t index = 0; index < statement_table.size(); ++index )
+            {
+                std::copy( hoisted_statement_table[ index ].begin(), hoisted_statement_table[ index ].end(), std::back_inserter( hoisted_function_statement_table ) );
+                hoisted_function_statement_table.push_back( statement_table[ index ] );
+            }
+
+            statement_table.swap( hoisted_function_statement_table );
+        }
+
+        Base::Statistics::AddCount( "hoisted_texture_fetch_count", m_HoistedFetchCount );
+        Base::Statistics::AddCount( "hoisted_texture_fetch_distance", hoisted_distance );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef TEXTURE_FETCH_HOISTER_H
+    #define TEXTURE_FETCH_HOISTER_H
+
+    #include <ast/node.h>
+
+    namespace Generation
+    {
+        // Issues the texture fetches of the generated functions as early as their
+        // coordinates allow, so their latency overlaps the statements before their use.
+        //
+        // The tex1D, tex2D, tex3D and texCUBE intrinsics with their variants, and the
+        // Sample methods of the textures declared with a known element type, found in
+        // the expressions of a top level statement are stored in a temporary of their
+        // result type declared before the earliest statement they do not depend on. A
+        // fetch is not moved above an early return, and at most the given count of
+        // moved fetches are pending at any statement.
+
+        class TextureFetchHoister
+        {
+        public:
+
+            TextureFetchHoister() :
+                m_MaximumInFlightCount( 4 ),
+                m_HoistedFetchCount( 0 )
+            {
+            }
+
+            void SetMaximumInFlightCount( const int count ) { m_MaximumInFlightCount = count; }
+
+            void Hoist( AST::TranslationUnit & translation_unit );
+
+            int GetHoistedFetchCount() const { return m_HoistedFetchCount; }
+
+        private:
+
+            int
+                m_MaximumInFlightCount,
+                m_HoistedFetchCount;
+        };
+    }
+
+#endif
\ No newline at end of file
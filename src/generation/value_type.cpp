@@ -0,0 +1,393 @@
+#include "value_type.h"
+
+#include "pass_helpers.h"
+#include <ast/function_node.h>
+#include <algorithm>
+#include <sstream>
+
+namespace Generation
+{
+    namespace
+    {
+        const char
+            * const ScalarTypeTable[] =
+            {
+                // In promotion order
+                "bool", "int", "uint", "half", "float", "double"
+            },
+            * const ComponentWiseFunctionTable[] =
+            {
+                "abs", "acos", "asin", "atan", "ceil", "cos", "cosh", "degrees", "exp", "exp2",
+                "floor", "frac", "log", "log10", "log2", "normalize", "radians", "rcp", "round",
+                "rsqrt", "saturate", "sign", "sin", "sinh", "sqrt", "tan", "tanh", "trunc",
+                "atan2", "clamp", "fmod", "lerp", "max", "min", "pow", "reflect", "refract",
+                "smoothstep", "step"
+            },
+            * const ScalarFunctionTable[] =
+            {
+                "dot", "length", "distance", "determinant"
+            };
+
+        bool IsDimension( const char character )
+        {
+            return character >= '1' && character <= '4';
+        }
+
+        bool GetMultiplicationType( ValueType & type, const ValueType & first, const ValueType & second )
+        {
+            if( first.IsScalar() || second.IsScalar() )
+            {
+                return CombineTypes( type, first, second );
+            }
+
+            type = ValueType();
+            type.m_Rank = std::max( first.m_Rank, second.m_Rank );
+
+            if( !first.IsMatrix() && !second.IsMatrix() )
+            {
+                // Dot product
+                return first.m_ComponentCount == second.m_ComponentCount;
+            }
+
+            if( !first.IsMatrix() )
+            {
+                type.m_ComponentCount = second.m_ColumnCount;
+                return first.m_ComponentCount == second.m_RowCount;
+            }
+
+            if( !second.IsMatrix() )
+            {
+                type.m_ComponentCount = first.m_RowCount;
+                return first.m_ColumnCount == second.m_ComponentCount;
+            }
+
+            type.m_RowCount = first.m_RowCount;
+            type.m_ColumnCount = second.m_ColumnCount;
+            type.m_ComponentCount = type.m_RowCount * type.m_ColumnCount;
+
+            return first.m_ColumnCount == second.m_RowCount;
+        }
+    }
+
+    std::string ValueType::GetName() const
+    {
+        std::ostringstream
+            name;
+
+        name << ScalarTypeTable[ m_Rank ];
+
+        if( IsMatrix() )
+        {
+            name << m_RowCount << "x" << m_ColumnCount;
+        }
+        else if( m_ComponentCount > 1 )
+        {
+            name << m_ComponentCount;
+        }
+
+        return name.str();
+    }
+
+    bool ParseType( ValueType & type, const std::string & name )
+    {
+        for( size_t rank = 0; rank < sizeof( ScalarTypeTable ) / sizeof( ScalarTypeTable[ 0 ] ); ++rank )
+        {
+            const std::string
+                scalar = ScalarTypeTable[ rank ];
+
+            if( name.compare( 0, scalar.size(), scalar ) != 0 )
+            {
+                continue;
+            }
+
+            const std::string
+                dimension = name.substr( scalar.size() );
+
+            type = ValueType();
+            type.m_Rank = rank;
+
+            if( dimension.size() == 1 && IsDimension( dimension[ 0 ] ) )
+            {
+                type.m_ComponentCount = dimension[ 0 ] - '0';
+            }
+            else if( dimension.size() == 3 && IsDimension( dimension[ 0 ] ) && dimension[ 1 ] == 'x' && IsDimension( dimension[ 2 ] ) )
+            {
+                type.m_RowCount = dimension[ 0 ] - '0';
+                type.m_ColumnCount = dimension[ 2 ] - '0';
+                type.m_ComponentCount = type.m_RowCount * type.m_ColumnCount;
+            }
+            else if( !dimension.empty() )
+            {
+                return false;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool CombineTypes( ValueType & type, const ValueType & first, const ValueType & second )
+    {
+        if( first.IsMatrix() || second.IsMatrix() )
+        {
+            if( !first.IsScalar() && !second.IsScalar()
+                && ( first.m_RowCount != second.m_RowCount || first.m_ColumnCount != second.m_ColumnCount )
+                )
+            {
+                return false;
+            }
+
+            type = first.IsMatrix() ? first : second;
+        }
+        else
+        {
+            type = first;
+            type.m_ComponentCount = first.IsScalar() ? second.m_ComponentCount
+                : second.IsScalar() ? first.m_ComponentCount
+                : std::min( first.m_ComponentCount, second.m_ComponentCount );
+        }
+
+        type.m_Rank = std::max( first.m_Rank, second.m_Rank );
+
+        return true;
+    }
+
+    bool GetIntrinsicCallType(
+        ValueType & type,
+        const std::string & name,
+        const std::vector<ValueType> & argument_type_table
+        )
+    {
+        if( argument_type_table.empty() )
+        {
+            return false;
+        }
+
+        const ValueType
+            & first = argument_type_table[ 0 ];
+
+        if( Contains( ComponentWiseFunctionTable, name ) )
+        {
+            type = first;
+
+            for( size_t index = 1; index < argument_type_table.size(); ++index )
+            {
+                if( !CombineTypes( type, ValueType( type ), argument_type_table[ index ] ) )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        type = ValueType();
+        type.m_Rank = first.m_Rank;
+
+        if( Contains( ScalarFunctionTable, name ) )
+        {
+            return true;
+        }
+
+        if( name == "cross" )
+        {
+            type.m_ComponentCount = 3;
+            return true;
+        }
+
+        if( name == "transpose" && first.IsMatrix() )
+        {
+            type = first;
+            std::swap( type.m_RowCount, type.m_ColumnCount );
+            return true;
+        }
+
+        return name == "mul" && argument_type_table.size() == 2 && GetMultiplicationType( type, first, argument_type_table[ 1 ] );
+    }
+
+    bool GetSwizzleType( ValueType & type, const ValueType & base_type, const std::string & swizzle )
+    {
+        if( base_type.IsMatrix() || swizzle.empty() || swizzle.size() > 4 || swizzle.find_first_not_of( "xyzwrgba" ) != std::string::npos )
+        {
+            return false;
+        }
+
+        type = base_type;
+        type.m_ComponentCount = static_cast<int>( swizzle.size() );
+
+        return true;
+    }
+
+    bool DeduceType(
+        ValueType & type,
+        const AST::Expression & expression,
+        const std::map<std::string, ValueType> & variable_type_table,
+        const std::map<std::string, ValueType> & function_type_table
+        )
+    {
+        switch( expression.m_Kind )
+        {
+            case AST::NodeKind_LiteralExpression:
+            {
+                const AST::LiteralExpression
+                    & literal = static_cast<const AST::LiteralExpression &>( expression );
+
+                return ParseType(
+                    type,
+                    literal.m_Type == AST::LiteralExpression::Float ? "float"
+                        : literal.m_Type == AST::LiteralExpression::Int ? "int"
+                        : "bool"
+                    );
+            }
+
+            case AST::NodeKind_VariableExpression:
+            {
+                const AST::VariableExpression
+                    & variable = static_cast<const AST::VariableExpression &>( expression );
+                std::map<std::string, ValueType>::const_iterator
+                    variable_type = variable_type_table.find( variable.m_Name );
+
+                if( variable.m_SubscriptExpression || variable_type == variable_type_table.end() )
+                {
+                    return false;
+                }
+
+                type = (*variable_type).second;
+                return true;
+            }
+
+            case AST::NodeKind_BinaryOperationExpression:
+            {
+                const AST::BinaryOperationExpression
+                    & operation = static_cast<const AST::BinaryOperationExpression &>( expression );
+                ValueType
+                    left_type,
+                    right_type;
+
+                if( !DeduceType( left_type, *operation.m_LeftExpression, variable_type_table, function_type_table )
+                    || !DeduceType( right_type, *operation.m_RightExpression, variable_type_table, function_type_table )
+                    || !CombineTypes( type, left_type, right_type )
+                    )
+                {
+                    return false;
+                }
+
+                if( operation.m_Operation <= AST::BinaryOperationExpression::LogicalAnd
+                    || ( operation.m_Operation >= AST::BinaryOperationExpression::Equality && operation.m_Operation <= AST::BinaryOperationExpression::GreaterThanOrEqual )
+                    )
+                {
+                    type.m_Rank = 0;
+                }
+
+                return true;
+            }
+
+            case AST::NodeKind_UnaryOperationExpression:
+            {
+                const AST::UnaryOperationExpression
+                    & operation = static_cast<const AST::UnaryOperationExpression &>( expression );
+
+                if( !DeduceType( type, *operation.m_Expression, variable_type_table, function_type_table ) )
+                {
+                    return false;
+                }
+
+                if( operation.m_Operation == AST::UnaryOperationExpression::Not )
+                {
+                    type.m_Rank = 0;
+                }
+
+                return true;
+            }
+
+            case AST::NodeKind_CastExpression:
+            {
+                const AST::CastExpression
+                    & cast = static_cast<const AST::CastExpression &>( expression );
+
+                return cast.m_ArraySize == -1 && ParseType( type, cast.m_Type->m_Name );
+            }
+
+            case AST::NodeKind_ConstructorExpression:
+                return ParseType( type, static_cast<const AST::ConstructorExpression &>( expression ).m_Type->m_Name );
+
+            case AST::NodeKind_ConditionalExpression:
+            {
+                const AST::ConditionalExpression
+                    & conditional = static_cast<const AST::ConditionalExpression &>( expression );
+                ValueType
+                    true_type,
+                    false_type;
+
+                return DeduceType( true_type, *conditional.m_IfTrue, variable_type_table, function_type_table )
+                    && DeduceType( false_type, *conditional.m_IfFalse, variable_type_table, function_type_table )
+                    && CombineTypes( type, true_type, false_type );
+            }
+
+            case AST::NodeKind_CallExpression:
+            {
+                const AST::CallExpression
+                    & call = static_cast<const AST::CallExpression &>( expression );
+                std::map<std::string, ValueType>::const_iterator
+                    function_type = function_type_table.find( call.m_Name );
+                std::vector<ValueType>
+                    argument_type_table;
+
+                if( function_type != function_type_table.end() )
+                {
+                    type = (*function_type).second;
+                    return true;
+                }
+
+                // Texture fetches return a float4
+                if( call.m_Name.compare( 0, 3, "tex" ) == 0 )
+                {
+                    return ParseType( type, "float4" );
+                }
+
+                for( size_t index = 0; call.m_ArgumentExpressionList && index < call.m_ArgumentExpressionList->m_ExpressionList.size(); ++index )
+                {
+                    argument_type_table.push_back( ValueType() );
+
+                    if( !DeduceType( argument_type_table.back(), *call.m_ArgumentExpressionList->m_ExpressionList[ index ], variable_type_table, function_type_table ) )
+                    {
+                        return false;
+                    }
+                }
+
+                return GetIntrinsicCallType( type, call.m_Name, argument_type_table );
+            }
+
+            case AST::NodeKind_PostfixExpression:
+            {
+                const AST::PostfixExpression
+                    & postfix = static_cast<const AST::PostfixExpression &>( expression );
+                ValueType
+                    base_type;
+
+                if( !postfix.m_Suffix )
+                {
+                    return DeduceType( type, *postfix.m_Expression, variable_type_table, function_type_table );
+                }
+
+                if( postfix.m_Suffix->m_Kind == AST::NodeKind_PostfixSuffixCall )
+                {
+                    const AST::PostfixSuffixCall
+                        & suffix = static_cast<const AST::PostfixSuffixCall &>( *postfix.m_Suffix );
+
+                    return !suffix.m_Suffix && suffix.m_CallExpression->m_Name.compare( 0, 6, "Sample" ) == 0
+                        && suffix.m_CallExpression->m_Name.find( "Cmp" ) == std::string::npos
+                        && ParseType( type, "float4" );
+                }
+
+                return postfix.m_Suffix->m_Kind == AST::NodeKind_Swizzle
+                    && DeduceType( base_type, *postfix.m_Expression, variable_type_table, function_type_table )
+                    && GetSwizzleType( type, base_type, static_cast<const AST::Swizzle &>( *postfix.m_Suffix ).m_Swizzle );
+            }
+
+            default:
+                return false;
+        }
+    }
+}
\ No newline at end of file
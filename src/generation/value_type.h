@@ -0,0 +1,54 @@
+#ifndef VALUE_TYPE_H
+    #define VALUE_TYPE_H
+
+    #include <map>
+    #include <string>
+    #include <vector>
+    #include <ast/node.h>
+
+    namespace Generation
+    {
+        // Scalar, vector or matrix intrinsic type. Vectors and scalars have no row.
+        struct ValueType
+        {
+            ValueType() : m_Rank( 0 ), m_ComponentCount( 1 ), m_RowCount( 0 ), m_ColumnCount( 0 ) {}
+
+            bool IsMatrix() const { return m_RowCount != 0; }
+            bool IsScalar() const { return !IsMatrix() && m_ComponentCount == 1; }
+
+            std::string GetName() const;
+
+            // Index of the scalar type, in promotion order from bool to double
+            size_t
+                m_Rank;
+            int
+                m_ComponentCount,
+                m_RowCount,
+                m_ColumnCount;
+        };
+
+        bool ParseType( ValueType & type, const std::string & name );
+
+        // Type of a component wise operation, scalars are broadcast and vectors truncated
+        bool CombineTypes( ValueType & type, const ValueType & first, const ValueType & second );
+
+        // Returns false for the unknown intrinsics
+        bool GetIntrinsicCallType(
+            ValueType & type,
+            const std::string & name,
+            const std::vector<ValueType> & argument_type_table
+            );
+
+        bool GetSwizzleType( ValueType & type, const ValueType & base_type, const std::string & swizzle );
+
+        // Deduces the type of an expression from the types of the variables and the
+        // return types of the functions it reads
+        bool DeduceType(
+            ValueType & type,
+            const AST::Expression & expression,
+            const std::map<std::string, ValueType> & variable_type_table,
+            const std::map<std::string, ValueType> & function_type_table
+            );
+    }
+
+#endif
\ No newline at end of file
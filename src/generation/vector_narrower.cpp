@@ -0,0 +1,1051 @@
+#include "vector_narrower.h"
+
+#include "pass_helpers.h"
+#include "value_type.h"
+#include <ast/function_node.h>
+#include <base/statistics.h>
+#include <map>
+
+namespace Generation
+{
+    namespace
+    {
+        // Intrinsics computing each component from the same component of their arguments
+        const char
+            * const ComponentWiseFunctionTable[] =
+            {
+                "abs", "acos", "asin", "atan", "ceil", "cos", "cosh", "degrees", "exp", "exp2",
+                "floor", "frac", "log", "log10", "log2", "radians", "rcp", "round", "rsqrt",
+                "saturate", "sign", "sin", "sinh", "sqrt", "tan", "tanh", "trunc",
+                "atan2", "clamp", "fmod", "lerp", "max", "min", "pow", "smoothstep", "step"
+            },
+            * const PositionComponentTable = "xyzw",
+            * const ColorComponentTable = "rgba";
+
+        int GetComponentIndex( const char component )
+        {
+            switch( component )
+            {
+                case 'x': case 'r': return 0;
+                case 'y': case 'g': return 1;
+                case 'z': case 'b': return 2;
+                case 'w': case 'a': return 3;
+                default: return -1;
+            }
+        }
+
+        std::string GetSwizzle( const std::vector<int> & component_table, const char * family )
+        {
+            std::string
+                swizzle;
+
+            for( size_t index = 0; index < component_table.size(); ++index )
+            {
+                swizzle += family[ component_table[ index ] ];
+            }
+
+            return swizzle;
+        }
+
+        // Components keep their name family
+        void RemapSwizzle( std::string & swizzle, const std::vector<int> & position_table )
+        {
+            for( size_t index = 0; index < swizzle.size(); ++index )
+            {
+                const char
+                    * family = std::string( ColorComponentTable ).find( swizzle[ index ] ) != std::string::npos ? ColorComponentTable : PositionComponentTable;
+
+                swizzle[ index ] = family[ position_table[ GetComponentIndex( swizzle[ index ] ) ] ];
+            }
+        }
+
+        struct Scope
+        {
+            std::map<std::string, ValueType>
+                m_VariableTypeTable,
+                m_FunctionTypeTable;
+        };
+
+        // How a variable of a function is used. Only the local vectors declared once,
+        // and only read or written through swizzles, are narrowable.
+        struct Usage
+        {
+            Usage() :
+                m_Declaration( 0 ),
+                m_DeclarationCount( 0 ),
+                m_IsNarrowable( true ),
+                m_LiveComponentMask( 0 )
+            {
+            }
+
+            AST::VariableDeclarationStatement
+                * m_Declaration;
+            int
+                m_DeclarationCount;
+            bool
+                m_IsNarrowable;
+            int
+                m_LiveComponentMask;
+            // Swizzled reads and the full values assigned
+            std::vector<Base::ObjectRef<AST::Expression> *>
+                m_ReadTable,
+                m_ValueTable;
+            // Swizzled writes
+            std::vector<AST::LValueExpression *>
+                m_WriteTable;
+        };
+
+        bool AddSwizzle( Usage & usage, const std::string & swizzle )
+        {
+            for( size_t index = 0; index < swizzle.size(); ++index )
+            {
+                const int
+                    component = GetComponentIndex( swizzle[ index ] );
+
+                if( component == -1 )
+                {
+                    return false;
+                }
+
+                usage.m_LiveComponentMask |= 1 << component;
+            }
+
+            return true;
+        }
+
+        void CollectExpression(
+            std::map<std::string, Usage> & usage_table,
+            Base::ObjectRef<AST::Expression> & expression
+            );
+
+        void CollectArguments(
+            std::map<std::string, Usage> & usage_table,
+            AST::ArgumentExpressionList * argument_list
+            )
+        {
+            if( !argument_list )
+            {
+                return;
+            }
+
+            std::vector<Base::ObjectRef<AST::Expression> >::iterator it, end;
+
+            for( it = argument_list->m_ExpressionList.begin(), end = argument_list->m_ExpressionList.end(); it != end; ++it )
+            {
+                CollectExpression( usage_table, *it );
+            }
+        }
+
+        void CollectLValue(
+            std::map<std::string, Usage> & usage_table,
+            AST::LValueExpression & expression,
+            Base::ObjectRef<AST::Expression> * assigned_value
+            )
+        {
+            AST::VariableExpression
+                & variable = *expression.m_VariableExpression;
+            Usage
+                & usage = usage_table[ variable.m_Name ];
+
+            if( variable.m_SubscriptExpression )
+            {
+                usage.m_IsNarrowable = false;
+                CollectExpression( usage_table, variable.m_SubscriptExpression );
+            }
+            else if( !expression.m_Suffix )
+            {
+                if( assigned_value )
+                {
+                    usage.m_ValueTable.push_back( assigned_value );
+                }
+                else
+                {
+                    usage.m_IsNarrowable = false;
+                }
+            }
+            else if( expression.m_Suffix->m_Kind == AST::NodeKind_Swizzle
+                && AddSwizzle( usage, static_cast<const AST::Swizzle &>( *expression.m_Suffix ).m_Swizzle )
+                )
+            {
+                usage.m_WriteTable.push_back( &expression );
+            }
+            else
+            {
+                usage.m_IsNarrowable = false;
+            }
+        }
+
+        void CollectExpression(
+            std::map<std::string, Usage> & usage_table,
+            Base::ObjectRef<AST::Expression> & expression
+            )
+        {
+            if( !expression )
+            {
+                return;
+            }
+
+            switch( expression->m_Kind )
+            {
+                case AST::NodeKind_VariableExpression:
+                {
+                    AST::VariableExpression
+                        & variable = static_cast<AST::VariableExpression &>( *expression );
+
+                    usage_table[ variable.m_Name ].m_IsNarrowable = false;
+                    CollectExpression( usage_table, variable.m_SubscriptExpression );
+                    break;
+                }
+
+                case AST::NodeKind_PostfixExpression:
+                {
+                    AST::PostfixExpression
+                        & postfix = static_cast<AST::PostfixExpression &>( *expression );
+
+                    if( postfix.m_Expression->m_Kind == AST::NodeKind_VariableExpression
+                        && !static_cast<const AST::VariableExpression &>( *postfix.m_Expression ).m_SubscriptExpression
+                        && postfix.m_Suffix
+                        && postfix.m_Suffix->m_Kind == AST::NodeKind_Swizzle
+                        )
+                    {
+                        Usage
+                            & usage = usage_table[ static_cast<const AST::VariableExpression &>( *postfix.m_Expression ).m_Name ];
+
+                        if( AddSwizzle( usage, static_cast<const AST::Swizzle &>( *postfix.m_Suffix ).m_Swizzle ) )
+                        {
+                            usage.m_ReadTable.push_back( &expression );
+                        }
+                        else
+                        {
+                            usage.m_IsNarrowable = false;
+                        }
+
+                        break;
+                    }
+
+                    CollectExpression( usage_table, postfix.m_Expression );
+
+                    for( AST::PostfixSuffix * suffix = &*postfix.m_Suffix; suffix; )
+                    {
+                        if( suffix->m_Kind == AST::NodeKind_PostfixSuffixCall )
+                        {
+                            AST::PostfixSuffixCall
+                                & call = static_cast<AST::PostfixSuffixCall &>( *suffix );
+
+                            CollectArguments( usage_table, &*call.m_CallExpression->m_ArgumentExpressionList );
+                            suffix = &*call.m_Suffix;
+                        }
+                        else if( suffix->m_Kind == AST::NodeKind_PostfixSuffixVariable )
+                        {
+                            suffix = &*static_cast<AST::PostfixSuffixVariable &>( *suffix ).m_Suffix;
+                        }
+                        else
+                        {
+                            suffix = 0;
+                        }
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_BinaryOperationExpression:
+                {
+                    AST::BinaryOperationExpression
+                        & operation = static_cast<AST::BinaryOperationExpression &>( *expression );
+
+                    CollectExpression( usage_table, operation.m_LeftExpression );
+                    CollectExpression( usage_table, operation.m_RightExpression );
+                    break;
+                }
+
+                case AST::NodeKind_UnaryOperationExpression:
+                    CollectExpression( usage_table, static_cast<AST::UnaryOperationExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_CastExpression:
+                    CollectExpression( usage_table, static_cast<AST::CastExpression &>( *expression ).m_Expression );
+                    break;
+
+                case AST::NodeKind_ConditionalExpression:
+                {
+                    AST::ConditionalExpression
+                        & conditional = static_cast<AST::ConditionalExpression &>( *expression );
+
+                    CollectExpression( usage_table, conditional.m_Condition );
+                    CollectExpression( usage_table, conditional.m_IfTrue );
+                    CollectExpression( usage_table, conditional.m_IfFalse );
+                    break;
+                }
+
+                case AST::NodeKind_CallExpression:
+                    CollectArguments( usage_table, &*static_cast<AST::CallExpression &>( *expression ).m_ArgumentExpressionList );
+                    break;
+
+                case AST::NodeKind_ConstructorExpression:
+                    CollectArguments( usage_table, &*static_cast<AST::ConstructorExpression &>( *expression ).m_ArgumentExpressionList );
+                    break;
+
+                case AST::NodeKind_PreModifyExpression:
+                    CollectLValue( usage_table, *static_cast<AST::PreModifyExpression &>( *expression ).m_Expression, 0 );
+                    break;
+
+                case AST::NodeKind_PostModifyExpression:
+                    CollectLValue( usage_table, *static_cast<AST::PostModifyExpression &>( *expression ).m_Expression, 0 );
+                    break;
+
+                case AST::NodeKind_AssignmentExpression:
+                {
+                    AST::AssignmentExpression
+                        & assignment = static_cast<AST::AssignmentExpression &>( *expression );
+
+                    CollectLValue( usage_table, *assignment.m_LValueExpression, &assignment.m_Expression );
+                    CollectExpression( usage_table, assignment.m_Expression );
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        void CollectStatement(
+            std::map<std::string, Usage> & usage_table,
+            AST::Statement * statement
+            )
+        {
+            if( !statement )
+            {
+                return;
+            }
+
+            switch( statement->m_Kind )
+            {
+                case AST::NodeKind_ExpressionStatement:
+                    CollectExpression( usage_table, static_cast<AST::ExpressionStatement *>( statement )->m_Expression );
+                    break;
+
+                case AST::NodeKind_AssignmentStatement:
+                {
+                    AST::AssignmentExpression
+                        & assignment = *static_cast<AST::AssignmentStatement *>( statement )->m_Expression;
+
+                    CollectLValue( usage_table, *assignment.m_LValueExpression, &assignment.m_Expression );
+                    CollectExpression( usage_table, assignment.m_Expression );
+                    break;
+                }
+
+                case AST::NodeKind_ReturnStatement:
+                    CollectExpression( usage_table, static_cast<AST::ReturnStatement *>( statement )->m_Expression );
+                    break;
+
+                case AST::NodeKind_IfStatement:
+                {
+                    AST::IfStatement
+                        & if_statement = *static_cast<AST::IfStatement *>( statement );
+
+                    CollectExpression( usage_table, if_statement.m_Condition );
+                    CollectStatement( usage_table, &*if_statement.m_ThenStatement );
+                    CollectStatement( usage_table, &*if_statement.m_ElseStatement );
+                    break;
+                }
+
+                case AST::NodeKind_WhileStatement:
+                {
+                    AST::WhileStatement
+                        & while_statement = *static_cast<AST::WhileStatement *>( statement );
+
+                    CollectExpression( usage_table, while_statement.m_Condition );
+                    CollectStatement( usage_table, &*while_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_DoWhileStatement:
+                {
+                    AST::DoWhileStatement
+                        & do_while_statement = *static_cast<AST::DoWhileStatement *>( statement );
+
+                    CollectStatement( usage_table, &*do_while_statement.m_Statement );
+                    CollectExpression( usage_table, do_while_statement.m_Condition );
+                    break;
+                }
+
+                case AST::NodeKind_ForStatement:
+                {
+                    AST::ForStatement
+                        & for_statement = *static_cast<AST::ForStatement *>( statement );
+
+                    CollectStatement( usage_table, &*for_statement.m_InitStatement );
+                    CollectExpression( usage_table, for_statement.m_EqualityExpression );
+                    CollectExpression( usage_table, for_statement.m_ModifyExpression );
+                    CollectStatement( usage_table, &*for_statement.m_Statement );
+                    break;
+                }
+
+                case AST::NodeKind_BlockStatement:
+                {
+                    std::vector<Base::ObjectRef<AST::Statement> >::iterator it, end;
+                    AST::BlockStatement
+                        & block = *static_cast<AST::BlockStatement *>( statement );
+
+                    for( it = block.m_StatementTable.begin(), end = block.m_StatementTable.end(); it != end; ++it )
+                    {
+                        CollectStatement( usage_table, &**it );
+                    }
+                    break;
+                }
+
+                case AST::NodeKind_VariableDeclarationStatement:
+                {
+                    AST::VariableDeclarationStatement
+                        & declaration = *static_cast<AST::VariableDeclarationStatement *>( statement );
+                    std::vector<Base::ObjectRef<AST::VariableDeclarationBody> >::iterator it, end;
+
+                    for( it = declaration.m_BodyTable.begin(), end = declaration.m_BodyTable.end(); it != end; ++it )
+                    {
+                        AST::VariableDeclarationBody
+                            & body = **it;
+                        const bool
+                            is_used = usage_table.find( body.m_Name ) != usage_table.end();
+                        Usage
+                            & usage = usage_table[ body.m_Name ];
+
+                        // A variable used before its declaration is another one it hides
+                        usage.m_Declaration = &declaration;
+                        usage.m_IsNarrowable = usage.m_IsNarrowable
+                            && !is_used
+                            && declaration.m_BodyTable.size() == 1
+                            && declaration.m_StorageClass.empty()
+                            && body.m_ArraySize == 0;
+                        ++usage.m_DeclarationCount;
+
+                        if( !body.m_InitialValue )
+                        {
+                            continue;
+                        }
+
+                        if( body.m_InitialValue->m_Vector || body.m_InitialValue->m_ExpressionTable.size() != 1 )
+                        {
+                            usage.m_IsNarrowable = false;
+                        }
+                        else
+                        {
+                            usage.m_ValueTable.push_back( &body.m_InitialValue->m_ExpressionTable[ 0 ] );
+                        }
+
+                        std::vector<Base::ObjectRef<AST::Expression> >::iterator expression_it, expression_end;
+
+                        expression_it = body.m_InitialValue->m_ExpressionTable.begin();
+                        expression_end = body.m_InitialValue->m_ExpressionTable.end();
+
+                        for( ; expression_it != expression_end; ++expression_it )
+                        {
+                            CollectExpression( usage_table, *expression_it );
+                        }
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        bool NarrowExpression(
+            Base::ObjectRef<AST::Expression> & narrowed_expression,
+            const AST::Expression & expression,
+            const std::vector<int> & component_table,
+            const Scope & scope
+            );
+
+        // Keeps the components of a component wise expression, scalars are broadcast
+        bool NarrowOperand(
+            Base::ObjectRef<AST::Expression> & narrowed_expression,
+            const AST::Expression & expression,
+            const std::vector<int> & component_table,
+            const Scope & scope
+            )
+        {
+            ValueType
+                type;
+
+            if( !DeduceType( type, expression, scope.m_VariableTypeTable, scope.m_FunctionTypeTable ) )
+            {
+                return false;
+            }
+
+            if( type.IsScalar() )
+            {
+                narrowed_expression = expression.Clone();
+                return true;
+            }
+
+            return NarrowExpression( narrowed_expression, expression, component_table, scope );
+        }
+
+        bool NarrowArguments(
+            AST::ArgumentExpressionList & narrowed_argument_list,
+            const AST::ArgumentExpressionList & argument_list,
+            const std::vector<int> & component_table,
+            const Scope & scope
+            )
+        {
+            std::vector<Base::ObjectRef<AST::Expression> >::const_iterator it, end;
+
+            for( it = argument_list.m_ExpressionList.begin(), end = argument_list.m_ExpressionList.end(); it != end; ++it )
+            {
+                Base::ObjectRef<AST::Expression>
+                    argument;
+
+                if( !NarrowOperand( argument, **it, component_table, scope ) )
+                {
+                    return false;
+                }
+
+                narrowed_argument_list.AddExpression( &*argument );
+            }
+
+            return true;
+        }
+
+        // The components of a constructor come from its arguments in order
+        bool NarrowConstructor(
+            Base::ObjectRef<AST::Expression> & narrowed_expression,
+            const AST::ConstructorExpression & constructor,
+            const ValueType & narrowed_type,
+            const std::vector<int> & component_table,
+            const Scope & scope
+            )
+        {
+            std::vector<size_t>
+                argument_index_table;
+            std::vector<int>
+                argument_component_table;
+            const std::vector<Base::ObjectRef<AST::Expression> >
+                & argument_list = constructor.m_ArgumentExpressionList->m_ExpressionList;
+            Base::ObjectRef<AST::ArgumentExpressionList>
+                narrowed_argument_list = new AST::ArgumentExpressionList;
+
+            for( size_t index = 0; index < argument_list.size(); ++index )
+            {
+                ValueType
+                    type;
+
+                if( !DeduceType( type, *argument_list[ index ], scope.m_VariableTypeTable, scope.m_FunctionTypeTable )
+                    || type.IsMatrix()
+                    )
+                {
+                    return false;
+                }
+
+                for( int component = 0; component < type.m_ComponentCount; ++component )
+                {
+                    argument_index_table.push_back( index );
+                    argument_component_table.push_back( component );
+                }
+            }
+
+            if( argument_index_table.size() == 1 )
+            {
+                // Broadcast scalar
+                narrowed_argument_list->AddExpression( argument_list[ 0 ]->Clone() );
+            }
+            else
+            {
+                for( size_t first = 0; first < component_table.size(); )
+                {
+                    std::vector<int>
+                        component_list;
+                    size_t
+                        last = first,
+                        argument_index;
+                    Base::ObjectRef<AST::Expression>
+                        argument;
+
+                    if( static_cast<size_t>( component_table[ first ] ) >= argument_index_table.size() )
+                    {
+                        return false;
+                    }
+
+                    argument_index = argument_index_table[ component_table[ first ] ];
+
+                    while( last < component_table.size()
+                        && static_cast<size_t>( component_table[ last ] ) < argument_index_table.size()
+                        && argument_index_table[ component_table[ last ] ] == argument_index
+                        )
+                    {
+                        component_list.push_back( argument_component_table[ component_table[ last ] ] );
+                        ++last;
+                    }
+
+                    if( !NarrowOperand( argument, *argument_list[ argument_index ], component_list, scope ) )
+                    {
+                        return false;
+                    }
+
+                    narrowed_argument_list->AddExpression( &*argument );
+                    first = last;
+                }
+            }
+
+            if( narrowed_type.IsScalar() && narrowed_argument_list->m_ExpressionList.size() == 1 )
+            {
+                narrowed_expression = narrowed_argument_list->m_ExpressionList[ 0 ];
+            }
+            else
+            {
+                narrowed_expression = new AST::ConstructorExpression(
+                    new AST::IntrinsicType( narrowed_type.GetName() ),
+                    &*narrowed_argument_list
+                    );
+            }
+
+            return true;
+        }
+
+        // Builds an expression computing the given components of a vector expression
+        bool NarrowExpression(
+            Base::ObjectRef<AST::Expression> & narrowed_expression,
+            const AST::Expression & expression,
+            const std::vector<int> & component_table,
+            const Scope & scope
+            )
+        {
+            ValueType
+                type,
+                narrowed_type;
+
+            if( !DeduceType( type, expression, scope.m_VariableTypeTable, scope.m_FunctionTypeTable )
+                || type.IsMatrix()
+                )
+            {
+                return false;
+            }
+
+            for( size_t index = 0; index < component_table.size(); ++index )
+            {
+                if( component_table[ index ] >= type.m_ComponentCount )
+                {
+                    return false;
+                }
+            }
+
+            narrowed_type = type;
+            narrowed_type.m_ComponentCount = static_cast<int>( component_table.size() );
+
+            switch( expression.m_Kind )
+            {
+                case AST::NodeKind_BinaryOperationExpression:
+                {
+                    const AST::BinaryOperationExpression
+                        & operation = static_cast<const AST::BinaryOperationExpression &>( expression );
+                    Base::ObjectRef<AST::Expression>
+                        left_expression,
+                        right_expression;
+
+                    if( operation.m_Operation == AST::BinaryOperationExpression::LogicalOr
+                        || operation.m_Operation == AST::BinaryOperationExpression::LogicalAnd
+                        )
+                    {
+                        break;
+                    }
+
+                    if( !NarrowOperand( left_expression, *operation.m_LeftExpression, component_table, scope )
+                        || !NarrowOperand( right_expression, *operation.m_RightExpression, component_table, scope )
+                        )
+                    {
+                        return false;
+                    }
+
+                    narrowed_expression = new AST::BinaryOperationExpression( operation.m_Operation, &*left_expression, &*right_expression );
+                    return true;
+                }
+
+                case AST::NodeKind_UnaryOperationExpression:
+                {
+                    const AST::UnaryOperationExpression
+                        & operation = static_cast<const AST::UnaryOperationExpression &>( expression );
+                    Base::ObjectRef<AST::Expression>
+                        operand;
+
+                    if( !NarrowOperand( operand, *operation.m_Expression, component_table, scope ) )
+                    {
+                        return false;
+                    }
+
+                    narrowed_expression = new AST::UnaryOperationExpression( operation.m_Operation, &*operand );
+                    return true;
+                }
+
+                case AST::NodeKind_CastExpression:
+                {
+                    const AST::CastExpression
+                        & cast = static_cast<const AST::CastExpression &>( expression );
+                    Base::ObjectRef<AST::Expression>
+                        operand;
+
+                    if( !NarrowOperand( operand, *cast.m_Expression, component_table, scope ) )
+                    {
+                        return false;
+                    }
+
+                    narrowed_expression = new AST::CastExpression( new AST::IntrinsicType( narrowed_type.GetName() ), -1, &*operand );
+                    return true;
+                }
+
+                case AST::NodeKind_ConditionalExpression:
+                {
+                    const AST::ConditionalExpression
+                        & conditional = static_cast<const AST::ConditionalExpression &>( expression );
+                    Base::ObjectRef<AST::ConditionalExpression>
+                        narrowed_conditional = new AST::ConditionalExpression;
+
+                    if( !NarrowOperand( narrowed_conditional->m_Condition, *conditional.m_Condition, component_table, scope )
+                        || !NarrowOperand( narrowed_conditional->m_IfTrue, *conditional.m_IfTrue, component_table, scope )
+                        || !NarrowOperand( narrowed_conditional->m_IfFalse, *conditional.m_IfFalse, component_table, scope )
+                        )
+                    {
+                        return false;
+                    }
+
+                    narrowed_expression = &*narrowed_conditional;
+                    return true;
+                }
+
+                case AST::NodeKind_ConstructorExpression:
+                {
+                    const AST::ConstructorExpression
+                        & constructor = static_cast<const AST::ConstructorExpression &>( expression );
+
+                    return constructor.m_ArgumentExpressionList
+                        && NarrowConstructor( narrowed_expression, constructor, narrowed_type, component_table, scope );
+                }
+
+                case AST::NodeKind_CallExpression:
+                {
+                    const AST::CallExpression
+                        & call = static_cast<const AST::CallExpression &>( expression );
+                    Base::ObjectRef<AST::ArgumentExpressionList>
+                        narrowed_argument_list = new AST::ArgumentExpressionList;
+
+                    if( scope.m_FunctionTypeTable.find( call.m_Name ) != scope.m_FunctionTypeTable.end()
+                        || !Contains( ComponentWiseFunctionTable, call.m_Name )
+                        || !call.m_ArgumentExpressionList
+                        )
+                    {
+                        break;
+                    }
+
+                    if( !NarrowArguments( *narrowed_argument_list, *call.m_ArgumentExpressionList, component_table, scope ) )
+                    {
+                        return false;
+                    }
+
+                    narrowed_expression = new AST::CallExpression( call.m_Name, &*narrowed_argument_list );
+                    return true;
+                }
+
+                case AST::NodeKind_PostfixExpression:
+                {
+                    const AST::PostfixExpression
+                        & postfix = static_cast<const AST::PostfixExpression &>( expression );
+
+                    if( !postfix.m_Suffix || postfix.m_Suffix->m_Kind != AST::NodeKind_Swizzle )
+                    {
+                        break;
+                    }
+
+                    const std::string
+                        & swizzle = static_cast<const AST::Swizzle &>( *postfix.m_Suffix ).m_Swizzle;
+                    std::string
+                        narrowed_swizzle;
+
+                    for( size_t index = 0; index < component_table.size(); ++index )
+                    {
+                        narrowed_swizzle += swizzle[ component_table[ index ] ];
+                    }
+
+                    narrowed_expression = new AST::PostfixExpression( postfix.m_Expression->Clone(), new AST::Swizzle( narrowed_swizzle ) );
+                    return true;
+                }
+
+                case AST::NodeKind_VariableExpression:
+                    narrowed_expression = new AST::PostfixExpression(
+                        expression.Clone(),
+                        new AST::Swizzle( GetSwizzle( component_table, PositionComponentTable ) )
+                        );
+                    return true;
+
+                default:
+                    return false;
+            }
+
+            // Swizzles the result, the printers do not add parenthesis to the operations
+            if( expression.m_Kind != AST::NodeKind_CallExpression && expression.m_Kind != AST::NodeKind_PostfixExpression )
+            {
+                return false;
+            }
+
+            narrowed_expression = new AST::PostfixExpression(
+                expression.Clone(),
+                new AST::Swizzle( GetSwizzle( component_table, PositionComponentTable ) )
+                );
+
+            return true;
+        }
+
+        void AddGlobalTypes( Scope & scope, const AST::TranslationUnit & translation_unit )
+        {
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+            std::map<std::string, int>
+                function_count_table;
+
+            for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+            {
+                ValueType
+                    type;
+
+                if( const AST::VariableDeclaration * declaration = dynamic_cast<const AST::VariableDeclaration *>( &**it ) )
+                {
+                    for( size_t index = 0; index < declaration->m_BodyTable.size(); ++index )
+                    {
+                        if( declaration->m_BodyTable[ index ]->m_ArraySize == 0 && ParseType( type, declaration->m_Type->m_Name ) )
+                        {
+                            scope.m_VariableTypeTable[ declaration->m_BodyTable[ index ]->m_Name ] = type;
+                        }
+                    }
+                }
+                else if( const AST::FunctionDeclaration * function = dynamic_cast<const AST::FunctionDeclaration *>( &**it ) )
+                {
+                    // The return type of an overloaded function depends on its arguments
+                    if( ++function_count_table[ function->m_Name ] > 1 )
+                    {
+                        scope.m_FunctionTypeTable.erase( function->m_Name );
+                    }
+                    else if( function->m_Type && ParseType( type, function->m_Type->m_Name ) )
+                    {
+                        scope.m_FunctionTypeTable[ function->m_Name ] = type;
+                    }
+                }
+            }
+        }
+
+        bool NarrowVariable(
+            int & removed_component_count,
+            Scope & scope,
+            const std::string & name,
+            const Usage & usage
+            )
+        {
+            ValueType
+                type,
+                narrowed_type;
+            std::vector<int>
+                component_table;
+            std::vector<Base::ObjectRef<AST::Expression> >
+                narrowed_value_table;
+
+            if( !ParseType( type, usage.m_Declaration->m_Type->m_Name )
+                || type.IsMatrix()
+                || type.IsScalar()
+                )
+            {
+                return false;
+            }
+
+            for( int component = 0; component < type.m_ComponentCount; ++component )
+            {
+                if( usage.m_LiveComponentMask & ( 1 << component ) )
+                {
+                    component_table.push_back( component );
+                }
+            }
+
+            if( component_table.empty() || component_table.size() == static_cast<size_t>( type.m_ComponentCount ) )
+            {
+                return false;
+            }
+
+            narrowed_value_table.resize( usage.m_ValueTable.size() );
+
+            for( size_t index = 0; index < usage.m_ValueTable.size(); ++index )
+            {
+                if( !NarrowOperand( narrowed_value_table[ index ], **usage.m_ValueTable[ index ], component_table, scope ) )
+                {
+                    return false;
+                }
+            }
+
+            std::vector<int>
+                position_table( 4, -1 );
+
+            for( size_t index = 0; index < component_table.size(); ++index )
+            {
+                position_table[ component_table[ index ] ] = static_cast<int>( index );
+            }
+
+            narrowed_type = type;
+            narrowed_type.m_ComponentCount = static_cast<int>( component_table.size() );
+
+            for( size_t index = 0; index < usage.m_ReadTable.size(); ++index )
+            {
+                Base::ObjectRef<AST::Expression>
+                    & read = *usage.m_ReadTable[ index ];
+                AST::PostfixExpression
+                    & postfix = static_cast<AST::PostfixExpression &>( *read );
+                std::string
+                    & swizzle = static_cast<AST::Swizzle &>( *postfix.m_Suffix ).m_Swizzle;
+
+                RemapSwizzle( swizzle, position_table );
+
+                if( narrowed_type.IsScalar() && swizzle.size() == 1 )
+                {
+                    Base::ObjectRef<AST::Expression>
+                        variable = postfix.m_Expression;
+
+                    read = variable;
+                }
+            }
+
+            for( size_t index = 0; index < usage.m_WriteTable.size(); ++index )
+            {
+                AST::LValueExpression
+                    & write = *usage.m_WriteTable[ index ];
+                std::string
+                    & swizzle = static_cast<AST::Swizzle &>( *write.m_Suffix ).m_Swizzle;
+
+                RemapSwizzle( swizzle, position_table );
+
+                if( narrowed_type.IsScalar() && swizzle.size() == 1 )
+                {
+                    write.m_Suffix = 0;
+                }
+            }
+
+            usage.m_Declaration->m_Type = new AST::IntrinsicType( narrowed_type.GetName() );
+            scope.m_VariableTypeTable[ name ] = narrowed_type;
+
+            // The values are narrowed again as they may read the remapped swizzles
+            for( size_t index = 0; index < usage.m_ValueTable.size(); ++index )
+            {
+                NarrowOperand( narrowed_value_table[ index ], **usage.m_ValueTable[ index ], component_table, scope );
+                *usage.m_ValueTable[ index ] = narrowed_value_table[ index ];
+            }
+
+            removed_component_count = type.m_ComponentCount - narrowed_type.m_ComponentCount;
+
+            return true;
+        }
+    }
+
+    void VectorNarrower::Narrow( AST::TranslationUnit & translation_unit )
+    {
+        Base::ScopedTimer
+            timer( "narrow_vectors" );
+        Scope
+            global_scope;
+        std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::iterator it, end;
+
+        m_NarrowedVariableCount = 0;
+        m_RemovedComponentCount = 0;
+
+        AddGlobalTypes( global_scope, translation_unit );
+
+        for( it = translation_unit.m_GlobalDeclarationTable.begin(), end = translation_unit.m_GlobalDeclarationTable.end(); it != end; ++it )
+        {
+            AST::FunctionDeclaration
+                * function = dynamic_cast<AST::FunctionDeclaration *>( &**it );
+            bool
+                is_narrowed = true;
+
+            if( !function )
+            {
+                continue;
+            }
+
+            function->ResolveBody();
+
+            // Narrowing a variable replaces the values of the others, so the usages are
+            // collected again after each one
+            while( is_narrowed )
+            {
+                Scope
+                    scope = global_scope;
+                std::map<std::string, Usage>
+                    usage_table;
+                std::map<std::string, Usage>::iterator usage_it, usage_end;
+
+                is_narrowed = false;
+
+                if( function->m_ArgumentList )
+                {
+                    for( size_t index = 0; index < function->m_ArgumentList->m_ArgumentTable.size(); ++index )
+                    {
+                        const AST::Argument
+                            & argument = *function->m_ArgumentList->m_ArgumentTable[ index ];
+                        ValueType
+                            type;
+
+                        usage_table[ argument.m_Name ].m_IsNarrowable = false;
+
+                        if( ParseType( type, argument.m_Type->m_Name ) )
+                        {
+                            scope.m_VariableTypeTable[ argument.m_Name ] = type;
+                        }
+                        else
+                        {
+                            scope.m_VariableTypeTable.erase( argument.m_Name );
+                        }
+                    }
+                }
+
+                for( size_t index = 0; index < function->m_StatementTable.size(); ++index )
+                {
+                    CollectStatement( usage_table, &*function->m_StatementTable[ index ] );
+                }
+
+                for( usage_it = usage_table.begin(), usage_end = usage_table.end(); usage_it != usage_end; ++usage_it )
+                {
+                    const Usage
+                        & usage = (*usage_it).second;
+                    ValueType
+                        type;
+
+                    if( !usage.m_Declaration )
+                    {
+                        continue;
+                    }
+
+                    if( usage.m_DeclarationCount == 1 && ParseType( type, usage.m_Declaration->m_Type->m_Name ) )
+                    {
+                        scope.m_VariableTypeTable[ (*usage_it).first ] = type;
+                    }
+                    else
+                    {
+                        scope.m_VariableTypeTable.erase( (*usage_it).first );
+                    }
+                }
+
+                for( usage_it = usage_table.begin(), usage_end = usage_table.end(); usage_it != usage_end && !is_narrowed; ++usage_it )
+                {
+                    const Usage
+                        & usage = (*usage_it).second;
+                    int
+                        removed_component_count;
+
+                    if( usage.m_Declaration
+                        && usage.m_DeclarationCount == 1
+                        && usage.m_IsNarrowable
+                        && NarrowVariable( removed_component_count, scope, (*usage_it).first, usage )
+                        )
+                    {
+                        ++m_NarrowedVariableCount;
+                        m_RemovedComponentCount += removed_component_count;
+                        is_narrowed = true;
+                    }
+                }
+            }
+        }
+
+        Base::Statistics::AddCount( "narrowed_variable_count", m_NarrowedVariableCount );
+        Base::Statistics::AddCount( "narrowed_component_count", m_RemovedComponentCount );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef VECTOR_NARROWER_H
+    #define VECTOR_NARROWER_H
+
+    #include <ast/node.h>
+
+    namespace Generation
+    {
+        // Declares the local vectors of the functions with only the components read
+        // through their swizzles, so the unread components are never computed.
+        //
+        // The values assigned to a narrowed vector are rewritten component wise down to
+        // the operations, constructors and intrinsics producing the kept components,
+        // and its swizzles are remapped. A vector read whole, indexed, given to a
+        // function or incremented keeps its type, as do the arguments and the return
+        // values, which are seen by the other stage.
+
+        class VectorNarrower
+        {
+        public:
+
+            VectorNarrower() :
+                m_NarrowedVariableCount( 0 ),
+                m_RemovedComponentCount( 0 )
+            {
+            }
+
+            void Narrow( AST::TranslationUnit & translation_unit );
+
+            int GetNarrowedVariableCount() const { return m_NarrowedVariableCount; }
+            int GetRemovedComponentCount() const { return m_RemovedComponentCount; }
+
+        private:
+
+            int
+                m_NarrowedVariableCount,
+                m_RemovedComponentCount;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,756 @@
+#include "vertex_stage_mover.h"
+
+#include <ast/function_node.h>
+#include <base/statistics.h>
+
+namespace Generation
+{
+    namespace
+    {
+        // Components of a scalar, vector or matrix type
+        int GetComponentCount( const std::string & type )
+        {
+            const size_t
+                digit = type.find_first_of( "1234" );
+
+            if( digit == std::string::npos )
+            {
+                return 1;
+            }
+
+            int
+                count = type[ digit ] - '0';
+
+            if( digit + 2 < type.size() && type[ digit + 1 ] == 'x' )
+            {
+                count *= type[ digit + 2 ] - '0';
+            }
+
+            return count;
+        }
+
+        bool IsFloatType( const std::string & type )
+        {
+            return type.compare( 0, 5, "float" ) == 0 || type.compare( 0, 4, "half" ) == 0 || type.compare( 0, 6, "double" ) == 0;
+        }
+
+        bool IsInput( const AST::Argument & argument )
+        {
+            return argument.m_InputModifier.empty() || argument.m_InputModifier == "in";
+        }
+
+        // Tracks which local variables depend on the arguments, and counts the
+        // operations of the analyzed code
+        class AffineAnalyzer
+        {
+        public:
+
+            AffineAnalyzer() : m_Cost( 0 ) {}
+
+            void AddArgument( const std::string & name )
+            {
+                m_LocalVariableSet.insert( name );
+                m_DependentVariableSet.insert( name );
+            }
+
+            int GetCost() const { return m_Cost; }
+
+            bool AnalyzeStatement( const AST::Statement & statement );
+
+            bool AnalyzeExpression( bool & is_dependent, const AST::Expression & expression );
+
+        private:
+
+            bool IsDependent( const std::string & name ) const
+            {
+                return m_DependentVariableSet.find( name ) != m_DependentVariableSet.end();
+            }
+
+            void SetDependent( const std::string & name, const bool is_dependent )
+            {
+                if( is_dependent )
+                {
+                    m_DependentVariableSet.insert( name );
+                }
+                else
+                {
+                    m_DependentVariableSet.erase( name );
+                }
+            }
+
+            bool AnalyzeArguments(
+                std::vector<bool> & dependency_table,
+                const AST::ArgumentExpressionList * argument_list
+                );
+
+            bool AnalyzeAssignment( const AST::AssignmentExpression & assignment );
+
+            std::set<std::string>
+                m_LocalVariableSet,
+                m_DependentVariableSet;
+            int
+                m_Cost;
+        };
+
+        bool AffineAnalyzer::AnalyzeArguments(
+            std::vector<bool> & dependency_table,
+            const AST::ArgumentExpressionList * argument_list
+            )
+        {
+            if( !argument_list )
+            {
+                return true;
+            }
+
+            std::vector<Base::ObjectRef<AST::Expression> >::const_iterator it, end;
+
+            for( it = argument_list->m_ExpressionList.begin(), end = argument_list->m_ExpressionList.end(); it != end; ++it )
+            {
+                bool
+                    is_dependent;
+
+                if( !AnalyzeExpression( is_dependent, **it ) )
+                {
+                    return false;
+                }
+
+                dependency_table.push_back( is_dependent );
+            }
+
+            return true;
+        }
+
+        bool AffineAnalyzer::AnalyzeExpression( bool & is_dependent, const AST::Expression & expression )
+        {
+            is_dependent = false;
+
+            switch( expression.m_Kind )
+            {
+                case AST::NodeKind_LiteralExpression:
+                    return true;
+
+                case AST::NodeKind_VariableExpression:
+                {
+                    const AST::VariableExpression
+                        & variable = static_cast<const AST::VariableExpression &>( expression );
+
+                    if( variable.m_SubscriptExpression )
+                    {
+                        bool
+                            subscript_is_dependent;
+
+                        // Indexing by an interpolated value is not linear
+                        if( !AnalyzeExpression( subscript_is_dependent, *variable.m_SubscriptExpression ) || subscript_is_dependent )
+                        {
+                            return false;
+                        }
+                    }
+
+                    is_dependent = IsDependent( variable.m_Name );
+
+                    return true;
+                }
+
+                case AST::NodeKind_UnaryOperationExpression:
+                {
+                    const AST::UnaryOperationExpression
+                        & unary = static_cast<const AST::UnaryOperationExpression &>( expression );
+
+                    if( !AnalyzeExpression( is_dependent, *unary.m_Expression ) )
+                    {
+                        return false;
+                    }
+
+                    ++m_Cost;
+
+                    return unary.m_Operation == AST::UnaryOperationExpression::Plus
+                        || unary.m_Operation == AST::UnaryOperationExpression::Minus
+                        || !is_dependent;
+                }
+
+                case AST::NodeKind_BinaryOperationExpression:
+                {
+                    const AST::BinaryOperationExpression
+                        & binary = static_cast<const AST::BinaryOperationExpression &>( expression );
+                    bool
+                        left_is_dependent,
+                        right_is_dependent;
+
+                    if( !AnalyzeExpression( left_is_dependent, *binary.m_LeftExpression )
+                        || !AnalyzeExpression( right_is_dependent, *binary.m_RightExpression )
+                        )
+                    {
+                        return false;
+                    }
+
+                    ++m_Cost;
+                    is_dependent = left_is_dependent || right_is_dependent;
+
+                    switch( binary.m_Operation )
+                    {
+                        case AST::BinaryOperationExpression::Addition:
+                        case AST::BinaryOperationExpression::Subtraction:
+                            return true;
+
+                        case AST::BinaryOperationExpression::Multiplication:
+                            return !left_is_dependent || !right_is_dependent;
+
+                        case AST::BinaryOperationExpression::Division:
+                            return !right_is_dependent;
+
+                        default:
+                            return !is_dependent;
+                    }
+                }
+
+                case AST::NodeKind_CallExpression:
+                {
+                    const AST::CallExpression
+                        & call = static_cast<const AST::CallExpression &>( expression );
+                    std::vector<bool>
+                        dependency_table;
+                    int
+                        dependent_count = 0;
+
+                    if( !AnalyzeArguments( dependency_table, &*call.m_ArgumentExpressionList ) )
+                    {
+                        return false;
+                    }
+
+                    for( size_t index = 0; index < dependency_table.size(); ++index )
+                    {
+                        dependent_count += dependency_table[ index ] ? 1 : 0;
+                    }
+
+                    ++m_Cost;
+                    is_dependent = dependent_count > 0;
+
+                    // Bilinear intrinsics are affine when one side is constant
+                    if( call.m_Name == "mul" || call.m_Name == "dot" || call.m_Name == "cross" )
+                    {
+                        return dependent_count <= 1;
+                    }
+
+                    if( call.m_Name == "lerp" && dependency_table.size() == 3 )
+                    {
+                        return !dependency_table[ 2 ] || ( !dependency_table[ 0 ] && !dependency_table[ 1 ] );
+                    }
+
+                    return !is_dependent;
+                }
+
+                case AST::NodeKind_ConstructorExpression:
+                {
+                    const AST::ConstructorExpression
+                        & constructor = static_cast<const AST::ConstructorExpression &>( expression );
+                    std::vector<bool>
+                        dependency_table;
+
+                    if( !AnalyzeArguments( dependency_table, &*constructor.m_ArgumentExpressionList ) )
+                    {
+                        return false;
+                    }
+
+                    for( size_t index = 0; index < dependency_table.size(); ++index )
+                    {
+                        is_dependent = is_dependent || dependency_table[ index ];
+                    }
+
+                    return !is_dependent || IsFloatType( constructor.m_Type->m_Name );
+                }
+
+                case AST::NodeKind_CastExpression:
+                {
+                    const AST::CastExpression
+                        & cast = static_cast<const AST::CastExpression &>( expression );
+
+                    if( !AnalyzeExpression( is_dependent, *cast.m_Expression ) )
+                    {
+                        return false;
+                    }
+
+                    return !is_dependent || IsFloatType( cast.m_Type->m_Name );
+                }
+
+                case AST::NodeKind_ConditionalExpression:
+                {
+                    const AST::ConditionalExpression
+                        & conditional = static_cast<const AST::ConditionalExpression &>( expression );
+                    bool
+                        condition_is_dependent,
+                        true_is_dependent,
+                        false_is_dependent;
+
+                    if( !AnalyzeExpression( condition_is_dependent, *conditional.m_Condition )
+                        || condition_is_dependent
+                        || !AnalyzeExpression( true_is_dependent, *conditional.m_IfTrue )
+                        || !AnalyzeExpression( false_is_dependent, *conditional.m_IfFalse )
+                        )
+                    {
+                        return false;
+                    }
+
+                    ++m_Cost;
+                    is_dependent = true_is_dependent || false_is_dependent;
+
+                    return true;
+                }
+
+                case AST::NodeKind_PostfixExpression:
+                {
+                    const AST::PostfixExpression
+                        & postfix = static_cast<const AST::PostfixExpression &>( expression );
+
+                    if( !AnalyzeExpression( is_dependent, *postfix.m_Expression ) )
+                    {
+                        return false;
+                    }
+
+                    if( !postfix.m_Suffix || postfix.m_Suffix->m_Kind == AST::NodeKind_Swizzle )
+                    {
+                        return true;
+                    }
+
+                    // Members of a dependent structure, or methods like Sample, are not followed
+                    if( postfix.m_Suffix->m_Kind == AST::NodeKind_PostfixSuffixCall )
+                    {
+                        const AST::PostfixSuffixCall
+                            & suffix = static_cast<const AST::PostfixSuffixCall &>( *postfix.m_Suffix );
+                        bool
+                            call_is_dependent;
+
+                        if( !AnalyzeExpression( call_is_dependent, *suffix.m_CallExpression ) )
+                        {
+                            return false;
+                        }
+
+                        is_dependent = is_dependent || call_is_dependent;
+                    }
+
+                    return !is_dependent;
+                }
+
+                default:
+                    return false;
+            }
+        }
+
+        bool AffineAnalyzer::AnalyzeAssignment( const AST::AssignmentExpression & assignment )
+        {
+            const AST::LValueExpression
+                & lvalue = *assignment.m_LValueExpression;
+            const std::string
+                & name = lvalue.m_VariableExpression->m_Name;
+            bool
+                variable_is_dependent,
+                value_is_dependent;
+
+            // Writing to a global would change the behavior of the other functions
+            if( m_LocalVariableSet.find( name ) == m_LocalVariableSet.end()
+                || ( lvalue.m_Suffix && lvalue.m_Suffix->m_Kind != AST::NodeKind_Swizzle )
+                || !AnalyzeExpression( variable_is_dependent, *lvalue.m_VariableExpression )
+                || !AnalyzeExpression( value_is_dependent, *assignment.m_Expression )
+                )
+            {
+                return false;
+            }
+
+            switch( assignment.m_Operator )
+            {
+                case AST::AssignmentOperator_Assign:
+                    // A partial write keeps the other components
+                    SetDependent( name, value_is_dependent || ( lvalue.m_Suffix && variable_is_dependent ) );
+                    return true;
+
+                case AST::AssignmentOperator_Add:
+                case AST::AssignmentOperator_Subtract:
+                    ++m_Cost;
+                    SetDependent( name, variable_is_dependent || value_is_dependent );
+                    return true;
+
+                case AST::AssignmentOperator_Multiply:
+                    ++m_Cost;
+                    SetDependent( name, variable_is_dependent || value_is_dependent );
+                    return !variable_is_dependent || !value_is_dependent;
+
+                case AST::AssignmentOperator_Divide:
+                    ++m_Cost;
+                    return !value_is_dependent;
+
+                default:
+                    ++m_Cost;
+                    return !variable_is_dependent && !value_is_dependent;
+            }
+        }
+
+        bool AffineAnalyzer::AnalyzeStatement( const AST::Statement & statement )
+        {
+            switch( statement.m_Kind )
+            {
+                case AST::NodeKind_EmptyStatement:
+                    return true;
+
+                case AST::NodeKind_ReturnStatement:
+                {
+                    const AST::ReturnStatement
+                        & return_statement = static_cast<const AST::ReturnStatement &>( statement );
+                    bool
+                        is_dependent;
+
+                    return return_statement.m_Expression && AnalyzeExpression( is_dependent, *return_statement.m_Expression );
+                }
+
+                case AST::NodeKind_AssignmentStatement:
+                    return AnalyzeAssignment( *static_cast<const AST::AssignmentStatement &>( statement ).m_Expression );
+
+                case AST::NodeKind_BlockStatement:
+                {
+                    const AST::BlockStatement
+                        & block = static_cast<const AST::BlockStatement &>( statement );
+                    std::vector<Base::ObjectRef<AST::Statement> >::const_iterator it, end;
+
+                    for( it = block.m_StatementTable.begin(), end = block.m_StatementTable.end(); it != end; ++it )
+                    {
+                        if( !AnalyzeStatement( **it ) )
+                        {
+                            return false;
+                        }
+                    }
+
+                    return true;
+                }
+
+                case AST::NodeKind_VariableDeclarationStatement:
+                {
+                    const AST::VariableDeclarationStatement
+                        & declaration = static_cast<const AST::VariableDeclarationStatement &>( statement );
+                    std::vector<Base::ObjectRef<AST::VariableDeclarationBody> >::const_iterator it, end;
+
+                    for( it = declaration.m_BodyTable.begin(), end = declaration.m_BodyTable.end(); it != end; ++it )
+                    {
+                        bool
+                            is_dependent = false;
+
+                        if( (*it)->m_InitialValue )
+                        {
+                            std::vector<Base::ObjectRef<AST::Expression> >::const_iterator value_it, value_end;
+
+                            value_it = (*it)->m_InitialValue->m_ExpressionTable.begin();
+                            value_end = (*it)->m_InitialValue->m_ExpressionTable.end();
+
+                            for( ; value_it != value_end; ++value_it )
+                            {
+                                bool
+                                    value_is_dependent;
+
+                                if( !AnalyzeExpression( value_is_dependent, **value_it ) )
+                                {
+                                    return false;
+                                }
+
+                                is_dependent = is_dependent || value_is_dependent;
+                            }
+                        }
+
+                        if( is_dependent && !IsFloatType( declaration.m_Type->m_Name ) )
+                        {
+                            return false;
+                        }
+
+                        m_LocalVariableSet.insert( (*it)->m_Name );
+                        SetDependent( (*it)->m_Name, is_dependent );
+                    }
+
+                    return true;
+                }
+
+                default:
+                    return false;
+            }
+        }
+
+        const AST::FunctionDeclaration * FindMainFunction( const AST::TranslationUnit & translation_unit )
+        {
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_reverse_iterator it, end;
+
+            for( it = translation_unit.m_GlobalDeclarationTable.rbegin(), end = translation_unit.m_GlobalDeclarationTable.rend(); it != end; ++it )
+            {
+                if( (*it)->m_Kind != AST::NodeKind_FunctionDeclaration )
+                {
+                    continue;
+                }
+
+                const AST::FunctionDeclaration
+                    & function = static_cast<const AST::FunctionDeclaration &>( **it );
+
+                if( function.m_Name == "main" && function.m_ArgumentList )
+                {
+                    return &function;
+                }
+            }
+
+            return 0;
+        }
+
+        // A call of the main function, with the semantic it assigns
+        struct MainCall
+        {
+            std::string
+                m_Semantic;
+            const AST::CallExpression
+                * m_Call;
+            std::set<std::string>
+                m_ArgumentSemanticSet;
+        };
+
+        void FillArgumentSemanticSet( MainCall & main_call )
+        {
+            if( !main_call.m_Call->m_ArgumentExpressionList )
+            {
+                return;
+            }
+
+            std::vector<Base::ObjectRef<AST::Expression> >::const_iterator it, end;
+
+            it = main_call.m_Call->m_ArgumentExpressionList->m_ExpressionList.begin();
+            end = main_call.m_Call->m_ArgumentExpressionList->m_ExpressionList.end();
+
+            for( ; it != end; ++it )
+            {
+                if( (*it)->m_Kind == AST::NodeKind_VariableExpression )
+                {
+                    main_call.m_ArgumentSemanticSet.insert( static_cast<const AST::VariableExpression &>( **it ).m_Name );
+                }
+            }
+        }
+    }
+
+    bool VertexStageMover::GetAffineCost(
+        int & cost,
+        const AST::FunctionDeclaration & function
+        )
+    {
+        AffineAnalyzer
+            analyzer;
+
+        if( !function.m_Type || function.m_Type->m_Name == "void" )
+        {
+            return false;
+        }
+
+        if( function.m_ArgumentList )
+        {
+            std::vector<Base::ObjectRef<AST::Argument> >::const_iterator it, end;
+
+            for( it = function.m_ArgumentList->m_ArgumentTable.begin(), end = function.m_ArgumentList->m_ArgumentTable.end(); it != end; ++it )
+            {
+                if( !IsInput( **it ) || !IsFloatType( (*it)->m_Type->m_Name ) )
+                {
+                    return false;
+                }
+
+                analyzer.AddArgument( (*it)->m_Name );
+            }
+        }
+
+        function.ResolveBody();
+
+        std::vector<Base::ObjectRef<AST::Statement> >::const_iterator it, end;
+
+        for( it = function.m_StatementTable.begin(), end = function.m_StatementTable.end(); it != end; ++it )
+        {
+            if( !analyzer.AnalyzeStatement( **it ) )
+            {
+                return false;
+            }
+        }
+
+        cost = analyzer.GetCost();
+
+        return true;
+    }
+
+    void VertexStageMover::FindMovableSemantics(
+        std::vector<std::string> & semantic_table,
+        const AST::TranslationUnit & pixel_program
+        )
+    {
+        const AST::FunctionDeclaration
+            * main_function = FindMainFunction( pixel_program );
+        std::map<std::string, const AST::FunctionDeclaration *>
+            function_table;
+        std::map<std::string, std::string>
+            semantic_type_table;
+        std::map<std::string, int>
+            consumer_count_table;
+        std::set<std::string>
+            interpolated_semantic_set,
+            output_semantic_set;
+        std::vector<MainCall>
+            main_call_table;
+
+        m_MovedFunctionTable.clear();
+
+        if( !main_function )
+        {
+            return;
+        }
+
+        Base::ScopedTimer
+            timer( "move_to_vertex_stage" );
+
+        std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator declaration_it, declaration_end;
+
+        declaration_it = pixel_program.m_GlobalDeclarationTable.begin();
+        declaration_end = pixel_program.m_GlobalDeclarationTable.end();
+
+        for( ; declaration_it != declaration_end; ++declaration_it )
+        {
+            if( (*declaration_it)->m_Kind == AST::NodeKind_FunctionDeclaration )
+            {
+                const AST::FunctionDeclaration
+                    & function = static_cast<const AST::FunctionDeclaration &>( **declaration_it );
+
+                function_table[ function.m_Name ] = &function;
+            }
+        }
+
+        std::vector<Base::ObjectRef<AST::Argument> >::const_iterator argument_it, argument_end;
+
+        argument_it = main_function->m_ArgumentList->m_ArgumentTable.begin();
+        argument_end = main_function->m_ArgumentList->m_ArgumentTable.end();
+
+        for( ; argument_it != argument_end; ++argument_it )
+        {
+            semantic_type_table[ (*argument_it)->m_Semantic ] = (*argument_it)->m_Type->m_Name;
+
+            if( IsInput( **argument_it ) )
+            {
+                interpolated_semantic_set.insert( (*argument_it)->m_Semantic );
+            }
+            else
+            {
+                output_semantic_set.insert( (*argument_it)->m_Semantic );
+            }
+        }
+
+        std::vector<Base::ObjectRef<AST::Statement> >::const_iterator statement_it, statement_end;
+
+        statement_it = main_function->m_StatementTable.begin();
+        statement_end = main_function->m_StatementTable.end();
+
+        for( ; statement_it != statement_end; ++statement_it )
+        {
+            MainCall
+                main_call;
+
+            if( (*statement_it)->m_Kind == AST::NodeKind_AssignmentStatement )
+            {
+                const AST::AssignmentExpression
+                    & assignment = *static_cast<const AST::AssignmentStatement &>( **statement_it ).m_Expression;
+
+                if( assignment.m_Expression->m_Kind != AST::NodeKind_CallExpression )
+                {
+                    continue;
+                }
+
+                main_call.m_Semantic = assignment.m_LValueExpression->m_VariableExpression->m_Name;
+                main_call.m_Call = &static_cast<const AST::CallExpression &>( *assignment.m_Expression );
+            }
+            else if( (*statement_it)->m_Kind == AST::NodeKind_ExpressionStatement )
+            {
+                const AST::Expression
+                    & expression = *static_cast<const AST::ExpressionStatement &>( **statement_it ).m_Expression;
+
+                if( expression.m_Kind != AST::NodeKind_CallExpression )
+                {
+                    continue;
+                }
+
+                main_call.m_Call = &static_cast<const AST::CallExpression &>( expression );
+            }
+            else
+            {
+                continue;
+            }
+
+            FillArgumentSemanticSet( main_call );
+
+            std::set<std::string>::const_iterator it, end;
+
+            for( it = main_call.m_ArgumentSemanticSet.begin(), end = main_call.m_ArgumentSemanticSet.end(); it != end; ++it )
+            {
+                ++consumer_count_table[ *it ];
+            }
+
+            main_call_table.push_back( main_call );
+        }
+
+        std::vector<MainCall>::const_iterator call_it, call_end;
+
+        for( call_it = main_call_table.begin(), call_end = main_call_table.end(); call_it != call_end; ++call_it )
+        {
+            const MainCall
+                & main_call = *call_it;
+            std::map<std::string, const AST::FunctionDeclaration *>::const_iterator
+                function = function_table.find( main_call.m_Call->m_Name );
+            std::set<std::string>::const_iterator it, end;
+            MovedFunction
+                moved_function;
+            bool
+                has_interpolated_arguments = true;
+
+            // A reused temporary does not hold the semantic of its name
+            if( main_call.m_Semantic.empty()
+                || output_semantic_set.find( main_call.m_Semantic ) != output_semantic_set.end()
+                || function == function_table.end()
+                || (*function).second->m_Semantic != main_call.m_Semantic
+                )
+            {
+                continue;
+            }
+
+            for( it = main_call.m_ArgumentSemanticSet.begin(), end = main_call.m_ArgumentSemanticSet.end(); it != end; ++it )
+            {
+                has_interpolated_arguments = has_interpolated_arguments
+                    && interpolated_semantic_set.find( *it ) != interpolated_semantic_set.end();
+            }
+
+            if( !has_interpolated_arguments || !GetAffineCost( moved_function.m_Cost, *(*function).second ) )
+            {
+                continue;
+            }
+
+            // Arguments only used by this call are not interpolated anymore
+            moved_function.m_InterpolatorComponentDelta = GetComponentCount( (*function).second->m_Type->m_Name );
+
+            for( it = main_call.m_ArgumentSemanticSet.begin(), end = main_call.m_ArgumentSemanticSet.end(); it != end; ++it )
+            {
+                if( consumer_count_table[ *it ] == 1 && output_semantic_set.find( *it ) == output_semantic_set.end() )
+                {
+                    moved_function.m_InterpolatorComponentDelta -= GetComponentCount( semantic_type_table[ *it ] );
+                }
+            }
+
+            if( moved_function.m_Cost <= moved_function.m_InterpolatorComponentDelta * m_InterpolatorComponentCost )
+            {
+                continue;
+            }
+
+            moved_function.m_Name = main_call.m_Call->m_Name;
+            moved_function.m_Semantic = main_call.m_Semantic;
+            m_MovedFunctionTable.push_back( moved_function );
+
+            semantic_table.push_back( main_call.m_Semantic );
+            interpolated_semantic_set.insert( main_call.m_Semantic );
+            semantic_type_table[ main_call.m_Semantic ] = (*function).second->m_Type->m_Name;
+
+            for( it = main_call.m_ArgumentSemanticSet.begin(), end = main_call.m_ArgumentSemanticSet.end(); it != end; ++it )
+            {
+                --consumer_count_table[ *it ];
+            }
+        }
+
+        Base::Statistics::AddCount( "vertex_moved_function_count", m_MovedFunctionTable.size() );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef VERTEX_STAGE_MOVER_H
+    #define VERTEX_STAGE_MOVER_H
+
+    #include <map>
+    #include <set>
+    #include <string>
+    #include <vector>
+    #include <ast/node.h>
+
+    namespace Generation
+    {
+        // Finds the calls of a generated pixel program which can be computed per vertex:
+        // their arguments are interpolated semantics, and their result is an affine
+        // function of them, so interpolating the result gives the same value as
+        // computing it from the interpolated arguments. Such a call is moved when the
+        // pixel operations it saves outweigh the interpolator components it adds.
+
+        class VertexStageMover
+        {
+        public:
+
+            struct MovedFunction
+            {
+                std::string
+                    m_Name,
+                    m_Semantic;
+                // Operations saved per pixel
+                int
+                    m_Cost,
+                    m_InterpolatorComponentDelta;
+            };
+
+            VertexStageMover() : m_InterpolatorComponentCost( 2 ) {}
+
+            // Pixel operations an interpolated component is worth
+            void SetInterpolatorComponentCost( const int cost ) { m_InterpolatorComponentCost = cost; }
+
+            // Adds the semantics to generate in the vertex program, in execution order
+            void FindMovableSemantics(
+                std::vector<std::string> & semantic_table,
+                const AST::TranslationUnit & pixel_program
+                );
+
+            const std::vector<MovedFunction> & GetMovedFunctionTable() const
+            {
+                return m_MovedFunctionTable;
+            }
+
+            // Returns false when the body is not affine in the arguments, else its
+            // operation count
+            static bool GetAffineCost(
+                int & cost,
+                const AST::FunctionDeclaration & function
+                );
+
+        private:
+
+            std::vector<MovedFunction>
+                m_MovedFunctionTable;
+            int
+                m_InterpolatorComponentCost;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -22,6 +22,12 @@ options {
     #include <set>
     #include <algorithm>
     #include "ast/node.h"
+    #include "lazy_function_body.h"
+}
+
+@parser::apifuncs
+{
+    LazyFunctionBodyParsing = false;
 }
 
 @parser::members
@@ -106,6 +112,8 @@ options {
 
     std::set<std::string>
         TypeTable;
+    bool
+        LazyFunctionBodyParsing;
 }
 
 translation_unit returns [ AST::TranslationUnit * unit ]
@@ -374,9 +382,29 @@ function_declaration returns [AST::FunctionDeclaration * declaration = 0 ]
         ( type  { declaration->m_Type = $type.type; } | VOID_TOKEN ) Name=ID { declaration->m_Name = $Name.text; }
         LPAREN ( argument_list { declaration->m_ArgumentList = $argument_list.list; } )? RPAREN
         ( COLON semantic {declaration->m_Semantic = $semantic.text; })?
-        LCURLY
-            ( statement { declaration->AddStatement( $statement.statement ); } )*
-        RCURLY
+        (
+            { LazyFunctionBodyParsing }? => Begin=LCURLY skipped_function_body End=RCURLY
+            {
+                declaration->m_BodySource = new HLSL::LazyFunctionBody(
+                    std::string( (const char *)( $Begin->get_stopIndex() + 1 ), (const char *)$End->get_startIndex() ),
+                    $Begin->get_input()->get_fileName(),
+                    $Begin->get_line(),
+                    TypeTable
+                    );
+            }
+        |
+            LCURLY
+                ( statement { declaration->AddStatement( $statement.statement ); } )*
+            RCURLY
+        )
+    ;
+
+skipped_function_body
+    : ( LCURLY skipped_function_body RCURLY | ~( LCURLY | RCURLY ) )*
+    ;
+
+function_body[ AST::FunctionDeclaration * declaration ]
+    : ( statement { declaration->AddStatement( $statement.statement ); } )* EOF
     ;
 
 argument_list returns [ AST::ArgumentList * list = 0 ]
@@ -2,14 +2,205 @@
 
 #include "hlsl_parser/HLSLLexer.hpp"
 #include "hlsl_parser/HLSLParser.hpp"
+#include "hlsl_parser/preprocessor.h"
 #include "ast/node.h"
+#include "ast/node_size_report.h"
+#include "base/console_error_handler.h"
+#include "base/statistics.h"
 
-Base::ObjectRef<AST::TranslationUnit> HLSL::ParseHLSL( const string & filename )
+namespace
 {
-    HLSLLexerTraits::InputStreamType input( (ANTLR_UINT8*)filename.c_str(), ANTLR_ENC_8BIT );
-    HLSLLexer lexer( &input );
-    HLSLLexerTraits::TokenStreamType token_stream( ANTLR_SIZE_HINT, lexer.get_tokSource() );
-    HLSLParser parser( &token_stream );
+    AST::TranslationUnit * ParseText(
+        const std::string & text,
+        const std::string & path,
+        const std::set<std::string> & type_set,
+        const bool lazy_function_body_parsing
+        )
+    {
+        HLSLLexerTraits::InputStreamType input(
+            (const ANTLR_UINT8*)text.c_str(),
+            ANTLR_ENC_8BIT,
+            static_cast<ANTLR_UINT32>( text.size() ),
+            (ANTLR_UINT8*)path.c_str()
+            );
+        HLSLLexer lexer( &input );
+        HLSLLexerTraits::TokenStreamType token_stream( ANTLR_SIZE_HINT, lexer.get_tokSource() );
+        HLSLParser parser( &token_stream );
 
-    return parser.translation_unit();
+        parser.TypeTable = type_set;
+        parser.LazyFunctionBodyParsing = lazy_function_body_parsing;
+
+        AST::TranslationUnit
+            * translation_unit = parser.translation_unit();
+
+        Base::Statistics::AddCount( "token_count", token_stream.get_tokens().size() );
+
+        return translation_unit;
+    }
+
+    // type_set holds the user types visible at the include point on input, and
+    // receives the types defined by the unit and its own includes.
+    void ParseUnit(
+        HLSL::IncludeUnit & unit,
+        std::set<std::string> & type_set,
+        const bool lazy_function_body_parsing
+        )
+    {
+        std::vector<HLSL::IncludeUnit::Include>::const_iterator include_it, include_end;
+        std::vector< std::pair<int, std::string> >::const_iterator struct_it, struct_end;
+        std::set<std::string>
+            defined_type_set,
+            type_dependency_set;
+
+        include_it = unit.m_IncludeTable.begin();
+        include_end = unit.m_IncludeTable.end();
+        struct_it = unit.m_StructTable.begin();
+        struct_end = unit.m_StructTable.end();
+
+        for( ; include_it != include_end; ++include_it )
+        {
+            if( !(*include_it).m_Unit )
+            {
+                continue;
+            }
+
+            std::set<std::string>
+                include_type_set;
+
+            for( ; struct_it != struct_end && (*struct_it).first < (*include_it).m_Line; ++struct_it )
+            {
+                type_set.insert( (*struct_it).second );
+            }
+
+            include_type_set = type_set;
+            ParseUnit( *(*include_it).m_Unit, include_type_set, lazy_function_body_parsing );
+
+            type_set.insert( (*include_it).m_Unit->m_DefinedTypeSet.begin(), (*include_it).m_Unit->m_DefinedTypeSet.end() );
+            defined_type_set.insert( (*include_it).m_Unit->m_DefinedTypeSet.begin(), (*include_it).m_Unit->m_DefinedTypeSet.end() );
+        }
+
+        // Only the visible types the unit actually mentions can change its parse
+        {
+            std::set<std::string>::const_iterator it, end;
+
+            for( it = type_set.begin(), end = type_set.end(); it != end; ++it )
+            {
+                if( unit.m_IdentifierSet.find( *it ) != unit.m_IdentifierSet.end() )
+                {
+                    type_dependency_set.insert( *it );
+                }
+            }
+        }
+
+        if( !unit.m_TranslationUnit || unit.m_TypeDependencySet != type_dependency_set )
+        {
+            unit.m_TranslationUnit = ParseText( unit.m_Text, unit.m_Path, type_dependency_set, lazy_function_body_parsing );
+            unit.m_TypeDependencySet = type_dependency_set;
+
+            if( Base::Statistics::IsEnabled() && unit.m_TranslationUnit )
+            {
+                AST::NodeSizeReport
+                    report;
+
+                unit.m_TranslationUnit->Visit( report );
+                Base::Statistics::AddCount( "ast_node_count", report.GetNodeCount() );
+            }
+        }
+
+        for( struct_it = unit.m_StructTable.begin(); struct_it != struct_end; ++struct_it )
+        {
+            defined_type_set.insert( (*struct_it).second );
+        }
+
+        type_set.insert( defined_type_set.begin(), defined_type_set.end() );
+        unit.m_DefinedTypeSet.swap( defined_type_set );
+    }
+
+    // Declarations of included units are inserted before the first declaration
+    // following the #include line.
+    void AppendUnit(
+        AST::TranslationUnit & translation_unit,
+        const HLSL::IncludeUnit & unit
+        )
+    {
+        std::vector<HLSL::IncludeUnit::Include>::const_iterator include_it, include_end;
+        std::vector< Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+
+        include_it = unit.m_IncludeTable.begin();
+        include_end = unit.m_IncludeTable.end();
+        it = unit.m_TranslationUnit->m_GlobalDeclarationTable.begin();
+        end = unit.m_TranslationUnit->m_GlobalDeclarationTable.end();
+
+        for( ; it != end; ++it )
+        {
+            for( ; include_it != include_end && (*include_it).m_Line < (*it)->GetLine(); ++include_it )
+            {
+                if( (*include_it).m_Unit )
+                {
+                    AppendUnit( translation_unit, *(*include_it).m_Unit );
+                }
+            }
+
+            translation_unit.m_GlobalDeclarationTable.push_back( *it );
+        }
+
+        for( ; include_it != include_end; ++include_it )
+        {
+            if( (*include_it).m_Unit )
+            {
+                AppendUnit( translation_unit, *(*include_it).m_Unit );
+            }
+        }
+
+        translation_unit.m_TechniqueTable.insert(
+            translation_unit.m_TechniqueTable.end(),
+            unit.m_TranslationUnit->m_TechniqueTable.begin(),
+            unit.m_TranslationUnit->m_TechniqueTable.end()
+            );
+    }
+}
+
+Base::ObjectRef<AST::TranslationUnit> HLSL::ParseHLSL( const std::string & filename )
+{
+    IncludeCache::Ref
+        cache = new IncludeCache;
+    Base::ErrorHandlerInterface::Ref
+        error_handler = new Base::ConsoleErrorHandler;
+    Preprocessor
+        preprocessor( *cache, *error_handler );
+
+    return ParseHLSL( filename, preprocessor );
+}
+
+Base::ObjectRef<AST::TranslationUnit> HLSL::ParseHLSL(
+    const std::string & filename,
+    Preprocessor & preprocessor,
+    const bool lazy_function_body_parsing
+    )
+{
+    Base::ScopedTimer
+        timer( "parse", filename );
+    IncludeUnit::Ref
+        unit = preprocessor.Process( filename );
+    std::set<std::string>
+        type_set;
+
+    if( !unit )
+    {
+        return 0;
+    }
+
+    ParseUnit( *unit, type_set, lazy_function_body_parsing );
+
+    if( unit->m_IncludeTable.empty() )
+    {
+        return unit->m_TranslationUnit;
+    }
+
+    Base::ObjectRef<AST::TranslationUnit>
+        translation_unit = new AST::TranslationUnit;
+
+    AppendUnit( *translation_unit, *unit );
+
+    return translation_unit;
 }
\ No newline at end of file
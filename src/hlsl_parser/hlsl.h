@@ -7,7 +7,19 @@
 
     namespace HLSL
     {
+        class Preprocessor;
+
         Base::ObjectRef<AST::TranslationUnit> ParseHLSL( const std::string & filename );
+
+        // Included files are parsed once per preprocessor cache and their
+        // declarations are shared between the returned translation units.
+        // In lazy mode, function bodies are only parsed when first needed, see
+        // AST::FunctionDeclaration::ResolveBody.
+        Base::ObjectRef<AST::TranslationUnit> ParseHLSL(
+            const std::string & filename,
+            Preprocessor & preprocessor,
+            const bool lazy_function_body_parsing = false
+            );
     }
 
 #endif
\ No newline at end of file
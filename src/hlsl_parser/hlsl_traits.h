@@ -27,36 +27,33 @@
         class RuleReturnValueType : public antlr3::RuleReturnValue<HLSLParserTraits>
         {
             const CommonTokenType*  m_StartToken;
-            int m_PreviousLine;
-            StringType m_PreviousFile;
+            AST::SourceLocation m_PreviousLocation;
 
         public:
 
             RuleReturnValueType()
                 : RuleReturnValue(),
                 m_StartToken( 0 ),
-                m_PreviousLine( -1 ),
-                m_PreviousFile()
+                m_PreviousLocation()
             {
             }
 
             RuleReturnValueType( BaseParserType* parser )
                 : RuleReturnValue( parser ),
                 m_StartToken( parser->LT( 1 ) ),
-                m_PreviousLine( AST::Node::GetCurrentLine() ),
-                m_PreviousFile( AST::Node::GetCurrentFileName() )
+                m_PreviousLocation( AST::Node::GetCurrentLocation() )
             {
                 AST::Node::SetDebugInfo(
                     m_StartToken->get_input()->get_fileName(),
-                    m_StartToken->get_line()
+                    m_StartToken->get_line(),
+                    m_StartToken->get_charPositionInLine()
                     );
             }
 
             RuleReturnValueType( const RuleReturnValueType& other )
                 : RuleReturnValue( other ),
                 m_StartToken( other.m_StartToken ),
-                m_PreviousLine( other.m_PreviousLine ),
-                m_PreviousFile( other.m_PreviousFile )
+                m_PreviousLocation( other.m_PreviousLocation )
             {
             }
 
@@ -64,15 +61,14 @@
             {
                 RuleReturnValue::operator=( other );
                 m_StartToken = other.m_StartToken;
-                m_PreviousLine = other.m_PreviousLine;
-                m_PreviousFile = other.m_PreviousFile;
+                m_PreviousLocation = other.m_PreviousLocation;
 
                 return *this;
             }
 
             ~RuleReturnValueType()
             {
-                AST::Node::SetDebugInfo( m_PreviousFile, m_PreviousLine );
+                AST::Node::SetDebugInfo( m_PreviousLocation );
             }
         };
     };
@@ -0,0 +1,172 @@
+#include "include_cache.h"
+
+#include "HLSLLexer.hpp"
+#include "hlsl_traits.h"
+#include <fstream>
+#include <sstream>
+#include <utils/hash.h>
+
+namespace HLSL
+{
+    namespace
+    {
+        bool MatchesMacroDependencies(
+            const IncludeUnit & unit,
+            const MacroTable & macro_table
+            )
+        {
+            std::vector<IncludeUnit::MacroDependency>::const_iterator it, end;
+
+            it = unit.m_MacroDependencyTable.begin();
+            end = unit.m_MacroDependencyTable.end();
+
+            for( ; it != end; ++it )
+            {
+                MacroTable::const_iterator macro = macro_table.find( (*it).m_Name );
+
+                if( ( macro != macro_table.end() ) != (*it).m_IsDefined )
+                {
+                    return false;
+                }
+
+                if( (*it).m_IsDefined && (*macro).second != (*it).m_Definition )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool MatchesOnceDependencies(
+            const IncludeUnit & unit,
+            const std::set<std::string> & once_file_set
+            )
+        {
+            std::vector<IncludeUnit::OnceDependency>::const_iterator it, end;
+
+            it = unit.m_OnceDependencyTable.begin();
+            end = unit.m_OnceDependencyTable.end();
+
+            for( ; it != end; ++it )
+            {
+                if( ( once_file_set.find( (*it).m_Path ) != once_file_set.end() ) != (*it).m_WasIncluded )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    bool IncludeCache::ReadFile(
+        std::string & content,
+        const std::string & path
+        ) const
+    {
+        typedef antlr3::FileUtils< antlr3::TraitsBase< HLSLUserTraits > >
+            FileUtilsType;
+
+        if( FileUtilsType::ReadFileContentCallback )
+        {
+            size_t
+                length;
+
+            FileUtilsType::ReadFileContentCallback( NULL, length, path.c_str() );
+
+            if( !length )
+            {
+                return false;
+            }
+
+            content.resize( length );
+            FileUtilsType::ReadFileContentCallback( &content[ 0 ], length, path.c_str() );
+
+            return true;
+        }
+
+        std::ifstream
+            file( path.c_str(), std::ios::in | std::ios::binary );
+
+        if( !file )
+        {
+            return false;
+        }
+
+        std::ostringstream
+            stream;
+
+        stream << file.rdbuf();
+        content = stream.str();
+
+        return true;
+    }
+
+    IncludeUnit::Ref IncludeCache::FindUnit(
+        const std::string & path,
+        const uint64_t content_hash,
+        const MacroTable & macro_table,
+        const std::set<std::string> & once_file_set
+        )
+    {
+        typedef std::multimap<std::string, IncludeUnit::Ref>::iterator
+            unit_iterator;
+
+        std::pair<unit_iterator, unit_iterator>
+            range = m_UnitTable.equal_range( path );
+
+        for( unit_iterator it = range.first; it != range.second; ++it )
+        {
+            const IncludeUnit & unit = *(*it).second;
+
+            if( unit.m_ContentHash == content_hash
+                && MatchesMacroDependencies( unit, macro_table )
+                && MatchesOnceDependencies( unit, once_file_set )
+                )
+            {
+                ++m_HitCount;
+                return (*it).second;
+            }
+        }
+
+        ++m_MissCount;
+        return 0;
+    }
+
+    void IncludeCache::AddUnit( IncludeUnit & unit )
+    {
+        typedef std::multimap<std::string, IncludeUnit::Ref>::iterator
+            unit_iterator;
+
+        std::pair<unit_iterator, unit_iterator>
+            range = m_UnitTable.equal_range( unit.m_Path );
+
+        // Units built from an older version of the file can never match again
+        for( unit_iterator it = range.first; it != range.second; )
+        {
+            if( (*it).second->m_ContentHash != unit.m_ContentHash )
+            {
+                m_UnitTable.erase( it++ );
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        m_UnitTable.insert( std::make_pair( unit.m_Path, IncludeUnit::Ref( &unit ) ) );
+    }
+
+    void IncludeCache::Clear()
+    {
+        m_UnitTable.clear();
+        m_HitCount = 0;
+        m_MissCount = 0;
+    }
+
+    uint64_t IncludeCache::ComputeHash( const std::string & content )
+    {
+        return compute_content_hash( content );
+    }
+}
@@ -0,0 +1,167 @@
+#ifndef INCLUDE_CACHE_H
+    #define INCLUDE_CACHE_H
+
+    #include <cstdint>
+    #include <map>
+    #include <set>
+    #include <string>
+    #include <vector>
+    #include <base/object.h>
+    #include <base/object_ref.h>
+    #include <ast/node.h>
+
+    namespace HLSL
+    {
+        struct MacroDefinition
+        {
+            MacroDefinition() : m_IsFunctionLike( false ) {}
+
+            bool operator ==( const MacroDefinition & other ) const
+            {
+                return m_IsFunctionLike == other.m_IsFunctionLike
+                    && m_ParameterTable == other.m_ParameterTable
+                    && m_Value == other.m_Value;
+            }
+
+            bool operator !=( const MacroDefinition & other ) const { return !( *this == other ); }
+
+            bool
+                m_IsFunctionLike;
+            std::vector<std::string>
+                m_ParameterTable;
+            std::string
+                m_Value;
+        };
+
+        typedef std::map<std::string, MacroDefinition>
+            MacroTable;
+
+        // Preprocessed form of a single source file. Directive lines are blanked so
+        // the text always has the line count of the original file, which keeps the
+        // lexer line numbers valid for AST::Node debug info.
+
+        struct IncludeUnit : public Base::Object
+        {
+            typedef Base::ObjectRef<IncludeUnit>
+                Ref;
+
+            struct Include
+            {
+                int
+                    m_Line;
+                std::string
+                    m_Path;
+                // Null when the include was skipped because of #pragma once
+                Ref
+                    m_Unit;
+            };
+
+            struct MacroDependency
+            {
+                std::string
+                    m_Name;
+                bool
+                    m_IsDefined;
+                MacroDefinition
+                    m_Definition;
+            };
+
+            struct OnceDependency
+            {
+                std::string
+                    m_Path;
+                bool
+                    m_WasIncluded;
+            };
+
+            struct MacroOperation
+            {
+                std::string
+                    m_Name;
+                bool
+                    m_IsDefine;
+                MacroDefinition
+                    m_Definition;
+            };
+
+            IncludeUnit() : m_ContentHash( 0 ), m_HasPragmaOnce( false ) {}
+
+            std::string
+                m_Path,
+                m_Text;
+            uint64_t
+                m_ContentHash;
+            bool
+                m_HasPragmaOnce;
+
+            // Macro and #pragma once state read from the including context. A cached
+            // unit can only be reused when all of them still match.
+            std::vector<MacroDependency>
+                m_MacroDependencyTable;
+            std::vector<OnceDependency>
+                m_OnceDependencyTable;
+
+            // Side effects replayed on the including context when the unit is reused.
+            std::vector<MacroOperation>
+                m_MacroOperationTable;
+            std::vector<std::string>
+                m_OnceFileTable;
+
+            std::vector<Include>
+                m_IncludeTable;
+            std::vector< std::pair<int, std::string> >
+                m_StructTable;
+            std::set<std::string>
+                m_IdentifierSet;
+
+            // Parse results, filled by HLSL::ParseHLSL. The parse only depends on the
+            // user defined types visible at include point that the unit mentions.
+            Base::ObjectRef<AST::TranslationUnit>
+                m_TranslationUnit;
+            std::set<std::string>
+                m_TypeDependencySet,
+                m_DefinedTypeSet;
+        };
+
+        class IncludeCache : public Base::Object
+        {
+        public:
+
+            typedef Base::ObjectRef<IncludeCache>
+                Ref;
+
+            IncludeCache() : m_HitCount( 0 ), m_MissCount( 0 ) {}
+            virtual ~IncludeCache() {}
+
+            virtual bool ReadFile(
+                std::string & content,
+                const std::string & path
+                ) const;
+
+            IncludeUnit::Ref FindUnit(
+                const std::string & path,
+                const uint64_t content_hash,
+                const MacroTable & macro_table,
+                const std::set<std::string> & once_file_set
+                );
+
+            void AddUnit( IncludeUnit & unit );
+
+            void Clear();
+
+            static uint64_t ComputeHash( const std::string & content );
+
+            int GetHitCount() const { return m_HitCount; }
+            int GetMissCount() const { return m_MissCount; }
+
+        private:
+
+            std::multimap<std::string, IncludeUnit::Ref>
+                m_UnitTable;
+            int
+                m_HitCount,
+                m_MissCount;
+        };
+    }
+
+#endif
@@ -0,0 +1,41 @@
+#include "lazy_function_body.h"
+
+#include "hlsl_parser/HLSLLexer.hpp"
+#include "hlsl_parser/HLSLParser.hpp"
+
+namespace HLSL
+{
+    LazyFunctionBody::LazyFunctionBody(
+        const std::string & text,
+        const std::string & file_name,
+        const int line,
+        const std::set<std::string> & type_table
+        ) :
+        m_Text( text ),
+        m_FileName( file_name ),
+        m_Line( line ),
+        m_TypeTable( type_table )
+    {
+
+    }
+
+    void LazyFunctionBody::Parse( AST::FunctionDeclaration & declaration ) const
+    {
+        HLSLLexerTraits::InputStreamType input(
+            (const ANTLR_UINT8*)m_Text.c_str(),
+            ANTLR_ENC_8BIT,
+            static_cast<ANTLR_UINT32>( m_Text.size() ),
+            (ANTLR_UINT8*)m_FileName.c_str()
+            );
+        HLSLLexer lexer( &input );
+
+        // The body starts on the line of its opening brace
+        input.set_line( m_Line );
+
+        HLSLLexerTraits::TokenStreamType token_stream( ANTLR_SIZE_HINT, lexer.get_tokSource() );
+        HLSLParser parser( &token_stream );
+
+        parser.TypeTable = m_TypeTable;
+        parser.function_body( &declaration );
+    }
+}
\ No newline at end of file
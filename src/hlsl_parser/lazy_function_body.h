@@ -0,0 +1,38 @@
+#ifndef LAZY_FUNCTION_BODY_H
+    #define LAZY_FUNCTION_BODY_H
+
+    #include <set>
+    #include <string>
+    #include <ast/node.h>
+
+    namespace HLSL
+    {
+        // Body text of a function parsed in lazy mode, with the context needed
+        // to parse it later as if it had been parsed in place.
+
+        class LazyFunctionBody : public AST::FunctionBodySource
+        {
+        public:
+
+            LazyFunctionBody(
+                const std::string & text,
+                const std::string & file_name,
+                const int line,
+                const std::set<std::string> & type_table
+                );
+
+            virtual void Parse( AST::FunctionDeclaration & declaration ) const override;
+
+        private:
+
+            std::string
+                m_Text,
+                m_FileName;
+            int
+                m_Line;
+            std::set<std::string>
+                m_TypeTable;
+        };
+    }
+
+#endif
\ No newline at end of file
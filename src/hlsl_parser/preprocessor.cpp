@@ -0,0 +1,1680 @@
+#include "preprocessor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace HLSL
+{
+    namespace
+    {
+        bool IsIdentifierStart( const char character )
+        {
+            return ( character >= 'a' && character <= 'z' )
+                || ( character >= 'A' && character <= 'Z' )
+                || character == '_';
+        }
+
+        bool IsIdentifierCharacter( const char character )
+        {
+            return IsIdentifierStart( character ) || ( character >= '0' && character <= '9' );
+        }
+
+        bool IsDigit( const char character )
+        {
+            return character >= '0' && character <= '9';
+        }
+
+        bool IsSpace( const char character )
+        {
+            return character == ' ' || character == '\t' || character == '\r' || character == '\f' || character == '\v';
+        }
+
+        std::string Trim( const std::string & text )
+        {
+            size_t
+                first = 0,
+                last = text.size();
+
+            while( first < last && IsSpace( text[ first ] ) )
+            {
+                ++first;
+            }
+
+            while( last > first && IsSpace( text[ last - 1 ] ) )
+            {
+                --last;
+            }
+
+            return text.substr( first, last - first );
+        }
+
+        size_t SkipString( const std::string & text, size_t position )
+        {
+            const char
+                delimiter = text[ position ];
+
+            for( ++position; position < text.size(); ++position )
+            {
+                if( text[ position ] == '\\' )
+                {
+                    ++position;
+                }
+                else if( text[ position ] == delimiter )
+                {
+                    return position + 1;
+                }
+            }
+
+            return text.size();
+        }
+
+        size_t SkipNumber( const std::string & text, size_t position )
+        {
+            while( position < text.size() )
+            {
+                const char character = text[ position ];
+
+                if( IsIdentifierCharacter( character ) || character == '.' )
+                {
+                    ++position;
+                }
+                else if( ( character == '+' || character == '-' )
+                    && ( text[ position - 1 ] == 'e' || text[ position - 1 ] == 'E' ) )
+                {
+                    ++position;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            return position;
+        }
+
+        // Removes the comments of a directive line, a comment left open is dropped
+        std::string StripComments( const std::string & text )
+        {
+            std::string
+                result;
+            size_t
+                position = 0;
+
+            while( position < text.size() )
+            {
+                if( text[ position ] == '"' )
+                {
+                    size_t end = SkipString( text, position );
+                    result.append( text, position, end - position );
+                    position = end;
+                }
+                else if( text.compare( position, 2, "//" ) == 0 )
+                {
+                    break;
+                }
+                else if( text.compare( position, 2, "/*" ) == 0 )
+                {
+                    size_t end = text.find( "*/", position + 2 );
+
+                    if( end == std::string::npos )
+                    {
+                        break;
+                    }
+
+                    result += ' ';
+                    position = end + 2;
+                }
+                else
+                {
+                    result += text[ position ];
+                    ++position;
+                }
+            }
+
+            return result;
+        }
+
+        std::string ReadIdentifier( const std::string & text, size_t & position )
+        {
+            while( position < text.size() && IsSpace( text[ position ] ) )
+            {
+                ++position;
+            }
+
+            size_t
+                start = position;
+
+            if( position < text.size() && IsIdentifierStart( text[ position ] ) )
+            {
+                while( position < text.size() && IsIdentifierCharacter( text[ position ] ) )
+                {
+                    ++position;
+                }
+            }
+
+            return text.substr( start, position - start );
+        }
+
+        // Collects the arguments of a function like macro invocation. On success,
+        // position is moved after the closing parenthesis.
+        bool CollectArguments(
+            std::vector<std::string> & argument_table,
+            const std::string & text,
+            size_t & position
+            )
+        {
+            size_t
+                current = position;
+            int
+                depth = 0;
+            std::string
+                argument;
+
+            while( current < text.size() && IsSpace( text[ current ] ) )
+            {
+                ++current;
+            }
+
+            if( current >= text.size() || text[ current ] != '(' )
+            {
+                return false;
+            }
+
+            for( ++current; current < text.size(); ++current )
+            {
+                const char character = text[ current ];
+
+                if( character == '"' )
+                {
+                    size_t end = SkipString( text, current );
+                    argument.append( text, current, end - current );
+                    current = end - 1;
+                }
+                else if( character == '(' )
+                {
+                    ++depth;
+                    argument += character;
+                }
+                else if( character == ')' )
+                {
+                    if( depth == 0 )
+                    {
+                        argument_table.push_back( Trim( argument ) );
+                        position = current + 1;
+                        return true;
+                    }
+
+                    --depth;
+                    argument += character;
+                }
+                else if( character == ',' && depth == 0 )
+                {
+                    argument_table.push_back( Trim( argument ) );
+                    argument.clear();
+                }
+                else
+                {
+                    argument += character;
+                }
+            }
+
+            return false;
+        }
+
+        class ConditionEvaluator
+        {
+        public:
+
+            ConditionEvaluator( const std::string & text ) : m_Text( text ), m_Position( 0 ), m_HasError( false ) {}
+
+            long long Evaluate()
+            {
+                long long value = ParseLogicalOr();
+
+                SkipSpaces();
+
+                if( m_Position != m_Text.size() )
+                {
+                    m_HasError = true;
+                }
+
+                return value;
+            }
+
+            bool HasError() const { return m_HasError; }
+
+        private:
+
+            void SkipSpaces()
+            {
+                while( m_Position < m_Text.size() && IsSpace( m_Text[ m_Position ] ) )
+                {
+                    ++m_Position;
+                }
+            }
+
+            bool Accept( const char * token )
+            {
+                SkipSpaces();
+
+                const size_t length = strlen( token );
+
+                if( m_Text.compare( m_Position, length, token ) == 0 )
+                {
+                    m_Position += length;
+                    return true;
+                }
+
+                return false;
+            }
+
+            long long ParseLogicalOr()
+            {
+                long long value = ParseLogicalAnd();
+
+                while( Accept( "||" ) )
+                {
+                    long long right = ParseLogicalAnd();
+                    value = value || right;
+                }
+
+                return value;
+            }
+
+            long long ParseLogicalAnd()
+            {
+                long long value = ParseEquality();
+
+                while( Accept( "&&" ) )
+                {
+                    long long right = ParseEquality();
+                    value = value && right;
+                }
+
+                return value;
+            }
+
+            long long ParseEquality()
+            {
+                long long value = ParseRelational();
+
+                for( ;; )
+                {
+                    if( Accept( "==" ) )
+                    {
+                        value = value == ParseRelational();
+                    }
+                    else if( Accept( "!=" ) )
+                    {
+                        value = value != ParseRelational();
+                    }
+                    else
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            long long ParseRelational()
+            {
+                long long value = ParseAdditive();
+
+                for( ;; )
+                {
+                    if( Accept( "<=" ) )
+                    {
+                        value = value <= ParseAdditive();
+                    }
+                    else if( Accept( ">=" ) )
+                    {
+                        value = value >= ParseAdditive();
+                    }
+                    else if( Accept( "<" ) )
+                    {
+                        value = value < ParseAdditive();
+                    }
+                    else if( Accept( ">" ) )
+                    {
+                        value = value > ParseAdditive();
+                    }
+                    else
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            long long ParseAdditive()
+            {
+                long long value = ParseMultiplicative();
+
+                for( ;; )
+                {
+                    if( Accept( "+" ) )
+                    {
+                        value += ParseMultiplicative();
+                    }
+                    else if( Accept( "-" ) )
+                    {
+                        value -= ParseMultiplicative();
+                    }
+                    else
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            long long ParseMultiplicative()
+            {
+                long long value = ParseUnary();
+
+                for( ;; )
+                {
+                    if( Accept( "*" ) )
+                    {
+                        value *= ParseUnary();
+                    }
+                    else if( Accept( "/" ) || Accept( "%" ) )
+                    {
+                        const bool is_division = m_Text[ m_Position - 1 ] == '/';
+                        long long right = ParseUnary();
+
+                        if( right == 0 )
+                        {
+                            m_HasError = true;
+                            return 0;
+                        }
+
+                        value = is_division ? value / right : value % right;
+                    }
+                    else
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            long long ParseUnary()
+            {
+                if( Accept( "!" ) )
+                {
+                    return !ParseUnary();
+                }
+                else if( Accept( "-" ) )
+                {
+                    return -ParseUnary();
+                }
+                else if( Accept( "+" ) )
+                {
+                    return ParseUnary();
+                }
+
+                return ParsePrimary();
+            }
+
+            long long ParsePrimary()
+            {
+                SkipSpaces();
+
+                if( Accept( "(" ) )
+                {
+                    long long value = ParseLogicalOr();
+
+                    if( !Accept( ")" ) )
+                    {
+                        m_HasError = true;
+                    }
+
+                    return value;
+                }
+
+                if( m_Position < m_Text.size() && IsDigit( m_Text[ m_Position ] ) )
+                {
+                    size_t
+                        end = SkipNumber( m_Text, m_Position );
+                    long long
+                        value = strtoll( m_Text.c_str() + m_Position, 0, 0 );
+
+                    m_Position = end;
+
+                    return value;
+                }
+
+                if( m_Position < m_Text.size() && IsIdentifierStart( m_Text[ m_Position ] ) )
+                {
+                    // Identifiers left after macro expansion evaluate to 0
+                    ReadIdentifier( m_Text, m_Position );
+                    return 0;
+                }
+
+                m_HasError = true;
+                return 0;
+            }
+
+            const std::string
+                & m_Text;
+            size_t
+                m_Position;
+            bool
+                m_HasError;
+
+            ConditionEvaluator & operator =( const ConditionEvaluator & );
+        };
+    }
+
+    Preprocessor::Preprocessor(
+        IncludeCache & cache,
+        Base::ErrorHandlerInterface & error_handler
+        ) :
+        m_Cache( &cache ),
+        m_ErrorHandler( &error_handler ),
+        m_HasErrors( false )
+    {
+
+    }
+
+    void Preprocessor::AddIncludePath( const std::string & path )
+    {
+        m_IncludePathTable.push_back( NormalizePath( path ) );
+    }
+
+    void Preprocessor::Define( const std::string & name, const std::string & value )
+    {
+        MacroDefinition
+            definition;
+
+        definition.m_Value = value;
+        m_PredefinedMacroTable[ name ] = definition;
+    }
+
+    void Preprocessor::GetDefineTable( std::vector<std::string> & define_table ) const
+    {
+        MacroTable::const_iterator it, end;
+
+        for( it = m_PredefinedMacroTable.begin(), end = m_PredefinedMacroTable.end(); it != end; ++it )
+        {
+            define_table.push_back( (*it).first + "=" + (*it).second.m_Value );
+        }
+    }
+
+    IncludeUnit::Ref Preprocessor::Process( const std::string & filename )
+    {
+        std::string
+            path = NormalizePath( filename ),
+            content;
+
+        BeginProcessing();
+
+        if( !m_Cache->ReadFile( content, path ) )
+        {
+            m_ErrorHandler->ReportError( "Unable to open file", path );
+            return 0;
+        }
+
+        return ProcessUnit( content, path );
+    }
+
+    IncludeUnit::Ref Preprocessor::ProcessSource(
+        const std::string & source,
+        const std::string & filename
+        )
+    {
+        BeginProcessing();
+
+        return ProcessUnit( source, NormalizePath( filename ) );
+    }
+
+    std::string Preprocessor::NormalizePath( const std::string & path )
+    {
+        std::vector<std::string>
+            part_table;
+        std::string
+            prefix,
+            part;
+        size_t
+            position = 0;
+
+        if( !path.empty() && ( path[ 0 ] == '/' || path[ 0 ] == '\\' ) )
+        {
+            prefix = "/";
+            position = 1;
+        }
+
+        for( ; position <= path.size(); ++position )
+        {
+            if( position == path.size() || path[ position ] == '/' || path[ position ] == '\\' )
+            {
+                if( part == ".." && !part_table.empty() && part_table.back() != ".." )
+                {
+                    part_table.pop_back();
+                }
+                else if( part == ".." && !prefix.empty() )
+                {
+                    // Already at root
+                }
+                else if( !part.empty() && part != "." )
+                {
+                    part_table.push_back( part );
+                }
+
+                part.clear();
+            }
+            else
+            {
+                part += path[ position ];
+            }
+        }
+
+        std::string
+            result = prefix;
+
+        for( std::vector<std::string>::const_iterator it = part_table.begin(), end = part_table.end(); it != end; ++it )
+        {
+            if( it != part_table.begin() )
+            {
+                result += '/';
+            }
+
+            result += *it;
+        }
+
+        return result;
+    }
+
+    void Preprocessor::BeginProcessing()
+    {
+        m_MacroTable = m_PredefinedMacroTable;
+        m_OnceFileSet.clear();
+        m_FrameStack.clear();
+        m_IncludedPathTable.clear();
+        m_HasErrors = false;
+    }
+
+    IncludeUnit::Ref Preprocessor::ProcessUnit(
+        const std::string & source,
+        const std::string & path
+        )
+    {
+        IncludeUnit::Ref
+            unit = new IncludeUnit;
+        Frame
+            frame;
+
+        unit->m_Path = path;
+        unit->m_ContentHash = IncludeCache::ComputeHash( source );
+        frame.m_Unit = &*unit;
+
+        m_FrameStack.push_back( &frame );
+        ProcessText( frame, source );
+        m_FrameStack.pop_back();
+
+        if( m_HasErrors )
+        {
+            return 0;
+        }
+
+        std::set<std::string>
+            path_set;
+
+        AddIncludedPaths( path_set, *unit );
+
+        return unit;
+    }
+
+    // Reused units keep the includes they were processed with
+    void Preprocessor::AddIncludedPaths( std::set<std::string> & path_set, const IncludeUnit & unit )
+    {
+        std::vector<IncludeUnit::Include>::const_iterator it, end;
+
+        for( it = unit.m_IncludeTable.begin(), end = unit.m_IncludeTable.end(); it != end; ++it )
+        {
+            if( path_set.insert( (*it).m_Path ).second )
+            {
+                m_IncludedPathTable.push_back( (*it).m_Path );
+            }
+
+            if( (*it).m_Unit )
+            {
+                AddIncludedPaths( path_set, *(*it).m_Unit );
+            }
+        }
+    }
+
+    void Preprocessor::ProcessText( Frame & frame, const std::string & source )
+    {
+        std::vector<std::string>
+            line_table;
+        std::vector<Conditional>
+            conditional_stack;
+        LineState
+            state;
+        std::string
+            & output = frame.m_Unit->m_Text;
+
+        {
+            size_t
+                start = 0,
+                end;
+
+            while( ( end = source.find( '\n', start ) ) != std::string::npos )
+            {
+                line_table.push_back( source.substr( start, end - start ) );
+                start = end + 1;
+            }
+
+            line_table.push_back( source.substr( start ) );
+        }
+
+        output.clear();
+        output.reserve( source.size() );
+
+        for( size_t index = 0; index < line_table.size(); )
+        {
+            std::string
+                logical_line = line_table[ index ];
+            size_t
+                consumed = 1;
+            const int
+                line = static_cast<int>( index ) + 1;
+
+            if( !logical_line.empty() && logical_line[ logical_line.size() - 1 ] == '\r' )
+            {
+                logical_line.erase( logical_line.size() - 1 );
+            }
+
+            while( !logical_line.empty()
+                && logical_line[ logical_line.size() - 1 ] == '\\'
+                && index + consumed < line_table.size()
+                )
+            {
+                std::string next_line = line_table[ index + consumed ];
+
+                if( !next_line.empty() && next_line[ next_line.size() - 1 ] == '\r' )
+                {
+                    next_line.erase( next_line.size() - 1 );
+                }
+
+                logical_line.erase( logical_line.size() - 1 );
+                logical_line += next_line;
+                ++consumed;
+            }
+
+            const size_t
+                first = logical_line.find_first_not_of( " \t" );
+            const bool
+                is_active = conditional_stack.empty() || conditional_stack.back().m_IsActive;
+
+            if( !state.m_IsInBlockComment && first != std::string::npos && logical_line[ first ] == '#' )
+            {
+                ProcessDirective( frame, conditional_stack, state, logical_line.substr( first + 1 ), line );
+            }
+            else if( is_active )
+            {
+                output += ProcessCodeLine( frame, state, logical_line, line );
+            }
+            else
+            {
+                // Inactive lines still need comment tracking
+                LineState
+                    inactive_state = state;
+                size_t
+                    position = 0;
+
+                while( position < logical_line.size() )
+                {
+                    if( inactive_state.m_IsInBlockComment )
+                    {
+                        size_t end = logical_line.find( "*/", position );
+
+                        if( end == std::string::npos )
+                        {
+                            break;
+                        }
+
+                        inactive_state.m_IsInBlockComment = false;
+                        position = end + 2;
+                    }
+                    else if( logical_line[ position ] == '"' )
+                    {
+                        position = SkipString( logical_line, position );
+                    }
+                    else if( logical_line.compare( position, 2, "//" ) == 0 )
+                    {
+                        break;
+                    }
+                    else if( logical_line.compare( position, 2, "/*" ) == 0 )
+                    {
+                        inactive_state.m_IsInBlockComment = true;
+                        position += 2;
+                    }
+                    else
+                    {
+                        ++position;
+                    }
+                }
+
+                state.m_IsInBlockComment = inactive_state.m_IsInBlockComment;
+            }
+
+            for( size_t newline = 0; newline < consumed; ++newline )
+            {
+                if( index + newline + 1 < line_table.size() )
+                {
+                    output += '\n';
+                }
+            }
+
+            index += consumed;
+        }
+
+        if( !conditional_stack.empty() )
+        {
+            ReportError( "unterminated conditional directive", frame.m_Unit->m_Path, conditional_stack.back().m_Line );
+        }
+    }
+
+    bool Preprocessor::ProcessDirective(
+        Frame & frame,
+        std::vector<Conditional> & conditional_stack,
+        const LineState & state,
+        const std::string & directive,
+        const int line
+        )
+    {
+        const std::string
+            & path = frame.m_Unit->m_Path;
+        size_t
+            position = 0;
+        const std::string
+            keyword = ReadIdentifier( directive, position ),
+            argument = Trim( StripComments( directive.substr( position ) ) );
+        const bool
+            is_active = conditional_stack.empty() || conditional_stack.back().m_IsActive;
+
+        if( keyword == "ifdef" || keyword == "ifndef" || keyword == "if" )
+        {
+            Conditional
+                conditional;
+
+            conditional.m_Line = line;
+            conditional.m_HasElse = false;
+
+            if( !is_active )
+            {
+                conditional.m_IsActive = false;
+                conditional.m_HasBeenTaken = true;
+            }
+            else
+            {
+                bool
+                    value;
+
+                if( keyword == "if" )
+                {
+                    value = EvaluateCondition( frame, argument, line );
+                }
+                else
+                {
+                    size_t name_position = 0;
+                    const std::string name = ReadIdentifier( argument, name_position );
+
+                    if( name.empty() )
+                    {
+                        ReportError( "#" + keyword + " expects a macro name", path, line );
+                        return false;
+                    }
+
+                    value = ( LookupMacro( name ) != 0 ) == ( keyword == "ifdef" );
+                }
+
+                conditional.m_IsActive = value;
+                conditional.m_HasBeenTaken = value;
+            }
+
+            conditional_stack.push_back( conditional );
+            return true;
+        }
+
+        if( keyword == "elif" || keyword == "else" || keyword == "endif" )
+        {
+            if( conditional_stack.empty() )
+            {
+                ReportError( "#" + keyword + " without #if", path, line );
+                return false;
+            }
+
+            Conditional
+                & conditional = conditional_stack.back();
+
+            if( keyword == "endif" )
+            {
+                conditional_stack.pop_back();
+                return true;
+            }
+
+            if( conditional.m_HasElse )
+            {
+                ReportError( "#" + keyword + " after #else", path, line );
+                return false;
+            }
+
+            if( keyword == "else" )
+            {
+                conditional.m_HasElse = true;
+                conditional.m_IsActive = !conditional.m_HasBeenTaken;
+                conditional.m_HasBeenTaken = true;
+            }
+            else if( conditional.m_HasBeenTaken )
+            {
+                conditional.m_IsActive = false;
+            }
+            else
+            {
+                conditional.m_IsActive = EvaluateCondition( frame, argument, line );
+                conditional.m_HasBeenTaken = conditional.m_IsActive;
+            }
+
+            return true;
+        }
+
+        if( !is_active )
+        {
+            return true;
+        }
+
+        if( keyword == "define" )
+        {
+            return ProcessDefine( frame, argument, line );
+        }
+
+        if( keyword == "undef" )
+        {
+            size_t name_position = 0;
+            const std::string name = ReadIdentifier( argument, name_position );
+
+            if( name.empty() )
+            {
+                ReportError( "#undef expects a macro name", path, line );
+                return false;
+            }
+
+            SetMacro( name, 0 );
+            return true;
+        }
+
+        if( keyword == "include" )
+        {
+            if( state.m_BraceDepth != 0 || state.m_IsInBlockComment )
+            {
+                ReportError( "#include is only supported at global scope", path, line );
+                return false;
+            }
+
+            return ProcessInclude( frame, argument, line );
+        }
+
+        if( keyword == "pragma" )
+        {
+            size_t name_position = 0;
+
+            if( ReadIdentifier( argument, name_position ) == "once" )
+            {
+                frame.m_Unit->m_HasPragmaOnce = true;
+                MarkOnceFile( path );
+            }
+
+            // Other pragmas have no meaning for the generator
+            return true;
+        }
+
+        if( keyword == "error" )
+        {
+            ReportError( "#error " + argument, path, line );
+            return false;
+        }
+
+        if( keyword.empty() && argument.empty() )
+        {
+            return true;
+        }
+
+        ReportError( "unknown preprocessor directive #" + keyword, path, line );
+        return false;
+    }
+
+    bool Preprocessor::ProcessInclude(
+        Frame & frame,
+        const std::string & argument,
+        const int line
+        )
+    {
+        IncludeUnit::Include
+            include;
+        std::string
+            name,
+            content;
+        bool
+            is_system = false;
+
+        if( argument.size() >= 2 && argument[ 0 ] == '"' )
+        {
+            size_t end = argument.find( '"', 1 );
+            name = argument.substr( 1, end == std::string::npos ? std::string::npos : end - 1 );
+        }
+        else if( argument.size() >= 2 && argument[ 0 ] == '<' )
+        {
+            size_t end = argument.find( '>', 1 );
+            name = argument.substr( 1, end == std::string::npos ? std::string::npos : end - 1 );
+            is_system = true;
+        }
+
+        if( name.empty() )
+        {
+            ReportError( "#include expects \"file\" or <file>", frame.m_Unit->m_Path, line );
+            return false;
+        }
+
+        if( !ResolveInclude( include.m_Path, content, name, is_system, frame.m_Unit->m_Path ) )
+        {
+            ReportError( "cannot open include file " + name, frame.m_Unit->m_Path, line );
+            return false;
+        }
+
+        include.m_Line = line;
+
+        if( IsOnceFileIncluded( include.m_Path ) )
+        {
+            frame.m_Unit->m_IncludeTable.push_back( include );
+            return true;
+        }
+
+        for( std::vector<Frame *>::const_iterator it = m_FrameStack.begin(), end = m_FrameStack.end(); it != end; ++it )
+        {
+            if( (*it)->m_Unit->m_Path == include.m_Path )
+            {
+                ReportError( "recursive inclusion of " + include.m_Path, frame.m_Unit->m_Path, line );
+                return false;
+            }
+        }
+
+        const uint64_t
+            content_hash = IncludeCache::ComputeHash( content );
+
+        include.m_Unit = m_Cache->FindUnit( include.m_Path, content_hash, m_MacroTable, m_OnceFileSet );
+
+        if( include.m_Unit )
+        {
+            ReuseUnit( *include.m_Unit );
+        }
+        else
+        {
+            Frame
+                nested_frame;
+
+            include.m_Unit = new IncludeUnit;
+            include.m_Unit->m_Path = include.m_Path;
+            include.m_Unit->m_ContentHash = content_hash;
+            nested_frame.m_Unit = &*include.m_Unit;
+
+            m_FrameStack.push_back( &nested_frame );
+            ProcessText( nested_frame, content );
+            m_FrameStack.pop_back();
+
+            if( m_HasErrors )
+            {
+                return false;
+            }
+
+            m_Cache->AddUnit( *include.m_Unit );
+        }
+
+        frame.m_Unit->m_IncludeTable.push_back( include );
+
+        return true;
+    }
+
+    bool Preprocessor::ProcessDefine(
+        Frame & frame,
+        const std::string & argument,
+        const int line
+        )
+    {
+        MacroDefinition
+            definition;
+        size_t
+            position = 0;
+        const std::string
+            name = ReadIdentifier( argument, position );
+
+        if( name.empty() )
+        {
+            ReportError( "#define expects a macro name", frame.m_Unit->m_Path, line );
+            return false;
+        }
+
+        if( position < argument.size() && argument[ position ] == '(' )
+        {
+            definition.m_IsFunctionLike = true;
+
+            for( ++position; ; )
+            {
+                const std::string parameter = ReadIdentifier( argument, position );
+
+                while( position < argument.size() && IsSpace( argument[ position ] ) )
+                {
+                    ++position;
+                }
+
+                if( position >= argument.size() )
+                {
+                    ReportError( "missing ) in macro parameter list", frame.m_Unit->m_Path, line );
+                    return false;
+                }
+
+                if( !parameter.empty() )
+                {
+                    definition.m_ParameterTable.push_back( parameter );
+                }
+
+                if( argument[ position ] == ')' )
+                {
+                    ++position;
+                    break;
+                }
+
+                if( argument[ position ] != ',' || parameter.empty() )
+                {
+                    ReportError( "invalid macro parameter list", frame.m_Unit->m_Path, line );
+                    return false;
+                }
+
+                ++position;
+            }
+        }
+
+        definition.m_Value = Trim( argument.substr( position ) );
+
+        SetMacro( name, &definition );
+
+        return true;
+    }
+
+    std::string Preprocessor::ProcessCodeLine(
+        Frame & frame,
+        LineState & state,
+        const std::string & text,
+        const int line
+        )
+    {
+        std::string
+            result;
+        size_t
+            position = 0;
+
+        result.reserve( text.size() );
+
+        while( position < text.size() )
+        {
+            if( state.m_IsInBlockComment )
+            {
+                size_t end = text.find( "*/", position );
+
+                if( end == std::string::npos )
+                {
+                    result.append( text, position, std::string::npos );
+                    break;
+                }
+
+                result.append( text, position, end + 2 - position );
+                position = end + 2;
+                state.m_IsInBlockComment = false;
+                continue;
+            }
+
+            const char
+                character = text[ position ];
+
+            if( character == '/' && text.compare( position, 2, "//" ) == 0 )
+            {
+                result.append( text, position, std::string::npos );
+                break;
+            }
+
+            if( character == '/' && text.compare( position, 2, "/*" ) == 0 )
+            {
+                state.m_IsInBlockComment = true;
+                result += "/*";
+                position += 2;
+                continue;
+            }
+
+            if( character == '"' )
+            {
+                size_t end = SkipString( text, position );
+                result.append( text, position, end - position );
+                position = end;
+                state.m_PreviousIsStruct = false;
+                continue;
+            }
+
+            if( IsDigit( character ) )
+            {
+                size_t end = SkipNumber( text, position );
+                result.append( text, position, end - position );
+                position = end;
+                state.m_PreviousIsStruct = false;
+                continue;
+            }
+
+            if( IsIdentifierStart( character ) )
+            {
+                size_t
+                    start = position;
+                std::string
+                    identifier = ReadIdentifier( text, position );
+                const MacroDefinition
+                    * macro = LookupMacro( identifier );
+
+                frame.m_Unit->m_IdentifierSet.insert( identifier );
+
+                if( macro && macro->m_IsFunctionLike )
+                {
+                    std::vector<std::string>
+                        argument_table;
+                    size_t
+                        argument_end = position;
+
+                    if( CollectArguments( argument_table, text, argument_end ) )
+                    {
+                        std::set<std::string>
+                            disabled_macro_set;
+
+                        // Expand the whole invocation through the common code path
+                        result += ExpandText( text.substr( start, argument_end - start ), disabled_macro_set );
+                        position = argument_end;
+                        state.m_PreviousIsStruct = false;
+                        continue;
+                    }
+
+                    macro = 0;
+                }
+
+                if( macro )
+                {
+                    std::set<std::string>
+                        disabled_macro_set;
+
+                    result += ExpandText( identifier, disabled_macro_set );
+                    state.m_PreviousIsStruct = false;
+                    continue;
+                }
+
+                if( state.m_PreviousIsStruct )
+                {
+                    frame.m_Unit->m_StructTable.push_back( std::make_pair( line, identifier ) );
+                }
+
+                state.m_PreviousIsStruct = ( identifier == "struct" );
+                result += identifier;
+                continue;
+            }
+
+            if( character == '{' )
+            {
+                ++state.m_BraceDepth;
+            }
+            else if( character == '}' )
+            {
+                --state.m_BraceDepth;
+            }
+
+            if( !IsSpace( character ) )
+            {
+                state.m_PreviousIsStruct = false;
+            }
+
+            result += character;
+            ++position;
+        }
+
+        return result;
+    }
+
+    std::string Preprocessor::ExpandText(
+        const std::string & text,
+        std::set<std::string> & disabled_macro_set
+        )
+    {
+        std::string
+            result;
+        size_t
+            position = 0;
+
+        while( position < text.size() )
+        {
+            const char
+                character = text[ position ];
+
+            if( character == '"' )
+            {
+                size_t end = SkipString( text, position );
+                result.append( text, position, end - position );
+                position = end;
+                continue;
+            }
+
+            if( IsDigit( character ) )
+            {
+                size_t end = SkipNumber( text, position );
+                result.append( text, position, end - position );
+                position = end;
+                continue;
+            }
+
+            if( !IsIdentifierStart( character ) )
+            {
+                result += character;
+                ++position;
+                continue;
+            }
+
+            const std::string
+                identifier = ReadIdentifier( text, position );
+            const MacroDefinition
+                * macro = 0;
+
+            if( disabled_macro_set.find( identifier ) == disabled_macro_set.end() )
+            {
+                macro = LookupMacro( identifier );
+            }
+
+            if( !macro )
+            {
+                m_FrameStack.back()->m_Unit->m_IdentifierSet.insert( identifier );
+                result += identifier;
+                continue;
+            }
+
+            std::string
+                replacement;
+
+            if( macro->m_IsFunctionLike )
+            {
+                std::vector<std::string>
+                    argument_table;
+
+                if( !CollectArguments( argument_table, text, position ) )
+                {
+                    result += identifier;
+                    continue;
+                }
+
+                if( argument_table.size() == 1 && argument_table[ 0 ].empty() && macro->m_ParameterTable.empty() )
+                {
+                    argument_table.clear();
+                }
+
+                if( argument_table.size() != macro->m_ParameterTable.size() )
+                {
+                    ReportError(
+                        "wrong number of arguments for macro " + identifier,
+                        m_FrameStack.back()->m_Unit->m_Path,
+                        0
+                        );
+                    result += identifier;
+                    continue;
+                }
+
+                // Arguments are fully expanded before substitution
+                std::vector<std::string>
+                    expanded_argument_table;
+
+                for( std::vector<std::string>::const_iterator it = argument_table.begin(), end = argument_table.end(); it != end; ++it )
+                {
+                    expanded_argument_table.push_back( ExpandText( *it, disabled_macro_set ) );
+                }
+
+                const std::string
+                    & value = macro->m_Value;
+                size_t
+                    value_position = 0;
+
+                while( value_position < value.size() )
+                {
+                    if( !IsIdentifierStart( value[ value_position ] ) )
+                    {
+                        if( value[ value_position ] == '"' )
+                        {
+                            size_t end = SkipString( value, value_position );
+                            replacement.append( value, value_position, end - value_position );
+                            value_position = end;
+                        }
+                        else
+                        {
+                            replacement += value[ value_position ];
+                            ++value_position;
+                        }
+
+                        continue;
+                    }
+
+                    const std::string
+                        name = ReadIdentifier( value, value_position );
+                    std::vector<std::string>::const_iterator
+                        parameter = std::find( macro->m_ParameterTable.begin(), macro->m_ParameterTable.end(), name );
+
+                    if( parameter != macro->m_ParameterTable.end() )
+                    {
+                        replacement += expanded_argument_table[ parameter - macro->m_ParameterTable.begin() ];
+                    }
+                    else
+                    {
+                        replacement += name;
+                    }
+                }
+            }
+            else
+            {
+                replacement = macro->m_Value;
+            }
+
+            disabled_macro_set.insert( identifier );
+            result += ExpandText( replacement, disabled_macro_set );
+            disabled_macro_set.erase( identifier );
+        }
+
+        return result;
+    }
+
+    bool Preprocessor::EvaluateCondition(
+        Frame & frame,
+        const std::string & expression,
+        const int line
+        )
+    {
+        std::string
+            resolved_expression;
+        size_t
+            position = 0;
+
+        // defined must be resolved before macro expansion
+        while( position < expression.size() )
+        {
+            if( !IsIdentifierStart( expression[ position ] ) )
+            {
+                resolved_expression += expression[ position ];
+                ++position;
+                continue;
+            }
+
+            std::string
+                identifier = ReadIdentifier( expression, position );
+
+            if( identifier != "defined" )
+            {
+                resolved_expression += identifier;
+                continue;
+            }
+
+            while( position < expression.size() && IsSpace( expression[ position ] ) )
+            {
+                ++position;
+            }
+
+            const bool
+                has_parenthesis = position < expression.size() && expression[ position ] == '(';
+
+            if( has_parenthesis )
+            {
+                ++position;
+            }
+
+            const std::string
+                name = ReadIdentifier( expression, position );
+
+            while( position < expression.size() && IsSpace( expression[ position ] ) )
+            {
+                ++position;
+            }
+
+            if( name.empty() || ( has_parenthesis && ( position >= expression.size() || expression[ position ] != ')' ) ) )
+            {
+                ReportError( "invalid use of defined", frame.m_Unit->m_Path, line );
+                return false;
+            }
+
+            if( has_parenthesis )
+            {
+                ++position;
+            }
+
+            resolved_expression += LookupMacro( name ) ? " 1 " : " 0 ";
+        }
+
+        std::set<std::string>
+            disabled_macro_set;
+        const std::string
+            expanded_expression = ExpandText( resolved_expression, disabled_macro_set );
+        ConditionEvaluator
+            evaluator( expanded_expression );
+        const long long
+            value = evaluator.Evaluate();
+
+        if( evaluator.HasError() )
+        {
+            ReportError( "invalid preprocessor expression: " + expression, frame.m_Unit->m_Path, line );
+            return false;
+        }
+
+        return value != 0;
+    }
+
+    bool Preprocessor::ResolveInclude(
+        std::string & path,
+        std::string & content,
+        const std::string & name,
+        const bool is_system,
+        const std::string & including_path
+        ) const
+    {
+        std::vector<std::string>
+            candidate_table;
+        const bool
+            is_absolute = name[ 0 ] == '/' || name[ 0 ] == '\\' || name.find( ':' ) != std::string::npos;
+
+        if( is_absolute )
+        {
+            candidate_table.push_back( name );
+        }
+        else
+        {
+            if( !is_system )
+            {
+                const size_t separator = including_path.find_last_of( "/\\" );
+
+                candidate_table.push_back(
+                    separator == std::string::npos ? name : including_path.substr( 0, separator + 1 ) + name
+                    );
+            }
+
+            for( std::vector<std::string>::const_iterator it = m_IncludePathTable.begin(), end = m_IncludePathTable.end(); it != end; ++it )
+            {
+                candidate_table.push_back( *it + "/" + name );
+            }
+        }
+
+        for( std::vector<std::string>::const_iterator it = candidate_table.begin(), end = candidate_table.end(); it != end; ++it )
+        {
+            const std::string candidate = NormalizePath( *it );
+
+            if( m_Cache->ReadFile( content, candidate ) )
+            {
+                path = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const MacroDefinition * Preprocessor::LookupMacro( const std::string & name )
+    {
+        MacroTable::const_iterator
+            macro = m_MacroTable.find( name );
+
+        // Record the value seen on entry of every unit that did not change it itself
+        for( std::vector<Frame *>::reverse_iterator it = m_FrameStack.rbegin(), end = m_FrameStack.rend(); it != end; ++it )
+        {
+            Frame & frame = **it;
+
+            if( frame.m_ModifiedMacroSet.find( name ) != frame.m_ModifiedMacroSet.end()
+                || !frame.m_MacroDependencySet.insert( name ).second
+                )
+            {
+                break;
+            }
+
+            IncludeUnit::MacroDependency
+                dependency;
+
+            dependency.m_Name = name;
+            dependency.m_IsDefined = macro != m_MacroTable.end();
+
+            if( dependency.m_IsDefined )
+            {
+                dependency.m_Definition = (*macro).second;
+            }
+
+            frame.m_Unit->m_MacroDependencyTable.push_back( dependency );
+        }
+
+        return macro != m_MacroTable.end() ? &(*macro).second : 0;
+    }
+
+    bool Preprocessor::IsOnceFileIncluded( const std::string & path )
+    {
+        const bool
+            is_included = m_OnceFileSet.find( path ) != m_OnceFileSet.end();
+
+        for( std::vector<Frame *>::reverse_iterator it = m_FrameStack.rbegin(), end = m_FrameStack.rend(); it != end; ++it )
+        {
+            Frame & frame = **it;
+
+            if( frame.m_MarkedOnceFileSet.find( path ) != frame.m_MarkedOnceFileSet.end()
+                || !frame.m_OnceDependencySet.insert( path ).second
+                )
+            {
+                break;
+            }
+
+            IncludeUnit::OnceDependency
+                dependency;
+
+            dependency.m_Path = path;
+            dependency.m_WasIncluded = is_included;
+
+            frame.m_Unit->m_OnceDependencyTable.push_back( dependency );
+        }
+
+        return is_included;
+    }
+
+    void Preprocessor::SetMacro( const std::string & name, const MacroDefinition * definition )
+    {
+        IncludeUnit::MacroOperation
+            operation;
+
+        operation.m_Name = name;
+        operation.m_IsDefine = definition != 0;
+
+        if( definition )
+        {
+            operation.m_Definition = *definition;
+            m_MacroTable[ name ] = *definition;
+        }
+        else
+        {
+            m_MacroTable.erase( name );
+        }
+
+        for( std::vector<Frame *>::iterator it = m_FrameStack.begin(), end = m_FrameStack.end(); it != end; ++it )
+        {
+            (*it)->m_ModifiedMacroSet.insert( name );
+            (*it)->m_Unit->m_MacroOperationTable.push_back( operation );
+        }
+    }
+
+    void Preprocessor::MarkOnceFile( const std::string & path )
+    {
+        m_OnceFileSet.insert( path );
+
+        for( std::vector<Frame *>::iterator it = m_FrameStack.begin(), end = m_FrameStack.end(); it != end; ++it )
+        {
+            (*it)->m_MarkedOnceFileSet.insert( path );
+            (*it)->m_Unit->m_OnceFileTable.push_back( path );
+        }
+    }
+
+    void Preprocessor::ReuseUnit( const IncludeUnit & unit )
+    {
+        {
+            std::vector<IncludeUnit::MacroDependency>::const_iterator it, end;
+
+            for( it = unit.m_MacroDependencyTable.begin(), end = unit.m_MacroDependencyTable.end(); it != end; ++it )
+            {
+                LookupMacro( (*it).m_Name );
+            }
+        }
+
+        {
+            std::vector<IncludeUnit::OnceDependency>::const_iterator it, end;
+
+            for( it = unit.m_OnceDependencyTable.begin(), end = unit.m_OnceDependencyTable.end(); it != end; ++it )
+            {
+                IsOnceFileIncluded( (*it).m_Path );
+            }
+        }
+
+        {
+            std::vector<IncludeUnit::MacroOperation>::const_iterator it, end;
+
+            for( it = unit.m_MacroOperationTable.begin(), end = unit.m_MacroOperationTable.end(); it != end; ++it )
+            {
+                SetMacro( (*it).m_Name, (*it).m_IsDefine ? &(*it).m_Definition : 0 );
+            }
+        }
+
+        {
+            std::vector<std::string>::const_iterator it, end;
+
+            for( it = unit.m_OnceFileTable.begin(), end = unit.m_OnceFileTable.end(); it != end; ++it )
+            {
+                MarkOnceFile( *it );
+            }
+        }
+    }
+
+    void Preprocessor::ReportError(
+        const std::string & message,
+        const std::string & file,
+        const int line
+        )
+    {
+        std::ostringstream
+            stream;
+
+        m_HasErrors = true;
+
+        if( line > 0 )
+        {
+            stream << "line " << line << ": ";
+        }
+
+        stream << message;
+
+        m_ErrorHandler->ReportError( stream.str(), file );
+    }
+}
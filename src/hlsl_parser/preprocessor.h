@@ -0,0 +1,169 @@
+#ifndef PREPROCESSOR_H
+    #define PREPROCESSOR_H
+
+    #include <set>
+    #include <string>
+    #include <vector>
+    #include <base/error_handler_interface.h>
+    #include "include_cache.h"
+
+    namespace HLSL
+    {
+        // Supports #include, #define/#undef (object and function like), #if/#ifdef/
+        // #ifndef/#elif/#else/#endif and #pragma once. Includes are only allowed at
+        // global scope: each included file is preprocessed and parsed on its own so
+        // the result can be shared through the IncludeCache.
+
+        class Preprocessor
+        {
+        public:
+
+            Preprocessor(
+                IncludeCache & cache,
+                Base::ErrorHandlerInterface & error_handler
+                );
+
+            void AddIncludePath( const std::string & path );
+            void Define( const std::string & name, const std::string & value = "1" );
+
+            IncludeUnit::Ref Process( const std::string & filename );
+
+            IncludeUnit::Ref ProcessSource(
+                const std::string & source,
+                const std::string & filename
+                );
+
+            // Files included by the last processed source, directly or not, each once
+            const std::vector<std::string> & GetIncludedPathTable() const { return m_IncludedPathTable; }
+
+            // Macros given to Define, as NAME=VALUE sorted by name
+            void GetDefineTable( std::vector<std::string> & define_table ) const;
+
+            IncludeCache & GetCache() { return *m_Cache; }
+            Base::ErrorHandlerInterface & GetErrorHandler() { return *m_ErrorHandler; }
+
+            static std::string NormalizePath( const std::string & path );
+
+        private:
+
+            struct Frame
+            {
+                IncludeUnit
+                    * m_Unit;
+                std::set<std::string>
+                    m_ModifiedMacroSet,
+                    m_MarkedOnceFileSet,
+                    m_MacroDependencySet,
+                    m_OnceDependencySet;
+            };
+
+            struct Conditional
+            {
+                bool
+                    m_IsActive,
+                    m_HasBeenTaken,
+                    m_HasElse;
+                int
+                    m_Line;
+            };
+
+            struct LineState
+            {
+                LineState() : m_IsInBlockComment( false ), m_BraceDepth( 0 ), m_PreviousIsStruct( false ) {}
+
+                bool
+                    m_IsInBlockComment;
+                int
+                    m_BraceDepth;
+                bool
+                    m_PreviousIsStruct;
+            };
+
+            void BeginProcessing();
+
+            IncludeUnit::Ref ProcessUnit(
+                const std::string & source,
+                const std::string & path
+                );
+
+            void ProcessText( Frame & frame, const std::string & source );
+
+            bool ProcessDirective(
+                Frame & frame,
+                std::vector<Conditional> & conditional_stack,
+                const LineState & state,
+                const std::string & directive,
+                const int line
+                );
+
+            bool ProcessInclude(
+                Frame & frame,
+                const std::string & argument,
+                const int line
+                );
+
+            bool ProcessDefine(
+                Frame & frame,
+                const std::string & argument,
+                const int line
+                );
+
+            std::string ProcessCodeLine(
+                Frame & frame,
+                LineState & state,
+                const std::string & text,
+                const int line
+                );
+
+            std::string ExpandText(
+                const std::string & text,
+                std::set<std::string> & disabled_macro_set
+                );
+
+            bool EvaluateCondition(
+                Frame & frame,
+                const std::string & expression,
+                const int line
+                );
+
+            bool ResolveInclude(
+                std::string & path,
+                std::string & content,
+                const std::string & name,
+                const bool is_system,
+                const std::string & including_path
+                ) const;
+
+            const MacroDefinition * LookupMacro( const std::string & name );
+            bool IsOnceFileIncluded( const std::string & path );
+            void SetMacro( const std::string & name, const MacroDefinition * definition );
+            void MarkOnceFile( const std::string & path );
+            void ReuseUnit( const IncludeUnit & unit );
+            void AddIncludedPaths( std::set<std::string> & path_set, const IncludeUnit & unit );
+
+            void ReportError(
+                const std::string & message,
+                const std::string & file,
+                const int line
+                );
+
+            IncludeCache::Ref
+                m_Cache;
+            Base::ErrorHandlerInterface::Ref
+                m_ErrorHandler;
+            std::vector<std::string>
+                m_IncludePathTable,
+                m_IncludedPathTable;
+            MacroTable
+                m_PredefinedMacroTable,
+                m_MacroTable;
+            std::set<std::string>
+                m_OnceFileSet;
+            std::vector<Frame *>
+                m_FrameStack;
+            bool
+                m_HasErrors;
+        };
+    }
+
+#endif
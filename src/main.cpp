@@ -1,34 +1,283 @@
 #include <hlsl_parser/hlsl.h>
+#include <hlsl_parser/preprocessor.h>
 #include <ast/print_visitor.h>
 #include <ast/node.h>
+#include <ast/node_size_report.h>
+#include <ast/node_allocation.h>
 #include <generation/code_generator.h>
+#include <generation/cost_estimator.h>
 #include <generation/technique_generator.h>
+#include <generation/fragment_index.h>
+#include <generation/permutation_enumerator.h>
+#include <generation/resolution_cache.h>
+#include <generation/preshader_extractor.h>
+#include <server/generation_server.h>
+#include <server/file_watcher.h>
 #include <tclap/CmdLine.h>
 #include <ast/printer/hlsl_printer.h>
 #include <ast/printer/annotation_printer.h>
 #include <base/console_error_handler.h>
+#include <base/statistics.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
 
 TCLAP::CmdLine cmd( "ShaderShaker" );
 
-TCLAP::MultiArg<std::string> semantic_argument( "s", "semantic", "semantic to output", true, "string", cmd );
-TCLAP::MultiArg<std::string> input_semantic_argument( "i", "input_semantic", "semantic available for input", true, "string", cmd );
+TCLAP::MultiArg<std::string> semantic_argument( "s", "semantic", "semantic to output", false, "string", cmd );
+TCLAP::MultiArg<std::string> input_semantic_argument( "i", "input_semantic", "semantic available for input", false, "string", cmd );
 TCLAP::MultiArg<std::string> interpolator_semantic_argument(
     "n", "interpolator_semantic",
     "semantic used between PS and VS. If no interpolator semantic is given, only one program is generated",
     false, "string", cmd );
-TCLAP::UnlabeledMultiArg<std::string> fragment_arguments( "fragment", "fragment file path", true, "filepath", cmd );
-TCLAP::ValueArg<std::string> generator_argument( "g", "generator", "generator to use", true, "hlsl", "", cmd ); 
+TCLAP::UnlabeledMultiArg<std::string> fragment_arguments( "fragment", "fragment file path", false, "filepath", cmd );
+TCLAP::ValueArg<std::string> generator_argument( "g", "generator", "generator to use", false, "hlsl", "", cmd ); 
+TCLAP::MultiArg<std::string> include_path_argument( "I", "include_path", "directory searched for included files", false, "path", cmd );
+TCLAP::MultiArg<std::string> define_argument( "D", "define", "macro definition, as NAME or NAME=VALUE", false, "string", cmd );
+TCLAP::SwitchArg pack_interpolators_argument( "", "pack_interpolators", "pack the semantics passed from the vertex to the pixel program into float4 interpolators", cmd );
+TCLAP::SwitchArg select_cheapest_argument( "", "select_cheapest", "choose the function with the lowest estimated cost when several fragments generate a semantic", cmd );
+TCLAP::SwitchArg schedule_calls_argument( "", "schedule_calls", "order the calls of the generated code to keep few temporaries alive, and reuse the dead ones", cmd );
+TCLAP::ValueArg<int> unroll_loops_argument( "", "unroll_loops", "unroll the loops with a constant trip count when the copies of their body add up to at most this many statements, 0 to disable", false, 0, "count", cmd );
+TCLAP::SwitchArg reduce_strength_argument( "", "reduce_strength", "rewrite the operations of the generated code into cheaper forms giving the same result, such as pow( x, 2 ) into x * x", cmd );
+TCLAP::SwitchArg fast_math_argument( "", "fast_math", "also allow the rewrites changing the rounding or using approximated intrinsics, such as 1 / sqrt( x ) into rsqrt( x ), implies --reduce_strength", cmd );
+TCLAP::SwitchArg narrow_vectors_argument( "", "narrow_vectors", "declare the local vectors of the generated functions with only the components they read", cmd );
+TCLAP::ValueArg<int> hoist_fetches_argument( "", "hoist_fetches", "issue the texture fetches as early as their coordinates allow, with at most this many pending at once, 0 to disable", false, 0, "count", cmd );
+TCLAP::SwitchArg preshader_argument( "", "preshader", "replace the expressions only reading uniforms by new uniforms, and print the program computing them once per draw", cmd );
+TCLAP::SwitchArg move_to_vertex_argument( "", "move_to_vertex", "compute the affine pixel functions of interpolated semantics in the vertex program", cmd );
+TCLAP::SwitchArg lazy_argument( "l", "lazy", "parse function bodies only when they are used", cmd );
+TCLAP::ValueArg<std::string> build_index_argument( "b", "build_index", "write the signature index of the fragments to this file and exit", false, "", "filepath", cmd );
+TCLAP::ValueArg<std::string> index_argument( "x", "index", "fragment index file, fragments are only parsed when used", false, "", "filepath", cmd );
+TCLAP::SwitchArg node_size_argument( "", "node_sizes", "print the size of the nodes of each parsed fragment", cmd );
+TCLAP::SwitchArg stats_argument( "", "stats", "print the time spent in each phase and the pipeline counters", cmd );
+TCLAP::ValueArg<std::string> stats_json_argument( "", "stats_json", "write the statistics of the run in JSON to this file", false, "", "filepath", cmd );
+TCLAP::SwitchArg server_argument( "", "server", "keep the fragments loaded and answer NDJSON generation requests on standard input", cmd );
+TCLAP::ValueArg<std::string> socket_argument( "", "socket", "in server mode, answer the requests of the clients of this Unix domain socket", false, "", "filepath", cmd );
+TCLAP::SwitchArg watch_argument( "", "watch", "in server mode, reload the fragments when their files change", cmd );
+TCLAP::SwitchArg query_argument( "", "query", "only print whether the semantics can be generated, the used input semantics and the chosen functions", cmd );
+TCLAP::SwitchArg enumerate_argument( "", "enumerate", "print the arguments of every permutation of the optional semantics that can be generated", cmd );
+TCLAP::MultiArg<std::string> optional_semantic_argument( "o", "optional_semantic", "semantic which can be added to the -s ones when enumerating", false, "string", cmd );
+TCLAP::ValueArg<int> resolution_cache_argument( "", "resolution_cache", "memory in megabytes kept to reuse the functions resolved for other permutations when enumerating, 0 to disable", false, 16, "megabytes", cmd );
+TCLAP::SwitchArg memory_report_argument( "", "memory_report", "print the live and peak memory used by each node type", cmd );
+TCLAP::ValueArg<std::string> trace_argument( "", "trace", "write a Chrome trace event file of the run, to be loaded in Perfetto", false, "", "filepath", cmd );
 
-void generate_code(
+class ParsingFragmentLoader : public Generation::FragmentLoaderInterface
+{
+public:
+
+    ParsingFragmentLoader( HLSL::Preprocessor & preprocessor ) : m_Preprocessor( preprocessor ) {}
+
+    virtual Base::ObjectRef<AST::TranslationUnit> LoadTranslationUnit(
+        const std::string & path
+        ) override
+    {
+        Base::ObjectRef<AST::TranslationUnit>
+            translation_unit = HLSL::ParseHLSL( path, m_Preprocessor, lazy_argument.getValue() );
+
+        if( translation_unit && node_size_argument.getValue() )
+        {
+            AST::NodeSizeReport
+                report;
+
+            translation_unit->Visit( report );
+
+            std::cerr << path << std::endl;
+            report.Print( std::cerr );
+        }
+
+        return translation_unit;
+    }
+
+    virtual void GetIncludedPathTable( std::vector<std::string> & path_table ) const override
+    {
+        path_table = m_Preprocessor.GetIncludedPathTable();
+    }
+
+    virtual void GetDefineTable( std::vector<std::string> & define_table ) const override
+    {
+        m_Preprocessor.GetDefineTable( define_table );
+    }
+
+private:
+
+    HLSL::Preprocessor
+        & m_Preprocessor;
+};
+
+bool build_index(
+    Generation::FragmentLoaderInterface & loader,
+    Base::ErrorHandlerInterface & error_handler
+    )
+{
+    Generation::FragmentIndex
+        index;
+
+    if( !index.Build( fragment_arguments.getValue(), loader, error_handler ) )
+    {
+        std::cerr << std::endl << "Unable to build index, exiting" << std::endl;
+        return false;
+    }
+
+    std::ofstream
+        file( build_index_argument.getValue().c_str() );
+
+    index.Save( file );
+
+    if( !file )
+    {
+        std::cerr << "Unable to write " << build_index_argument.getValue() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool load_fragments(
+    std::vector< Generation::FragmentDefinition::Ref > & definition_table,
+    std::vector< std::string > & path_table,
+    Generation::FragmentLoaderInterface & loader,
+    Base::ErrorHandlerInterface & error_handler
+    )
+{
+    if( index_argument.isSet() )
+    {
+        Generation::FragmentIndex
+            index;
+        std::ifstream
+            file( index_argument.getValue().c_str() );
+        std::vector<std::string>
+            stale_path_table;
+
+        if( !file )
+        {
+            std::cerr << "Unable to open " << index_argument.getValue() << std::endl;
+            return false;
+        }
+
+        if( !index.Load( file, index_argument.getValue(), error_handler )
+            || !index.CreateFragmentTable( definition_table, stale_path_table, loader )
+            )
+        {
+            std::cerr << std::endl << "Unable to load index, exiting" << std::endl;
+            return false;
+        }
+
+        for( size_t fragment_index = 0; fragment_index < index.GetFragmentCount(); ++fragment_index )
+        {
+            path_table.push_back( index.GetFragmentPath( fragment_index ) );
+        }
+
+        if( !stale_path_table.empty() )
+        {
+            std::cerr << stale_path_table.size() << " fragment(s) changed since the index was built, "
+                << "rebuild it with --build_index" << std::endl;
+        }
+    }
+
+    std::vector<std::string>::const_iterator it, end;
+
+    it = fragment_arguments.getValue().begin();
+    end = fragment_arguments.getValue().end();
+
+    for(; it!=end; ++it )
+    {
+        Base::ObjectRef<AST::TranslationUnit>
+            translation_unit;
+
+        translation_unit = loader.LoadTranslationUnit( *it );
+
+        if( !translation_unit )
+        {
+            std::cerr << std::endl << "Unable to parse " << *it << ", exiting" << std::endl;
+            return false;
+        }
+
+        definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *translation_unit ) );
+        path_table.push_back( *it );
+    }
+
+    return true;
+}
+
+void write_output( const std::string & output )
+{
+    Base::Statistics::AddCount( "emitted_byte_count", output.size() );
+    std::cout << output;
+}
+
+bool write_reports()
+{
+    if( memory_report_argument.getValue() )
+    {
+        AST::NodeAllocation::Print( std::cerr );
+    }
+
+    AST::NodeAllocation::AddStatistics();
+
+    if( stats_argument.getValue() )
+    {
+        Base::Statistics::Print( std::cerr );
+    }
+
+    if( stats_json_argument.isSet() )
+    {
+        std::ofstream
+            file( stats_json_argument.getValue().c_str() );
+
+        Base::Statistics::PrintJson( file );
+
+        if( !file )
+        {
+            std::cerr << "Unable to write " << stats_json_argument.getValue() << std::endl;
+            return false;
+        }
+    }
+
+    if( trace_argument.isSet() )
+    {
+        std::ofstream
+            file( trace_argument.getValue().c_str() );
+
+        Base::Tracer::Write( file );
+
+        if( !file )
+        {
+            std::cerr << "Unable to write " << trace_argument.getValue() << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns the count of operations moved to the preshader
+int generate_code(
     Base::ObjectRef < AST::TranslationUnit > & generated_code,
     std::vector < std::string > & used_semantic_set,
     Base::ErrorHandlerInterface::Ref & error_handler,
-    const std::vector< Generation::FragmentDefinition::Ref > & definition_table
+    const std::vector< Generation::FragmentDefinition::Ref > & definition_table,
+    Generation::PreshaderExtractor * preshader_extractor = 0
     )
 {
     Generation::CodeGenerator
         code_generator;
+    Generation::CostEstimator
+        cost_estimator;
 
+    if( select_cheapest_argument.getValue() )
+    {
+        code_generator.SetCostEstimator( &cost_estimator );
+        code_generator.SetCheapestSelection( true );
+    }
+
+    code_generator.SetCallScheduling( schedule_calls_argument.getValue() );
+    code_generator.SetLoopUnrolling( unroll_loops_argument.getValue() );
+    code_generator.SetStrengthReduction( reduce_strength_argument.getValue() );
+    code_generator.SetFastMath( fast_math_argument.getValue() );
+    code_generator.SetVectorNarrowing( narrow_vectors_argument.getValue() );
+    code_generator.SetTextureFetchHoisting( hoist_fetches_argument.getValue() );
+    code_generator.SetPreshaderExtractor( preshader_extractor );
     code_generator.GenerateShader(
         generated_code,
         used_semantic_set,
@@ -37,6 +286,118 @@ void generate_code(
         input_semantic_argument.getValue(),
         *error_handler
         );
+
+    return code_generator.GetPreshaderOperationCount();
+}
+
+void reload_changed_fragments(
+    Server::FileWatcher & watcher,
+    Server::GenerationServer & server,
+    Generation::FragmentLoaderInterface & loader
+    )
+{
+    std::vector< std::string >
+        changed_path_table;
+    std::string
+        error;
+
+    for( ;; )
+    {
+        if( !watcher.WaitForChanges( changed_path_table, error ) )
+        {
+            std::cerr << "Stopped watching the fragments: " << error << std::endl;
+            return;
+        }
+
+        if( changed_path_table.empty() )
+        {
+            return;
+        }
+
+        std::vector<std::string>::iterator it, end;
+
+        for( it = changed_path_table.begin(), end = changed_path_table.end(); it != end; ++it )
+        {
+            *it = HLSL::Preprocessor::NormalizePath( *it );
+        }
+
+        if( !server.ReloadFragments( changed_path_table, loader ) )
+        {
+            std::cerr << "Some fragments could not be reloaded, their previous version is kept" << std::endl;
+        }
+    }
+}
+
+bool run_server(
+    const std::vector< Generation::FragmentDefinition::Ref > & definition_table,
+    const std::vector< std::string > & path_table,
+    Generation::FragmentLoaderInterface & loader
+    )
+{
+    std::vector< std::string >
+        normalized_path_table;
+    std::set< std::string >
+        directory_set;
+    Server::FileWatcher
+        watcher;
+    std::string
+        error;
+    std::vector<std::string>::const_iterator it, end;
+
+    for( it = path_table.begin(), end = path_table.end(); it != end; ++it )
+    {
+        const std::string
+            path = HLSL::Preprocessor::NormalizePath( *it );
+        const std::string::size_type
+            separator = path.find_last_of( '/' );
+
+        normalized_path_table.push_back( path );
+        directory_set.insert( separator == std::string::npos ? "." : path.substr( 0, separator ) );
+    }
+
+    if( watch_argument.getValue() )
+    {
+        std::set<std::string>::const_iterator directory, directory_end;
+
+        for( directory = directory_set.begin(), directory_end = directory_set.end(); directory != directory_end; ++directory )
+        {
+            if( !watcher.AddDirectory( *directory, error ) )
+            {
+                std::cerr << "Unable to watch " << *directory << ": " << error << std::endl;
+                return false;
+            }
+        }
+    }
+
+    Server::GenerationServer
+        server( definition_table, normalized_path_table );
+    std::thread
+        reload_thread;
+    bool
+        success = true;
+
+    if( watch_argument.getValue() )
+    {
+        reload_thread = std::thread( reload_changed_fragments, std::ref( watcher ), std::ref( server ), std::ref( loader ) );
+    }
+
+    if( !socket_argument.isSet() )
+    {
+        server.Serve( std::cin, std::cout );
+    }
+    else if( !server.ServeSocket( socket_argument.getValue(), error ) )
+    {
+        std::cerr << "Unable to serve on " << socket_argument.getValue() << ": " << error << std::endl;
+        success = false;
+    }
+
+    if( reload_thread.joinable() )
+    {
+        watcher.Stop();
+        reload_thread.join();
+    }
+
+    return success;
 }
 
 bool generate_hlsl(
@@ -53,16 +414,42 @@ bool generate_hlsl(
         std::vector < std::string >
             used_semantic_set;
         
-        generate_code( generated_code, used_semantic_set, error_handler, definition_table );
+        Generation::PreshaderExtractor preshader_extractor;
+        const int removed_operation_count = generate_code(
+            generated_code,
+            used_semantic_set,
+            error_handler,
+            definition_table,
+            preshader_argument.getValue() ? &preshader_extractor : 0
+            );
 
-        AST::HLSLPrinter printer( std::cout );
+        Base::ScopedTimer timer( "print" );
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        if( preshader_argument.getValue() )
+        {
+            output << "Preshader : " << removed_operation_count << " operations removed" << std::endl;
+        }
 
         generated_code->Visit( printer );
+
+        if( preshader_argument.getValue() )
+        {
+            output << "Preshader Program : " << std::endl;
+            preshader_extractor.CreateEvaluationProgram()->Visit( printer );
+        }
+
+        write_output( output.str() );
     }
     else
     {
         Generation::TechniqueGenerator
             generator;
+        Generation::CostEstimator
+            cost_estimator;
+        Generation::PreshaderExtractor
+            preshader_extractor;
         Base::ObjectRef < AST::TranslationUnit >
             pixel_code,
             vertex_code;
@@ -72,6 +459,24 @@ bool generate_hlsl(
         generator.SetOutputSemanticTable( semantic_argument.getValue() );
         generator.SetInputSemanticTable( input_semantic_argument.getValue() );
         generator.SetInterpolatorSemanticTable( interpolator_semantic_argument.getValue() );
+        generator.SetInterpolatorPacking( pack_interpolators_argument.getValue() );
+        generator.SetVertexStageMoving( move_to_vertex_argument.getValue() );
+        generator.SetCallScheduling( schedule_calls_argument.getValue() );
+        generator.SetLoopUnrolling( unroll_loops_argument.getValue() );
+        generator.SetStrengthReduction( reduce_strength_argument.getValue() );
+        generator.SetFastMath( fast_math_argument.getValue() );
+        generator.SetVectorNarrowing( narrow_vectors_argument.getValue() );
+        generator.SetTextureFetchHoisting( hoist_fetches_argument.getValue() );
+
+        if( select_cheapest_argument.getValue() )
+        {
+            generator.SetCostEstimator( &cost_estimator );
+        }
+
+        if( preshader_argument.getValue() )
+        {
+            generator.SetPreshaderExtractor( &preshader_extractor );
+        }
 
         if ( !generator.Generate(
                 vertex_code,
@@ -86,14 +491,232 @@ bool generate_hlsl(
             return false;
         }
 
-        AST::HLSLPrinter printer( std::cout );
+        Base::ScopedTimer timer( "print" );
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        if( pack_interpolators_argument.getValue() )
+        {
+            output << "Interpolator slots : " << generator.GetUnpackedInterpolatorSlotCount()
+                << " before packing, " << generator.GetInterpolatorSlotCount() << " after" << std::endl;
+        }
+
+        std::vector< Generation::VertexStageMover::MovedFunction >::const_iterator moved_it, moved_end;
+
+        for( moved_it = generator.GetMovedFunctionTable().begin(), moved_end = generator.GetMovedFunctionTable().end(); moved_it != moved_end; ++moved_it )
+        {
+            output << "Moved to vertex stage : " << (*moved_it).m_Name
+                << " (" << (*moved_it).m_Semantic
+                << ", cost " << (*moved_it).m_Cost
+                << ", interpolator components " << std::showpos << (*moved_it).m_InterpolatorComponentDelta << std::noshowpos
+                << ")" << std::endl;
+        }
+
+        if( preshader_argument.getValue() )
+        {
+            output << "Preshader : " << generator.GetVertexPreshaderOperationCount() << " vertex operations and "
+                << generator.GetPixelPreshaderOperationCount() << " pixel operations removed" << std::endl;
+        }
 
-        std::cout << "Vertex Shader : " << std::endl;
+        output << "Vertex Shader : " << std::endl;
         vertex_code->Visit( printer );
-        std::cout << "Pixel Shader : " << std::endl;
+        output << "Pixel Shader : " << std::endl;
         pixel_code->Visit( printer );
+
+        if( preshader_argument.getValue() )
+        {
+            output << "Preshader Program : " << std::endl;
+            preshader_extractor.CreateEvaluationProgram()->Visit( printer );
+        }
+
+        write_output( output.str() );
+    }
+
+    return true;
+}
+
+void write_query_functions(
+    std::ostream & output,
+    const char * label,
+    const std::vector< Generation::FunctionDefinition::Ref > & function_table
+    )
+{
+    std::vector< Generation::FunctionDefinition::Ref >::const_iterator it, end;
+
+    for( it = function_table.begin(), end = function_table.end(); it != end; ++it )
+    {
+        output << label << ": " << (*it)->GetName() << " "
+            << (*it)->GetSourceFilename() << ":" << (*it)->GetSourceFileLine() << std::endl;
+    }
+}
+
+bool query_shader(
+    const std::vector< Generation::FragmentDefinition::Ref > & definition_table
+    )
+{
+    Base::ErrorHandlerInterface::Ref
+        error_handler = new Base::ConsoleErrorHandler;
+    Generation::CodeGenerator
+        code_generator;
+    Generation::CostEstimator
+        cost_estimator;
+    std::vector< std::string >
+        used_semantic_table,
+        input_semantic_table = input_semantic_argument.getValue();
+    std::vector< Generation::FunctionDefinition::Ref >
+        function_table;
+    std::ostringstream
+        output;
+    bool
+        is_satisfiable;
+    int
+        estimated_cost;
+
+    // Estimating the cost loads the fragments, which queries avoid otherwise
+    if( select_cheapest_argument.getValue() )
+    {
+        code_generator.SetCostEstimator( &cost_estimator );
+        code_generator.SetCheapestSelection( true );
+    }
+
+    // Same stages as TechniqueGenerator : the vertex program generates what the pixel program uses
+    input_semantic_table.insert(
+        input_semantic_table.end(),
+        interpolator_semantic_argument.getValue().begin(),
+        interpolator_semantic_argument.getValue().end()
+        );
+
+    is_satisfiable = code_generator.QueryShader(
+        used_semantic_table,
+        function_table,
+        definition_table,
+        semantic_argument.getValue(),
+        input_semantic_table,
+        *error_handler
+        );
+    estimated_cost = code_generator.GetEstimatedCost();
+
+    if( is_satisfiable && interpolator_semantic_argument.isSet() )
+    {
+        std::vector< std::string >
+            pixel_used_semantic_table;
+        std::vector< Generation::FunctionDefinition::Ref >
+            vertex_function_table;
+
+        pixel_used_semantic_table.swap( used_semantic_table );
+        write_query_functions( output, "pixel_function", function_table );
+
+        is_satisfiable = code_generator.QueryShader(
+            used_semantic_table,
+            vertex_function_table,
+            definition_table,
+            pixel_used_semantic_table,
+            input_semantic_argument.getValue(),
+            *error_handler
+            );
+        estimated_cost += code_generator.GetEstimatedCost();
+
+        write_query_functions( output, "vertex_function", vertex_function_table );
+    }
+    else
+    {
+        write_query_functions( output, "function", function_table );
     }
 
+    std::ostringstream
+        result;
+
+    result << "satisfiable: " << ( is_satisfiable ? "yes" : "no" ) << std::endl;
+
+    if( is_satisfiable )
+    {
+        result << "used_input_semantics:";
+
+        for( std::vector< std::string >::const_iterator it = used_semantic_table.begin(); it != used_semantic_table.end(); ++it )
+        {
+            result << " " << *it;
+        }
+
+        result << std::endl;
+
+        if( select_cheapest_argument.getValue() )
+        {
+            result << "estimated_cost: " << estimated_cost << std::endl;
+        }
+
+        result << output.str();
+    }
+
+    write_output( result.str() );
+
+    return true;
+}
+
+bool enumerate_permutations(
+    const std::vector< Generation::FragmentDefinition::Ref > & definition_table
+    )
+{
+    Base::ErrorHandlerInterface::Ref
+        error_handler = new Base::ConsoleErrorHandler;
+    Generation::PermutationEnumerator
+        enumerator;
+    Generation::ResolutionCache
+        resolution_cache( static_cast<size_t>( std::max( 0, resolution_cache_argument.getValue() ) ) * 1024 * 1024 );
+    Generation::CostEstimator
+        cost_estimator;
+    std::vector< Generation::PermutationEnumerator::Permutation >
+        permutation_table;
+    std::ostringstream
+        output;
+
+    if( resolution_cache_argument.getValue() > 0 )
+    {
+        enumerator.SetResolutionCache( &resolution_cache );
+    }
+
+    // The cost of each permutation is reported with the statistics
+    if( select_cheapest_argument.getValue() || Base::Statistics::IsEnabled() )
+    {
+        enumerator.SetCostEstimator( &cost_estimator );
+        enumerator.SetCheapestSelection( select_cheapest_argument.getValue() );
+    }
+
+    if( !enumerator.Enumerate(
+            permutation_table,
+            definition_table,
+            semantic_argument.getValue(),
+            optional_semantic_argument.getValue(),
+            input_semantic_argument.getValue(),
+            *error_handler
+            )
+        )
+    {
+        return false;
+    }
+
+    std::vector< Generation::PermutationEnumerator::Permutation >::const_iterator it, end;
+
+    for( it = permutation_table.begin(), end = permutation_table.end(); it != end; ++it )
+    {
+        const char
+            * separator = "";
+
+        for( std::vector< std::string >::const_iterator semantic = (*it).m_SemanticTable.begin(); semantic != (*it).m_SemanticTable.end(); ++semantic )
+        {
+            output << separator << "-s " << *semantic;
+            separator = " ";
+        }
+
+        for( std::vector< std::string >::const_iterator semantic = (*it).m_UsedInputSemanticTable.begin(); semantic != (*it).m_UsedInputSemanticTable.end(); ++semantic )
+        {
+            output << " -i " << *semantic;
+        }
+
+        output << std::endl;
+    }
+
+    write_output( output.str() );
+
     return true;
 }
 
@@ -110,9 +733,12 @@ bool generate_annotations(
 
     generate_code( generated_code, used_semantic_set, error_handler, definition_table );
 
-    AST::AnnotationPrinter printer( std::cout );
+    Base::ScopedTimer timer( "print" );
+    std::ostringstream output;
+    AST::AnnotationPrinter printer( output );
 
     generated_code->Visit( printer );
+    write_output( output.str() );
     return true;
 }
 
@@ -122,23 +748,101 @@ int main( int argument_count, const char* argument_table[] )
     {
         cmd.parse( argument_count, argument_table );
 
+        Base::Statistics::Enable( stats_argument.getValue() || stats_json_argument.isSet() );
+        Base::Tracer::Enable( trace_argument.isSet() );
+
         std::vector< Generation::FragmentDefinition::Ref > definition_table;
+        std::vector< std::string > path_table;
         std::vector<std::string>::const_iterator it, end;
-        it = fragment_arguments.getValue().begin();
-        end = fragment_arguments.getValue().end();
+        HLSL::IncludeCache::Ref include_cache = new HLSL::IncludeCache;
+        Base::ErrorHandlerInterface::Ref parse_error_handler = new Base::ConsoleErrorHandler;
+        HLSL::Preprocessor preprocessor( *include_cache, *parse_error_handler );
+
+        it = include_path_argument.getValue().begin();
+        end = include_path_argument.getValue().end();
 
         for(; it!=end; ++it )
         {
-            Base::ObjectRef<AST::TranslationUnit>
-                translation_unit;
-            Base::ObjectRef<Generation::FragmentDefinition>
-                definition;
+            preprocessor.AddIncludePath( *it );
+        }
 
-            translation_unit = HLSL::ParseHLSL( (*it).c_str() );
+        it = define_argument.getValue().begin();
+        end = define_argument.getValue().end();
 
-            definition = Generation::FragmentDefinition::GenerateFragment( *translation_unit );
+        for(; it!=end; ++it )
+        {
+            std::string::size_type separator = (*it).find( '=' );
 
-            definition_table.push_back( definition );
+            if( separator == std::string::npos )
+            {
+                preprocessor.Define( *it );
+            }
+            else
+            {
+                preprocessor.Define( (*it).substr( 0, separator ), (*it).substr( separator + 1 ) );
+            }
+        }
+
+        Generation::FragmentLoaderInterface::Ref loader = new ParsingFragmentLoader( preprocessor );
+
+        if( build_index_argument.isSet() )
+        {
+            bool success = build_index( *loader, *parse_error_handler );
+
+            return write_reports() && success ? 0 : 1;
+        }
+
+        if( server_argument.getValue() )
+        {
+            if( !load_fragments( definition_table, path_table, *loader, *parse_error_handler ) )
+            {
+                return 1;
+            }
+
+            bool success = run_server( definition_table, path_table, *loader );
+
+            return write_reports() && success ? 0 : 1;
+        }
+
+        if( enumerate_argument.getValue() )
+        {
+            if( !load_fragments( definition_table, path_table, *loader, *parse_error_handler ) )
+            {
+                return 1;
+            }
+
+            bool success = enumerate_permutations( definition_table );
+
+            return write_reports() && success ? 0 : 1;
+        }
+
+        if( query_argument.getValue() )
+        {
+            if( !semantic_argument.isSet() )
+            {
+                std::cerr << "error: -s is required to query" << std::endl;
+                return 1;
+            }
+
+            if( !load_fragments( definition_table, path_table, *loader, *parse_error_handler ) )
+            {
+                return 1;
+            }
+
+            bool success = query_shader( definition_table );
+
+            return write_reports() && success ? 0 : 1;
+        }
+
+        if( !semantic_argument.isSet() || !input_semantic_argument.isSet() || !generator_argument.isSet() )
+        {
+            std::cerr << "error: -s, -i and -g are required to generate code" << std::endl;
+            return 1;
+        }
+
+        if( !load_fragments( definition_table, path_table, *loader, *parse_error_handler ) )
+        {
+            return 1;
         }
 
         if ( generator_argument.getValue() == "a" )
@@ -155,6 +859,11 @@ int main( int argument_count, const char* argument_table[] )
                 return 1;
             }
         }
+
+        if( !write_reports() )
+        {
+            return 1;
+        }
     }
     catch( TCLAP::ArgException &e )
     {
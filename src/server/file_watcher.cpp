@@ -0,0 +1,208 @@
+#include "file_watcher.h"
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <cstring>
+    #include <set>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace Server
+{
+
+#ifdef __linux__
+
+    FileWatcher::FileWatcher() :
+        m_Descriptor( inotify_init1( IN_CLOEXEC ) )
+    {
+        if( pipe2( m_StopDescriptorTable, O_CLOEXEC ) != 0 )
+        {
+            m_StopDescriptorTable[ 0 ] = m_StopDescriptorTable[ 1 ] = -1;
+        }
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        for( int index = 0; index < 2; ++index )
+        {
+            if( m_StopDescriptorTable[ index ] >= 0 )
+            {
+                close( m_StopDescriptorTable[ index ] );
+            }
+        }
+
+        if( m_Descriptor >= 0 )
+        {
+            close( m_Descriptor );
+        }
+    }
+
+    bool FileWatcher::AddDirectory( const std::string & directory, std::string & error )
+    {
+        if( m_Descriptor < 0 )
+        {
+            error = std::strerror( errno );
+            return false;
+        }
+
+        // Editors saving through a temporary file rename it over the original
+        const int
+            watch = inotify_add_watch(
+                m_Descriptor,
+                directory.empty() ? "." : directory.c_str(),
+                IN_CLOSE_WRITE | IN_MOVED_TO
+                );
+
+        if( watch < 0 )
+        {
+            error = std::strerror( errno );
+            return false;
+        }
+
+        m_DirectoryTable[ watch ] = directory.empty() ? "." : directory;
+
+        return true;
+    }
+
+    bool FileWatcher::WaitForChanges(
+        std::vector<std::string> & path_table,
+        std::string & error,
+        const int settle_milliseconds
+        )
+    {
+        std::set<std::string>
+            path_set;
+        // Large enough for several events, aligned as required by inotify_event
+        alignas( inotify_event ) char
+            buffer[ 4096 ];
+
+        path_table.clear();
+
+        if( m_Descriptor < 0 || m_StopDescriptorTable[ 0 ] < 0 || m_DirectoryTable.empty() )
+        {
+            error = "no directory is watched";
+            return false;
+        }
+
+        for( ;; )
+        {
+            pollfd
+                descriptor_table[ 2 ];
+
+            descriptor_table[ 0 ].fd = m_Descriptor;
+            descriptor_table[ 1 ].fd = m_StopDescriptorTable[ 0 ];
+            descriptor_table[ 0 ].events = descriptor_table[ 1 ].events = POLLIN;
+            descriptor_table[ 0 ].revents = descriptor_table[ 1 ].revents = 0;
+
+            const int
+                ready_count = poll( descriptor_table, 2, path_set.empty() ? -1 : settle_milliseconds );
+
+            if( ready_count < 0 )
+            {
+                if( errno == EINTR )
+                {
+                    continue;
+                }
+
+                error = std::strerror( errno );
+                return false;
+            }
+
+            if( descriptor_table[ 1 ].revents != 0 )
+            {
+                return true;
+            }
+
+            if( ready_count == 0 )
+            {
+                break;
+            }
+
+            const ssize_t
+                read_size = read( m_Descriptor, buffer, sizeof( buffer ) );
+
+            if( read_size < 0 )
+            {
+                if( errno == EINTR || errno == EAGAIN )
+                {
+                    continue;
+                }
+
+                error = std::strerror( errno );
+                return false;
+            }
+
+            for( ssize_t offset = 0; offset < read_size; )
+            {
+                const inotify_event
+                    & event = *reinterpret_cast<const inotify_event *>( buffer + offset );
+                std::map<int, std::string>::const_iterator
+                    directory = m_DirectoryTable.find( event.wd );
+
+                if( event.len > 0 && directory != m_DirectoryTable.end() )
+                {
+                    path_set.insert( (*directory).second + "/" + event.name );
+                }
+
+                offset += sizeof( inotify_event ) + event.len;
+            }
+        }
+
+        path_table.assign( path_set.begin(), path_set.end() );
+
+        return true;
+    }
+
+    void FileWatcher::Stop()
+    {
+        const char
+            signal = 0;
+
+        if( m_StopDescriptorTable[ 1 ] >= 0 )
+        {
+            // Only fails when the pipe is full, which wakes up the watcher as well
+            const ssize_t
+                written_size = write( m_StopDescriptorTable[ 1 ], &signal, 1 );
+
+            (void)written_size;
+        }
+    }
+
+#else
+
+    FileWatcher::FileWatcher() :
+        m_Descriptor( -1 )
+    {
+        m_StopDescriptorTable[ 0 ] = m_StopDescriptorTable[ 1 ] = -1;
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+    }
+
+    bool FileWatcher::AddDirectory( const std::string & /*directory*/, std::string & error )
+    {
+        error = "file watching is not supported on this platform";
+        return false;
+    }
+
+    bool FileWatcher::WaitForChanges(
+        std::vector<std::string> & path_table,
+        std::string & error,
+        const int /*settle_milliseconds*/
+        )
+    {
+        path_table.clear();
+        error = "file watching is not supported on this platform";
+        return false;
+    }
+
+    void FileWatcher::Stop()
+    {
+    }
+
+#endif
+}
\ No newline at end of file
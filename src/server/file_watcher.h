@@ -0,0 +1,48 @@
+#ifndef FILE_WATCHER_H
+    #define FILE_WATCHER_H
+
+    #include <map>
+    #include <string>
+    #include <vector>
+
+    namespace Server
+    {
+        // Reports the files written or moved into a set of directories, using inotify.
+        // On other platforms, AddDirectory always fails.
+
+        class FileWatcher
+        {
+        public:
+
+            FileWatcher();
+            ~FileWatcher();
+
+            bool AddDirectory( const std::string & directory, std::string & error );
+
+            // Blocks until files change, then returns their paths as directory/name.
+            // Events arriving within settle_milliseconds of each other are coalesced,
+            // as editors often save a file in several steps. Returns an empty table
+            // once Stop is called.
+            bool WaitForChanges(
+                std::vector<std::string> & path_table,
+                std::string & error,
+                const int settle_milliseconds = 50
+                );
+
+            // Wakes up WaitForChanges, can be called from any thread
+            void Stop();
+
+        private:
+
+            FileWatcher( const FileWatcher & );
+            FileWatcher & operator=( const FileWatcher & );
+
+            int
+                m_Descriptor,
+                m_StopDescriptorTable[ 2 ];
+            std::map<int, std::string>
+                m_DirectoryTable;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,607 @@
+#include "generation_server.h"
+
+#include <ast/node.h>
+#include <ast/printer/annotation_printer.h>
+#include <ast/printer/hlsl_printer.h>
+#include <base/statistics.h>
+#include <base/text_error_handler.h>
+#include <generation/code_generator.h>
+#include <generation/function_definition.h>
+#include <generation/preshader_extractor.h>
+#include <generation/technique_generator.h>
+#include <utils/json.h>
+#include <map>
+#include <sstream>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <csignal>
+    #include <cstring>
+    #include <thread>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace Server
+{
+    namespace
+    {
+        typedef std::map<std::string, std::vector<std::string> >
+            Request;
+
+        const std::vector<std::string> & GetField( const Request & request, const char * name )
+        {
+            static const std::vector<std::string>
+                empty_table;
+            Request::const_iterator
+                field = request.find( name );
+
+            return field == request.end() ? empty_table : (*field).second;
+        }
+
+        void WriteStringTable( std::ostream & stream, const std::vector<std::string> & table )
+        {
+            std::vector<std::string>::const_iterator it, end;
+            const char
+                * separator = "";
+
+            stream << "[";
+
+            for( it = table.begin(), end = table.end(); it != end; ++it )
+            {
+                stream << separator;
+                write_json_string( stream, *it );
+                separator = ",";
+            }
+
+            stream << "]";
+        }
+
+        std::string CreateErrorResponse( const std::string & id, const std::string & message )
+        {
+            std::ostringstream
+                response;
+
+            response << "{\"id\":";
+            write_json_string( response, id );
+            response << ",\"status\":\"error\",\"message\":";
+            write_json_string( response, message );
+            response << "}";
+
+            return response.str();
+        }
+
+        std::string PrintHLSL( const AST::TranslationUnit & translation_unit )
+        {
+            std::ostringstream
+                output;
+            AST::HLSLPrinter
+                printer( output );
+
+            translation_unit.Visit( printer );
+
+            return output.str();
+        }
+
+        void AddProducedSemantics( std::set<std::string> & semantic_set, const Generation::FragmentDefinition & fragment )
+        {
+            std::vector<Generation::FunctionDefinition::Ref>::const_iterator it, end;
+
+            for( it = fragment.GetFunctionDefinitionTable().begin(), end = fragment.GetFunctionDefinitionTable().end(); it != end; ++it )
+            {
+                semantic_set.insert( (*it)->GetOutSemanticSet().begin(), (*it)->GetOutSemanticSet().end() );
+                semantic_set.insert( (*it)->GetInOutSemanticSet().begin(), (*it)->GetInOutSemanticSet().end() );
+            }
+        }
+
+        bool IsIntersecting( const std::set<std::string> & first, const std::set<std::string> & second )
+        {
+            std::set<std::string>::const_iterator it, end;
+
+            for( it = first.begin(), end = first.end(); it != end; ++it )
+            {
+                if( second.find( *it ) != second.end() )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Included declarations keep the path of the file they come from
+        bool IncludesFile( const Generation::FragmentDefinition & fragment, const std::set<std::string> & path_set )
+        {
+            const std::vector<Base::ObjectRef<AST::GlobalDeclaration> >
+                & declaration_table = fragment.GetTranslationUnit().m_GlobalDeclarationTable;
+            std::vector<Base::ObjectRef<AST::GlobalDeclaration> >::const_iterator it, end;
+
+            for( it = declaration_table.begin(), end = declaration_table.end(); it != end; ++it )
+            {
+                if( path_set.find( (*it)->GetFileName() ) != path_set.end() )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    }
+
+    GenerationServer::GenerationServer(
+        const std::vector<Generation::FragmentDefinition::Ref> & definition_table,
+        const std::vector<std::string> & path_table
+        ) :
+        m_PathTable( path_table ),
+        m_Library( new Library )
+    {
+        std::vector<Generation::FragmentDefinition::Ref>::const_iterator it, end;
+
+        m_Library->m_DefinitionTable = definition_table;
+
+        for( it = definition_table.begin(), end = definition_table.end(); it != end; ++it )
+        {
+            (*it)->Prewarm();
+        }
+    }
+
+    std::string GenerationServer::HandleRequest( const std::string & request_text ) const
+    {
+        Base::ScopedTimer
+            timer( "server_request" );
+        Request
+            request;
+
+        if( !read_json_object( request, request_text ) )
+        {
+            return CreateErrorResponse( "", "invalid request" );
+        }
+
+        const std::string
+            id = GetField( request, "id" ).empty() ? "" : GetField( request, "id" ).front();
+        const std::vector<std::string>
+            & semantic_table = GetField( request, "semantics" ),
+            & input_semantic_table = GetField( request, "input_semantics" ),
+            & interpolator_semantic_table = GetField( request, "interpolator_semantics" ),
+            & preshader_field = GetField( request, "preshader" );
+        const bool
+            extracts_preshader = !preshader_field.empty() && preshader_field.front() == "true";
+        std::ostringstream
+            key,
+            response;
+        Library::Ref
+            library;
+        std::string
+            body;
+
+        if( semantic_table.empty() )
+        {
+            return CreateErrorResponse( id, "no semantic requested" );
+        }
+
+        WriteStringTable( key, semantic_table );
+        WriteStringTable( key, input_semantic_table );
+        WriteStringTable( key, interpolator_semantic_table );
+        key << extracts_preshader;
+
+        {
+            std::lock_guard<std::mutex>
+                lock( m_Mutex );
+            std::map<std::string, CachedResponse>::const_iterator
+                cached_response = m_ResponseTable.find( key.str() );
+
+            library = m_Library;
+
+            if( cached_response != m_ResponseTable.end() )
+            {
+                body = (*cached_response).second.m_Body;
+            }
+        }
+
+        if( !body.empty() )
+        {
+            Base::Statistics::AddCount( "server_cache_hit_count" );
+        }
+        else
+        {
+            std::set<std::string>
+                searched_semantic_set;
+            std::string
+                error;
+
+            Base::Statistics::AddCount( "server_cache_miss_count" );
+
+            if( !GenerateResponseBody( body, searched_semantic_set, error, *library, semantic_table, input_semantic_table, interpolator_semantic_table, extracts_preshader ) )
+            {
+                return CreateErrorResponse( id, error );
+            }
+
+            std::lock_guard<std::mutex>
+                lock( m_Mutex );
+
+            // A response generated from a replaced library could miss its invalidation
+            if( m_Library == &*library )
+            {
+                CachedResponse
+                    & cached_response = m_ResponseTable[ key.str() ];
+
+                cached_response.m_Body = body;
+                cached_response.m_SearchedSemanticSet.swap( searched_semantic_set );
+            }
+        }
+
+        response << "{\"id\":";
+        write_json_string( response, id );
+        response << body;
+
+        return response.str();
+    }
+
+    bool GenerationServer::GenerateResponseBody(
+        std::string & body,
+        std::set<std::string> & searched_semantic_set,
+        std::string & error,
+        const Library & library,
+        const std::vector<std::string> & semantic_table,
+        const std::vector<std::string> & input_semantic_table,
+        const std::vector<std::string> & interpolator_semantic_table,
+        const bool extracts_preshader
+        ) const
+    {
+        Base::ObjectRef<Base::TextErrorHandler>
+            error_handler = new Base::TextErrorHandler;
+        Generation::PreshaderExtractor
+            preshader_extractor;
+        std::ostringstream
+            response;
+
+        response << ",\"status\":\"ok\"";
+
+        if( interpolator_semantic_table.empty() )
+        {
+            Generation::CodeGenerator
+                code_generator;
+            Base::ObjectRef<AST::TranslationUnit>
+                generated_code;
+            std::vector<std::string>
+                used_semantic_table;
+
+            code_generator.SetPreshaderExtractor( extracts_preshader ? &preshader_extractor : 0 );
+            code_generator.GenerateShader(
+                generated_code,
+                used_semantic_table,
+                library.m_DefinitionTable,
+                semantic_table,
+                input_semantic_table,
+                *error_handler
+                );
+
+            if( !generated_code )
+            {
+                error = error_handler->GetErrorMessage();
+                return false;
+            }
+
+            std::ostringstream
+                annotations;
+            AST::AnnotationPrinter
+                annotation_printer( annotations );
+
+            generated_code->Visit( annotation_printer );
+
+            response << ",\"hlsl\":";
+            write_json_string( response, PrintHLSL( *generated_code ) );
+            response << ",\"annotations\":";
+            write_json_string( response, annotations.str() );
+            response << ",\"used_semantics\":";
+            WriteStringTable( response, used_semantic_table );
+
+            searched_semantic_set = code_generator.GetSearchedSemanticSet();
+        }
+        else
+        {
+            Generation::TechniqueGenerator
+                generator;
+            Base::ObjectRef<AST::TranslationUnit>
+                vertex_code,
+                pixel_code;
+            std::vector<std::string>
+                used_input_semantic_table;
+
+            generator.SetOutputSemanticTable( semantic_table );
+            generator.SetInputSemanticTable( input_semantic_table );
+            generator.SetInterpolatorSemanticTable( interpolator_semantic_table );
+            generator.SetPreshaderExtractor( extracts_preshader ? &preshader_extractor : 0 );
+
+            if( !generator.Generate( vertex_code, pixel_code, used_input_semantic_table, library.m_DefinitionTable, *error_handler ) )
+            {
+                error = error_handler->GetErrorMessage();
+                return false;
+            }
+
+            response << ",\"vertex_hlsl\":";
+            write_json_string( response, PrintHLSL( *vertex_code ) );
+            response << ",\"pixel_hlsl\":";
+            write_json_string( response, PrintHLSL( *pixel_code ) );
+            response << ",\"used_input_semantics\":";
+            WriteStringTable( response, used_input_semantic_table );
+
+            searched_semantic_set = generator.GetSearchedSemanticSet();
+        }
+
+        if( extracts_preshader )
+        {
+            response << ",\"preshader_hlsl\":";
+            write_json_string( response, PrintHLSL( *preshader_extractor.CreateEvaluationProgram() ) );
+        }
+
+        response << "}";
+        body = response.str();
+
+        return true;
+    }
+
+    bool GenerationServer::ReloadFragments(
+        const std::vector<std::string> & changed_path_table,
+        Generation::FragmentLoaderInterface & loader
+        )
+    {
+        Base::ScopedTimer
+            timer( "server_reload" );
+        const std::set<std::string>
+            changed_path_set( changed_path_table.begin(), changed_path_table.end() );
+        std::set<std::string>
+            produced_semantic_set;
+        Library::Ref
+            library = new Library;
+        int
+            reloaded_count = 0;
+        bool
+            success = true;
+
+        {
+            std::lock_guard<std::mutex>
+                lock( m_Mutex );
+
+            library->m_DefinitionTable = m_Library->m_DefinitionTable;
+        }
+
+        for( size_t index = 0; index < m_PathTable.size() && index < library->m_DefinitionTable.size(); ++index )
+        {
+            const Generation::FragmentDefinition
+                & fragment = *library->m_DefinitionTable[ index ];
+
+            if( changed_path_set.find( m_PathTable[ index ] ) == changed_path_set.end()
+                && !IncludesFile( fragment, changed_path_set )
+                )
+            {
+                continue;
+            }
+
+            // The loader reports its own errors
+            Base::ObjectRef<AST::TranslationUnit>
+                translation_unit = loader.LoadTranslationUnit( m_PathTable[ index ] );
+
+            if( !translation_unit )
+            {
+                success = false;
+                continue;
+            }
+
+            Generation::FragmentDefinition::Ref
+                reloaded_fragment = Generation::FragmentDefinition::GenerateFragment( *translation_unit );
+
+            reloaded_fragment->Prewarm();
+
+            AddProducedSemantics( produced_semantic_set, fragment );
+            AddProducedSemantics( produced_semantic_set, *reloaded_fragment );
+
+            library->m_DefinitionTable[ index ] = reloaded_fragment;
+            ++reloaded_count;
+        }
+
+        if( reloaded_count == 0 )
+        {
+            return success;
+        }
+
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+        std::map<std::string, CachedResponse>::iterator
+            it = m_ResponseTable.begin();
+        int
+            invalidated_count = 0;
+
+        m_Library = library;
+
+        while( it != m_ResponseTable.end() )
+        {
+            if( IsIntersecting( (*it).second.m_SearchedSemanticSet, produced_semantic_set ) )
+            {
+                it = m_ResponseTable.erase( it );
+                ++invalidated_count;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        Base::Statistics::AddCount( "server_reloaded_fragment_count", reloaded_count );
+        Base::Statistics::AddCount( "server_invalidated_response_count", invalidated_count );
+
+        return success;
+    }
+
+    size_t GenerationServer::GetCachedResponseCount() const
+    {
+        std::lock_guard<std::mutex>
+            lock( m_Mutex );
+
+        return m_ResponseTable.size();
+    }
+
+    void GenerationServer::Serve( std::istream & input, std::ostream & output ) const
+    {
+        std::string
+            line;
+
+        while( std::getline( input, line ) )
+        {
+            if( line.find_first_not_of( " \t\r" ) == std::string::npos )
+            {
+                continue;
+            }
+
+            output << HandleRequest( line ) << std::endl;
+        }
+    }
+
+#ifndef _WIN32
+
+    bool GenerationServer::ServeSocket( const std::string & path, std::string & error ) const
+    {
+        sockaddr_un
+            address;
+        int
+            server;
+
+        if( path.size() >= sizeof( address.sun_path ) )
+        {
+            error = "socket path is too long";
+            return false;
+        }
+
+        std::memset( &address, 0, sizeof( address ) );
+        address.sun_family = AF_UNIX;
+        std::strncpy( address.sun_path, path.c_str(), sizeof( address.sun_path ) - 1 );
+
+        server = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+        if( server < 0 )
+        {
+            error = std::strerror( errno );
+            return false;
+        }
+
+        // A stale socket file from a previous run would make bind fail
+        unlink( path.c_str() );
+
+        if( bind( server, reinterpret_cast<sockaddr *>( &address ), sizeof( address ) ) != 0
+            || listen( server, SOMAXCONN ) != 0
+            )
+        {
+            error = std::strerror( errno );
+            close( server );
+            return false;
+        }
+
+        // Disconnected clients are detected by the write errors
+        std::signal( SIGPIPE, SIG_IGN );
+
+        for( ;; )
+        {
+            int
+                client = accept( server, 0, 0 );
+
+            if( client < 0 )
+            {
+                if( errno == EINTR || errno == ECONNABORTED )
+                {
+                    continue;
+                }
+
+                error = std::strerror( errno );
+                close( server );
+                return false;
+            }
+
+            std::thread( &GenerationServer::ServeClient, this, client ).detach();
+        }
+    }
+
+    void GenerationServer::ServeClient( const int client ) const
+    {
+        std::string
+            pending;
+        char
+            buffer[ 4096 ];
+        bool
+            is_connected = true;
+
+        while( is_connected )
+        {
+            const ssize_t
+                read_size = read( client, buffer, sizeof( buffer ) );
+
+            if( read_size < 0 && errno == EINTR )
+            {
+                continue;
+            }
+
+            if( read_size <= 0 )
+            {
+                break;
+            }
+
+            pending.append( buffer, static_cast<size_t>( read_size ) );
+
+            std::string::size_type
+                line_end;
+
+            while( is_connected && ( line_end = pending.find( '\n' ) ) != std::string::npos )
+            {
+                const std::string
+                    line = pending.substr( 0, line_end );
+
+                pending.erase( 0, line_end + 1 );
+
+                if( line.find_first_not_of( " \t\r" ) == std::string::npos )
+                {
+                    continue;
+                }
+
+                const std::string
+                    response = HandleRequest( line ) + "\n";
+                size_t
+                    written_size = 0;
+
+                while( written_size < response.size() )
+                {
+                    const ssize_t
+                        size = write( client, response.data() + written_size, response.size() - written_size );
+
+                    if( size < 0 && errno == EINTR )
+                    {
+                        continue;
+                    }
+
+                    if( size <= 0 )
+                    {
+                        is_connected = false;
+                        break;
+                    }
+
+                    written_size += static_cast<size_t>( size );
+                }
+            }
+        }
+
+        close( client );
+    }
+
+#else
+
+    bool GenerationServer::ServeSocket( const std::string & /*path*/, std::string & error ) const
+    {
+        error = "Unix domain sockets are not supported on this platform";
+        return false;
+    }
+
+    void GenerationServer::ServeClient( const int /*client*/ ) const
+    {
+    }
+
+#endif
+}
\ No newline at end of file
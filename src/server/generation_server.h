@@ -0,0 +1,116 @@
+#ifndef GENERATION_SERVER_H
+    #define GENERATION_SERVER_H
+
+    #include <base/object.h>
+    #include <generation/fragment_definition.h>
+    #include <istream>
+    #include <map>
+    #include <mutex>
+    #include <ostream>
+    #include <set>
+    #include <string>
+    #include <vector>
+
+    namespace Server
+    {
+        // Keeps a fragment library resident and answers generation requests, one JSON
+        // object per line (NDJSON) :
+        //
+        //     {"id":"1","semantics":["Color"],"input_semantics":["TexCoord"]}
+        //
+        // The response echoes the id as a string and holds either "hlsl", "annotations"
+        // and "used_semantics", or, when "interpolator_semantics" are given, "vertex_hlsl",
+        // "pixel_hlsl" and "used_input_semantics". With "preshader":true, the uniform
+        // expressions are extracted and their evaluation program is in "preshader_hlsl",
+        // see Generation::PreshaderExtractor. Failed requests get a "status" of "error"
+        // and a "message".
+        //
+        // The library is prewarmed on construction and only read afterwards, so requests
+        // can be handled by several threads at once. Reference counts are atomic for the
+        // lifetime of the server, see Base::Object::SharingScope. Reloaded fragments are
+        // prewarmed before being published in a new library snapshot, while requests in
+        // flight keep the snapshot they started with.
+        //
+        // Successful responses are cached per semantic tables, along with the semantics
+        // searched to generate them. A reload only drops the responses that searched
+        // for a semantic produced by the old or new version of a reloaded fragment.
+
+        class GenerationServer
+        {
+        public:
+
+            // path_table gives the path of each fragment, it is only needed to reload them
+            explicit GenerationServer(
+                const std::vector<Generation::FragmentDefinition::Ref> & definition_table,
+                const std::vector<std::string> & path_table = std::vector<std::string>()
+                );
+
+            std::string HandleRequest( const std::string & request ) const;
+
+            // Reparses the fragments whose path is in changed_path_table, or which contain
+            // declarations coming from such a file through an include. A fragment that
+            // fails to parse keeps its previous version and makes the call return false.
+            // Only one thread may reload at a time.
+            bool ReloadFragments(
+                const std::vector<std::string> & changed_path_table,
+                Generation::FragmentLoaderInterface & loader
+                );
+
+            size_t GetCachedResponseCount() const;
+
+            // Serves requests until the end of the input
+            void Serve( std::istream & input, std::ostream & output ) const;
+
+            // Serves every client connecting to the Unix domain socket at path in its own
+            // thread. Only returns on error, or immediately on platforms without such sockets.
+            bool ServeSocket( const std::string & path, std::string & error ) const;
+
+        private:
+
+            struct Library : public Base::Object
+            {
+                typedef Base::ObjectRef<Library>
+                    Ref;
+
+                std::vector<Generation::FragmentDefinition::Ref>
+                    m_DefinitionTable;
+            };
+
+            struct CachedResponse
+            {
+                // Response without its id, starting at the status field
+                std::string
+                    m_Body;
+                std::set<std::string>
+                    m_SearchedSemanticSet;
+            };
+
+            bool GenerateResponseBody(
+                std::string & body,
+                std::set<std::string> & searched_semantic_set,
+                std::string & error,
+                const Library & library,
+                const std::vector<std::string> & semantic_table,
+                const std::vector<std::string> & input_semantic_table,
+                const std::vector<std::string> & interpolator_semantic_table,
+                const bool extracts_preshader
+                ) const;
+
+            void ServeClient( const int client ) const;
+
+            // Client threads and reloads share the objects of the library
+            Base::Object::SharingScope
+                m_SharingScope;
+            std::vector<std::string>
+                m_PathTable;
+            // Guards the library snapshot and the response cache
+            mutable std::mutex
+                m_Mutex;
+            Library::Ref
+                m_Library;
+            mutable std::map<std::string, CachedResponse>
+                m_ResponseTable;
+        };
+    }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#include "utils/hash.h"
+
+
+uint64_t compute_content_hash( const std::string & content )
+{
+    uint64_t
+        hash = 14695981039346656037ULL;
+
+    for( std::string::const_iterator it = content.begin(), end = content.end(); it != end; ++it )
+    {
+        hash ^= static_cast<unsigned char>( *it );
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef HASH_H
+    #define HASH_H
+
+    #include <cstdint>
+    #include <string>
+
+    // FNV-1a, used to detect content changes, not for security
+    uint64_t compute_content_hash( const std::string & content );
+
+#endif
\ No newline at end of file
@@ -0,0 +1,289 @@
+#include "utils/json.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    void skip_whitespace( std::string::const_iterator & it, const std::string::const_iterator end )
+    {
+        while( it != end && std::isspace( static_cast<unsigned char>( *it ) ) )
+        {
+            ++it;
+        }
+    }
+
+    void append_utf8( std::string & value, const unsigned long code_point )
+    {
+        if( code_point < 0x80 )
+        {
+            value += static_cast<char>( code_point );
+        }
+        else if( code_point < 0x800 )
+        {
+            value += static_cast<char>( 0xC0 | ( code_point >> 6 ) );
+            value += static_cast<char>( 0x80 | ( code_point & 0x3F ) );
+        }
+        else
+        {
+            value += static_cast<char>( 0xE0 | ( code_point >> 12 ) );
+            value += static_cast<char>( 0x80 | ( ( code_point >> 6 ) & 0x3F ) );
+            value += static_cast<char>( 0x80 | ( code_point & 0x3F ) );
+        }
+    }
+
+    bool read_json_string(
+        std::string & value,
+        std::string::const_iterator & it,
+        const std::string::const_iterator end
+        )
+    {
+        value.clear();
+
+        if( it == end || *it != '"' )
+        {
+            return false;
+        }
+
+        for( ++it; it != end; ++it )
+        {
+            if( *it == '"' )
+            {
+                ++it;
+                return true;
+            }
+
+            if( *it != '\\' )
+            {
+                value += *it;
+                continue;
+            }
+
+            if( ++it == end )
+            {
+                return false;
+            }
+
+            switch( *it )
+            {
+                case '"': value += '"'; break;
+                case '\\': value += '\\'; break;
+                case '/': value += '/'; break;
+                case 'b': value += '\b'; break;
+                case 'f': value += '\f'; break;
+                case 'n': value += '\n'; break;
+                case 'r': value += '\r'; break;
+                case 't': value += '\t'; break;
+
+                case 'u':
+                    {
+                        if( end - it < 5 )
+                        {
+                            return false;
+                        }
+
+                        const std::string
+                            digits( it + 1, it + 5 );
+                        char
+                            * digit_end;
+                        const unsigned long
+                            code_point = std::strtoul( digits.c_str(), &digit_end, 16 );
+
+                        if( digit_end != digits.c_str() + 4 )
+                        {
+                            return false;
+                        }
+
+                        append_utf8( value, code_point );
+                        it += 4;
+                    }
+                    break;
+
+                default:
+                    return false;
+            }
+        }
+
+        return false;
+    }
+
+    bool read_json_scalar(
+        std::string & value,
+        std::string::const_iterator & it,
+        const std::string::const_iterator end
+        )
+    {
+        if( it != end && *it == '"' )
+        {
+            return read_json_string( value, it, end );
+        }
+
+        value.clear();
+
+        while( it != end && ( std::isalnum( static_cast<unsigned char>( *it ) ) || *it == '-' || *it == '+' || *it == '.' ) )
+        {
+            value += *it;
+            ++it;
+        }
+
+        return !value.empty();
+    }
+}
+
+
+void write_json_string( std::ostream & stream, const std::string & value )
+{
+    stream << '"';
+
+    for( std::string::const_iterator it = value.begin(), end = value.end(); it != end; ++it )
+    {
+        switch( *it )
+        {
+            case '"': stream << "\\\""; break;
+            case '\\': stream << "\\\\"; break;
+            case '\n': stream << "\\n"; break;
+            case '\r': stream << "\\r"; break;
+            case '\t': stream << "\\t"; break;
+
+            default:
+                if( static_cast<unsigned char>( *it ) < 0x20 )
+                {
+                    char
+                        buffer[ 8 ];
+
+                    std::snprintf( buffer, sizeof( buffer ), "\\u%04x", static_cast<unsigned char>( *it ) );
+                    stream << buffer;
+                }
+                else
+                {
+                    stream << *it;
+                }
+                break;
+        }
+    }
+
+    stream << '"';
+}
+
+bool read_json_object(
+    std::map<std::string, std::vector<std::string> > & object,
+    const std::string & text
+    )
+{
+    std::string::const_iterator
+        it = text.begin(),
+        end = text.end();
+
+    object.clear();
+    skip_whitespace( it, end );
+
+    if( it == end || *it != '{' )
+    {
+        return false;
+    }
+
+    ++it;
+    skip_whitespace( it, end );
+
+    if( it != end && *it == '}' )
+    {
+        ++it;
+        skip_whitespace( it, end );
+        return it == end;
+    }
+
+    while( it != end )
+    {
+        std::string
+            key;
+
+        if( !read_json_string( key, it, end ) )
+        {
+            return false;
+        }
+
+        skip_whitespace( it, end );
+
+        if( it == end || *it != ':' )
+        {
+            return false;
+        }
+
+        ++it;
+        skip_whitespace( it, end );
+
+        std::vector<std::string>
+            values;
+
+        if( it != end && *it == '[' )
+        {
+            ++it;
+            skip_whitespace( it, end );
+
+            while( it != end && *it != ']' )
+            {
+                std::string
+                    value;
+
+                if( !read_json_scalar( value, it, end ) )
+                {
+                    return false;
+                }
+
+                values.push_back( value );
+                skip_whitespace( it, end );
+
+                if( it != end && *it == ',' )
+                {
+                    ++it;
+                    skip_whitespace( it, end );
+                }
+                else if( it == end || *it != ']' )
+                {
+                    return false;
+                }
+            }
+
+            if( it == end )
+            {
+                return false;
+            }
+
+            ++it;
+        }
+        else
+        {
+            std::string
+                value;
+
+            if( !read_json_scalar( value, it, end ) )
+            {
+                return false;
+            }
+
+            values.push_back( value );
+        }
+
+        object[ key ].swap( values );
+        skip_whitespace( it, end );
+
+        if( it != end && *it == ',' )
+        {
+            ++it;
+            skip_whitespace( it, end );
+            continue;
+        }
+
+        if( it != end && *it == '}' )
+        {
+            ++it;
+            skip_whitespace( it, end );
+            return it == end;
+        }
+
+        return false;
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef JSON_H
+    #define JSON_H
+
+    #include <map>
+    #include <ostream>
+    #include <string>
+    #include <vector>
+
+    // Writes value as a quoted JSON string
+    void write_json_string( std::ostream & stream, const std::string & value );
+
+    // Reads an object whose values are scalars or arrays of scalars, as used by
+    // the server requests. Scalars are stored as one element tables, numbers and
+    // literals keep their text. Nested objects are rejected.
+    bool read_json_object(
+        std::map<std::string, std::vector<std::string> > & object,
+        const std::string & text
+        );
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include <shader_shaker.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+TEST_CASE( "C interface generates shaders", "[api]" )
+{
+    ShaderShakerContext * context = ShaderShaker_CreateContext();
+    const char source[] =
+        "#include \"common.h\"\n"
+        "float4 GetColor( float2 uv : TexCoord ) : Color { return SCALE; }\n";
+    const char common_source[] = "#define SCALE 2\n";
+    const char * semantic_table[] = { "Color" };
+    const char * input_semantic_table[] = { "TexCoord" };
+
+    REQUIRE( context );
+    REQUIRE( ShaderShaker_ParseFragment( context, "common.h", common_source, std::strlen( common_source ) ) == SHADERSHAKER_OK );
+    REQUIRE( ShaderShaker_ParseFragment( context, "color.fx", source, std::strlen( source ) ) == SHADERSHAKER_OK );
+    ShaderShaker_Prewarm( context );
+
+    SECTION( "Code is written in the caller buffer" )
+    {
+        std::vector<char> buffer( 4096 );
+        size_t size = buffer.size();
+
+        REQUIRE( ShaderShaker_GenerateShader( context, semantic_table, 1, input_semantic_table, 1, &buffer[ 0 ], &size ) == SHADERSHAKER_OK );
+        CHECK( size == std::strlen( &buffer[ 0 ] ) );
+        CHECK( std::string( &buffer[ 0 ] ).find( "GetColor" ) != std::string::npos );
+        REQUIRE( ShaderShaker_GetUsedSemanticCount( context ) == 1 );
+        CHECK( std::string( ShaderShaker_GetUsedSemantic( context, 0 ) ) == "TexCoord" );
+    }
+
+    SECTION( "Required size is returned when the buffer is too small" )
+    {
+        size_t size = 0;
+
+        REQUIRE( ShaderShaker_GenerateShader( context, semantic_table, 1, input_semantic_table, 1, 0, &size ) == SHADERSHAKER_BUFFER_TOO_SMALL );
+
+        std::vector<char> buffer( size );
+        char small_buffer[ 8 ];
+        size_t small_size = sizeof( small_buffer );
+
+        CHECK( ShaderShaker_GenerateShader( context, semantic_table, 1, input_semantic_table, 1, small_buffer, &small_size ) == SHADERSHAKER_BUFFER_TOO_SMALL );
+        CHECK( small_size == size );
+        CHECK( ShaderShaker_GenerateShader( context, semantic_table, 1, input_semantic_table, 1, &buffer[ 0 ], &size ) == SHADERSHAKER_OK );
+        CHECK( size == buffer.size() - 1 );
+    }
+
+    SECTION( "Errors are reported" )
+    {
+        const char * missing_semantic_table[] = { "Normal" };
+        size_t size = 0;
+
+        CHECK( ShaderShaker_GenerateShader( context, missing_semantic_table, 1, input_semantic_table, 1, 0, &size ) == SHADERSHAKER_GENERATION_ERROR );
+        CHECK( std::strlen( ShaderShaker_GetLastError( context ) ) > 0 );
+        CHECK( ShaderShaker_GenerateShader( context, 0, 1, input_semantic_table, 1, 0, &size ) == SHADERSHAKER_INVALID_ARGUMENT );
+    }
+
+    SECTION( "Semantics are queried" )
+    {
+        const char * missing_semantic_table[] = { "Normal" };
+
+        CHECK( ShaderShaker_QueryShader( context, semantic_table, 1, input_semantic_table, 1 ) == SHADERSHAKER_OK );
+        CHECK( ShaderShaker_GetUsedSemanticCount( context ) == 1 );
+        CHECK( ShaderShaker_QueryShader( context, missing_semantic_table, 1, input_semantic_table, 1 ) == SHADERSHAKER_GENERATION_ERROR );
+        CHECK( ShaderShaker_GetUsedSemanticCount( context ) == 0 );
+    }
+
+    SECTION( "Preshader is extracted on request" )
+    {
+        const char scale_source[] = "float Scale;\nfloat4 GetScaled( float2 uv : TexCoord ) : Scaled { return Scale * 2.0; }\n";
+        const char * scaled_semantic_table[] = { "Scaled" };
+        std::vector<char> buffer( 4096 );
+        size_t size = buffer.size();
+
+        REQUIRE( ShaderShaker_ParseFragment( context, "scale.fx", scale_source, std::strlen( scale_source ) ) == SHADERSHAKER_OK );
+        REQUIRE( ShaderShaker_GenerateShader( context, scaled_semantic_table, 1, input_semantic_table, 1, &buffer[ 0 ], &size ) == SHADERSHAKER_OK );
+        CHECK( ShaderShaker_GetPreshader( context, &buffer[ 0 ], &size ) == SHADERSHAKER_GENERATION_ERROR );
+
+        ShaderShaker_SetPreshader( context, 1 );
+        size = buffer.size();
+
+        REQUIRE( ShaderShaker_GenerateShader( context, scaled_semantic_table, 1, input_semantic_table, 1, &buffer[ 0 ], &size ) == SHADERSHAKER_OK );
+        CHECK( std::string( &buffer[ 0 ] ).find( "preshader_0" ) != std::string::npos );
+        size = buffer.size();
+        REQUIRE( ShaderShaker_GetPreshader( context, &buffer[ 0 ], &size ) == SHADERSHAKER_OK );
+        CHECK( std::string( &buffer[ 0 ] ).find( "preshader_0 = ( Scale ) * ( 2.0 );" ) != std::string::npos );
+    }
+
+    SECTION( "Reset removes the fragments" )
+    {
+        size_t size = 0;
+
+        ShaderShaker_Reset( context );
+
+        CHECK( ShaderShaker_GenerateShader( context, semantic_table, 1, input_semantic_table, 1, 0, &size ) == SHADERSHAKER_GENERATION_ERROR );
+    }
+
+    ShaderShaker_DestroyContext( context );
+}
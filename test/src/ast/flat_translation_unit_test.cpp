@@ -0,0 +1,138 @@
+#include "catch.hpp"
+#include "ast/node.h"
+#include "ast/flat/flat_converter.h"
+#include "ast/flat/flat_hlsl_printer.h"
+#include "ast/printer/hlsl_printer.h"
+#include "generation/flat_semantic_remover.h"
+#include <sstream>
+
+namespace
+{
+    AST::TranslationUnit * CreateTranslationUnit()
+    {
+        AST::TranslationUnit * translation_unit = new AST::TranslationUnit;
+        AST::VariableDeclaration * variable = new AST::VariableDeclaration;
+        AST::VariableDeclarationBody * body = new AST::VariableDeclarationBody( "Scale" );
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+        AST::Argument * argument = new AST::Argument;
+        AST::BlockStatement * block = new AST::BlockStatement;
+
+        variable->SetType( new AST::IntrinsicType( "float" ) );
+        variable->AddStorageClass( new AST::StorageClass( "static" ) );
+        variable->AddTypeModifier( new AST::TypeModifier( "const" ) );
+        body->m_InitialValue = new AST::InitialValue;
+        body->m_InitialValue->AddExpression( new AST::LiteralExpression( AST::LiteralExpression::Float, "2.0" ) );
+        variable->AddBody( body );
+        translation_unit->AddGlobalDeclaration( variable );
+
+        argument->m_Type = new AST::IntrinsicType( "float2" );
+        argument->m_Name = "uv";
+        argument->m_Semantic = "TexCoord";
+        function->m_Type = new AST::IntrinsicType( "float4" );
+        function->m_Name = "GetColor";
+        function->m_Semantic = "Color";
+        function->m_ArgumentList = new AST::ArgumentList;
+        function->m_ArgumentList->AddArgument( argument );
+
+        block->AddStatement( new AST::ExpressionStatement( new AST::CallExpression( "Clip", 0 ) ) );
+        function->AddStatement(
+            new AST::IfStatement(
+                new AST::BinaryOperationExpression(
+                    AST::BinaryOperationExpression::LessThan,
+                    new AST::PostfixExpression( new AST::VariableExpression( "uv" ), new AST::Swizzle( "x" ) ),
+                    new AST::VariableExpression( "Scale" )
+                    ),
+                block,
+                0
+                )
+            );
+        function->AddStatement(
+            new AST::ReturnStatement(
+                new AST::ConstructorExpression( new AST::IntrinsicType( "float4" ), new AST::ArgumentExpressionList )
+                )
+            );
+        translation_unit->AddGlobalDeclaration( function );
+
+        return translation_unit;
+    }
+
+    std::string PrintTree( const AST::TranslationUnit & translation_unit )
+    {
+        std::ostringstream
+            output;
+        AST::HLSLPrinter
+            printer( output );
+
+        translation_unit.Visit( printer );
+
+        return output.str();
+    }
+
+    std::string PrintFlat( const AST::FlatTranslationUnit & flat_unit )
+    {
+        std::ostringstream
+            output;
+        AST::FlatHLSLPrinter
+            printer( output );
+
+        printer.Print( flat_unit );
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Flat translation units", "[ast][flat]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = CreateTranslationUnit();
+    AST::FlatTranslationUnit flat_unit;
+
+    AST::ConvertToFlat( flat_unit, *translation_unit );
+
+    SECTION( "Flat unit is printed as the tree" )
+    {
+        CHECK( PrintFlat( flat_unit ) == PrintTree( *translation_unit ) );
+    }
+
+    SECTION( "Tree is rebuilt from the flat unit" )
+    {
+        Base::ObjectRef<AST::TranslationUnit> rebuilt_unit = AST::ConvertToTree( flat_unit );
+
+        REQUIRE( rebuilt_unit );
+        CHECK( PrintTree( *rebuilt_unit ) == PrintTree( *translation_unit ) );
+        CHECK( rebuilt_unit->m_GlobalDeclarationTable[ 1 ]->GetLine() == translation_unit->m_GlobalDeclarationTable[ 1 ]->GetLine() );
+    }
+
+    SECTION( "Copies are independent" )
+    {
+        AST::FlatTranslationUnit copy( flat_unit );
+        Generation::FlatSemanticRemover remover;
+
+        remover.Process( copy );
+
+        CHECK( copy.GetNodeCount() == flat_unit.GetNodeCount() );
+        CHECK( PrintFlat( copy ).find( "TexCoord" ) == std::string::npos );
+        CHECK( PrintFlat( copy ).find( " : Color" ) == std::string::npos );
+        CHECK( PrintFlat( flat_unit ).find( "TexCoord" ) != std::string::npos );
+    }
+
+    SECTION( "Traversal reaches every node" )
+    {
+        struct CountNodes
+        {
+            CountNodes() : m_Count( 0 ) {}
+
+            bool operator()( const AST::FlatTranslationUnit & /*flat_unit*/, const uint32_t /*index*/ )
+            {
+                ++m_Count;
+                return true;
+            }
+
+            size_t
+                m_Count;
+        } count_nodes;
+
+        flat_unit.Traverse( AST::FlatTranslationUnit::RootIndex, count_nodes );
+
+        CHECK( count_nodes.m_Count == flat_unit.GetNodeCount() );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "ast/node.h"
+#include "ast/node_allocation.h"
+#include "base/statistics.h"
+#include <sstream>
+
+TEST_CASE( "Node allocations are accounted by kind", "[ast][memory]" )
+{
+    const size_t
+        binary_count = AST::NodeAllocation::GetLiveCount( AST::NodeKind_BinaryOperationExpression ),
+        variable_count = AST::NodeAllocation::GetLiveCount( AST::NodeKind_VariableExpression ),
+        live_size = AST::NodeAllocation::GetLiveSize();
+
+    CHECK( AST::NodeAllocation::GetName( AST::NodeKind_BinaryOperationExpression ) == std::string( "BinaryOperationExpression" ) );
+    CHECK( AST::NodeAllocation::GetName( AST::NodeKind_VariableDeclarationStatement ) == std::string( "VariableDeclarationStatement" ) );
+    CHECK( AST::NodeAllocation::GetSize( AST::NodeKind_VariableExpression ) == sizeof( AST::VariableExpression ) );
+
+    {
+        Base::ObjectRef<AST::Expression> expression = new AST::BinaryOperationExpression(
+            AST::BinaryOperationExpression::Addition,
+            new AST::VariableExpression( "a" ),
+            new AST::VariableExpression( "b" )
+            );
+
+        CHECK( AST::NodeAllocation::GetLiveCount( AST::NodeKind_BinaryOperationExpression ) == binary_count + 1 );
+        CHECK( AST::NodeAllocation::GetLiveCount( AST::NodeKind_VariableExpression ) == variable_count + 2 );
+        CHECK( AST::NodeAllocation::GetLiveSize() == live_size + sizeof( AST::BinaryOperationExpression ) + 2 * sizeof( AST::VariableExpression ) );
+
+        Base::ObjectRef<AST::Expression> clone = expression->Clone();
+
+        CHECK( AST::NodeAllocation::GetLiveCount( AST::NodeKind_VariableExpression ) == variable_count + 4 );
+        CHECK( AST::NodeAllocation::GetPeakCount( AST::NodeKind_VariableExpression ) >= variable_count + 4 );
+
+        std::ostringstream
+            report;
+
+        AST::NodeAllocation::Print( report );
+
+        CHECK( report.str().find( "BinaryOperationExpression" ) != std::string::npos );
+
+        Base::Statistics::Reset();
+        Base::Statistics::Enable();
+        AST::NodeAllocation::AddStatistics();
+
+        CHECK( Base::Statistics::GetCount( "ast_live_count.VariableExpression" ) == int64_t( variable_count + 4 ) );
+        CHECK( Base::Statistics::GetCount( "ast_live_bytes.VariableExpression" ) == int64_t( ( variable_count + 4 ) * sizeof( AST::VariableExpression ) ) );
+        CHECK( Base::Statistics::GetCount( "ast_live_count.BinaryOperationExpression" ) == int64_t( binary_count + 2 ) );
+        CHECK( Base::Statistics::GetCount( "ast_peak_bytes.BinaryOperationExpression" ) >= int64_t( ( binary_count + 2 ) * sizeof( AST::BinaryOperationExpression ) ) );
+
+        Base::Statistics::Enable( false );
+        Base::Statistics::Reset();
+    }
+
+    CHECK( AST::NodeAllocation::GetLiveCount( AST::NodeKind_BinaryOperationExpression ) == binary_count );
+    CHECK( AST::NodeAllocation::GetLiveCount( AST::NodeKind_VariableExpression ) == variable_count );
+    CHECK( AST::NodeAllocation::GetLiveSize() == live_size );
+
+    AST::NodeAllocation::ResetPeak();
+
+    CHECK( AST::NodeAllocation::GetPeakSize() == live_size );
+}
\ No newline at end of file
@@ -185,6 +185,25 @@ TEST_CASE( "Do While statement is printed", "[ast][hlsl][printer]" )
     CHECK( output.str() == "do Function();\nwhile( a );\n" );
 }
 
+TEST_CASE( "For statement is printed", "[ast][hlsl][printer]" )
+{
+    AST::ForStatement
+        node(
+            new AST::AssignmentStatement( new AST::LValueExpression( new AST::VariableExpression( "i" ) ), AST::AssignmentOperator_Assign, new AST::LiteralExpression( AST::LiteralExpression::Int, "0" ) ),
+            new AST::BinaryOperationExpression( AST::BinaryOperationExpression::LessThan, new AST::VariableExpression( "i" ), new AST::VariableExpression( "a" ) ),
+            new AST::PreModifyExpression( AST::SelfModifyOperator_PlusPlus, new AST::LValueExpression( new AST::VariableExpression( "i" ) ) ),
+            new AST::ExpressionStatement( new AST::CallExpression( "Function", 0 ) )
+            );
+    std::ostringstream
+        output;
+    AST::HLSLPrinter
+        printer( output );
+
+    node.Visit( printer );
+
+    CHECK( output.str() == "for( i = 0;\n( i ) < ( a ); ++i ) Function();\n" );
+}
+
 TEST_CASE( "Block statements are printed", "[ast][hlsl][printer]" )
 {
     SECTION( "Empty block is printed" )
@@ -0,0 +1,87 @@
+#include "catch.hpp"
+#include "ast/node.h"
+#include "ast/statement_node.h"
+#include "ast/node_size_report.h"
+#include <sstream>
+
+TEST_CASE( "Source locations are compact", "[ast][location]" )
+{
+    SECTION( "Location is packed and unpacked" )
+    {
+        AST::SourceLocation
+            location( "a/long/path/to/the/fragment.fx", 1234, 56 );
+
+        CHECK( location.GetFileName() == "a/long/path/to/the/fragment.fx" );
+        CHECK( location.GetLine() == 1234 );
+        CHECK( location.GetColumn() == 56 );
+        CHECK( sizeof( location ) == 8 );
+    }
+
+    SECTION( "File names are shared" )
+    {
+        AST::SourceLocation
+            first( "shared.fx", 1 ),
+            second( "shared.fx", 2 ),
+            other( "other.fx", 1 );
+
+        CHECK( first.m_FileIndex == second.m_FileIndex );
+        CHECK( first.m_FileIndex != other.m_FileIndex );
+    }
+
+    SECTION( "Default location has no line" )
+    {
+        AST::SourceLocation
+            location;
+
+        CHECK( location.GetFileName().empty() );
+        CHECK( location.GetLine() == -1 );
+    }
+
+    SECTION( "Out of range values are clamped" )
+    {
+        AST::SourceLocation
+            location( "file.fx", AST::SourceLocation::MaxLine + 10, 100000 );
+
+        CHECK( location.GetLine() == AST::SourceLocation::MaxLine );
+        CHECK( location.GetColumn() == AST::SourceLocation::MaxColumn );
+    }
+
+    SECTION( "Nodes take the current location" )
+    {
+        AST::SourceLocation
+            previous_location = AST::Node::GetCurrentLocation();
+
+        AST::Node::SetDebugInfo( "node.fx", 12, 4 );
+
+        AST::ReturnStatement
+            statement;
+
+        AST::Node::SetDebugInfo( previous_location );
+
+        CHECK( statement.GetFileName() == "node.fx" );
+        CHECK( statement.GetLine() == 12 );
+        CHECK( statement.GetColumn() == 4 );
+    }
+}
+
+TEST_CASE( "Node sizes are reported", "[ast][location]" )
+{
+    AST::BlockStatement
+        block;
+    AST::NodeSizeReport
+        report;
+    std::ostringstream
+        output;
+
+    block.m_StatementTable.push_back( new AST::BreakStatement );
+    block.m_StatementTable.push_back( new AST::BreakStatement );
+
+    block.Visit( report );
+    report.Print( output );
+
+    CHECK( report.GetNodeCount() == 3 );
+    CHECK( report.GetTotalSize() == sizeof( AST::BlockStatement ) + 2 * sizeof( AST::BreakStatement ) );
+    REQUIRE( report.GetEntryTable().count( "BreakStatement" ) == 1 );
+    CHECK( report.GetEntryTable().find( "BreakStatement" )->second.m_Count == 2 );
+    CHECK( output.str().find( "BlockStatement" ) != std::string::npos );
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "catch.hpp"
+#include "ast/node.h"
+#include "ast/tree_traverser.h"
+#include "ast/static_visitor.h"
+#include "generation/semantic_remover.h"
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+    class VirtualCounter : public AST::TreeTraverser
+    {
+    public:
+
+        VirtualCounter() : m_LiteralCount( 0 ), m_VariableCount( 0 ) {}
+
+        using AST::TreeTraverser::Visit;
+
+        virtual void Visit( const AST::Node & /*node*/ ) override
+        {
+        }
+
+        virtual void Visit( const AST::LiteralExpression & expression ) override
+        {
+            ++m_LiteralCount;
+            AST::TreeTraverser::Visit( expression );
+        }
+
+        virtual void Visit( const AST::VariableExpression & expression ) override
+        {
+            ++m_VariableCount;
+            AST::TreeTraverser::Visit( expression );
+        }
+
+        int
+            m_LiteralCount,
+            m_VariableCount;
+    };
+
+    class StaticCounter : public AST::StaticTreeTraverser<StaticCounter>
+    {
+    public:
+
+        StaticCounter() : m_LiteralCount( 0 ), m_VariableCount( 0 ) {}
+
+        using AST::StaticTreeTraverser<StaticCounter>::Visit;
+
+        void Visit( const AST::LiteralExpression & /*expression*/ )
+        {
+            ++m_LiteralCount;
+        }
+
+        void Visit( const AST::VariableExpression & expression )
+        {
+            ++m_VariableCount;
+            AST::StaticTreeTraverser<StaticCounter>::Visit( expression );
+        }
+
+        int
+            m_LiteralCount,
+            m_VariableCount;
+    };
+
+    AST::FunctionDeclaration * CreateFunction( const std::string & name, const int statement_count )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+        AST::Argument * argument = new AST::Argument;
+
+        argument->m_Type = new AST::IntrinsicType( "float" );
+        argument->m_Name = "value";
+        argument->m_Semantic = "Value";
+        function->m_Type = new AST::IntrinsicType( "float" );
+        function->m_Name = name;
+        function->m_Semantic = "Result";
+        function->m_ArgumentList = new AST::ArgumentList;
+        function->m_ArgumentList->AddArgument( argument );
+
+        for( int index = 0; index < statement_count; ++index )
+        {
+            function->AddStatement(
+                new AST::ExpressionStatement(
+                    new AST::BinaryOperationExpression(
+                        AST::BinaryOperationExpression::Addition,
+                        new AST::VariableExpression( "value" ),
+                        new AST::BinaryOperationExpression(
+                            AST::BinaryOperationExpression::Multiplication,
+                            new AST::LiteralExpression( AST::LiteralExpression::Float, "2.0" ),
+                            new AST::VariableExpression( "value" )
+                            )
+                        )
+                    )
+                );
+        }
+
+        function->AddStatement( new AST::ReturnStatement( new AST::VariableExpression( "value" ) ) );
+
+        return function;
+    }
+
+    AST::TranslationUnit * CreateTranslationUnit( const int function_count, const int statement_count )
+    {
+        AST::TranslationUnit * translation_unit = new AST::TranslationUnit;
+
+        for( int index = 0; index < function_count; ++index )
+        {
+            std::ostringstream
+                name;
+
+            name << "Function" << index;
+            translation_unit->AddGlobalDeclaration( CreateFunction( name.str(), statement_count ) );
+        }
+
+        return translation_unit;
+    }
+}
+
+TEST_CASE( "Static visitor matches the virtual visitor", "[ast][visitor]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = CreateTranslationUnit( 3, 4 );
+
+    SECTION( "Node kind is set by the constructors" )
+    {
+        CHECK( translation_unit->m_Kind == AST::NodeKind_TranslationUnit );
+        CHECK( translation_unit->m_GlobalDeclarationTable[ 0 ]->m_Kind == AST::NodeKind_FunctionDeclaration );
+        CHECK( AST::IntrinsicType( "float" ).m_Kind == AST::NodeKind_IntrinsicType );
+        CHECK( AST::Type( "float" ).m_Kind == AST::NodeKind_Type );
+    }
+
+    SECTION( "Traversals visit the same nodes" )
+    {
+        VirtualCounter virtual_counter;
+        StaticCounter static_counter;
+
+        translation_unit->Visit( virtual_counter );
+        static_counter.Dispatch( *translation_unit );
+
+        CHECK( virtual_counter.m_LiteralCount == 12 );
+        CHECK( virtual_counter.m_VariableCount == 27 );
+        CHECK( static_counter.m_LiteralCount == virtual_counter.m_LiteralCount );
+        CHECK( static_counter.m_VariableCount == virtual_counter.m_VariableCount );
+    }
+
+    SECTION( "Semantic remover clears the semantics" )
+    {
+        Generation::SemanticRemover remover;
+        const AST::FunctionDeclaration & function =
+            static_cast<const AST::FunctionDeclaration &>( *translation_unit->m_GlobalDeclarationTable[ 1 ] );
+
+        remover.Dispatch( *translation_unit );
+
+        CHECK( function.m_Semantic.empty() );
+        CHECK( function.m_ArgumentList->m_ArgumentTable[ 0 ]->m_Semantic.empty() );
+    }
+}
+
+TEST_CASE( "Static visitor benchmark", "[.][benchmark]" )
+{
+    const int iteration_count = 20;
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = CreateTranslationUnit( 1000, 100 );
+    std::chrono::high_resolution_clock::time_point start;
+    int virtual_count = 0, static_count = 0;
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for( int iteration = 0; iteration < iteration_count; ++iteration )
+    {
+        VirtualCounter counter;
+
+        translation_unit->Visit( counter );
+        virtual_count += counter.m_LiteralCount;
+    }
+
+    std::chrono::duration<double, std::milli> virtual_time = std::chrono::high_resolution_clock::now() - start;
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for( int iteration = 0; iteration < iteration_count; ++iteration )
+    {
+        StaticCounter counter;
+
+        counter.Dispatch( *translation_unit );
+        static_count += counter.m_LiteralCount;
+    }
+
+    std::chrono::duration<double, std::milli> static_time = std::chrono::high_resolution_clock::now() - start;
+
+    WARN( "virtual visitor: " << virtual_time.count() / iteration_count << " ms per traversal" );
+    WARN( "static visitor: " << static_time.count() / iteration_count << " ms per traversal" );
+
+    CHECK( static_count == virtual_count );
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "catch.hpp"
+#include "base/statistics.h"
+#include <sstream>
+
+TEST_CASE( "Statistics are recorded when enabled", "[base][statistics]" )
+{
+    Base::Statistics::Reset();
+
+    SECTION( "Nothing is recorded while disabled" )
+    {
+        Base::Statistics::Enable( false );
+
+        {
+            Base::ScopedTimer timer( "phase" );
+            Base::Statistics::AddCount( "counter", 3 );
+        }
+
+        CHECK( Base::Statistics::GetCallCount( "phase" ) == 0 );
+        CHECK( Base::Statistics::GetCount( "counter" ) == 0 );
+    }
+
+    SECTION( "Timers and counters accumulate" )
+    {
+        Base::Statistics::Enable();
+
+        for( int index = 0; index < 2; ++index )
+        {
+            Base::ScopedTimer timer( "phase" );
+            Base::Statistics::AddCount( "counter", 3 );
+        }
+
+        Base::Statistics::AddTime( "other \"phase\"", 1.5 );
+
+        CHECK( Base::Statistics::GetCallCount( "phase" ) == 2 );
+        CHECK( Base::Statistics::GetTime( "phase" ) >= 0.0 );
+        CHECK( Base::Statistics::GetTime( "other \"phase\"" ) == 1.5 );
+        CHECK( Base::Statistics::GetCount( "counter" ) == 6 );
+
+        std::ostringstream
+            table,
+            json;
+
+        Base::Statistics::Print( table );
+        Base::Statistics::PrintJson( json );
+
+        CHECK( table.str().find( "counter" ) != std::string::npos );
+        CHECK( json.str().find( "\"counters\": {\n    \"counter\": 6\n  }" ) != std::string::npos );
+        CHECK( json.str().find( "\"other \\\"phase\\\"\": { \"calls\": 1, \"milliseconds\": 1.5 }" ) != std::string::npos );
+    }
+
+    SECTION( "Samples keep their labels" )
+    {
+        Base::Statistics::Enable();
+        Base::Statistics::AddSample( "cost", "Color", 12 );
+        Base::Statistics::AddSample( "cost", "Color Fog", 20 );
+
+        CHECK( Base::Statistics::GetSampleCount( "cost" ) == 2 );
+
+        std::ostringstream
+            json;
+
+        Base::Statistics::PrintJson( json );
+
+        CHECK( json.str().find( "\"samples\": {\n    \"cost\": [\n      { \"label\": \"Color\", \"value\": 12 }," ) != std::string::npos );
+    }
+
+    Base::Statistics::Enable( false );
+    Base::Statistics::Reset();
+}
\ No newline at end of file
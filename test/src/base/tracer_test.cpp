@@ -0,0 +1,51 @@
+#include "catch.hpp"
+#include "base/statistics.h"
+#include "base/tracer.h"
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    void RunPhase()
+    {
+        Base::ScopedTimer timer( "phase", "file.fx" );
+    }
+}
+
+TEST_CASE( "Tracer records events of every thread", "[base][tracer]" )
+{
+    Base::Tracer::Reset();
+
+    SECTION( "Nothing is recorded while disabled" )
+    {
+        RunPhase();
+
+        CHECK( Base::Tracer::GetEventCount() == 0 );
+    }
+
+    SECTION( "Events are written as Chrome trace events" )
+    {
+        Base::Tracer::Enable();
+
+        RunPhase();
+
+        std::thread
+            thread( RunPhase );
+
+        thread.join();
+
+        std::ostringstream
+            output;
+
+        Base::Tracer::Write( output );
+
+        CHECK( Base::Tracer::GetEventCount() == 2 );
+        CHECK( output.str().find( "{\"traceEvents\":[" ) == 0 );
+        CHECK( output.str().find( "\"name\":\"phase\",\"cat\":\"shader_shaker\",\"ph\":\"X\"" ) != std::string::npos );
+        CHECK( output.str().find( "\"tid\":1,\"args\":{\"detail\":\"file.fx\"}" ) != std::string::npos );
+        CHECK( output.str().find( "\"tid\":2," ) != std::string::npos );
+    }
+
+    Base::Tracer::Enable( false );
+    Base::Tracer::Reset();
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/call_scheduler.h>
+#include <sstream>
+
+namespace
+{
+    // float4 name( float4 first_semantic, float4 second_semantic ) : semantic
+    Generation::FunctionDefinition::Ref CreateFunction(
+        const std::string & name,
+        const std::string & semantic,
+        const std::string & first_semantic,
+        const std::string & second_semantic = ""
+        )
+    {
+        Generation::FunctionDefinition::Ref function = new Generation::FunctionDefinition;
+        Generation::FunctionDefinition::Argument argument;
+
+        function->SetName( name );
+        function->SetReturnValue( "float4", semantic );
+        argument.m_Type = "float4";
+        argument.m_Semantic = first_semantic;
+        function->AddArgument( argument );
+
+        if( !second_semantic.empty() )
+        {
+            argument.m_Semantic = second_semantic;
+            function->AddArgument( argument );
+        }
+
+        return function;
+    }
+
+    std::string PrintStatements( const std::vector<Base::ObjectRef<AST::Statement> > & statement_table )
+    {
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        for( size_t index = 0; index < statement_table.size(); ++index )
+        {
+            statement_table[ index ]->Visit( printer );
+        }
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Generated calls are scheduled", "[generation][scheduling]" )
+{
+    std::vector<Generation::FunctionDefinition::Ref> definition_table;
+    std::vector<const Generation::FunctionDefinition *> function_table;
+    std::vector<Base::ObjectRef<AST::Statement> > statement_table;
+    std::set<std::string> argument_semantic_set;
+    Generation::CallScheduler scheduler;
+
+    definition_table.push_back( CreateFunction( "GetFirst", "First", "Position" ) );
+    definition_table.push_back( CreateFunction( "GetSecond", "Second", "Position" ) );
+    definition_table.push_back( CreateFunction( "GetThird", "Third", "Position" ) );
+    definition_table.push_back( CreateFunction( "Combine", "Combined", "First", "Second" ) );
+    definition_table.push_back( CreateFunction( "GetColor", "Color", "Third", "Combined" ) );
+
+    for( size_t index = 0; index < definition_table.size(); ++index )
+    {
+        function_table.push_back( &*definition_table[ index ] );
+    }
+
+    argument_semantic_set.insert( "Position" );
+    argument_semantic_set.insert( "Color" );
+
+    scheduler.Schedule( statement_table, function_table, argument_semantic_set );
+
+    SECTION( "Producers needing the most temporaries run first" )
+    {
+        CHECK( scheduler.GetUnscheduledPeakLiveCount() == 3 );
+        CHECK( scheduler.GetPeakLiveCount() == 2 );
+    }
+
+    SECTION( "Dead temporaries are reused" )
+    {
+        const std::string code =
+            "float4\n\tFirst;\n"
+            "First = GetFirst(Position);\n"
+            "float4\n\tSecond;\n"
+            "Second = GetSecond(Position);\n"
+            "float4\n\tCombined;\n"
+            "Combined = Combine(First, Second);\n"
+            "Second = GetThird(Position);\n"
+            "Color = GetColor(Second, Combined);\n";
+
+        CHECK( scheduler.GetReusedTemporaryCount() == 1 );
+        CHECK( PrintStatements( statement_table ) == code );
+    }
+}
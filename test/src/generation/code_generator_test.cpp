@@ -182,3 +182,62 @@ TEST_CASE( "Type mismatch are detected", "[generation][fragment]" )
         "previously seen type was float but defined here as float2"
         );
 }
+
+TEST_CASE( "Shaders are queried without generating code", "[generation][fragment]" )
+{
+    std::string
+        code_c_table[] =
+        {
+            "float B( float x :X ) : B { return x; }",
+            "float A( float b :B, float y :Y ) : A { return b + y; }"
+        };
+    std::vector<std::string>
+        code_table( std::begin( code_c_table ), std::end( code_c_table ) );
+    std::vector<Base::ObjectRef<Generation::FragmentDefinition> >
+        definition_table;
+
+    definition_table = GetFragmentTable( code_table );
+
+    Generation::CodeGenerator code_generator;
+    Base::ObjectRef<SimpleErrorHandler> error_handler = new SimpleErrorHandler;
+    std::vector<std::string> used_semantic_table;
+    std::vector<Generation::FunctionDefinition::Ref> function_table;
+    std::vector<std::string> input_semantic_table;
+
+    input_semantic_table.push_back( "X" );
+    input_semantic_table.push_back( "Y" );
+    input_semantic_table.push_back( "Z" );
+
+    SECTION( "Satisfiable semantics return the chosen functions" )
+    {
+        CHECK( code_generator.QueryShader(
+            used_semantic_table,
+            function_table,
+            definition_table,
+            std::vector<std::string>( 1, "A" ),
+            input_semantic_table,
+            * error_handler
+            ) );
+
+        REQUIRE( function_table.size() == 2 );
+        CHECK( function_table[ 0 ]->GetName() == "A" );
+        CHECK( function_table[ 1 ]->GetName() == "B" );
+        REQUIRE( used_semantic_table.size() == 2 );
+        CHECK( used_semantic_table[ 0 ] == "X" );
+        CHECK( used_semantic_table[ 1 ] == "Y" );
+    }
+
+    SECTION( "Unsatisfiable semantics are reported" )
+    {
+        CHECK( !code_generator.QueryShader(
+            used_semantic_table,
+            function_table,
+            definition_table,
+            std::vector<std::string>( 1, "A" ),
+            std::vector<std::string>( 1, "X" ),
+            * error_handler
+            ) );
+
+        CHECK( error_handler->m_Message == "Unable to find function that generates Y, " );
+    }
+}
@@ -0,0 +1,281 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <generation/code_generator.h>
+#include <generation/cost_estimator.h>
+#include <generation/fragment_definition.h>
+#include <base/text_error_handler.h>
+
+namespace
+{
+    AST::Expression * Literal( const std::string & value, const AST::LiteralExpression::Type type = AST::LiteralExpression::Float )
+    {
+        return new AST::LiteralExpression( type, value );
+    }
+
+    AST::Expression * Call( const std::string & name, AST::Expression * first, AST::Expression * second )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( first );
+        argument_list->AddExpression( second );
+
+        return new AST::CallExpression( name, argument_list );
+    }
+
+    AST::FunctionDeclaration * AddFunction(
+        AST::TranslationUnit & translation_unit,
+        const std::string & name,
+        const std::string & semantic,
+        AST::Expression * return_expression
+        )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+
+        function->m_Type = new AST::Type( "float4" );
+        function->m_Name = name;
+        function->m_Semantic = semantic;
+        function->AddStatement( new AST::ReturnStatement( return_expression ) );
+        translation_unit.AddGlobalDeclaration( function );
+
+        return function;
+    }
+
+    void AddArgument( AST::FunctionDeclaration & function, const std::string & semantic )
+    {
+        AST::Argument * argument = new AST::Argument;
+
+        argument->m_Type = new AST::IntrinsicType( "float4" );
+        argument->m_Name = semantic;
+        argument->m_Semantic = semantic;
+        function.m_ArgumentList = new AST::ArgumentList;
+        function.m_ArgumentList->AddArgument( argument );
+    }
+
+    // for( i = 0; i < last; i += step )
+    AST::ForStatement * CreateLoop( const std::string & last, const std::string & step, AST::Statement * statement )
+    {
+        return new AST::ForStatement(
+            new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( "i" ) ),
+                AST::AssignmentOperator_Assign,
+                Literal( "0", AST::LiteralExpression::Int )
+                ),
+            new AST::BinaryOperationExpression(
+                AST::BinaryOperationExpression::LessThan,
+                new AST::VariableExpression( "i" ),
+                Literal( last, AST::LiteralExpression::Int )
+                ),
+            new AST::AssignmentExpression(
+                new AST::LValueExpression( new AST::VariableExpression( "i" ) ),
+                AST::AssignmentOperator_Add,
+                Literal( step, AST::LiteralExpression::Int )
+                ),
+            statement
+            );
+    }
+
+    std::string QueryColor(
+        Generation::CostEstimator * estimator,
+        const bool selects_cheapest,
+        const std::vector<Generation::FragmentDefinition::Ref> & definition_table,
+        int & estimated_cost,
+        const size_t function_count = 1
+        )
+    {
+        Generation::CodeGenerator code_generator;
+        Base::ObjectRef<Base::TextErrorHandler> error_handler = new Base::TextErrorHandler;
+        std::vector<std::string> used_semantic_table, semantic_table, input_semantic_table;
+        std::vector<Generation::FunctionDefinition::Ref> function_table;
+
+        semantic_table.push_back( "Color" );
+        code_generator.SetCostEstimator( estimator );
+        code_generator.SetCheapestSelection( selects_cheapest );
+
+        REQUIRE( code_generator.QueryShader( used_semantic_table, function_table, definition_table, semantic_table, input_semantic_table, *error_handler ) );
+        REQUIRE( function_table.size() == function_count );
+
+        estimated_cost = code_generator.GetEstimatedCost();
+
+        return function_table[ 0 ]->GetName();
+    }
+}
+
+TEST_CASE( "Function cost is estimated", "[generation][cost]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    Generation::ShaderCost cost;
+
+    SECTION( "Operations are weighted by kind" )
+    {
+        // return tex2D( Sampler, UV ) * pow( Base, 2 ) + 1;
+        AST::FunctionDeclaration * function = AddFunction(
+            *translation_unit, "GetColor", "Color",
+            new AST::BinaryOperationExpression(
+                AST::BinaryOperationExpression::Addition,
+                new AST::BinaryOperationExpression(
+                    AST::BinaryOperationExpression::Multiplication,
+                    Call( "tex2D", new AST::VariableExpression( "Sampler" ), new AST::VariableExpression( "UV" ) ),
+                    Call( "pow", new AST::VariableExpression( "Base" ), Literal( "2" ) )
+                    ),
+                Literal( "1" )
+                )
+            );
+
+        Generation::CostEstimator::EstimateFunction( cost, *function, &*translation_unit );
+
+        CHECK( cost.m_AluCount == 2 );
+        CHECK( cost.m_TextureFetchCount == 1 );
+        CHECK( cost.m_TranscendentalCount == 1 );
+
+        const int expected_total = 2 + Generation::CostEstimator::TextureFetchWeight + Generation::CostEstimator::TranscendentalWeight;
+
+        CHECK( cost.GetTotal() == expected_total );
+    }
+
+    SECTION( "Helper functions of the translation unit are included" )
+    {
+        AddFunction( *translation_unit, "GetHelper", "", Call( "pow", Literal( "2" ), Literal( "2" ) ) );
+
+        AST::FunctionDeclaration * function = AddFunction(
+            *translation_unit, "GetColor", "Color",
+            new AST::UnaryOperationExpression( AST::UnaryOperationExpression::Minus, new AST::CallExpression( "GetHelper", 0 ) )
+            );
+
+        Generation::CostEstimator::EstimateFunction( cost, *function, &*translation_unit );
+
+        CHECK( cost.m_AluCount == 1 );
+        CHECK( cost.m_TranscendentalCount == 1 );
+    }
+
+    SECTION( "Loops multiply the cost of their body" )
+    {
+        AST::FunctionDeclaration * function = AddFunction( *translation_unit, "GetColor", "Color", new AST::VariableExpression( "Value" ) );
+
+        // for( i = 0; i < 5; i += 2 ) Value += 1;
+        function->m_StatementTable.insert(
+            function->m_StatementTable.begin(),
+            CreateLoop(
+                "5", "2",
+                new AST::AssignmentStatement(
+                    new AST::LValueExpression( new AST::VariableExpression( "Value" ) ),
+                    AST::AssignmentOperator_Add,
+                    Literal( "1" )
+                    )
+                )
+            );
+
+        Generation::CostEstimator::EstimateFunction( cost, *function, &*translation_unit );
+
+        // Condition, increment and body, 3 times
+        CHECK( cost.m_AluCount == 9 );
+    }
+}
+
+TEST_CASE( "Loop trip count is found", "[generation][cost]" )
+{
+    int trip_count = 0;
+    Generation::CostEstimator::ConstantLoop constant_loop;
+    Base::ObjectRef<AST::ForStatement> loop = CreateLoop( "8", "1", new AST::EmptyStatement );
+
+    CHECK( Generation::CostEstimator::GetConstantTripCount( trip_count, *loop ) );
+    CHECK( trip_count == 8 );
+
+    loop = CreateLoop( "8", "3", new AST::EmptyStatement );
+
+    CHECK( Generation::CostEstimator::GetConstantTripCount( trip_count, *loop ) );
+    CHECK( trip_count == 3 );
+    REQUIRE( Generation::CostEstimator::GetConstantLoop( constant_loop, *loop ) );
+    CHECK( constant_loop.m_Variable == "i" );
+    CHECK( constant_loop.m_First == 0 );
+    CHECK( constant_loop.m_Step == 3 );
+    CHECK( constant_loop.m_TripCount == 3 );
+    CHECK( constant_loop.m_IsInteger );
+
+    loop->m_EqualityExpression = new AST::BinaryOperationExpression(
+        AST::BinaryOperationExpression::LessThan,
+        new AST::VariableExpression( "i" ),
+        Literal( "8.0", AST::LiteralExpression::Float )
+        );
+
+    REQUIRE( Generation::CostEstimator::GetConstantLoop( constant_loop, *loop ) );
+    CHECK( constant_loop.m_TripCount == 3 );
+    CHECK( !constant_loop.m_IsInteger );
+
+    loop->m_EqualityExpression = new AST::BinaryOperationExpression(
+        AST::BinaryOperationExpression::LessThan,
+        new AST::VariableExpression( "i" ),
+        new AST::VariableExpression( "Count" )
+        );
+
+    CHECK( !Generation::CostEstimator::GetConstantTripCount( trip_count, *loop ) );
+}
+
+TEST_CASE( "Cheapest producer is selected", "[generation][cost]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> cheap_unit = new AST::TranslationUnit;
+    Base::ObjectRef<AST::TranslationUnit> expensive_unit = new AST::TranslationUnit;
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+    Generation::CostEstimator estimator;
+    int estimated_cost = -1;
+
+    AddFunction(
+        *cheap_unit, "GetTintColor", "Color",
+        new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Multiplication, new AST::VariableExpression( "Tint" ), Literal( "2" ) )
+        );
+    AddFunction(
+        *expensive_unit, "GetTexturedColor", "Color",
+        Call( "tex2D", new AST::VariableExpression( "Sampler" ), Literal( "0" ) )
+        );
+
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *cheap_unit ) );
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *expensive_unit ) );
+
+    CHECK( QueryColor( 0, false, definition_table, estimated_cost ) == "GetTexturedColor" );
+    CHECK( estimated_cost == 0 );
+    CHECK( QueryColor( &estimator, false, definition_table, estimated_cost ) == "GetTexturedColor" );
+    CHECK( estimated_cost == Generation::CostEstimator::TextureFetchWeight );
+    CHECK( QueryColor( &estimator, true, definition_table, estimated_cost ) == "GetTintColor" );
+    CHECK( estimated_cost == 1 );
+}
+
+TEST_CASE( "Cheapest producer includes the cost of its inputs", "[generation][cost]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> detail_unit = new AST::TranslationUnit;
+    Base::ObjectRef<AST::TranslationUnit> blended_unit = new AST::TranslationUnit;
+    Base::ObjectRef<AST::TranslationUnit> tinted_unit = new AST::TranslationUnit;
+    Base::ObjectRef<AST::TranslationUnit> masked_unit = new AST::TranslationUnit;
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+    Generation::CostEstimator estimator;
+    int estimated_cost = -1;
+
+    AddFunction(
+        *detail_unit, "GetDetail", "Detail",
+        Call( "tex2D", new AST::VariableExpression( "Sampler" ), Literal( "0" ) )
+        );
+    AddArgument(
+        *AddFunction(
+            *blended_unit, "GetBlendedColor", "Color",
+            new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Multiplication, new AST::VariableExpression( "Detail" ), new AST::VariableExpression( "Tint" ) )
+            ),
+        "Detail"
+        );
+    AddFunction(
+        *tinted_unit, "GetTintedColor", "Color",
+        new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Multiplication, Call( "pow", new AST::VariableExpression( "Tint" ), Literal( "2" ) ), Literal( "2" ) )
+        );
+    // Cheapest by itself, but nothing generates its input
+    AddArgument( *AddFunction( *masked_unit, "GetMaskedColor", "Color", new AST::VariableExpression( "Mask" ) ), "Mask" );
+
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *detail_unit ) );
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *tinted_unit ) );
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *blended_unit ) );
+
+    CHECK( QueryColor( &estimator, false, definition_table, estimated_cost, 2 ) == "GetBlendedColor" );
+    CHECK( estimated_cost == 1 + Generation::CostEstimator::TextureFetchWeight );
+    CHECK( QueryColor( &estimator, true, definition_table, estimated_cost ) == "GetTintedColor" );
+    CHECK( estimated_cost == 1 + Generation::CostEstimator::TranscendentalWeight );
+
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *masked_unit ) );
+
+    CHECK( QueryColor( &estimator, true, definition_table, estimated_cost ) == "GetTintedColor" );
+}
@@ -0,0 +1,212 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include "../parser/parser_helper.h"
+#include <generation/fragment_index.h>
+#include <base/error_handler_interface.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <utime.h>
+
+namespace
+{
+    struct SimpleErrorHandler : public Base::ErrorHandlerInterface
+    {
+        virtual void ReportError(
+            const std::string & message,
+            const std::string & file
+            ) override
+        {
+            m_Message = message;
+            m_File = file;
+        }
+
+        std::string
+            m_Message,
+            m_File;
+    };
+
+    struct CodeLoader : public Generation::FragmentLoaderInterface
+    {
+        CodeLoader( const std::string & code ) : m_Code( code ), m_LoadCount( 0 ) {}
+
+        virtual Base::ObjectRef<AST::TranslationUnit> LoadTranslationUnit(
+            const std::string & /*path*/
+            ) override
+        {
+            Parser parser( m_Code.c_str(), m_Code.length() );
+
+            ++m_LoadCount;
+
+            return parser.m_Parser.translation_unit();
+        }
+
+        virtual void GetIncludedPathTable( std::vector<std::string> & path_table ) const override
+        {
+            path_table = m_IncludedPathTable;
+        }
+
+        virtual void GetDefineTable( std::vector<std::string> & define_table ) const override
+        {
+            define_table = m_DefineTable;
+        }
+
+        std::string
+            m_Code;
+        std::vector<std::string>
+            m_IncludedPathTable,
+            m_DefineTable;
+        int
+            m_LoadCount;
+    };
+
+    void WriteFile( const std::string & path, const std::string & content )
+    {
+        std::ofstream file( path.c_str() );
+
+        file << content;
+    }
+}
+
+TEST_CASE( "Fragment index is saved and loaded", "[generation][index]" )
+{
+    Base::ObjectRef<SimpleErrorHandler> error_handler = new SimpleErrorHandler;
+    Generation::FragmentIndex index;
+
+    SECTION( "Index is loaded and saved back" )
+    {
+        const std::string content =
+            "shader_shaker_index 2\n"
+            "fragment 1400000000 cbf29ce484222325 missing file.fx\n"
+            "define QUALITY=2\n"
+            "include 1400000000 84222325cbf29ce4 missing header.fxh\n"
+            "function GetColor 3 float4 DiffuseColor missing file.fx\n"
+            "argument - float2 DiffuseTexCoord\n"
+            "argument inout float3 Normal\n"
+            "function Transform 7 - - missing file.fx\n"
+            "argument out float4 Position\n";
+        std::istringstream input( content );
+        std::ostringstream output;
+
+        REQUIRE( index.Load( input, "index.txt", *error_handler ) );
+        CHECK( index.GetFragmentCount() == 1 );
+
+        index.Save( output );
+
+        CHECK( output.str() == content );
+    }
+
+    SECTION( "Invalid index is rejected" )
+    {
+        std::istringstream input( "shader_shaker_index 2\nfragment not_a_timestamp\n" );
+
+        CHECK( !index.Load( input, "index.txt", *error_handler ) );
+        CHECK( error_handler->m_File == "index.txt" );
+        CHECK( index.GetFragmentCount() == 0 );
+    }
+
+    SECTION( "Modified fragments are loaded from source" )
+    {
+        std::istringstream input(
+            "shader_shaker_index 2\n"
+            "fragment 1400000000 0 missing file.fx\n"
+            "function GetOldColor 1 float4 DiffuseColor missing file.fx\n"
+            );
+        Base::ObjectRef<CodeLoader> loader = new CodeLoader( "float4 GetColor() : DiffuseColor { return 1; }" );
+        std::vector<Generation::FragmentDefinition::Ref> definition_table;
+        std::vector<std::string> stale_path_table;
+        Generation::FunctionDefinition::Ref function_definition;
+
+        REQUIRE( index.Load( input, "index.txt", *error_handler ) );
+        REQUIRE( index.CreateFragmentTable( definition_table, stale_path_table, *loader ) );
+
+        REQUIRE( definition_table.size() == 1 );
+        REQUIRE( stale_path_table.size() == 1 );
+        CHECK( stale_path_table[ 0 ] == "missing file.fx" );
+        CHECK( loader->m_LoadCount == 1 );
+        CHECK( definition_table[ 0 ]->FindFunctionDefinition( function_definition, "GetColor" ) );
+        CHECK( !definition_table[ 0 ]->FindFunctionDefinition( function_definition, "GetOldColor" ) );
+    }
+}
+
+TEST_CASE( "Fragment index entries depend on the includes and the defines", "[generation][index]" )
+{
+    const std::string fragment_path = "fragment_index_test.fx";
+    const std::string header_path = "fragment_index_test.fxh";
+    Base::ObjectRef<SimpleErrorHandler> error_handler = new SimpleErrorHandler;
+    Base::ObjectRef<CodeLoader> loader = new CodeLoader( "float4 GetColor() : DiffuseColor { return 1; }" );
+    std::vector<std::string> path_table( 1, fragment_path );
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+    std::vector<std::string> stale_path_table;
+    Generation::FragmentIndex index;
+
+    WriteFile( fragment_path, "#include \"fragment_index_test.fxh\"\n" );
+    WriteFile( header_path, "float4 GetColor() : DiffuseColor { return 1; }\n" );
+    loader->m_IncludedPathTable.push_back( header_path );
+    loader->m_DefineTable.push_back( "QUALITY=1" );
+
+    REQUIRE( index.Build( path_table, *loader, *error_handler ) );
+
+    SECTION( "Unchanged entries are deferred" )
+    {
+        REQUIRE( index.CreateFragmentTable( definition_table, stale_path_table, *loader ) );
+
+        CHECK( stale_path_table.empty() );
+        CHECK( !definition_table[ 0 ]->IsLoaded() );
+    }
+
+    SECTION( "Changed defines make the entry stale" )
+    {
+        loader->m_DefineTable[ 0 ] = "QUALITY=2";
+
+        REQUIRE( index.CreateFragmentTable( definition_table, stale_path_table, *loader ) );
+
+        CHECK( stale_path_table.size() == 1 );
+    }
+
+    SECTION( "Changed includes make the entry stale" )
+    {
+        struct utimbuf times;
+
+        // Timestamps have a one second resolution, so the content is compared
+        WriteFile( header_path, "float4 GetColor() : DiffuseColor { return 0; }\n" );
+        times.actime = 1;
+        times.modtime = 1;
+        utime( header_path.c_str(), &times );
+
+        REQUIRE( index.CreateFragmentTable( definition_table, stale_path_table, *loader ) );
+
+        CHECK( stale_path_table.size() == 1 );
+    }
+
+    std::remove( fragment_path.c_str() );
+    std::remove( header_path.c_str() );
+}
+
+TEST_CASE( "Deferred fragments are loaded on first use", "[generation][index]" )
+{
+    Base::ObjectRef<CodeLoader> loader = new CodeLoader( "float4 GetColor() : DiffuseColor { return 1; }" );
+    Generation::FunctionDefinition::Ref function_definition = new Generation::FunctionDefinition;
+    std::vector<Generation::FunctionDefinition::Ref> function_definition_table;
+
+    function_definition->SetName( "GetColor" );
+    function_definition->SetReturnValue( "float4", "DiffuseColor" );
+    function_definition_table.push_back( function_definition );
+
+    Generation::FragmentDefinition::Ref fragment = Generation::FragmentDefinition::CreateDeferred(
+        "color.fx",
+        *loader,
+        function_definition_table
+        );
+    std::set<std::string> semantic_set;
+
+    semantic_set.insert( "DiffuseColor" );
+
+    CHECK( fragment->FindFunctionDefinitionMatchingSemanticSet( function_definition, semantic_set ) );
+    CHECK( !fragment->IsLoaded() );
+    CHECK( loader->m_LoadCount == 0 );
+
+    CHECK( fragment->GetTranslationUnit().m_GlobalDeclarationTable.size() == 1 );
+    CHECK( fragment->IsLoaded() );
+    CHECK( loader->m_LoadCount == 1 );
+}
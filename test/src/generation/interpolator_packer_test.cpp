@@ -0,0 +1,153 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/interpolator_packer.h>
+#include <sstream>
+
+namespace
+{
+    void AddArgument(
+        AST::FunctionDeclaration & function,
+        const std::string & input_modifier,
+        const std::string & type,
+        const std::string & semantic
+        )
+    {
+        AST::Argument * argument = new AST::Argument;
+
+        argument->m_Type = new AST::Type( type );
+        argument->m_Name = semantic;
+        argument->m_Semantic = semantic;
+        argument->m_InputModifier = input_modifier;
+        function.m_ArgumentList->AddArgument( argument );
+    }
+
+    AST::FunctionDeclaration * AddMainFunction( AST::TranslationUnit & translation_unit )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+
+        function->m_Name = "main";
+        function->m_ArgumentList = new AST::ArgumentList;
+        translation_unit.AddGlobalDeclaration( function );
+
+        return function;
+    }
+
+    // semantic = Get<semantic>( argument_semantic );
+    void AddCall(
+        AST::FunctionDeclaration & function,
+        const std::string & semantic,
+        const std::string & argument_semantic
+        )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( new AST::VariableExpression( argument_semantic ) );
+        function.AddStatement(
+            new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( semantic ) ),
+                AST::AssignmentOperator_Assign,
+                new AST::CallExpression( "Get" + semantic, argument_list )
+                )
+            );
+    }
+
+    std::string Print( const AST::TranslationUnit & translation_unit )
+    {
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        translation_unit.Visit( printer );
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Interpolators are packed", "[generation][interpolator]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> vertex_program = new AST::TranslationUnit;
+    Base::ObjectRef<AST::TranslationUnit> pixel_program = new AST::TranslationUnit;
+    AST::FunctionDeclaration * vertex_main = AddMainFunction( *vertex_program );
+    AST::FunctionDeclaration * pixel_main = AddMainFunction( *pixel_program );
+    Generation::InterpolatorPacker packer;
+
+    AddArgument( *vertex_main, "out", "float2", "UV" );
+    AddArgument( *vertex_main, "out", "float", "Fog" );
+    AddArgument( *vertex_main, "out", "float4", "Position" );
+    AddArgument( *vertex_main, "inout", "float3", "Normal" );
+    AddArgument( *vertex_main, "in", "float3", "VertexPosition" );
+    AddCall( *vertex_main, "UV", "VertexPosition" );
+    AddCall( *vertex_main, "Fog", "VertexPosition" );
+    AddCall( *vertex_main, "Position", "VertexPosition" );
+
+    AddArgument( *pixel_main, "out", "float4", "Color" );
+    AddArgument( *pixel_main, "in", "float2", "UV" );
+    AddArgument( *pixel_main, "in", "float", "Fog" );
+    AddArgument( *pixel_main, "in", "float4", "Position" );
+    AddArgument( *pixel_main, "in", "float3", "Normal" );
+    AddCall( *pixel_main, "Color", "UV" );
+
+    SECTION( "Semantics share float4 slots" )
+    {
+        REQUIRE( packer.Pack( *vertex_program, *pixel_program ) );
+
+        CHECK( packer.GetUnpackedSlotCount() == 4 );
+        CHECK( packer.GetSlotCount() == 3 );
+        CHECK( Print( *vertex_program ) ==
+            "void main(out float2 UV : UV, out float4 PackedInterpolator0 : PackedInterpolator0, out float4 Position : Position, "
+            "in float3 Normal : Normal, in float3 VertexPosition : VertexPosition)\n"
+            "{\n"
+            "\tfloat\n\t\tFog;\n"
+            "\tUV = GetUV(VertexPosition);\n"
+            "\tFog = GetFog(VertexPosition);\n"
+            "\tPosition = GetPosition(VertexPosition);\n"
+            "\tPackedInterpolator0.xyz = Normal;\n"
+            "\tPackedInterpolator0.w = Fog;\n"
+            "\t\n}\n"
+            );
+        CHECK( Print( *pixel_program ) ==
+            "void main(out float4 Color : Color, in float2 UV : UV, in float4 PackedInterpolator0 : PackedInterpolator0, "
+            "in float4 Position : Position)\n"
+            "{\n"
+            "\tfloat\n\t\tFog = PackedInterpolator0.w;\n"
+            "\tfloat3\n\t\tNormal = PackedInterpolator0.xyz;\n"
+            "\tColor = GetColor(UV);\n"
+            "\t\n}\n"
+            );
+    }
+
+    SECTION( "Slots holding one semantic are not rewritten" )
+    {
+        AddArgument( *vertex_main, "out", "float4", "Tangent" );
+        AddArgument( *pixel_main, "in", "float4", "Tangent" );
+        AddArgument( *vertex_main, "out", "float4x4", "Basis" );
+        AddArgument( *pixel_main, "in", "float4x4", "Basis" );
+
+        REQUIRE( packer.Pack( *vertex_program, *pixel_program ) );
+
+        CHECK( packer.GetUnpackedSlotCount() == 9 );
+        CHECK( packer.GetSlotCount() == 8 );
+        CHECK( Print( *pixel_program ).find( "in float4 Tangent : Tangent" ) != std::string::npos );
+        CHECK( Print( *pixel_program ).find( "in float4x4 Basis : Basis" ) != std::string::npos );
+    }
+
+    SECTION( "Nothing is packed when no slot is saved" )
+    {
+        pixel_main->m_ArgumentList->m_ArgumentTable.erase( pixel_main->m_ArgumentList->m_ArgumentTable.begin() + 2 );
+
+        const std::string pixel_code = Print( *pixel_program );
+
+        REQUIRE( packer.Pack( *vertex_program, *pixel_program ) );
+
+        CHECK( packer.GetUnpackedSlotCount() == 3 );
+        CHECK( packer.GetSlotCount() == 3 );
+        CHECK( Print( *pixel_program ) == pixel_code );
+    }
+
+    SECTION( "Programs without main function are rejected" )
+    {
+        Base::ObjectRef<AST::TranslationUnit> empty_program = new AST::TranslationUnit;
+
+        CHECK( !packer.Pack( *vertex_program, *empty_program ) );
+    }
+}
@@ -0,0 +1,258 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/loop_unroller.h>
+#include <sstream>
+
+namespace
+{
+    AST::Expression * Variable( const std::string & name )
+    {
+        return new AST::VariableExpression( name );
+    }
+
+    AST::Expression * Integer( const std::string & value )
+    {
+        return new AST::LiteralExpression( AST::LiteralExpression::Int, value );
+    }
+
+    AST::Expression * Operation( AST::BinaryOperationExpression::Operation operation, AST::Expression * left, AST::Expression * right )
+    {
+        return new AST::BinaryOperationExpression( operation, left, right );
+    }
+
+    AST::Expression * Element( const std::string & name, AST::Expression * index )
+    {
+        AST::VariableExpression * variable = new AST::VariableExpression( name );
+
+        variable->m_SubscriptExpression = index;
+
+        return variable;
+    }
+
+    AST::LValueExpression * LValue( const std::string & name )
+    {
+        return new AST::LValueExpression( new AST::VariableExpression( name ) );
+    }
+
+    // name op value;
+    AST::Statement * Assign( const std::string & name, const AST::AssignmentOperator assignment_operator, AST::Expression * value )
+    {
+        return new AST::AssignmentStatement( LValue( name ), assignment_operator, value );
+    }
+
+    // int name = value;
+    AST::Statement * Declare( const std::string & name, AST::Expression * value )
+    {
+        AST::VariableDeclarationStatement * statement = new AST::VariableDeclarationStatement;
+        AST::VariableDeclarationBody * body = new AST::VariableDeclarationBody( name );
+
+        body->m_InitialValue = new AST::InitialValue;
+        body->m_InitialValue->AddExpression( value );
+        statement->SetType( new AST::Type( "int" ) );
+        statement->AddBody( body );
+
+        return statement;
+    }
+
+    AST::BlockStatement * Block( AST::Statement * first, AST::Statement * second = 0 )
+    {
+        AST::BlockStatement * block = new AST::BlockStatement;
+
+        block->AddStatement( first );
+
+        if( second )
+        {
+            block->AddStatement( second );
+        }
+
+        return block;
+    }
+
+    // for( int variable = 0; variable < count; ++variable )
+    AST::Statement * Loop( const std::string & variable, const std::string & count, AST::Statement * statement )
+    {
+        return new AST::ForStatement(
+            Declare( variable, Integer( "0" ) ),
+            Operation( AST::BinaryOperationExpression::LessThan, Variable( variable ), Integer( count ) ),
+            new AST::PreModifyExpression( AST::SelfModifyOperator_PlusPlus, LValue( variable ) ),
+            statement
+            );
+    }
+
+    AST::FunctionDeclaration * AddFunction( AST::TranslationUnit & translation_unit, const std::string & name )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+
+        function->m_Type = new AST::Type( "float" );
+        function->m_Name = name;
+        translation_unit.AddGlobalDeclaration( function );
+
+        return function;
+    }
+
+    std::string PrintStatements( const AST::FunctionDeclaration & function )
+    {
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        for( size_t index = 0; index < function.m_StatementTable.size(); ++index )
+        {
+            function.m_StatementTable[ index ]->Visit( printer );
+        }
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Loops with a constant trip count are unrolled", "[generation][unrolling]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit, "GetColor" );
+    Generation::LoopUnroller unroller;
+
+    // if( i == 0 ) color += Base; else color += Lights[ i ] * i;
+    function->AddStatement(
+        Loop( "i", "3",
+            Block(
+                new AST::IfStatement(
+                    Operation( AST::BinaryOperationExpression::Equality, Variable( "i" ), Integer( "0" ) ),
+                    Block( Assign( "color", AST::AssignmentOperator_Add, Variable( "Base" ) ) ),
+                    Block( Assign( "color", AST::AssignmentOperator_Add, Operation( AST::BinaryOperationExpression::Multiplication, Element( "Lights", Variable( "i" ) ), Variable( "i" ) ) ) )
+                    )
+                )
+            )
+        );
+    function->AddStatement( new AST::ReturnStatement( Variable( "color" ) ) );
+
+    SECTION( "Copies are folded" )
+    {
+        const std::string code =
+            "color += Base;\n"
+            "color += ( Lights[1] ) * ( 1 );\n"
+            "color += ( Lights[2] ) * ( 2 );\n"
+            "return color;\n";
+
+        unroller.Unroll( *translation_unit );
+
+        CHECK( unroller.GetUnrolledLoopCount() == 1 );
+        CHECK( unroller.GetFoldedExpressionCount() == 6 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "Loops over the budget are kept" )
+    {
+        unroller.SetMaximumStatementCount( 8 );
+        unroller.Unroll( *translation_unit );
+
+        CHECK( unroller.GetUnrolledLoopCount() == 0 );
+        CHECK( function->m_StatementTable[ 0 ]->m_Kind == AST::NodeKind_ForStatement );
+    }
+}
+
+TEST_CASE( "Inner loops are unrolled first", "[generation][unrolling]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit, "GetTotal" );
+    Generation::LoopUnroller unroller;
+    const std::string code =
+        "total += 0;\n"
+        "total += 1;\n"
+        "total += 2;\n"
+        "total += 3;\n";
+
+    function->AddStatement(
+        Loop( "i", "2",
+            Loop( "j", "2",
+                Assign( "total", AST::AssignmentOperator_Add,
+                    Operation( AST::BinaryOperationExpression::Addition,
+                        Operation( AST::BinaryOperationExpression::Multiplication, Variable( "i" ), Integer( "2" ) ),
+                        Variable( "j" )
+                        )
+                    )
+                )
+            )
+        );
+
+    unroller.Unroll( *translation_unit );
+
+    CHECK( unroller.GetUnrolledLoopCount() == 2 );
+    CHECK( PrintStatements( *function ) == code );
+}
+
+TEST_CASE( "While loops following their induction variable are unrolled", "[generation][unrolling]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit, "GetTotal" );
+    Generation::LoopUnroller unroller;
+
+    // int i = 1; while( i <= 2 ) { total += i; i++; }
+    function->AddStatement( Declare( "i", Integer( "1" ) ) );
+    function->AddStatement(
+        new AST::WhileStatement(
+            Operation( AST::BinaryOperationExpression::LessThanOrEqual, Variable( "i" ), Integer( "2" ) ),
+            Block(
+                Assign( "total", AST::AssignmentOperator_Add, Variable( "i" ) ),
+                new AST::ExpressionStatement( new AST::PostModifyExpression( AST::SelfModifyOperator_PlusPlus, LValue( "i" ) ) )
+                )
+            )
+        );
+
+    SECTION( "Unread variables are removed" )
+    {
+        const std::string code =
+            "total += 1;\n"
+            "total += 2;\n"
+            "return total;\n";
+
+        function->AddStatement( new AST::ReturnStatement( Variable( "total" ) ) );
+        unroller.Unroll( *translation_unit );
+
+        CHECK( unroller.GetUnrolledLoopCount() == 1 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "Read variables get their final value" )
+    {
+        const std::string code =
+            "int\n\ti = 1;\n"
+            "total += 1;\n"
+            "total += 2;\n"
+            "i = 3;\n"
+            "return i;\n";
+
+        function->AddStatement( new AST::ReturnStatement( Variable( "i" ) ) );
+        unroller.Unroll( *translation_unit );
+
+        CHECK( unroller.GetUnrolledLoopCount() == 1 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+}
+
+TEST_CASE( "Loops leaving early or writing their variable are kept", "[generation][unrolling]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit, "GetTotal" );
+    AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+    AST::ForStatement * float_loop = static_cast<AST::ForStatement *>( Loop( "i", "4", Assign( "total", AST::AssignmentOperator_Add, Operation( AST::BinaryOperationExpression::Division, Variable( "i" ), Integer( "2" ) ) ) ) );
+    Generation::LoopUnroller unroller;
+
+    argument_list->AddExpression( Variable( "i" ) );
+    AddFunction( *translation_unit, "Update" );
+
+    function->AddStatement( Loop( "i", "4", Block( Assign( "total", AST::AssignmentOperator_Add, Variable( "i" ) ), new AST::BreakStatement ) ) );
+    function->AddStatement( Loop( "i", "4", Block( Assign( "i", AST::AssignmentOperator_Add, Integer( "1" ) ) ) ) );
+    function->AddStatement( Loop( "i", "4", new AST::ExpressionStatement( new AST::CallExpression( "Update", argument_list ) ) ) );
+    function->AddStatement( Loop( "i", "4", Loop( "j", "4", Block( Assign( "total", AST::AssignmentOperator_Add, Variable( "j" ) ), new AST::ContinueStatement ) ) ) );
+    // i < 4.0, folding i into integer literals would turn i / 2 into an integer division
+    static_cast<AST::BinaryOperationExpression &>( *float_loop->m_EqualityExpression ).m_RightExpression = new AST::LiteralExpression( AST::LiteralExpression::Float, "4.0" );
+    function->AddStatement( float_loop );
+
+    unroller.Unroll( *translation_unit );
+
+    CHECK( unroller.GetUnrolledLoopCount() == 1 );
+    // Only the outer loop of the last integer one, its copies keeping the inner loop
+    CHECK( function->m_StatementTable.size() == 8 );
+    CHECK( function->m_StatementTable[ 3 ]->m_Kind == AST::NodeKind_ForStatement );
+    CHECK( function->m_StatementTable[ 7 ]->m_Kind == AST::NodeKind_ForStatement );
+}
@@ -0,0 +1,168 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <generation/fragment_definition.h>
+#include <generation/permutation_enumerator.h>
+#include <generation/resolution_cache.h>
+#include <base/text_error_handler.h>
+
+namespace
+{
+    // The by-product semantic is also generated with an out argument
+    Generation::FragmentDefinition::Ref CreateFragment(
+        const std::string & semantic,
+        const std::string & argument_semantic,
+        const std::string & by_product_semantic = ""
+        )
+    {
+        Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+        AST::Argument * argument = new AST::Argument;
+
+        argument->m_Type = new AST::IntrinsicType( "float" );
+        argument->m_Name = "value";
+        argument->m_Semantic = argument_semantic;
+        function->m_Type = new AST::IntrinsicType( "float" );
+        function->m_Name = "Get" + semantic;
+        function->m_Semantic = semantic;
+        function->m_ArgumentList = new AST::ArgumentList;
+        function->m_ArgumentList->AddArgument( argument );
+
+        if( !by_product_semantic.empty() )
+        {
+            AST::Argument * by_product_argument = new AST::Argument;
+
+            by_product_argument->m_Type = new AST::IntrinsicType( "float" );
+            by_product_argument->m_Name = "by_product";
+            by_product_argument->m_Semantic = by_product_semantic;
+            by_product_argument->m_InputModifier = "out";
+            function->m_ArgumentList->AddArgument( by_product_argument );
+        }
+
+        function->AddStatement( new AST::ReturnStatement( new AST::VariableExpression( "value" ) ) );
+        translation_unit->AddGlobalDeclaration( function );
+
+        return Generation::FragmentDefinition::GenerateFragment( *translation_unit );
+    }
+}
+
+TEST_CASE( "Permutations are enumerated", "[generation][permutation]" )
+{
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+    std::vector<Generation::PermutationEnumerator::Permutation> permutation_table;
+    std::vector<std::string> required_semantic_table, optional_semantic_table, input_semantic_table;
+    Base::ObjectRef<Base::TextErrorHandler> error_handler = new Base::TextErrorHandler;
+    Generation::PermutationEnumerator enumerator;
+
+    definition_table.push_back( CreateFragment( "A", "X" ) );
+    definition_table.push_back( CreateFragment( "B", "Y" ) );
+    definition_table.push_back( CreateFragment( "C", "A" ) );
+    definition_table.push_back( CreateFragment( "D", "X" ) );
+
+    optional_semantic_table.push_back( "A" );
+    optional_semantic_table.push_back( "B" );
+    optional_semantic_table.push_back( "C" );
+    optional_semantic_table.push_back( "D" );
+    input_semantic_table.push_back( "X" );
+
+    SECTION( "Unsatisfiable combinations are pruned" )
+    {
+        enumerator.SetThreadCount( 1 );
+
+        REQUIRE( enumerator.Enumerate( permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        // A C and A C D use the functions of C and C D
+        REQUIRE( permutation_table.size() == 5 );
+        CHECK( permutation_table[ 0 ].m_SemanticTable == std::vector<std::string>( 1, "A" ) );
+        CHECK( permutation_table[ 0 ].m_UsedInputSemanticTable == std::vector<std::string>( 1, "X" ) );
+        CHECK( permutation_table[ 2 ].m_SemanticTable == std::vector<std::string>( 1, "D" ) );
+        REQUIRE( permutation_table[ 4 ].m_SemanticTable.size() == 2 );
+        CHECK( permutation_table[ 4 ].m_SemanticTable[ 0 ] == "C" );
+    }
+
+    SECTION( "Threads find the same permutations" )
+    {
+        std::vector<Generation::PermutationEnumerator::Permutation> threaded_permutation_table;
+
+        enumerator.SetThreadCount( 1 );
+        REQUIRE( enumerator.Enumerate( permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        enumerator.SetThreadCount( 4 );
+        REQUIRE( enumerator.Enumerate( threaded_permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        REQUIRE( threaded_permutation_table.size() == permutation_table.size() );
+
+        for( size_t index = 0; index < permutation_table.size(); ++index )
+        {
+            CHECK( threaded_permutation_table[ index ].m_SemanticTable == permutation_table[ index ].m_SemanticTable );
+        }
+    }
+
+    SECTION( "Threads share the resolution cache" )
+    {
+        std::vector<Generation::PermutationEnumerator::Permutation> cached_permutation_table;
+        Generation::ResolutionCache cache;
+
+        REQUIRE( enumerator.Enumerate( permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        enumerator.SetThreadCount( 4 );
+        enumerator.SetResolutionCache( &cache );
+        REQUIRE( enumerator.Enumerate( cached_permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        REQUIRE( cached_permutation_table.size() == permutation_table.size() );
+
+        for( size_t index = 0; index < permutation_table.size(); ++index )
+        {
+            CHECK( cached_permutation_table[ index ].m_SemanticTable == permutation_table[ index ].m_SemanticTable );
+            CHECK( cached_permutation_table[ index ].m_UsedInputSemanticTable == permutation_table[ index ].m_UsedInputSemanticTable );
+        }
+
+        CHECK( cache.GetHitCount() > 0 );
+    }
+
+    SECTION( "Required semantics are part of every permutation" )
+    {
+        required_semantic_table.push_back( "D" );
+        optional_semantic_table.pop_back();
+
+        REQUIRE( enumerator.Enumerate( permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        REQUIRE( permutation_table.size() == 3 );
+        CHECK( permutation_table[ 0 ].m_SemanticTable == std::vector<std::string>( 1, "D" ) );
+        CHECK( permutation_table[ 2 ].m_SemanticTable.back() == "C" );
+
+        required_semantic_table.push_back( "B" );
+
+        CHECK( !enumerator.Enumerate( permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+    }
+
+    SECTION( "Semantics generated by their prefix are not added again" )
+    {
+        definition_table.insert( definition_table.begin(), CreateFragment( "E", "X", "D" ) );
+        optional_semantic_table.insert( optional_semantic_table.begin(), "E" );
+
+        REQUIRE( enumerator.Enumerate( permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        // D is already generated with E, C uses the function of A
+        REQUIRE( permutation_table.size() == 8 );
+
+        for( size_t index = 0; index < permutation_table.size(); ++index )
+        {
+            const std::vector<std::string> & semantic_table = permutation_table[ index ].m_SemanticTable;
+
+            CHECK( !( semantic_table.front() == "E" && semantic_table.back() == "D" ) );
+        }
+    }
+
+    SECTION( "Combinations resolving to the same functions are listed once" )
+    {
+        definition_table.push_back( CreateFragment( "E", "X", "D" ) );
+        optional_semantic_table.push_back( "E" );
+
+        REQUIRE( enumerator.Enumerate( permutation_table, definition_table, required_semantic_table, optional_semantic_table, input_semantic_table, *error_handler ) );
+
+        // D is generated by the function of E, listed with D only
+        REQUIRE( permutation_table.size() == 5 );
+        CHECK( permutation_table[ 2 ].m_SemanticTable == std::vector<std::string>( 1, "D" ) );
+        CHECK( permutation_table[ 4 ].m_SemanticTable.back() == "D" );
+    }
+}
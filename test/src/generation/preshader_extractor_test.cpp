@@ -0,0 +1,130 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/preshader_extractor.h>
+#include <sstream>
+
+namespace
+{
+    AST::Expression * Variable( const std::string & name )
+    {
+        return new AST::VariableExpression( name );
+    }
+
+    AST::Expression * Literal( const std::string & value )
+    {
+        return new AST::LiteralExpression( AST::LiteralExpression::Float, value );
+    }
+
+    AST::Expression * Binary( const AST::BinaryOperationExpression::Operation operation, AST::Expression * left, AST::Expression * right )
+    {
+        return new AST::BinaryOperationExpression( operation, left, right );
+    }
+
+    AST::Expression * Call( const std::string & name, AST::Expression * argument )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( argument );
+
+        return new AST::CallExpression( name, argument_list );
+    }
+
+    void AddUniform( AST::TranslationUnit & translation_unit, const std::string & type, const std::string & name )
+    {
+        AST::VariableDeclaration * declaration = new AST::VariableDeclaration;
+
+        declaration->SetType( new AST::Type( type ) );
+        declaration->AddBody( new AST::VariableDeclarationBody( name ) );
+        translation_unit.AddGlobalDeclaration( declaration );
+    }
+
+    // float4 name( float3 normal ) { return expression; }
+    void AddFunction( AST::TranslationUnit & translation_unit, const std::string & name, AST::Expression * expression )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+        AST::Argument * argument = new AST::Argument;
+
+        function->m_Type = new AST::IntrinsicType( "float4" );
+        function->m_Name = name;
+        function->m_ArgumentList = new AST::ArgumentList;
+        argument->m_Type = new AST::Type( "float3" );
+        argument->m_Name = "normal";
+        function->m_ArgumentList->AddArgument( argument );
+        function->AddStatement( new AST::ReturnStatement( expression ) );
+        translation_unit.AddGlobalDeclaration( function );
+    }
+
+    std::string Print( const AST::Node & node )
+    {
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        node.Visit( printer );
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Uniform expressions are extracted", "[generation][preshader]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> vertex_program = new AST::TranslationUnit;
+    Base::ObjectRef<AST::TranslationUnit> pixel_program = new AST::TranslationUnit;
+    Generation::PreshaderExtractor extractor;
+
+    AddUniform( *pixel_program, "float3", "LightDirection" );
+    AddUniform( *pixel_program, "float", "FogRange" );
+
+    // dot( normal, normalize( LightDirection ) ) * ( 1.0 / FogRange )
+    AddFunction(
+        *pixel_program,
+        "GetColor",
+        Binary(
+            AST::BinaryOperationExpression::Multiplication,
+            Binary( AST::BinaryOperationExpression::Addition, Variable( "normal" ), Call( "normalize", Variable( "LightDirection" ) ) ),
+            Binary( AST::BinaryOperationExpression::Division, Literal( "1.0" ), Variable( "FogRange" ) )
+            )
+        );
+
+    AddUniform( *vertex_program, "float3", "LightDirection" );
+    AddFunction( *vertex_program, "GetLight", Binary( AST::BinaryOperationExpression::Addition, Variable( "normal" ), Call( "normalize", Variable( "LightDirection" ) ) ) );
+
+    SECTION( "The largest uniform expressions are replaced by uniforms" )
+    {
+        CHECK( extractor.Extract( *pixel_program ) == 2 );
+        CHECK( extractor.GetUniformCount() == 2 );
+
+        REQUIRE( pixel_program->m_GlobalDeclarationTable.size() == 5 );
+        CHECK( Print( *pixel_program->m_GlobalDeclarationTable[ 0 ] ) == "float3\n\tpreshader_0;\n" );
+        CHECK( Print( *pixel_program->m_GlobalDeclarationTable[ 1 ] ) == "float\n\tpreshader_1;\n" );
+        CHECK( Print( *pixel_program->m_GlobalDeclarationTable[ 4 ] ).find( "return ( ( normal ) + ( preshader_0 ) ) * ( preshader_1 );" ) != std::string::npos );
+    }
+
+    SECTION( "Programs share the uniforms of identical expressions" )
+    {
+        CHECK( extractor.Extract( *pixel_program ) == 2 );
+        CHECK( extractor.Extract( *vertex_program ) == 1 );
+        CHECK( extractor.GetUniformCount() == 2 );
+        CHECK( Print( *vertex_program->m_GlobalDeclarationTable[ 0 ] ) == "float3\n\tpreshader_0;\n" );
+    }
+
+    SECTION( "The evaluation program computes the uniforms" )
+    {
+        extractor.Extract( *pixel_program );
+
+        const std::string code = Print( *extractor.CreateEvaluationProgram() );
+
+        CHECK( code.find( "LightDirection;" ) != std::string::npos );
+        CHECK( code.find( "FogRange;" ) != std::string::npos );
+        CHECK( code.find( "preshader_0 = normalize(LightDirection);" ) != std::string::npos );
+        CHECK( code.find( "preshader_1 = ( 1.0 ) / ( FogRange );" ) != std::string::npos );
+    }
+
+    SECTION( "Locals hiding a uniform are not extracted" )
+    {
+        AddFunction( *pixel_program, "GetFog", Binary( AST::BinaryOperationExpression::Division, Literal( "1.0" ), Call( "abs", Variable( "normal" ) ) ) );
+        AddUniform( *pixel_program, "float3", "normal" );
+
+        CHECK( extractor.Extract( *pixel_program ) == 2 );
+    }
+}
@@ -0,0 +1,186 @@
+#include "catch.hpp"
+#include <generation/code_generator.h>
+#include <generation/fragment_definition.h>
+#include <generation/resolution_cache.h>
+#include <base/text_error_handler.h>
+#include <set>
+#include <sstream>
+
+namespace
+{
+    struct NullLoader : public Generation::FragmentLoaderInterface
+    {
+        virtual Base::ObjectRef<AST::TranslationUnit> LoadTranslationUnit(
+            const std::string & /*path*/
+            ) override
+        {
+            return 0;
+        }
+    };
+
+    // Fragments are only described by their signature, queries never load them
+    Generation::FragmentDefinition::Ref CreateFragment(
+        Generation::FragmentLoaderInterface & loader,
+        const std::string & semantic,
+        const std::string & argument_semantics,
+        const std::string & input_modifier = ""
+        )
+    {
+        Generation::FunctionDefinition::Ref function_definition = new Generation::FunctionDefinition;
+        std::vector<Generation::FunctionDefinition::Ref> function_definition_table;
+        std::istringstream argument_stream( argument_semantics );
+        std::string argument_semantic;
+
+        function_definition->SetName( "Get" + semantic );
+
+        if( input_modifier.empty() )
+        {
+            function_definition->SetReturnValue( "float4", semantic );
+        }
+
+        while( argument_stream >> argument_semantic )
+        {
+            Generation::FunctionDefinition::Argument argument;
+
+            argument.m_InputModifier = input_modifier;
+            argument.m_Type = "float4";
+            argument.m_Semantic = argument_semantic;
+            function_definition->AddArgument( argument );
+        }
+
+        function_definition_table.push_back( function_definition );
+
+        return Generation::FragmentDefinition::CreateDeferred( semantic + ".fx", loader, function_definition_table );
+    }
+
+    std::string Query(
+        Generation::ResolutionCache * cache,
+        const std::vector<Generation::FragmentDefinition::Ref> & definition_table,
+        const std::vector<std::string> & semantic_table,
+        const std::vector<std::string> & input_semantic_table
+        )
+    {
+        Generation::CodeGenerator code_generator;
+        Base::ObjectRef<Base::TextErrorHandler> error_handler = new Base::TextErrorHandler;
+        std::vector<std::string> used_semantic_table;
+        std::vector<Generation::FunctionDefinition::Ref> function_table;
+        std::ostringstream result;
+
+        code_generator.SetResolutionCache( cache );
+
+        result << code_generator.QueryShader( used_semantic_table, function_table, definition_table, semantic_table, input_semantic_table, *error_handler );
+
+        for( size_t index = 0; index < used_semantic_table.size(); ++index )
+        {
+            result << " " << used_semantic_table[ index ];
+        }
+
+        for( size_t index = 0; index < function_table.size(); ++index )
+        {
+            result << " " << function_table[ index ]->GetName();
+        }
+
+        std::set<std::string>::const_iterator it, end;
+
+        for( it = code_generator.GetSearchedSemanticSet().begin(), end = code_generator.GetSearchedSemanticSet().end(); it != end; ++it )
+        {
+            result << " " << *it;
+        }
+
+        return result.str();
+    }
+}
+
+TEST_CASE( "Cached resolutions are spliced", "[generation][resolution_cache]" )
+{
+    Base::ObjectRef<NullLoader> loader = new NullLoader;
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+    std::vector<std::string> output_semantic_table, first_input_table, second_input_table;
+
+    definition_table.push_back( CreateFragment( *loader, "Color", "Light Albedo" ) );
+    definition_table.push_back( CreateFragment( *loader, "Light", "Normal" ) );
+    definition_table.push_back( CreateFragment( *loader, "Albedo", "TexCoord" ) );
+    definition_table.push_back( CreateFragment( *loader, "Normal", "X" ) );
+    definition_table.push_back( CreateFragment( *loader, "Fog", "Position Color" ) );
+    definition_table.push_back( CreateFragment( *loader, "Position", "X" ) );
+    definition_table.push_back( CreateFragment( *loader, "Tint", "Color", "inout" ) );
+    definition_table.push_back( CreateFragment( *loader, "Shadow", "Light Position" ) );
+    definition_table.push_back( CreateFragment( *loader, "BumpNormal", "Normal Y" ) );
+
+    output_semantic_table.push_back( "Color" );
+    output_semantic_table.push_back( "Fog" );
+    output_semantic_table.push_back( "Shadow" );
+    output_semantic_table.push_back( "Light" );
+    output_semantic_table.push_back( "BumpNormal" );
+    output_semantic_table.push_back( "Position" );
+
+    first_input_table.push_back( "X" );
+    first_input_table.push_back( "TexCoord" );
+    second_input_table = first_input_table;
+    second_input_table.push_back( "Y" );
+    second_input_table.push_back( "Light" );
+
+    SECTION( "Queries give the same result with the cache" )
+    {
+        Generation::ResolutionCache cache;
+        int mismatch_count = 0;
+
+        for( int pass = 0; pass < 2; ++pass )
+        {
+            for( unsigned int mask = 1; mask < ( 1u << output_semantic_table.size() ); ++mask )
+            {
+                std::vector<std::string> semantic_table;
+
+                for( size_t index = 0; index < output_semantic_table.size(); ++index )
+                {
+                    if( mask & ( 1u << index ) )
+                    {
+                        semantic_table.push_back( output_semantic_table[ index ] );
+                    }
+                }
+
+                const std::vector<std::string> & input_table = pass == 0 ? first_input_table : second_input_table;
+
+                if( Query( &cache, definition_table, semantic_table, input_table ) != Query( 0, definition_table, semantic_table, input_table ) )
+                {
+                    ++mismatch_count;
+                }
+            }
+        }
+
+        CHECK( mismatch_count == 0 );
+        CHECK( cache.GetHitCount() > 0 );
+        CHECK( cache.GetEvictionCount() == 0 );
+    }
+
+    SECTION( "Unsatisfiable semantics are cached" )
+    {
+        Generation::ResolutionCache cache;
+        std::vector<std::string> semantic_table( 1, "BumpNormal" );
+
+        CHECK( Query( &cache, definition_table, semantic_table, first_input_table ).compare( 0, 1, "0" ) == 0 );
+        CHECK( Query( &cache, definition_table, semantic_table, first_input_table ) == Query( 0, definition_table, semantic_table, first_input_table ) );
+        CHECK( cache.GetHitCount() == 1 );
+    }
+
+    SECTION( "Least recently used resolutions are evicted" )
+    {
+        Generation::ResolutionCache cache( 2048 );
+        std::vector<std::string> semantic_table;
+
+        for( size_t index = 0; index < output_semantic_table.size(); ++index )
+        {
+            semantic_table.assign( 1, output_semantic_table[ index ] );
+
+            CHECK( Query( &cache, definition_table, semantic_table, second_input_table ) == Query( 0, definition_table, semantic_table, second_input_table ) );
+        }
+
+        CHECK( cache.GetEvictionCount() > 0 );
+        CHECK( cache.GetSize() <= 2048 );
+
+        cache.Clear();
+
+        CHECK( cache.GetEntryCount() == 0 );
+        CHECK( cache.GetSize() == 0 );
+    }
+}
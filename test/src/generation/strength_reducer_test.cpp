@@ -0,0 +1,146 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/strength_reducer.h>
+#include <sstream>
+
+namespace
+{
+    AST::Expression * Variable( const std::string & name )
+    {
+        return new AST::VariableExpression( name );
+    }
+
+    AST::Expression * Integer( const std::string & value )
+    {
+        return new AST::LiteralExpression( AST::LiteralExpression::Int, value );
+    }
+
+    AST::Expression * Float( const std::string & value )
+    {
+        return new AST::LiteralExpression( AST::LiteralExpression::Float, value );
+    }
+
+    AST::Expression * Operation( AST::BinaryOperationExpression::Operation operation, AST::Expression * left, AST::Expression * right )
+    {
+        return new AST::BinaryOperationExpression( operation, left, right );
+    }
+
+    AST::Expression * Call( const std::string & name, AST::Expression * first, AST::Expression * second = 0 )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( first );
+
+        if( second )
+        {
+            argument_list->AddExpression( second );
+        }
+
+        return new AST::CallExpression( name, argument_list );
+    }
+
+    // float name = value;
+    AST::Statement * Declare( const std::string & name, AST::Expression * value )
+    {
+        AST::VariableDeclarationStatement * statement = new AST::VariableDeclarationStatement;
+        AST::VariableDeclarationBody * body = new AST::VariableDeclarationBody( name );
+
+        body->m_InitialValue = new AST::InitialValue;
+        body->m_InitialValue->AddExpression( value );
+        statement->SetType( new AST::Type( "float" ) );
+        statement->AddBody( body );
+
+        return statement;
+    }
+
+    AST::FunctionDeclaration * AddFunction( AST::TranslationUnit & translation_unit, const std::string & name )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+
+        function->m_Type = new AST::Type( "float" );
+        function->m_Name = name;
+        translation_unit.AddGlobalDeclaration( function );
+
+        return function;
+    }
+
+    std::string PrintStatements( const AST::FunctionDeclaration & function )
+    {
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        for( size_t index = 0; index < function.m_StatementTable.size(); ++index )
+        {
+            function.m_StatementTable[ index ]->Visit( printer );
+        }
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Operations are reduced to cheaper forms", "[generation][strength_reduction]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit, "GetValue" );
+    Generation::StrengthReducer reducer;
+
+    function->AddStatement( Declare( "a", Call( "pow", Variable( "x" ), Integer( "2" ) ) ) );
+    function->AddStatement( Declare( "b", Call( "pow", Operation( AST::BinaryOperationExpression::Addition, Variable( "a" ), Integer( "1" ) ), Float( "1.0" ) ) ) );
+    function->AddStatement( Declare( "c", Operation( AST::BinaryOperationExpression::Division, Variable( "b" ), Float( "4.0" ) ) ) );
+    function->AddStatement( Declare( "d", Operation( AST::BinaryOperationExpression::Division, Variable( "c" ), Float( "3.0f" ) ) ) );
+    function->AddStatement( Declare( "e", Operation( AST::BinaryOperationExpression::Division, Integer( "1" ), Call( "sqrt", Variable( "d" ) ) ) ) );
+    function->AddStatement( Declare( "f", Operation( AST::BinaryOperationExpression::Multiplication, Call( "length", Variable( "v" ) ), Call( "length", Variable( "v" ) ) ) ) );
+    function->AddStatement( Declare( "g", Operation( AST::BinaryOperationExpression::Division, Call( "pow", Variable( "f" ), Float( "3.0" ) ), Integer( "4" ) ) ) );
+
+    SECTION( "Only the exact rewrites are made by default" )
+    {
+        const std::string code =
+            "float\n\ta = ( x ) * ( x );\n"
+            "float\n\tb = ( a ) + ( 1 );\n"
+            "float\n\tc = ( b ) * ( 0.25 );\n"
+            "float\n\td = ( c ) / ( 3.0f );\n"
+            "float\n\te = ( 1 ) / ( sqrt(d) );\n"
+            "float\n\tf = ( length(v) ) * ( length(v) );\n"
+            "float\n\tg = ( pow(f, 3.0) ) / ( 4 );\n";
+
+        reducer.Reduce( *translation_unit );
+
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_PowerSquare ) == 1 );
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_PowerIdentity ) == 1 );
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_PowerOfTwoDivision ) == 1 );
+        CHECK( reducer.GetTotalHitCount() == 3 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "Fast math allows the approximations" )
+    {
+        const std::string code =
+            "float\n\ta = ( x ) * ( x );\n"
+            "float\n\tb = ( a ) + ( 1 );\n"
+            "float\n\tc = ( b ) * ( 0.25 );\n"
+            "float\n\td = ( c ) * ( 0.333333333 );\n"
+            "float\n\te = rsqrt(d);\n"
+            "float\n\tf = dot(v, v);\n"
+            "float\n\tg = ( ( ( f ) * ( f ) ) * ( f ) ) / ( 4 );\n";
+
+        reducer.SetFastMath( true );
+        reducer.Reduce( *translation_unit );
+
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_ConstantDivision ) == 1 );
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_ReciprocalSquareRoot ) == 1 );
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_LengthProduct ) == 1 );
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_PowerCube ) == 1 );
+        CHECK( reducer.GetTotalHitCount() == 7 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "Functions hide the intrinsics" )
+    {
+        AddFunction( *translation_unit, "pow" );
+        reducer.Reduce( *translation_unit );
+
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_PowerSquare ) == 0 );
+        CHECK( reducer.GetHitCount( Generation::StrengthReducer::Rule_PowerOfTwoDivision ) == 1 );
+    }
+}
@@ -0,0 +1,178 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/texture_fetch_hoister.h>
+#include <sstream>
+
+namespace
+{
+    AST::Expression * Variable( const std::string & name )
+    {
+        return new AST::VariableExpression( name );
+    }
+
+    AST::Expression * Add( AST::Expression * left, AST::Expression * right )
+    {
+        return new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Addition, left, right );
+    }
+
+    // tex2D( DiffuseSampler, coordinates )
+    AST::Expression * Fetch( AST::Expression * coordinates )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( Variable( "DiffuseSampler" ) );
+        argument_list->AddExpression( coordinates );
+
+        return new AST::CallExpression( "tex2D", argument_list );
+    }
+
+    // texture.Sample( LinearSampler, coordinates )
+    AST::Expression * Sample( const std::string & texture, AST::Expression * coordinates )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( Variable( "LinearSampler" ) );
+        argument_list->AddExpression( coordinates );
+
+        return new AST::PostfixExpression( Variable( texture ), new AST::PostfixSuffixCall( new AST::CallExpression( "Sample", argument_list ), 0 ) );
+    }
+
+    // type name = value;
+    AST::Statement * Declare( const std::string & type, const std::string & name, AST::Expression * value )
+    {
+        AST::VariableDeclarationStatement * statement = new AST::VariableDeclarationStatement;
+        AST::VariableDeclarationBody * body = new AST::VariableDeclarationBody( name );
+
+        body->m_InitialValue = new AST::InitialValue;
+        body->m_InitialValue->AddExpression( value );
+        statement->SetType( new AST::Type( type ) );
+        statement->AddBody( body );
+
+        return statement;
+    }
+
+    AST::FunctionDeclaration * AddFunction( AST::TranslationUnit & translation_unit )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+        AST::Argument * argument = new AST::Argument;
+
+        function->m_Type = new AST::Type( "float4" );
+        function->m_Name = "GetColor";
+        function->m_ArgumentList = new AST::ArgumentList;
+        argument->m_Type = new AST::Type( "float2" );
+        argument->m_Name = "uv";
+        function->m_ArgumentList->AddArgument( argument );
+        translation_unit.AddGlobalDeclaration( function );
+
+        return function;
+    }
+
+    std::string PrintStatements( const AST::FunctionDeclaration & function )
+    {
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        for( size_t index = 0; index < function.m_StatementTable.size(); ++index )
+        {
+            function.m_StatementTable[ index ]->Visit( printer );
+        }
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Texture fetches are hoisted", "[generation][hoisting]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit );
+    Generation::TextureFetchHoister hoister;
+
+    function->AddStatement( Declare( "float4", "a", Add( Variable( "uv" ), Variable( "uv" ) ) ) );
+    function->AddStatement( Declare( "float2", "b", Add( Variable( "uv" ), Variable( "a" ) ) ) );
+
+    SECTION( "Fetches move above the statements they do not depend on" )
+    {
+        const std::string code =
+            "float4\n\tfetch_0 = tex2D(DiffuseSampler, uv);\n"
+            "float4\n\ta = ( uv ) + ( uv );\n"
+            "float2\n\tb = ( uv ) + ( a );\n"
+            "float4\n\tfetch_1 = tex2D(DiffuseSampler, b);\n"
+            "float4\n\tc = ( a ) + ( fetch_0 );\n"
+            "return ( c ) + ( fetch_1 );\n";
+
+        function->AddStatement( Declare( "float4", "c", Add( Variable( "a" ), Fetch( Variable( "uv" ) ) ) ) );
+        function->AddStatement( new AST::ReturnStatement( Add( Variable( "c" ), Fetch( Variable( "b" ) ) ) ) );
+
+        hoister.Hoist( *translation_unit );
+
+        CHECK( hoister.GetHoistedFetchCount() == 2 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "In flight fetches are limited" )
+    {
+        const std::string code =
+            "float4\n\tfetch_0 = tex2D(DiffuseSampler, uv);\n"
+            "float4\n\ta = ( uv ) + ( uv );\n"
+            "float2\n\tb = ( uv ) + ( a );\n"
+            "float4\n\tfetch_1 = tex2D(DiffuseSampler, uv);\n"
+            "float4\n\tc = ( a ) + ( fetch_0 );\n"
+            "return ( c ) + ( ( fetch_1 ) + ( tex2D(DiffuseSampler, b) ) );\n";
+
+        function->AddStatement( Declare( "float4", "c", Add( Variable( "a" ), Fetch( Variable( "uv" ) ) ) ) );
+        function->AddStatement( new AST::ReturnStatement( Add( Variable( "c" ), Add( Fetch( Variable( "uv" ) ), Fetch( Variable( "b" ) ) ) ) ) );
+
+        hoister.SetMaximumInFlightCount( 1 );
+        hoister.Hoist( *translation_unit );
+
+        CHECK( hoister.GetHoistedFetchCount() == 2 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "Fetches are not moved above an early return" )
+    {
+        function->AddStatement( new AST::IfStatement( Variable( "b" ), new AST::ReturnStatement( Variable( "a" ) ), 0 ) );
+        function->AddStatement( new AST::ReturnStatement( Fetch( Variable( "uv" ) ) ) );
+
+        hoister.Hoist( *translation_unit );
+
+        CHECK( hoister.GetHoistedFetchCount() == 0 );
+    }
+}
+
+TEST_CASE( "Hoisted fetches have the element type of their texture", "[generation][hoisting]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function;
+    AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+    Generation::TextureFetchHoister hoister;
+    const std::string code =
+        "float2\n\tfetch_0 = Offsets.Sample(LinearSampler, uv);\n"
+        "float4\n\tfetch_1 = Diffuse.Sample(LinearSampler, uv);\n"
+        "float4\n\ta = ( uv ) + ( uv );\n"
+        "return ( ( ( a ) + ( fetch_0 ) ) + ( ( fetch_1 ) + ( Unknown.Sample(LinearSampler, uv) ) ) ) + ( texelSize(uv) );\n";
+
+    translation_unit->AddGlobalDeclaration( new AST::TextureDeclaration( "Texture2D< float2 >", "Offsets", "", 0 ) );
+    translation_unit->AddGlobalDeclaration( new AST::TextureDeclaration( "Texture2D", "Diffuse", "", 0 ) );
+    function = AddFunction( *translation_unit );
+    argument_list->AddExpression( Variable( "uv" ) );
+
+    function->AddStatement( Declare( "float4", "a", Add( Variable( "uv" ), Variable( "uv" ) ) ) );
+    function->AddStatement(
+        new AST::ReturnStatement(
+            Add(
+                Add(
+                    Add( Variable( "a" ), Sample( "Offsets", Variable( "uv" ) ) ),
+                    Add( Sample( "Diffuse", Variable( "uv" ) ), Sample( "Unknown", Variable( "uv" ) ) )
+                    ),
+                new AST::CallExpression( "texelSize", argument_list )
+                )
+            )
+        );
+
+    hoister.Hoist( *translation_unit );
+
+    CHECK( hoister.GetHoistedFetchCount() == 2 );
+    CHECK( PrintStatements( *function ) == code );
+}
@@ -0,0 +1,154 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <ast/printer/hlsl_printer.h>
+#include <generation/vector_narrower.h>
+#include <sstream>
+
+namespace
+{
+    AST::Expression * Variable( const std::string & name )
+    {
+        return new AST::VariableExpression( name );
+    }
+
+    AST::Expression * Literal( const std::string & value )
+    {
+        return new AST::LiteralExpression( AST::LiteralExpression::Int, value );
+    }
+
+    AST::Expression * Multiply( AST::Expression * left, AST::Expression * right )
+    {
+        return new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Multiplication, left, right );
+    }
+
+    AST::Expression * Swizzle( const std::string & name, const std::string & swizzle )
+    {
+        return new AST::PostfixExpression( Variable( name ), new AST::Swizzle( swizzle ) );
+    }
+
+    AST::Expression * Call( const std::string & name, AST::Expression * first, AST::Expression * second = 0, AST::Expression * third = 0 )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( first );
+
+        if( second )
+        {
+            argument_list->AddExpression( second );
+        }
+
+        if( third )
+        {
+            argument_list->AddExpression( third );
+        }
+
+        return new AST::CallExpression( name, argument_list );
+    }
+
+    AST::Expression * Construct( const std::string & type, AST::Expression * first, AST::Expression * second = 0, AST::Expression * third = 0 )
+    {
+        AST::CallExpression * call = static_cast<AST::CallExpression *>( Call( type, first, second, third ) );
+
+        return new AST::ConstructorExpression( new AST::IntrinsicType( type ), &*call->m_ArgumentExpressionList );
+    }
+
+    // type name = value;
+    AST::Statement * Declare( const std::string & type, const std::string & name, AST::Expression * value )
+    {
+        AST::VariableDeclarationStatement * statement = new AST::VariableDeclarationStatement;
+        AST::VariableDeclarationBody * body = new AST::VariableDeclarationBody( name );
+
+        body->m_InitialValue = new AST::InitialValue;
+        body->m_InitialValue->AddExpression( value );
+        statement->SetType( new AST::Type( type ) );
+        statement->AddBody( body );
+
+        return statement;
+    }
+
+    AST::FunctionDeclaration * AddFunction( AST::TranslationUnit & translation_unit )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+        AST::Argument * argument = new AST::Argument;
+
+        function->m_Type = new AST::Type( "float4" );
+        function->m_Name = "GetColor";
+        function->m_ArgumentList = new AST::ArgumentList;
+        argument->m_Type = new AST::Type( "float2" );
+        argument->m_Name = "uv";
+        function->m_ArgumentList->AddArgument( argument );
+        translation_unit.AddGlobalDeclaration( function );
+
+        return function;
+    }
+
+    std::string PrintStatements( const AST::FunctionDeclaration & function )
+    {
+        std::ostringstream output;
+        AST::HLSLPrinter printer( output );
+
+        for( size_t index = 0; index < function.m_StatementTable.size(); ++index )
+        {
+            function.m_StatementTable[ index ]->Visit( printer );
+        }
+
+        return output.str();
+    }
+}
+
+TEST_CASE( "Vectors are narrowed to their read components", "[generation][narrowing]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit );
+    Generation::VectorNarrower narrower;
+
+    SECTION( "Unread components are not computed" )
+    {
+        const std::string code =
+            "float2\n\tcolor = float2(( uv.x ) * ( 2 ), 1);\n"
+            "color.y = 3;\n"
+            "float\n\tmask = saturate(uv.y);\n"
+            "return ( color.xy ) * ( mask );\n";
+
+        function->AddStatement( Declare( "float4", "color", Construct( "float4", Multiply( Variable( "uv" ), Literal( "2" ) ), Swizzle( "uv", "y" ), Literal( "1" ) ) ) );
+        function->AddStatement( new AST::AssignmentStatement( new AST::LValueExpression( static_cast<AST::VariableExpression *>( Variable( "color" ) ), new AST::Swizzle( "w" ) ), AST::AssignmentOperator_Assign, Literal( "3" ) ) );
+        function->AddStatement( Declare( "float3", "mask", Call( "saturate", Construct( "float3", Variable( "uv" ), Literal( "0" ) ) ) ) );
+        function->AddStatement( new AST::ReturnStatement( Multiply( Swizzle( "color", "xw" ), Swizzle( "mask", "y" ) ) ) );
+
+        narrower.Narrow( *translation_unit );
+
+        CHECK( narrower.GetNarrowedVariableCount() == 2 );
+        CHECK( narrower.GetRemovedComponentCount() == 4 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "Narrowed values let the vectors they read be narrowed" )
+    {
+        const std::string code =
+            "float\n\ta = uv.x;\n"
+            "float\n\tb = ( a ) * ( 2 );\n"
+            "return b;\n";
+
+        function->AddStatement( Declare( "float4", "a", Construct( "float4", Variable( "uv" ), Variable( "uv" ) ) ) );
+        function->AddStatement( Declare( "float4", "b", Multiply( Variable( "a" ), Literal( "2" ) ) ) );
+        function->AddStatement( new AST::ReturnStatement( Swizzle( "b", "r" ) ) );
+
+        narrower.Narrow( *translation_unit );
+
+        CHECK( narrower.GetNarrowedVariableCount() == 2 );
+        CHECK( narrower.GetRemovedComponentCount() == 6 );
+        CHECK( PrintStatements( *function ) == code );
+    }
+
+    SECTION( "Vectors used whole keep their type" )
+    {
+        function->AddStatement( Declare( "float4", "a", Construct( "float4", Variable( "uv" ), Variable( "uv" ) ) ) );
+        function->AddStatement( Declare( "float4", "b", Construct( "float4", Variable( "uv" ), Variable( "uv" ) ) ) );
+        function->AddStatement( new AST::ExpressionStatement( Call( "Transform", Variable( "a" ) ) ) );
+        function->AddStatement( new AST::ReturnStatement( Multiply( Variable( "a" ), Swizzle( "b", "xyzw" ) ) ) );
+
+        narrower.Narrow( *translation_unit );
+
+        CHECK( narrower.GetNarrowedVariableCount() == 0 );
+    }
+}
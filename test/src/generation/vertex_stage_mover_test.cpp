@@ -0,0 +1,220 @@
+#include "catch.hpp"
+#include <ast/node.h>
+#include <generation/vertex_stage_mover.h>
+
+namespace
+{
+    void AddArgument(
+        AST::FunctionDeclaration & function,
+        const std::string & input_modifier,
+        const std::string & type,
+        const std::string & name
+        )
+    {
+        AST::Argument * argument = new AST::Argument;
+
+        argument->m_Type = new AST::Type( type );
+        argument->m_Name = name;
+        argument->m_Semantic = name;
+        argument->m_InputModifier = input_modifier;
+        function.m_ArgumentList->AddArgument( argument );
+    }
+
+    AST::FunctionDeclaration * AddFunction(
+        AST::TranslationUnit & translation_unit,
+        const std::string & type,
+        const std::string & name
+        )
+    {
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+
+        function->m_Type = new AST::Type( type );
+        function->m_Name = name;
+        function->m_ArgumentList = new AST::ArgumentList;
+        translation_unit.AddGlobalDeclaration( function );
+
+        return function;
+    }
+
+    // type Get<Semantic>( float argument ) : Semantic { return expression; }
+    void AddReturnFunction(
+        AST::TranslationUnit & translation_unit,
+        const std::string & type,
+        const std::string & name,
+        const std::string & argument_type,
+        const std::string & argument,
+        AST::Expression * expression
+        )
+    {
+        AST::FunctionDeclaration * function = AddFunction( translation_unit, type, name );
+
+        function->m_Semantic = name.substr( 3 );
+        AddArgument( *function, "", argument_type, argument );
+        function->AddStatement( new AST::ReturnStatement( expression ) );
+    }
+
+    AST::Expression * Multiply( AST::Expression * left, AST::Expression * right )
+    {
+        return new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Multiplication, left, right );
+    }
+
+    AST::Expression * Variable( const std::string & name )
+    {
+        return new AST::VariableExpression( name );
+    }
+
+    AST::Expression * Literal( const std::string & value )
+    {
+        return new AST::LiteralExpression( AST::LiteralExpression::Float, value );
+    }
+
+    // semantic = function( argument_semantic );
+    void AddCall(
+        AST::FunctionDeclaration & main_function,
+        const std::string & semantic,
+        const std::string & function,
+        const std::string & argument_semantic
+        )
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( new AST::VariableExpression( argument_semantic ) );
+        main_function.AddStatement(
+            new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( semantic ) ),
+                AST::AssignmentOperator_Assign,
+                new AST::CallExpression( function, argument_list )
+                )
+            );
+    }
+}
+
+TEST_CASE( "Affine pixel functions are moved to the vertex stage", "[generation][vertex_stage]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> pixel_program = new AST::TranslationUnit;
+    Generation::VertexStageMover mover;
+    std::vector<std::string> semantic_table;
+
+    // return UV * 2 + 0.5;
+    AddReturnFunction(
+        *pixel_program, "float2", "GetWorldUV", "float2", "UV",
+        new AST::BinaryOperationExpression(
+            AST::BinaryOperationExpression::Addition,
+            Multiply( Variable( "UV" ), Literal( "2" ) ),
+            Literal( "0.5" )
+            )
+        );
+
+    // return tex2D( DiffuseSampler, WorldUV );
+    {
+        AST::ArgumentExpressionList * argument_list = new AST::ArgumentExpressionList;
+
+        argument_list->AddExpression( new AST::VariableExpression( "DiffuseSampler" ) );
+        argument_list->AddExpression( new AST::VariableExpression( "WorldUV" ) );
+
+        AddReturnFunction(
+            *pixel_program, "float4", "GetDiffuse", "float2", "WorldUV",
+            new AST::CallExpression( "tex2D", argument_list )
+            );
+    }
+
+    // return Depth * Depth;
+    AddReturnFunction( *pixel_program, "float", "GetDensity", "float", "Depth", Multiply( Variable( "Depth" ), Variable( "Depth" ) ) );
+
+    // return Fog * FogColor;
+    AddReturnFunction( *pixel_program, "float3", "GetFogColor", "float", "Fog", Multiply( Variable( "Fog" ), Variable( "FogColor" ) ) );
+
+    AST::FunctionDeclaration * main_function = AddFunction( *pixel_program, "void", "main" );
+
+    AddArgument( *main_function, "in", "float2", "UV" );
+    AddArgument( *main_function, "in", "float", "Depth" );
+    AddArgument( *main_function, "in", "float", "Fog" );
+    AddArgument( *main_function, "out", "float4", "Color" );
+    AddCall( *main_function, "WorldUV", "GetWorldUV", "UV" );
+    AddCall( *main_function, "Color", "GetDiffuse", "WorldUV" );
+    AddCall( *main_function, "Density", "GetDensity", "Depth" );
+    AddCall( *main_function, "FogColor", "GetFogColor", "Fog" );
+
+    SECTION( "Only affine functions of interpolated semantics are moved" )
+    {
+        mover.FindMovableSemantics( semantic_table, *pixel_program );
+
+        REQUIRE( semantic_table.size() == 1 );
+        CHECK( semantic_table[ 0 ] == "WorldUV" );
+        REQUIRE( mover.GetMovedFunctionTable().size() == 1 );
+        CHECK( mover.GetMovedFunctionTable()[ 0 ].m_Name == "GetWorldUV" );
+        CHECK( mover.GetMovedFunctionTable()[ 0 ].m_Cost == 2 );
+        CHECK( mover.GetMovedFunctionTable()[ 0 ].m_InterpolatorComponentDelta == 0 );
+    }
+
+    SECTION( "Functions adding interpolators must save enough operations" )
+    {
+        mover.SetInterpolatorComponentCost( 0 );
+        mover.FindMovableSemantics( semantic_table, *pixel_program );
+
+        REQUIRE( semantic_table.size() == 2 );
+        CHECK( semantic_table[ 1 ] == "FogColor" );
+        CHECK( mover.GetMovedFunctionTable()[ 1 ].m_InterpolatorComponentDelta == 2 );
+    }
+}
+
+TEST_CASE( "Affine function cost is computed", "[generation][vertex_stage]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+    AST::FunctionDeclaration * function = AddFunction( *translation_unit, "float3", "GetPosition" );
+    int cost = 0;
+
+    AddArgument( *function, "", "float3", "Position" );
+
+    SECTION( "Accumulated products by constants are affine" )
+    {
+        // Position *= Scale; Position += Offset; return -Position;
+        function->AddStatement(
+            new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( "Position" ) ),
+                AST::AssignmentOperator_Multiply,
+                Variable( "Scale" )
+                )
+            );
+        function->AddStatement(
+            new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( "Position" ) ),
+                AST::AssignmentOperator_Add,
+                Variable( "Offset" )
+                )
+            );
+        function->AddStatement(
+            new AST::ReturnStatement(
+                new AST::UnaryOperationExpression( AST::UnaryOperationExpression::Minus, Variable( "Position" ) )
+                )
+            );
+
+        CHECK( Generation::VertexStageMover::GetAffineCost( cost, *function ) );
+        CHECK( cost == 3 );
+    }
+
+    SECTION( "Division by an argument is not affine" )
+    {
+        function->AddStatement(
+            new AST::ReturnStatement(
+                new AST::BinaryOperationExpression( AST::BinaryOperationExpression::Division, Literal( "1" ), Variable( "Position" ) )
+                )
+            );
+
+        CHECK( !Generation::VertexStageMover::GetAffineCost( cost, *function ) );
+    }
+
+    SECTION( "Writing a global is not moved" )
+    {
+        function->AddStatement(
+            new AST::AssignmentStatement(
+                new AST::LValueExpression( new AST::VariableExpression( "LastPosition" ) ),
+                AST::AssignmentOperator_Assign,
+                Variable( "Position" )
+                )
+            );
+        function->AddStatement( new AST::ReturnStatement( Variable( "Position" ) ) );
+
+        CHECK( !Generation::VertexStageMover::GetAffineCost( cost, *function ) );
+    }
+}
@@ -87,6 +87,30 @@ TEST_CASE( "Function are parsed", "[parser]" )
 
     }
 
+    SECTION( "Function body is parsed on first use in lazy mode" )
+    {
+        const char code[] = " float test( float a )\n{\n    if( a > 0 ) { a = 1; }\n    return a;\n} ";
+        Parser parser( code, sizeof( code ) - 1 );
+
+        parser.m_Parser.LazyFunctionBodyParsing = true;
+        declaration = parser.m_Parser.function_declaration();
+
+        REQUIRE( declaration );
+
+        CHECK( declaration->m_Name == "test" );
+        CHECK( declaration->m_ArgumentList );
+        CHECK( declaration->HasDeferredBody() );
+        CHECK( declaration->m_StatementTable.empty() );
+
+        declaration->ResolveBody();
+
+        CHECK( !declaration->HasDeferredBody() );
+        REQUIRE( declaration->m_StatementTable.size() == 2 );
+        CHECK( declaration->m_StatementTable[ 0 ]->GetLine() == 3 );
+        CHECK( declaration->m_StatementTable[ 1 ]->GetLine() == 4 );
+        CHECK( declaration->m_StatementTable[ 1 ]->GetFileName() == "literal_code" );
+    }
+
     delete declaration;
 }
 
@@ -0,0 +1,191 @@
+#include "catch.hpp"
+#include "ast/node.h"
+#include "ast/function_node.h"
+#include "hlsl_parser/hlsl.h"
+#include "hlsl_parser/preprocessor.h"
+#include <map>
+
+namespace
+{
+    class MemoryIncludeCache : public HLSL::IncludeCache
+    {
+    public:
+
+        virtual bool ReadFile(
+            std::string & content,
+            const std::string & path
+            ) const override
+        {
+            std::map<std::string, std::string>::const_iterator file = m_FileTable.find( path );
+
+            if( file == m_FileTable.end() )
+            {
+                return false;
+            }
+
+            content = (*file).second;
+            return true;
+        }
+
+        std::map<std::string, std::string>
+            m_FileTable;
+    };
+
+    class CountingErrorHandler : public Base::ErrorHandlerInterface
+    {
+    public:
+
+        CountingErrorHandler() : m_ErrorCount( 0 ) {}
+
+        virtual void ReportError( const std::string & /*message*/, const std::string & /*file*/ ) override
+        {
+            ++m_ErrorCount;
+        }
+
+        int
+            m_ErrorCount;
+    };
+}
+
+TEST_CASE( "Preprocessor directives are handled", "[parser]" )
+{
+    Base::ObjectRef<MemoryIncludeCache> cache = new MemoryIncludeCache;
+    Base::ObjectRef<CountingErrorHandler> error_handler = new CountingErrorHandler;
+    HLSL::Preprocessor preprocessor( *cache, *error_handler );
+
+    SECTION( "Macros are expanded and lines are preserved" )
+    {
+        const char code[] =
+            "#define SCALE 2\n"
+            "#define SQUARE( x ) ( ( x ) * ( x ) )\n"
+            "float a = SQUARE( SCALE );\n";
+        HLSL::IncludeUnit::Ref unit = preprocessor.ProcessSource( code, "main.fx" );
+
+        REQUIRE( unit );
+        CHECK( unit->m_Text == "\n\nfloat a = ( ( 2 ) * ( 2 ) );\n" );
+    }
+
+    SECTION( "Conditional blocks are removed" )
+    {
+        const char code[] =
+            "#if defined( FIRST ) && VALUE > 1\n"
+            "float a;\n"
+            "#elif VALUE == 1\n"
+            "float b;\n"
+            "#else\n"
+            "float c;\n"
+            "#endif\n";
+
+        preprocessor.Define( "VALUE", "1" );
+
+        HLSL::IncludeUnit::Ref unit = preprocessor.ProcessSource( code, "main.fx" );
+
+        REQUIRE( unit );
+        CHECK( unit->m_Text == "\n\n\nfloat b;\n\n\n\n" );
+    }
+
+    SECTION( "Unterminated conditional is reported" )
+    {
+        const char code[] = "#ifdef VALUE\nfloat a;\n";
+
+        CHECK( !preprocessor.ProcessSource( code, "main.fx" ) );
+        CHECK( error_handler->m_ErrorCount == 1 );
+    }
+
+    SECTION( "Pragma once skips the second include" )
+    {
+        cache->m_FileTable[ "common.h" ] = "#pragma once\nfloat common;\n";
+
+        const char code[] = "#include \"common.h\"\n#include \"common.h\"\n";
+        HLSL::IncludeUnit::Ref unit = preprocessor.ProcessSource( code, "main.fx" );
+
+        REQUIRE( unit );
+        REQUIRE( unit->m_IncludeTable.size() == 2 );
+        CHECK( unit->m_IncludeTable[ 0 ].m_Unit );
+        CHECK( !unit->m_IncludeTable[ 1 ].m_Unit );
+    }
+
+    SECTION( "Included units are shared through the cache" )
+    {
+        cache->m_FileTable[ "include/common.h" ] = "float common = VALUE;\n";
+        preprocessor.AddIncludePath( "include" );
+
+        const char code[] = "#define VALUE 1\n#include <common.h>\n";
+        HLSL::IncludeUnit::Ref first_unit = preprocessor.ProcessSource( code, "first.fx" );
+        HLSL::IncludeUnit::Ref second_unit = preprocessor.ProcessSource( code, "second.fx" );
+
+        REQUIRE( first_unit );
+        REQUIRE( second_unit );
+        CHECK( &*first_unit->m_IncludeTable[ 0 ].m_Unit == &*second_unit->m_IncludeTable[ 0 ].m_Unit );
+        CHECK( cache->GetHitCount() == 1 );
+
+        const char other_code[] = "#define VALUE 2\n#include <common.h>\n";
+        HLSL::IncludeUnit::Ref third_unit = preprocessor.ProcessSource( other_code, "third.fx" );
+
+        REQUIRE( third_unit );
+        CHECK( &*third_unit->m_IncludeTable[ 0 ].m_Unit != &*first_unit->m_IncludeTable[ 0 ].m_Unit );
+        CHECK( third_unit->m_IncludeTable[ 0 ].m_Unit->m_Text == "float common = 2;\n" );
+    }
+
+    SECTION( "Included files are listed with the predefined macros" )
+    {
+        cache->m_FileTable[ "light.h" ] = "#include \"common.h\"\nfloat light;\n";
+        cache->m_FileTable[ "common.h" ] = "#pragma once\nfloat common;\n";
+        preprocessor.Define( "QUALITY", "2" );
+        preprocessor.Define( "ALPHA" );
+
+        const char code[] = "#include \"light.h\"\n#include \"common.h\"\n";
+        std::vector<std::string> define_table;
+
+        REQUIRE( preprocessor.ProcessSource( code, "main.fx" ) );
+        REQUIRE( preprocessor.GetIncludedPathTable().size() == 2 );
+        CHECK( preprocessor.GetIncludedPathTable()[ 0 ] == "light.h" );
+        CHECK( preprocessor.GetIncludedPathTable()[ 1 ] == "common.h" );
+
+        preprocessor.GetDefineTable( define_table );
+
+        REQUIRE( define_table.size() == 2 );
+        CHECK( define_table[ 0 ] == "ALPHA=1" );
+        CHECK( define_table[ 1 ] == "QUALITY=2" );
+    }
+
+    SECTION( "Include paths are normalized" )
+    {
+        CHECK( HLSL::Preprocessor::NormalizePath( "a/./b/../c.h" ) == "a/c.h" );
+        CHECK( HLSL::Preprocessor::NormalizePath( "a\\b.h" ) == "a/b.h" );
+        CHECK( HLSL::Preprocessor::NormalizePath( "../a.h" ) == "../a.h" );
+    }
+}
+
+TEST_CASE( "Included files are parsed", "[parser]" )
+{
+    Base::ObjectRef<MemoryIncludeCache> cache = new MemoryIncludeCache;
+    Base::ObjectRef<CountingErrorHandler> error_handler = new CountingErrorHandler;
+    HLSL::Preprocessor preprocessor( *cache, *error_handler );
+
+    cache->m_FileTable[ "types.h" ] =
+        "#pragma once\n"
+        "struct Light { float3 Direction; };\n";
+    cache->m_FileTable[ "first.fx" ] =
+        "#include \"types.h\"\n"
+        "float3 GetFirst( Light light ) { return light.Direction; }\n";
+    cache->m_FileTable[ "second.fx" ] =
+        "#include \"types.h\"\n"
+        "\n"
+        "float3 GetSecond( Light light ) { return light.Direction; }\n";
+
+    Base::ObjectRef<AST::TranslationUnit> first = HLSL::ParseHLSL( "first.fx", preprocessor );
+    Base::ObjectRef<AST::TranslationUnit> second = HLSL::ParseHLSL( "second.fx", preprocessor );
+
+    REQUIRE( first );
+    REQUIRE( second );
+    REQUIRE( first->m_GlobalDeclarationTable.size() == 2 );
+    REQUIRE( second->m_GlobalDeclarationTable.size() == 2 );
+
+    CHECK( &*first->m_GlobalDeclarationTable[ 0 ] == &*second->m_GlobalDeclarationTable[ 0 ] );
+    CHECK( first->m_GlobalDeclarationTable[ 0 ]->GetFileName() == "types.h" );
+    CHECK( second->m_GlobalDeclarationTable[ 1 ]->GetFileName() == "second.fx" );
+    CHECK( second->m_GlobalDeclarationTable[ 1 ]->GetLine() == 3 );
+    CHECK( dynamic_cast<AST::FunctionDeclaration *>( &*second->m_GlobalDeclarationTable[ 1 ] ) );
+    CHECK( error_handler->m_ErrorCount == 0 );
+}
@@ -0,0 +1,45 @@
+#include "catch.hpp"
+#include "server/file_watcher.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+#ifdef __linux__
+
+TEST_CASE( "File watcher reports written files", "[server]" )
+{
+    char directory[] = "/tmp/shader_shaker_watcher_XXXXXX";
+
+    REQUIRE( mkdtemp( directory ) );
+
+    const std::string path = std::string( directory ) + "/color.fx";
+    Server::FileWatcher watcher;
+    std::vector<std::string> path_table;
+    std::string error;
+
+    REQUIRE( watcher.AddDirectory( directory, error ) );
+
+    SECTION( "Changes are coalesced" )
+    {
+        std::ofstream( path.c_str() ) << "float4 a;";
+        std::ofstream( path.c_str() ) << "float4 b;";
+
+        REQUIRE( watcher.WaitForChanges( path_table, error ) );
+        REQUIRE( path_table.size() == 1 );
+        CHECK( path_table[ 0 ] == path );
+    }
+
+    SECTION( "Stop wakes up the watcher" )
+    {
+        watcher.Stop();
+
+        REQUIRE( watcher.WaitForChanges( path_table, error ) );
+        CHECK( path_table.empty() );
+    }
+
+    std::remove( path.c_str() );
+    rmdir( directory );
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "catch.hpp"
+#include "ast/node.h"
+#include "generation/fragment_definition.h"
+#include "server/generation_server.h"
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    Base::ObjectRef<AST::TranslationUnit> CreateTranslationUnit( const std::string & function_name, const std::string & semantic )
+    {
+        Base::ObjectRef<AST::TranslationUnit> translation_unit = new AST::TranslationUnit;
+        AST::FunctionDeclaration * function = new AST::FunctionDeclaration;
+        AST::Argument * argument = new AST::Argument;
+
+        argument->m_Type = new AST::IntrinsicType( "float2" );
+        argument->m_Name = "uv";
+        argument->m_Semantic = "TexCoord";
+        function->m_Type = new AST::IntrinsicType( "float4" );
+        function->m_Name = function_name;
+        function->m_Semantic = semantic;
+        function->m_ArgumentList = new AST::ArgumentList;
+        function->m_ArgumentList->AddArgument( argument );
+        function->AddStatement( new AST::ReturnStatement( new AST::LiteralExpression( AST::LiteralExpression::Int, "1" ) ) );
+        translation_unit->AddGlobalDeclaration( function );
+
+        return translation_unit;
+    }
+
+    Generation::FragmentDefinition::Ref CreateFragment()
+    {
+        return Generation::FragmentDefinition::GenerateFragment( *CreateTranslationUnit( "GetColor", "Color" ) );
+    }
+
+    struct FunctionLoader : public Generation::FragmentLoaderInterface
+    {
+        FunctionLoader() : m_LoadCount( 0 ) {}
+
+        virtual Base::ObjectRef<AST::TranslationUnit> LoadTranslationUnit(
+            const std::string & /*path*/
+            ) override
+        {
+            ++m_LoadCount;
+
+            if( m_FunctionName.empty() )
+            {
+                return 0;
+            }
+
+            return CreateTranslationUnit( m_FunctionName, "Color" );
+        }
+
+        std::string
+            m_FunctionName;
+        int
+            m_LoadCount;
+    };
+}
+
+TEST_CASE( "Generation server answers requests", "[server]" )
+{
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+
+    definition_table.push_back( CreateFragment() );
+
+    Server::GenerationServer server( definition_table );
+
+    SECTION( "Code is generated" )
+    {
+        const std::string response = server.HandleRequest(
+            "{ \"id\": 7, \"semantics\": [ \"Color\" ], \"input_semantics\": [ \"TexCoord\" ] }"
+            );
+
+        CHECK( response.find( "{\"id\":\"7\",\"status\":\"ok\",\"hlsl\":\"" ) == 0 );
+        CHECK( response.find( "GetColor" ) != std::string::npos );
+        CHECK( response.find( "\"used_semantics\":[\"TexCoord\"]}" ) != std::string::npos );
+        CHECK( response.find( '\n' ) == std::string::npos );
+    }
+
+    SECTION( "Errors are reported" )
+    {
+        CHECK( server.HandleRequest( "{ \"id\": \"a\"" ) == "{\"id\":\"\",\"status\":\"error\",\"message\":\"invalid request\"}" );
+        CHECK( server.HandleRequest( "{ \"id\": \"a\" }" ) == "{\"id\":\"a\",\"status\":\"error\",\"message\":\"no semantic requested\"}" );
+        CHECK( server.HandleRequest( "{ \"id\": \"b\", \"semantics\": [ \"Normal\" ] }" ).find( "\"status\":\"error\"" ) != std::string::npos );
+    }
+
+    SECTION( "Requests are read line by line" )
+    {
+        std::istringstream input(
+            "{ \"id\": \"1\", \"semantics\": [ \"Color\" ], \"input_semantics\": [ \"TexCoord\" ] }\n"
+            "\n"
+            "{ \"id\": \"2\", \"semantics\": [ \"Color\" ], \"input_semantics\": [ \"TexCoord\" ] }\n"
+            );
+        std::ostringstream output;
+        std::string line;
+        int line_count = 0;
+
+        server.Serve( input, output );
+
+        std::istringstream responses( output.str() );
+
+        while( std::getline( responses, line ) )
+        {
+            ++line_count;
+        }
+
+        CHECK( line_count == 2 );
+        CHECK( output.str().find( "{\"id\":\"2\",\"status\":\"ok\"" ) != std::string::npos );
+    }
+
+    SECTION( "Requests are handled concurrently" )
+    {
+        std::vector<std::thread> thread_table;
+        int failure_count[ 4 ] = { 0, 0, 0, 0 };
+
+        for( int thread_index = 0; thread_index < 4; ++thread_index )
+        {
+            thread_table.push_back( std::thread(
+                [&server, &failure_count, thread_index]()
+                {
+                    for( int index = 0; index < 50; ++index )
+                    {
+                        const std::string response = server.HandleRequest(
+                            "{ \"semantics\": [ \"Color\" ], \"input_semantics\": [ \"TexCoord\" ] }"
+                            );
+
+                        if( response.find( "\"status\":\"ok\"" ) == std::string::npos )
+                        {
+                            ++failure_count[ thread_index ];
+                        }
+                    }
+                }
+                ) );
+        }
+
+        for( size_t thread_index = 0; thread_index < thread_table.size(); ++thread_index )
+        {
+            thread_table[ thread_index ].join();
+        }
+
+        int
+            total_failure_count = failure_count[ 0 ] + failure_count[ 1 ] + failure_count[ 2 ] + failure_count[ 3 ];
+
+        CHECK( total_failure_count == 0 );
+    }
+}
+
+TEST_CASE( "Generation server extracts preshaders on request", "[server]" )
+{
+    Base::ObjectRef<AST::TranslationUnit> translation_unit = CreateTranslationUnit( "GetColor", "Color" );
+    AST::FunctionDeclaration & function = static_cast<AST::FunctionDeclaration &>( *translation_unit->m_GlobalDeclarationTable[ 0 ] );
+    AST::VariableDeclaration * uniform = new AST::VariableDeclaration;
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+
+    // float Scale; ... return Scale * 2.0;
+    uniform->SetType( new AST::IntrinsicType( "float" ) );
+    uniform->AddBody( new AST::VariableDeclarationBody( "Scale" ) );
+    translation_unit->m_GlobalDeclarationTable.insert( translation_unit->m_GlobalDeclarationTable.begin(), uniform );
+    function.m_StatementTable[ 0 ] = new AST::ReturnStatement(
+        new AST::BinaryOperationExpression(
+            AST::BinaryOperationExpression::Multiplication,
+            new AST::VariableExpression( "Scale" ),
+            new AST::LiteralExpression( AST::LiteralExpression::Float, "2.0" )
+            )
+        );
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *translation_unit ) );
+
+    Server::GenerationServer server( definition_table );
+    const std::string
+        semantic_fields = "\"semantics\": [ \"Color\" ], \"input_semantics\": [ \"TexCoord\" ]",
+        response = server.HandleRequest( "{ \"id\": 1, " + semantic_fields + ", \"preshader\": true }" );
+
+    CHECK( response.find( "return preshader_0;" ) != std::string::npos );
+    CHECK( response.find( "\"preshader_hlsl\":\"" ) != std::string::npos );
+    CHECK( response.find( "preshader_0 = ( Scale ) * ( 2.0 );" ) != std::string::npos );
+    CHECK( server.HandleRequest( "{ \"id\": 2, " + semantic_fields + " }" ).find( "preshader" ) == std::string::npos );
+}
+
+TEST_CASE( "Generation server reloads fragments", "[server]" )
+{
+    std::vector<Generation::FragmentDefinition::Ref> definition_table;
+    std::vector<std::string> path_table;
+    Base::ObjectRef<FunctionLoader> loader = new FunctionLoader;
+
+    definition_table.push_back( CreateFragment() );
+    definition_table.push_back( Generation::FragmentDefinition::GenerateFragment( *CreateTranslationUnit( "GetNormal", "Normal" ) ) );
+    path_table.push_back( "color.fx" );
+    path_table.push_back( "normal.fx" );
+
+    Server::GenerationServer server( definition_table, path_table );
+    std::vector<std::string> changed_path_table;
+
+    const std::string
+        color_request = "{ \"id\": 1, \"semantics\": [ \"Color\" ], \"input_semantics\": [ \"TexCoord\" ] }",
+        normal_request = "{ \"id\": 2, \"semantics\": [ \"Normal\" ], \"input_semantics\": [ \"TexCoord\" ] }";
+
+    CHECK( server.HandleRequest( color_request ).find( "GetColor" ) != std::string::npos );
+    CHECK( server.HandleRequest( normal_request ).find( "GetNormal" ) != std::string::npos );
+    CHECK( server.HandleRequest( color_request ) == server.HandleRequest( color_request ) );
+    CHECK( server.GetCachedResponseCount() == 2 );
+
+    SECTION( "Unrelated changes are ignored" )
+    {
+        changed_path_table.push_back( "other.fx" );
+
+        CHECK( server.ReloadFragments( changed_path_table, *loader ) );
+        CHECK( loader->m_LoadCount == 0 );
+        CHECK( server.GetCachedResponseCount() == 2 );
+    }
+
+    SECTION( "Only the dependent responses are invalidated" )
+    {
+        loader->m_FunctionName = "GetNewColor";
+        changed_path_table.push_back( "color.fx" );
+
+        CHECK( server.ReloadFragments( changed_path_table, *loader ) );
+        CHECK( loader->m_LoadCount == 1 );
+        CHECK( server.GetCachedResponseCount() == 1 );
+        CHECK( server.HandleRequest( color_request ).find( "GetNewColor" ) != std::string::npos );
+        CHECK( server.HandleRequest( normal_request ).find( "GetNormal" ) != std::string::npos );
+    }
+
+    SECTION( "Fragments failing to parse keep their previous version" )
+    {
+        changed_path_table.push_back( "color.fx" );
+
+        CHECK( !server.ReloadFragments( changed_path_table, *loader ) );
+        CHECK( server.GetCachedResponseCount() == 2 );
+        CHECK( server.HandleRequest( color_request ).find( "GetColor" ) != std::string::npos );
+    }
+}
\ No newline at end of file